@@ -0,0 +1,408 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweeping.hpp"
+#include <aliceVision/config.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsData/OrientedPoint.hpp>
+#include <aliceVision/mvsData/SeedPoint.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#endif
+
+#include <limits>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace depthMap {
+
+PlaneSweeping::PlaneSweeping(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
+                             int _scales)
+    : scales(_scales)
+    , mp(_mp)
+    , pc(_pc)
+    , ic(_ic)
+    , verbose(_mp->verbose)
+{
+}
+
+void PlaneSweeping::getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth,
+                                      float& maxDepth)
+{
+    StaticVector<SeedPoint>* seeds;
+    mvsUtils::loadSeedsFromFile(&seeds, rc, mp, mvsUtils::EFileType::seeds);
+
+    float minCamDist = (float)mp->_ini.get<double>("prematching.minCamDist", 0.0f);
+    float maxCamDist = (float)mp->_ini.get<double>("prematching.maxCamDist", 15.0f);
+    float maxDepthScale = (float)mp->_ini.get<double>("prematching.maxDepthScale", 1.5f);
+    bool minMaxDepthDontUseSeeds = mp->_ini.get<bool>("prematching.minMaxDepthDontUseSeeds", false);
+
+    if((seeds->empty()) || minMaxDepthDontUseSeeds)
+    {
+        minDepth = 0.0f;
+        maxDepth = 0.0f;
+        for(int c = 0; c < tcams->size(); c++)
+        {
+            int tc = (*tcams)[c];
+            minDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * minCamDist;
+            maxDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * maxCamDist;
+        }
+        minDepth /= (float)tcams->size();
+        maxDepth /= (float)tcams->size();
+        midDepth = (minDepth + maxDepth) / 2.0f;
+    }
+    else
+    {
+        OrientedPoint rcplane;
+        rcplane.p = mp->CArr[rc];
+        rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
+        rcplane.n = rcplane.n.normalize();
+
+        minDepth = std::numeric_limits<float>::max();
+        maxDepth = -std::numeric_limits<float>::max();
+
+        // StaticVector<sortedId> *sos = new StaticVector<sortedId>();
+        // sos->reserve(seeds->size());
+        // for (int i=0;i<seeds->size();i++) {
+        //	sos->push_back(sortedId(i,pointPlaneDistance((*seeds)[i].op.p,rcplane.p,rcplane.n)));
+        //};
+        // qsort(&(*sos)[0],sos->size(),sizeof(sortedId),qsortCompareSortedIdAsc);
+        // minDepth = (*sos)[(int)((float)sos->size()*0.1f)].value;
+        // maxDepth = (*sos)[(int)((float)sos->size()*0.9f)].value;
+
+        Point3d cg = Point3d(0.0f, 0.0f, 0.0f);
+        for(int i = 0; i < seeds->size(); i++)
+        {
+            SeedPoint* sp = &(*seeds)[i];
+            cg = cg + sp->op.p;
+            float depth = pointPlaneDistance(sp->op.p, rcplane.p, rcplane.n);
+            minDepth = std::min(minDepth, depth);
+            maxDepth = std::max(maxDepth, depth);
+        }
+        cg = cg / (float)seeds->size();
+        midDepth = pointPlaneDistance(cg, rcplane.p, rcplane.n);
+
+        maxDepth = maxDepth * maxDepthScale;
+    }
+
+    delete seeds;
+}
+
+StaticVector<float>* PlaneSweeping::getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth,
+                                                           int scale, int step, int maxDepthsHalf)
+{
+    float d = (float)step;
+
+    OrientedPoint rcplane;
+    rcplane.p = mp->CArr[rc];
+    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
+    rcplane.n = rcplane.n.normalize();
+
+    int ndepthsMidMax = 0;
+    float maxdepth = midDepth;
+    while((maxdepth < maxDepth) && (ndepthsMidMax < maxDepthsHalf))
+    {
+        Point3d p = rcplane.p + rcplane.n * maxdepth;
+        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
+        maxdepth += pixSize;
+        ndepthsMidMax++;
+    }
+
+    int ndepthsMidMin = 0;
+    float mindepth = midDepth;
+    while((mindepth > minDepth) && (ndepthsMidMin < maxDepthsHalf * 2 - ndepthsMidMax))
+    {
+        Point3d p = rcplane.p + rcplane.n * mindepth;
+        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
+        mindepth -= pixSize;
+        ndepthsMidMin++;
+    }
+
+    // getNumberOfDepths
+    float depth = mindepth;
+    int ndepths = 0;
+    float pixSize = 1.0f;
+    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
+    {
+        Point3d p = rcplane.p + rcplane.n * depth;
+        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
+        depth += pixSize;
+        ndepths++;
+    }
+
+    StaticVector<float>* out = new StaticVector<float>();
+    out->reserve(ndepths);
+
+    // fill
+    depth = mindepth;
+    pixSize = 1.0f;
+    ndepths = 0;
+    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
+    {
+        out->push_back(depth);
+        Point3d p = rcplane.p + rcplane.n * depth;
+        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
+        depth += pixSize;
+        ndepths++;
+    }
+
+    // check if it is asc
+    for(int i = 0; i < out->size() - 1; i++)
+    {
+        if((*out)[i] >= (*out)[i + 1])
+        {
+
+            for(int j = 0; j <= i + 1; j++)
+            {
+                ALICEVISION_LOG_TRACE("getDepthsByPixelSize: check if it is asc: " << (*out)[j]);
+            }
+            throw std::runtime_error("getDepthsByPixelSize not asc.");
+        }
+    }
+
+    return out;
+}
+
+StaticVector<float>* PlaneSweeping::getDepthsRcTc(int rc, int tc, int scale, float midDepth,
+                                                    int maxDepthsHalf)
+{
+    OrientedPoint rcplane;
+    rcplane.p = mp->CArr[rc];
+    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
+    rcplane.n = rcplane.n.normalize();
+
+    Point2d rmid = Point2d((float)mp->getWidth(rc) / 2.0f, (float)mp->getHeight(rc) / 2.0f);
+    Point2d pFromTar, pToTar; // segment of epipolar line of the principal point of the rc camera to the tc camera
+    getTarEpipolarDirectedLine(&pFromTar, &pToTar, rmid, rc, tc, mp);
+
+    int allDepths = static_cast<int>((pToTar - pFromTar).size());
+    if(verbose == true)
+    {
+        ALICEVISION_LOG_DEBUG("allDepths: " << allDepths);
+    }
+
+    Point2d pixelVect = ((pToTar - pFromTar).normalize()) * std::max(1.0f, (float)scale);
+
+    Point2d cg = Point2d(0.0f, 0.0f);
+    Point3d cg3 = Point3d(0.0f, 0.0f, 0.0f);
+    int ncg = 0;
+    // navigate through all pixels of the epilolar segment
+    // Compute the middle of the valid pixels of the epipolar segment (in rc camera) of the principal point (of the rc camera)
+    for(int i = 0; i < allDepths; i++)
+    {
+        Point2d tpix = pFromTar + pixelVect * (float)i;
+        Point3d p;
+        if(triangulateMatch(p, rmid, tpix, rc, tc, mp)) // triangulate principal point from rc with tpix
+        {
+            float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n); // todo: can compute the distance to the camera (as it's the principal point it's the same)
+            if( mp->isPixelInImage(tpix, tc)
+                && (depth > 0.0f)
+                && checkPair(p, rc, tc, mp, pc->minang, pc->maxang) )
+            {
+                cg = cg + tpix;
+                cg3 = cg3 + p;
+                ncg++;
+            }
+        }
+    }
+    if(ncg == 0)
+    {
+        return new StaticVector<float>();
+    }
+    cg = cg / (float)ncg;
+    cg3 = cg3 / (float)ncg;
+    allDepths = ncg;
+
+    if(verbose == true)
+    {
+        ALICEVISION_LOG_DEBUG("All correct depths: " << allDepths);
+    }
+
+    Point2d midpoint = cg;
+    if(midDepth > 0.0f)
+    {
+        Point3d midPt = rcplane.p + rcplane.n * midDepth;
+        mp->getPixelFor3DPoint(&midpoint, midPt, tc);
+    }
+
+    // compute the direction
+    float direction = 1.0f;
+    {
+        Point3d p;
+        if(!triangulateMatch(p, rmid, midpoint, rc, tc, mp))
+        {
+            StaticVector<float>* out = new StaticVector<float>();
+            return out;
+        }
+
+        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
+
+        if(!triangulateMatch(p, rmid, midpoint + pixelVect, rc, tc, mp))
+        {
+            StaticVector<float>* out = new StaticVector<float>();
+            return out;
+        }
+
+        float depthP1 = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
+        if(depth > depthP1)
+        {
+            direction = -1.0f;
+        }
+    }
+
+    StaticVector<float>* out1 = new StaticVector<float>();
+    out1->reserve(2 * maxDepthsHalf);
+
+    Point2d tpix = midpoint;
+    float depthOld = -1.0f;
+    int istep = 0;
+    bool ok = true;
+
+    // compute depths for all pixels from the middle point to on one side of the epipolar line
+    while((out1->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
+    {
+        tpix = tpix + pixelVect * direction;
+
+        Point3d refvect = mp->iCamArr[rc] * rmid;
+        Point3d tarvect = mp->iCamArr[tc] * tpix;
+        float rptpang = angleBetwV1andV2(refvect, tarvect);
+
+        Point3d p;
+        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
+
+        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
+        if (mp->isPixelInImage(tpix, tc)
+            && (depth > 0.0f) && (depth > depthOld)
+            && checkPair(p, rc, tc, mp, pc->minang, pc->maxang)
+            && (rptpang > pc->minang)  // WARNING if vects are near parallel thaen this results to strange angles ...
+            && (rptpang < pc->maxang)) // this is the propper angle ... beacause is does not depend on the triangluated p
+        {
+            out1->push_back(depth);
+        }
+        else
+        {
+            ok = false;
+        }
+        depthOld = depth;
+        istep++;
+    }
+
+    StaticVector<float>* out2 = new StaticVector<float>();
+    out2->reserve(2 * maxDepthsHalf);
+    tpix = midpoint;
+    istep = 0;
+    ok = true;
+
+    // compute depths for all pixels from the middle point to the other side of the epipolar line
+    while((out2->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
+    {
+        Point3d refvect = mp->iCamArr[rc] * rmid;
+        Point3d tarvect = mp->iCamArr[tc] * tpix;
+        float rptpang = angleBetwV1andV2(refvect, tarvect);
+
+        Point3d p;
+        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
+
+        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
+        if(mp->isPixelInImage(tpix, tc)
+            && (depth > 0.0f) && (depth < depthOld) 
+            && checkPair(p, rc, tc, mp, pc->minang, pc->maxang)
+            && (rptpang > pc->minang)  // WARNING if vects are near parallel thaen this results to strange angles ...
+            && (rptpang < pc->maxang)) // this is the propper angle ... beacause is does not depend on the triangluated p
+        {
+            out2->push_back(depth);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        depthOld = depth;
+        tpix = tpix - pixelVect * direction;
+    }
+
+    StaticVector<float>* out = new StaticVector<float>();
+    out->reserve(2 * maxDepthsHalf);
+    for(int i = out2->size() - 1; i >= 0; i--)
+    {
+        out->push_back((*out2)[i]);
+    }
+    for(int i = 0; i < out1->size(); i++)
+    {
+        out->push_back((*out1)[i]);
+    }
+
+    delete out2;
+    delete out1;
+
+    // we want to have it in ascending order
+    if((*out)[0] > (*out)[out->size() - 1])
+    {
+        StaticVector<float>* outTmp = new StaticVector<float>();
+        outTmp->reserve(out->size());
+        for(int i = out->size() - 1; i >= 0; i--)
+        {
+            outTmp->push_back((*out)[i]);
+        }
+        delete out;
+        out = outTmp;
+    }
+
+    // check if it is asc
+    for(int i = 0; i < out->size() - 1; i++)
+    {
+        if((*out)[i] > (*out)[i + 1])
+        {
+
+            for(int j = 0; j <= i + 1; j++)
+            {
+                ALICEVISION_LOG_TRACE("getDepthsRcTc: check if it is asc: " << (*out)[j]);
+            }
+            ALICEVISION_LOG_WARNING("getDepthsRcTc: not asc");
+
+            if(out->size() > 1)
+            {
+                qsort(&(*out)[0], out->size(), sizeof(float), qSortCompareFloatAsc);
+            }
+        }
+    }
+
+    if(verbose == true)
+    {
+        ALICEVISION_LOG_DEBUG("used depths: " << out->size());
+    }
+
+    return out;
+}
+
+PlaneSweeping* createPlaneSweeping(int CUDADeviceNo, mvsUtils::ImagesCache* ic, mvsUtils::MultiViewParams* mp,
+                                   mvsUtils::PreMatchCams* pc, int scales)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    if(CUDADeviceNo >= 0)
+        return new PlaneSweepingCuda(CUDADeviceNo, ic, mp, pc, scales);
+#endif
+    if(CUDADeviceNo >= 0)
+        ALICEVISION_LOG_WARNING("AliceVision is built without CUDA, use the CPU plane sweeping instead of CUDA device " << CUDADeviceNo << ".");
+    return new PlaneSweepingCpu(ic, mp, pc, scales);
+}
+
+#if !ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+int listCUDADevices(bool verbose)
+{
+    if(verbose)
+        ALICEVISION_LOG_INFO("AliceVision is built without CUDA.");
+    return 0;
+}
+#endif
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,92 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Plane sweeping backend used by the SGM and Refine steps.
+ *
+ * The depth ranges are computed on the host and shared by all the backends,
+ * the photometric computations are implemented by PlaneSweepingCuda (GPU)
+ * and PlaneSweepingCpu (CPU).
+ */
+class PlaneSweeping
+{
+public:
+    int scales;
+
+    mvsUtils::MultiViewParams* mp;
+    mvsUtils::PreMatchCams* pc;
+    mvsUtils::ImagesCache* ic;
+
+    bool verbose;
+
+    PlaneSweeping(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc, int _scales);
+    virtual ~PlaneSweeping() {}
+
+    void getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth, float& maxDepth);
+    StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
+                                              int step, int maxDepthsHalf = 1024);
+    StaticVector<float>* getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
+
+    virtual bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
+                                int wsh) = 0;
+    virtual bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr,
+                                int wsh) = 0;
+    virtual bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                    StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                                    float gammaP, float epipShift, int xFrom, int wPart) = 0;
+
+    /// Each volume cell keeps the best similarity over all the T cameras (tcams)
+    virtual float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                      int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                                      StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                                      StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                                      float epipShift) = 0;
+    virtual bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                      int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                      unsigned char P1, unsigned char P2) = 0;
+
+    /// @return (free, total, used) memory in MB available for the volumes
+    virtual Point3d getDeviceMemoryInfo() = 0;
+
+    virtual bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                      const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                      int nSamplesHalf, int nDepthsToRefine, float sigma) = 0;
+    virtual bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                    StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                    int nIters, int yFrom, int hPart) = 0;
+    virtual bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) = 0;
+};
+
+/**
+ * @brief Create the plane sweeping backend
+ * @param[in] CUDADeviceNo the CUDA device to use, or -1 for the CPU implementation
+ * @return a new backend (to delete by the caller)
+ */
+PlaneSweeping* createPlaneSweeping(int CUDADeviceNo, mvsUtils::ImagesCache* ic, mvsUtils::MultiViewParams* mp,
+                                   mvsUtils::PreMatchCams* pc, int scales);
+
+/**
+ * @brief List the CUDA devices
+ * @return the number of CUDA devices, 0 if AliceVision is built without CUDA
+ */
+int listCUDADevices(bool verbose);
+
+} // namespace depthMap
+} // namespace aliceVision
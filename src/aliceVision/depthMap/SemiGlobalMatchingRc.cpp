@@ -8,6 +8,7 @@
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRcTc.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingVolume.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/SeedPoint.hpp>
@@ -20,6 +21,7 @@
 #include <boost/filesystem.hpp>
 
 #include <iostream>
+#include <memory>
 
 namespace aliceVision {
 namespace depthMap {
@@ -711,10 +713,10 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
     
     // load images from files into RAM 
     mvsUtils::ImagesCache ic(mp, bandType, true);
-    // load stuff on GPU memory and creates multi-level images and computes gradients
-    PlaneSweepingCuda cps(CUDADeviceNo, &ic, mp, pc, sgmScale);
+    // load stuff on GPU memory (or in RAM for the CPU backend) and creates multi-level images and computes gradients
+    std::unique_ptr<PlaneSweeping> cps(createPlaneSweeping(CUDADeviceNo, &ic, mp, pc, sgmScale));
     // init plane sweeping parameters
-    SemiGlobalMatchingParams sp(mp, pc, &cps);
+    SemiGlobalMatchingParams sp(mp, pc, cps.get());
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
@@ -739,6 +741,14 @@ void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams
     int num_gpus = listCUDADevices(true);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
+
+    if(num_gpus == 0)
+    {
+        ALICEVISION_LOG_INFO("No CUDA device available, use the CPU implementation.");
+        computeDepthMapsPSSGM(-1, mp, pc, cams);
+        return;
+    }
+
     int numthreads = std::min(num_gpus, num_cpu_threads);
 
     int num_gpus_to_use = mp->_ini.get<int>("semiGlobalMatching.num_gpus_to_use", 1);
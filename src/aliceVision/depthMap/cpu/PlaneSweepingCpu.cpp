@@ -0,0 +1,1119 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+struct Lab
+{
+    float x, y, z, w;
+};
+
+inline unsigned char toUChar(float v)
+{
+    return static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, v)));
+}
+
+/// Same conversion as the (unsigned char) cast of the CUDA rgb2lab_kernel:
+/// truncation toward zero, then modulo 256 (negative a/b values are not clamped)
+inline unsigned char castUChar(float v)
+{
+    return static_cast<unsigned char>(static_cast<int>(v));
+}
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+template <typename C1, typename C2>
+inline float colorDistance(const C1& a, const C2& b)
+{
+    const float dx = float(a.x) - float(b.x);
+    const float dy = float(a.y) - float(b.y);
+    const float dz = float(a.z) - float(b.z);
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/// Lab image of one scale, sampled with clamped coordinates
+struct Image
+{
+    int width = 0;
+    int height = 0;
+    std::vector<LabPixel> data;
+
+    inline const LabPixel& at(int x, int y) const
+    {
+        x = std::min(std::max(x, 0), width - 1);
+        y = std::min(std::max(y, 0), height - 1);
+        return data[y * width + x];
+    }
+
+    /// Bilinear interpolation, (x, y) in pixel coordinates
+    inline Lab sample(float x, float y) const
+    {
+        const float fx0 = std::floor(x);
+        const float fy0 = std::floor(y);
+        const float ax = x - fx0;
+        const float ay = y - fy0;
+        const int x0 = static_cast<int>(fx0);
+        const int y0 = static_cast<int>(fy0);
+
+        const LabPixel& p00 = at(x0, y0);
+        const LabPixel& p10 = at(x0 + 1, y0);
+        const LabPixel& p01 = at(x0, y0 + 1);
+        const LabPixel& p11 = at(x0 + 1, y0 + 1);
+
+        const float w00 = (1.0f - ax) * (1.0f - ay);
+        const float w10 = ax * (1.0f - ay);
+        const float w01 = (1.0f - ax) * ay;
+        const float w11 = ax * ay;
+
+        return {w00 * p00.x + w10 * p10.x + w01 * p01.x + w11 * p11.x,
+                w00 * p00.y + w10 * p10.y + w01 * p01.y + w11 * p11.y,
+                w00 * p00.z + w10 * p10.z + w01 * p01.z + w11 * p11.z,
+                w00 * p00.w + w10 * p10.w + w01 * p01.w + w11 * p11.w};
+    }
+};
+
+/// Store the gradient magnitude of L in the w channel
+void computeGradient(Image& img)
+{
+#pragma omp parallel for
+    for(int y = 0; y < img.height; ++y)
+    {
+        for(int x = 0; x < img.width; ++x)
+        {
+            const float dx = float(img.at(x - 1, y).x) - float(img.at(x + 1, y).x);
+            const float dy = float(img.at(x, y - 1).x) - float(img.at(x, y + 1).x);
+            img.data[y * img.width + x].w = toUChar(std::sqrt(dx * dx + dy * dy));
+        }
+    }
+}
+
+/// Gaussian downscale (radius = scale, sigma = 1) of the full resolution image
+void downscale(const Image& img, int scale, Image& out)
+{
+    const int radius = scale;
+    std::vector<float> gaussian(2 * radius + 1);
+    float sum = 0.0f;
+    for(int i = -radius; i <= radius; ++i)
+    {
+        gaussian[i + radius] = std::exp(-float(i * i) / 2.0f);
+        sum += gaussian[i + radius];
+    }
+    const float norm = sum * sum;
+
+    out.width = img.width / scale;
+    out.height = img.height / scale;
+    out.data.resize(out.width * out.height);
+
+#pragma omp parallel for
+    for(int y = 0; y < out.height; ++y)
+    {
+        for(int x = 0; x < out.width; ++x)
+        {
+            Lab acc = {0.0f, 0.0f, 0.0f, 0.0f};
+            for(int i = -radius; i <= radius; ++i)
+            {
+                for(int j = -radius; j <= radius; ++j)
+                {
+                    const float w = gaussian[i + radius] * gaussian[j + radius];
+                    // center of the (scale x scale) block
+                    const Lab c = img.sample(float(x * scale + j) + scale / 2.0f - 0.5f,
+                                             float(y * scale + i) + scale / 2.0f - 0.5f);
+                    acc.x += w * c.x;
+                    acc.y += w * c.y;
+                    acc.z += w * c.z;
+                    acc.w += w * c.w;
+                }
+            }
+            LabPixel& p = out.data[y * out.width + x];
+            p.x = toUChar(acc.x / norm);
+            p.y = toUChar(acc.y / norm);
+            p.z = toUChar(acc.z / norm);
+            p.w = toUChar(acc.w / norm);
+        }
+    }
+}
+
+/// Camera matrices at a given scale (the CUDA cameraStruct)
+struct Camera
+{
+    Matrix3x4 P;
+    Matrix3x3 iP;
+    Point3d C;
+    Point3d zVect;
+
+    Camera(const mvsUtils::MultiViewParams& mp, int c, int scale)
+    {
+        const Matrix3x3 K = diag3x3(1.0 / double(scale), 1.0 / double(scale), 1.0) * mp.KArr[c];
+        P = K * (mp.RArr[c] | (Point3d(0.0, 0.0, 0.0) - mp.RArr[c] * mp.CArr[c]));
+        iP = mp.iRArr[c] * K.inverse();
+        C = mp.CArr[c];
+        zVect = (mp.iRArr[c] * Point3d(0.0, 0.0, 1.0)).normalize();
+    }
+
+    inline Point2d project(const Point3d& X) const
+    {
+        const Point3d h = P * X;
+        return Point2d(h.x / h.z, h.y / h.z);
+    }
+
+    inline Point3d ray(const Point2d& pix) const
+    {
+        return (iP * pix).normalize();
+    }
+
+    inline Point3d pixelTo3D(const Point2d& pix, float depth) const
+    {
+        return C + ray(pix) * depth;
+    }
+};
+
+inline Point2d normalize(const Point2d& v)
+{
+    return v / std::sqrt(v.x * v.x + v.y * v.y);
+}
+
+/// Size of one pixel of the reference camera at the given 3D point
+inline double computeRcPixSize(const Camera& rCam, const Point3d& p)
+{
+    const Point3d v = rCam.ray(rCam.project(p) + Point2d(1.0, 0.0));
+    return cross(v, rCam.C - p).size();
+}
+
+/// Patch oriented between the two cameras (computeRotCSEpip)
+struct Patch
+{
+    Point3d p;
+    Point3d x;
+    Point3d y;
+    double d;
+};
+
+Patch computePatch(const Camera& rCam, const Camera& tCam, const Point3d& p)
+{
+    Patch ptch;
+    ptch.p = p;
+    const Point3d v1 = (rCam.C - p).normalize();
+    const Point3d v2 = (tCam.C - p).normalize();
+    ptch.y = cross(v1, v2).normalize();
+    const Point3d n = ((v1 + v2) / 2.0).normalize();
+    ptch.x = cross(ptch.y, n).normalize();
+    ptch.d = computeRcPixSize(rCam, p);
+    return ptch;
+}
+
+/// Triangulate the reference pixel with a target pixel, the result is on the reference ray
+Point3d triangulateMatchRef(const Camera& rCam, const Camera& tCam, const Point2d& rp, const Point2d& tp)
+{
+    float k, l;
+    Point3d llis, lli1, lli2;
+    lineLineIntersect(&k, &l, &llis, &lli1, &lli2, rCam.C, rCam.C + rCam.iP * rp, tCam.C, tCam.C + tCam.iP * tp);
+    return lli1;
+}
+
+/**
+ * @brief Move the 3D point of a reference pixel along the reference ray by a number of pixels
+ *        of the target camera (useTcOrRcPixSize) or of the reference camera.
+ */
+Point3d movePointByPixels(const Camera& rCam, const Camera& tCam, bool useTcOrRcPixSize, const Point2d& pix,
+                          float depth, float step)
+{
+    const Point3d p = rCam.pixelTo3D(pix, depth);
+    if(useTcOrRcPixSize)
+    {
+        const Point2d rp = rCam.project(p);
+        const Point2d tpo = tCam.project(p);
+        const Point2d tpv = normalize(tCam.project(p + (rCam.C - p) / 2.0) - tpo);
+        return triangulateMatchRef(rCam, tCam, rp, tpo + tpv * step);
+    }
+    return p + (p - rCam.C).normalize() * (step * computeRcPixSize(rCam, p));
+}
+
+inline float computeWSim(float wsum, float xsum, float ysum, float xxsum, float yysum, float xysum)
+{
+    const float varX = (xxsum - xsum * xsum / wsum) / wsum;
+    const float varY = (yysum - ysum * ysum / wsum) / wsum;
+    const float varXY = (xysum - xsum * ysum / wsum) / wsum;
+    float sim = varXY / std::sqrt(varX * varY);
+    sim = std::isinf(sim) ? 1.0f : -sim;
+    // NaN gives 1
+    return std::fmax(std::fmin(sim, 1.0f), -1.0f);
+}
+
+/**
+ * @brief Weighted NCC on the L channel between the projections of a patch in the two cameras
+ *        (compNCCby3DptsYK), -1 is the best similarity and 1 the worst.
+ *
+ * The patch projections are linear in homogeneous coordinates, so all the sample positions
+ * are computed at once in contiguous arrays, then sampled and accumulated.
+ * The buffers are reused between calls: use one instance per thread.
+ */
+class PatchSimilarity
+{
+public:
+    PatchSimilarity(const Image& rImg, const Camera& rCam, const Image& tImg, const Camera& tCam, int wsh,
+                    float gammaC, float gammaP)
+        : _rImg(rImg)
+        , _rCam(rCam)
+        , _tImg(tImg)
+        , _tCam(tCam)
+        , _wsh(wsh)
+        , _gammaC(gammaC)
+    {
+        const int n = (2 * wsh + 1) * (2 * wsh + 1);
+        _rx.resize(n);
+        _ry.resize(n);
+        _tx.resize(n);
+        _ty.resize(n);
+        _rL.resize(n);
+        _tL.resize(n);
+        _w.resize(n);
+        // spatial term of the reference and target weights
+        _spatialW.resize(n);
+        int i = 0;
+        for(int yp = -wsh; yp <= wsh; ++yp)
+            for(int xp = -wsh; xp <= wsh; ++xp, ++i)
+                _spatialW[i] = std::exp(-2.0f * std::sqrt(float(xp * xp + yp * yp)) / gammaP);
+    }
+
+    float compute(const Patch& ptch, float epipShift)
+    {
+        const Point2d rp = _rCam.project(ptch.p);
+        Point2d tp = _tCam.project(ptch.p);
+
+        Point2d shift(0.0, 0.0);
+        if(epipShift != 0.0f)
+        {
+            const Point2d tvUp = normalize(_tCam.project(ptch.p + ptch.y * (ptch.d * 10.0)) - tp);
+            shift = tvUp * epipShift;
+            tp = tp + shift;
+        }
+
+        const double border = _wsh + 2;
+        if(!isInside(rp, _rImg, border) || !isInside(tp, _tImg, border))
+            return 1.0f;
+
+        const Lab gcr = _rImg.sample(rp.x, rp.y);
+        const Lab gct = _tImg.sample(tp.x, tp.y);
+
+        projectPatch(_rCam, ptch, Point2d(0.0, 0.0), _rx.data(), _ry.data());
+        projectPatch(_tCam, ptch, shift, _tx.data(), _ty.data());
+
+        const int n = static_cast<int>(_w.size());
+        const float invGammaC = 1.0f / _gammaC;
+        for(int i = 0; i < n; ++i)
+        {
+            const Lab cr = _rImg.sample(_rx[i], _ry[i]);
+            const Lab ct = _tImg.sample(_tx[i], _ty[i]);
+            _rL[i] = cr.x;
+            _tL[i] = ct.x;
+            _w[i] = _spatialW[i] * std::exp(-(colorDistance(gcr, cr) + colorDistance(gct, ct)) * invGammaC);
+        }
+
+        const float* rL = _rL.data();
+        const float* tL = _tL.data();
+        const float* w = _w.data();
+        float wsum = 0.0f, xsum = 0.0f, ysum = 0.0f, xxsum = 0.0f, yysum = 0.0f, xysum = 0.0f;
+#pragma omp simd reduction(+ : wsum, xsum, ysum, xxsum, yysum, xysum)
+        for(int i = 0; i < n; ++i)
+        {
+            wsum += w[i];
+            xsum += w[i] * rL[i];
+            ysum += w[i] * tL[i];
+            xxsum += w[i] * rL[i] * rL[i];
+            yysum += w[i] * tL[i] * tL[i];
+            xysum += w[i] * rL[i] * tL[i];
+        }
+
+        return computeWSim(wsum, xsum, ysum, xxsum, yysum, xysum);
+    }
+
+private:
+    static bool isInside(const Point2d& p, const Image& img, double border)
+    {
+        return (p.x >= border) && (p.x <= img.width - 1 - border) && (p.y >= border) &&
+               (p.y <= img.height - 1 - border);
+    }
+
+    /// Projections of the patch samples p + x*d*xp + y*d*yp
+    void projectPatch(const Camera& cam, const Patch& ptch, const Point2d& shift, float* xs, float* ys) const
+    {
+        const Point3d h0 = cam.P * ptch.p;
+        const Point3d hx = cam.P * (ptch.p + ptch.x * ptch.d) - h0;
+        const Point3d hy = cam.P * (ptch.p + ptch.y * ptch.d) - h0;
+        const int size = 2 * _wsh + 1;
+        for(int yp = -_wsh; yp <= _wsh; ++yp)
+        {
+            const float h0x = h0.x + hy.x * yp;
+            const float h0y = h0.y + hy.y * yp;
+            const float h0z = h0.z + hy.z * yp;
+            const float hxx = hx.x;
+            const float hxy = hx.y;
+            const float hxz = hx.z;
+            const float sx = shift.x;
+            const float sy = shift.y;
+            float* rowX = xs + (yp + _wsh) * size;
+            float* rowY = ys + (yp + _wsh) * size;
+#pragma omp simd
+            for(int i = 0; i < size; ++i)
+            {
+                const float xp = float(i - _wsh);
+                const float hz = h0z + hxz * xp;
+                rowX[i] = (h0x + hxx * xp) / hz + sx;
+                rowY[i] = (h0y + hxy * xp) / hz + sy;
+            }
+        }
+    }
+
+    const Image& _rImg;
+    const Camera& _rCam;
+    const Image& _tImg;
+    const Camera& _tCam;
+    const int _wsh;
+    const float _gammaC;
+    std::vector<float> _spatialW;
+    std::vector<float> _rx, _ry, _tx, _ty, _rL, _tL, _w;
+};
+
+/// Sub-pixel depth from the similarities of 3 consecutive depths (parabola fitting)
+float refineDepthSubPixel(const Point3d& depths, const Point3d& sims)
+{
+    const float simM1 = (sims.x + 1.0f) / 2.0f;
+    const float sim = (sims.y + 1.0f) / 2.0f;
+    const float simP1 = (sims.z + 1.0f) / 2.0f;
+
+    float outDepth = -1.0f;
+    if((simM1 > sim) && (simP1 > sim))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim)));
+        const float b = (depths.z + depths.x) / 2.0f;
+        const float a = b - depths.x;
+        outDepth = a * dispStep + b;
+    }
+    return outDepth;
+}
+
+} // namespace
+
+LabPixel rgb2lab(const rgb& c)
+{
+    const float r = c.r / 255.0f;
+    const float g = c.g / 255.0f;
+    const float b = c.b / 255.0f;
+
+    // sRGB (D65) to XYZ
+    const float X = (0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / 0.95047f;
+    const float Y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    const float Z = (0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / 1.08883f;
+
+    const auto f = [](float t) {
+        return (t > 216.0f / 24389.0f) ? std::cbrt(t) : ((24389.0f / 27.0f) * t + 16.0f) / 116.0f;
+    };
+    const float fx = f(X);
+    const float fy = f(Y);
+    const float fz = f(Z);
+
+    LabPixel lab;
+    lab.x = castUChar(2.55f * (116.0f * fy - 16.0f));
+    lab.y = castUChar(2.55f * (500.0f * (fx - fy)));
+    lab.z = castUChar(2.55f * (200.0f * (fy - fz)));
+    return lab;
+}
+
+void fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                                          const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nSamplesHalf,
+                                          int nDepthsToRefine, float sigma)
+{
+    const float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
+    const float twoTimesSigmaPowerTwo = 2.0f * sigma * sigma;
+    const int nMaps = dataMaps.size();
+
+    // dataMaps[0]: (midDepth, pixSize), dataMaps[1..]: (depth, sim)
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const int i = y * w + x;
+            const DepthSim& midDepthPixSize = (*dataMaps[0])[i];
+            if(midDepthPixSize.depth <= 0.0f)
+            {
+                oDepthSimMap[i] = DepthSim(-1.0f, 1.0f);
+                continue;
+            }
+
+            const float stepSize = midDepthPixSize.sim / samplesPerPixSize;
+            int bestSample = -nSamplesHalf;
+            float bestGsv = 0.0f;
+            for(int s = -nSamplesHalf; s <= nSamplesHalf; ++s)
+            {
+                float gsvSample = 0.0f;
+                for(int c = 1; c < nMaps; ++c)
+                {
+                    const DepthSim& depthSim = (*dataMaps[c])[i];
+                    if(depthSim.depth > 0.0f)
+                    {
+                        const float depthSampleId = (midDepthPixSize.depth - depthSim.depth) / stepSize;
+                        const float d = depthSampleId - float(s);
+                        gsvSample += -sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.sim) *
+                                     std::exp(-(d * d) / twoTimesSigmaPowerTwo);
+                    }
+                }
+                if((s == -nSamplesHalf) || (gsvSample < bestGsv))
+                {
+                    bestGsv = gsvSample;
+                    bestSample = s;
+                }
+            }
+            oDepthSimMap[i] = DepthSim(midDepthPixSize.depth - float(bestSample) * stepSize, bestGsv);
+        }
+    }
+}
+
+struct PlaneSweepingCpu::CameraImages
+{
+    int rc = -1;
+    long lastUse = 0;
+    /// one image per scale
+    std::vector<Image> levels;
+};
+
+PlaneSweepingCpu::PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
+                                   mvsUtils::PreMatchCams* _pc, int _scales)
+    : PlaneSweeping(_ic, _mp, _pc, _scales)
+{
+    const int maxImageWidth = mp->getMaxImageWidth();
+    const int maxImageHeight = mp->getMaxImageHeight();
+
+    float oneimagemb = 4.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
+    for(int scale = 2; scale <= scales; ++scale)
+    {
+        oneimagemb += 4.0 * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0) / 1024.0);
+    }
+    const float maxmbCPU = 1024.0f;
+    nImgsInMemAtTime = (int)(maxmbCPU / oneimagemb);
+    nImgsInMemAtTime = std::max(2, std::min(mp->ncams, nImgsInMemAtTime));
+
+    varianceWSH = mp->_ini.get<int>("global.varianceWSH", 4);
+
+    ALICEVISION_LOG_INFO("PlaneSweepingCpu:" << std::endl
+                         << "\t- nImgsInMemAtTime: " << nImgsInMemAtTime << std::endl
+                         << "\t- scales: " << scales << std::endl
+                         << "\t- varianceWSH: " << varianceWSH);
+
+    cams.resize(nImgsInMemAtTime);
+    for(auto& cam : cams)
+        cam.reset(new CameraImages());
+}
+
+PlaneSweepingCpu::~PlaneSweepingCpu() = default;
+
+const PlaneSweepingCpu::CameraImages& PlaneSweepingCpu::getCameraImages(int rc)
+{
+    ++camsTime;
+
+    auto it = std::find_if(cams.begin(), cams.end(),
+                           [rc](const std::unique_ptr<CameraImages>& cam) { return cam->rc == rc; });
+    if(it != cams.end())
+    {
+        (*it)->lastUse = camsTime;
+        return **it;
+    }
+
+    // replace the least recently used camera
+    CameraImages& cam = **std::min_element(cams.begin(), cams.end(),
+                                           [](const std::unique_ptr<CameraImages>& a,
+                                              const std::unique_ptr<CameraImages>& b) {
+                                               return a->lastUse < b->lastUse;
+                                           });
+    long t1 = clock();
+
+    const int width = mp->getWidth(rc);
+    const int height = mp->getHeight(rc);
+
+    // the images cache is not thread safe
+    std::vector<rgb> colors(width * height);
+    ic->refreshData(rc);
+    Pixel pix;
+    for(pix.y = 0; pix.y < height; ++pix.y)
+        for(pix.x = 0; pix.x < width; ++pix.x)
+            colors[pix.y * width + pix.x] = ic->getPixelValue(pix, rc);
+
+    cam.rc = rc;
+    cam.lastUse = camsTime;
+    cam.levels.resize(scales);
+
+    Image& img = cam.levels[0];
+    img.width = width;
+    img.height = height;
+    img.data.resize(width * height);
+
+#pragma omp parallel for
+    for(int i = 0; i < width * height; ++i)
+        img.data[i] = rgb2lab(colors[i]);
+
+    if(varianceWSH > 0)
+        computeGradient(img);
+
+    for(int scale = 2; scale <= scales; ++scale)
+    {
+        downscale(img, scale, cam.levels[scale - 1]);
+        if(varianceWSH > 0)
+            computeGradient(cam.levels[scale - 1]);
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1, "load image and compute the Lab pyramid ");
+
+    return cam;
+}
+
+bool PlaneSweepingCpu::smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
+                                      float igammaP, int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    const Image& rImg = getCameraImages(rc).levels[scale - 1];
+    const Camera rCam(*mp, rc, scale);
+
+    const std::vector<float> depths = depthMap->getData();
+    const auto depthAt = [&](int x, int y) {
+        return depths[std::min(std::max(y, 0), h - 1) * w + std::min(std::max(x, 0), w - 1)];
+    };
+
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = depths[y * w + x];
+            if(depth <= 0.0f)
+                continue;
+
+            const float pixSize = (rCam.pixelTo3D(Point2d(x, y), depth) -
+                                   rCam.pixelTo3D(Point2d(x + 1, y), depth)).size();
+            const LabPixel& gcr = rImg.at(x, y);
+
+            float wsum = 0.0f;
+            float dsum = 0.0f;
+            for(int yp = -wsh; yp <= wsh; ++yp)
+            {
+                for(int xp = -wsh; xp <= wsh; ++xp)
+                {
+                    const float depthn = depthAt(x + xp, y + yp);
+                    if((depthn > 0.0f) && (std::abs(depthn - depth) < 10.0f * pixSize))
+                    {
+                        const float deltaC = colorDistance(gcr, rImg.at(x + xp, y + yp));
+                        const float deltaP = std::sqrt(float(xp * xp + yp * yp));
+                        const float weight = std::exp(-(deltaC / igammaC + deltaP / igammaP));
+                        wsum += weight;
+                        dsum += weight * depthn;
+                    }
+                }
+            }
+            (*depthMap)[y * w + x] = dsum / wsum;
+        }
+    }
+    return true;
+}
+
+bool PlaneSweepingCpu::filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
+                                      float minCostThr, int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    const Image& rImg = getCameraImages(rc).levels[scale - 1];
+    const Camera rCam(*mp, rc, scale);
+
+    const std::vector<float> depths = depthMap->getData();
+    const auto depthAt = [&](int x, int y) {
+        return depths[std::min(std::max(y, 0), h - 1) * w + std::min(std::max(x, 0), w - 1)];
+    };
+
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = depths[y * w + x];
+            if(depth <= 0.0f)
+                continue;
+
+            const float pixSize = (rCam.pixelTo3D(Point2d(x, y), depth) -
+                                   rCam.pixelTo3D(Point2d(x + 1, y), depth)).size();
+            const LabPixel& gcr = rImg.at(x, y);
+
+            float wsum = 0.0f;
+            for(int yp = -wsh; yp <= wsh; ++yp)
+            {
+                for(int xp = -wsh; xp <= wsh; ++xp)
+                {
+                    const float depthn = depthAt(x + xp, y + yp);
+                    if((depthn > 0.0f) && (std::abs(depthn - depth) < 10.0f * pixSize))
+                        wsum += std::exp(-colorDistance(gcr, rImg.at(x + xp, y + yp)) / igammaC);
+                }
+            }
+            if(wsum < minCostThr)
+                (*depthMap)[y * w + x] = -1.0f;
+        }
+    }
+    return true;
+}
+
+bool PlaneSweepingCpu::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                          StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
+                                          float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
+{
+    const int w = wPart;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    const Image& rImg = getCameraImages(rc).levels[scale - 1];
+    const Image& tImg = getCameraImages(tc).levels[scale - 1];
+    const Camera rCam(*mp, rc, scale);
+    const Camera tCam(*mp, tc, scale);
+
+#pragma omp parallel
+    {
+        PatchSimilarity patchSim(rImg, rCam, tImg, tCam, wsh, gammaC, gammaP);
+
+        const auto computeSim = [&](const Point3d& p) {
+            return patchSim.compute(computePatch(rCam, tCam, p), epipShift);
+        };
+
+#pragma omp for schedule(dynamic)
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const Point2d pix(x + xFrom, y);
+                const float depth = (*rcDepthMap)[y * w + x];
+
+                float bestDepth = depth;
+                float bestSim = 1.0f;
+                for(int i = 0; i < nStepsToRefine; ++i)
+                {
+                    const float step = float(i - (nStepsToRefine - 1) / 2);
+                    float odpt = depth;
+                    float osim = 1.0f;
+                    if(depth > 0.0f)
+                    {
+                        const Point3d p = movePointByPixels(rCam, tCam, useTcOrRcPixSize, pix, depth, step);
+                        odpt = (p - rCam.C).size();
+                        osim = computeSim(p);
+                    }
+                    if((i == 0) || (osim < bestSim))
+                    {
+                        bestDepth = odpt;
+                        bestSim = osim;
+                    }
+                }
+
+                float outDepth = bestDepth;
+                if(bestDepth > 0.0f)
+                {
+                    const Point3d pm1 = movePointByPixels(rCam, tCam, useTcOrRcPixSize, pix, bestDepth, -1.0f);
+                    const Point3d pp1 = movePointByPixels(rCam, tCam, useTcOrRcPixSize, pix, bestDepth, +1.0f);
+                    const Point3d depths((pm1 - rCam.C).size(), bestDepth, (pp1 - rCam.C).size());
+                    const Point3d sims(computeSim(pm1), bestSim, computeSim(pp1));
+                    const float refinedDepth = refineDepthSubPixel(depths, sims);
+                    if(refinedDepth > 0.0f)
+                        outDepth = refinedDepth;
+                }
+
+                (*rcDepthMap)[y * w + x] = outDepth;
+                (*simMap)[y * w + x] = bestSim;
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, StaticVector<float>* depths, int rc, int wsh, float gammaC,
+                                            float gammaP, StaticVector<Voxel>* pixels, int scale, int step,
+                                            StaticVector<int>* tcams, float epipShift)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsVolume:" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- step: " << step << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- volStepXY: " << volStepXY << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return -1.0f;
+
+    long t1 = clock();
+
+    const Camera rCam(*mp, rc, scale);
+
+    std::vector<unsigned char>& vol = volume->getDataWritable();
+    std::fill(vol.begin(), vol.end(), 255);
+
+    const int npixels = pixels->size();
+    const int ndepths = depths->size();
+
+    // each T camera is swept in turn and each volume cell keeps the best similarity
+    // (min, as volume_saveSliceToVolume_kernel)
+    for(int c = 0; c < tcams->size(); ++c)
+    {
+        const int tc = (*tcams)[c];
+        const Image& rImg = getCameraImages(rc).levels[scale - 1];
+        const Image& tImg = getCameraImages(tc).levels[scale - 1];
+        const Camera tCam(*mp, tc, scale);
+
+        // each pixel owns its column of the volume
+#pragma omp parallel
+        {
+            PatchSimilarity patchSim(rImg, rCam, tImg, tCam, wsh, gammaC, gammaP);
+
+#pragma omp for schedule(dynamic, 16)
+            for(int i = 0; i < npixels; ++i)
+            {
+                const Voxel& pixel = (*pixels)[i];
+                const int vx = (pixel.x - volLUX) / volStepXY;
+                const int vy = (pixel.y - volLUY) / volStepXY;
+                if((vx < 0) || (vx >= volDimX) || (vy < 0) || (vy >= volDimY))
+                    continue;
+
+                const Point3d rayVect = rCam.ray(Point2d(pixel.x, pixel.y));
+                for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+                {
+                    const int depthid = sdptid + pixel.z;
+                    if(depthid >= ndepths)
+                        break;
+                    const int vz = depthid - volLUZ;
+                    if((vz < 0) || (vz >= volDimZ))
+                        continue;
+
+                    const float fpPlaneDepth = (*depths)[depthid];
+                    const Point3d p = linePlaneIntersect(rCam.C, rayVect, rCam.C + rCam.zVect * fpPlaneDepth, rCam.zVect);
+                    const float sim = patchSim.compute(computePatch(rCam, tCam, p), epipShift);
+                    const unsigned char simUChar =
+                        static_cast<unsigned char>(std::min(1.0f, std::max(0.0f, (sim + 1.0f) / 2.0f)) * 255.0f);
+
+                    unsigned char& v = vol[(std::size_t(vz) * volDimY + vy) * volDimX + vx];
+                    v = std::min(v, simUChar);
+                }
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return (float)volDimX * (float)volDimY * (float)volDimZ / (1024.0f * 1024.0f);
+}
+
+/**
+ * @param[inout] volume input similarity volume (after Z reduction)
+ */
+bool PlaneSweepingCpu::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                            int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                            unsigned char P1, unsigned char P2)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("SGM optimizing volume:" << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    long t1 = clock();
+
+    const Image& rImg = getCameraImages(rc).levels[scale - 1];
+
+    // P2 depends on the color gradient along the path (as in the CUDA kernel)
+    (void)P2;
+
+    const std::vector<unsigned char> sim = volume->getData();
+    std::vector<unsigned char>& agr = volume->getDataWritable();
+    const std::size_t sliceSize = std::size_t(volDimX) * volDimY;
+
+    // 4 paths: along y, y inverted, x, x inverted
+    for(int path = 0; path < 4; ++path)
+    {
+        const bool alongX = (path >= 2);
+        const bool invert = (path % 2 == 1);
+        const int nPositions = alongX ? volDimX : volDimY;
+        const int nLanes = alongX ? volDimY : volDimX;
+
+#pragma omp parallel
+        {
+            std::vector<unsigned int> prevCosts(volDimZ);
+            std::vector<unsigned int> costs(volDimZ);
+
+#pragma omp for
+            for(int lane = 0; lane < nLanes; ++lane)
+            {
+                const LabPixel* prevColor = nullptr;
+                for(int i = 0; i < nPositions; ++i)
+                {
+                    const int pos = invert ? nPositions - 1 - i : i;
+                    const int vx = alongX ? pos : lane;
+                    const int vy = alongX ? lane : pos;
+                    const std::size_t xyOffset = std::size_t(vy) * volDimX + vx;
+                    const LabPixel& color = rImg.at(volLUX + vx * volStepXY, volLUY + vy * volStepXY);
+
+                    if(i == 0)
+                    {
+                        for(int z = 0; z < volDimZ; ++z)
+                            costs[z] = sim[z * sliceSize + xyOffset];
+                    }
+                    else
+                    {
+                        const unsigned int p2 =
+                            (unsigned int)sigmoid(15.0f, 255.0f, 80.0f, 20.0f, colorDistance(color, *prevColor));
+                        const unsigned int bestCost = *std::min_element(prevCosts.begin(), prevCosts.end());
+
+                        costs[0] = 255;
+                        costs[volDimZ - 1] = 255;
+                        for(int z = 1; z < volDimZ - 1; ++z)
+                        {
+                            unsigned int minCost = std::min(prevCosts[z], prevCosts[z - 1] + P1);
+                            minCost = std::min(minCost, prevCosts[z + 1] + P1);
+                            minCost = std::min(minCost, bestCost + p2);
+                            costs[z] = sim[z * sliceSize + xyOffset] + minCost - bestCost;
+                        }
+                    }
+
+                    for(int z = 0; z < volDimZ; ++z)
+                    {
+                        const float pathCost = (i == 0) ? 255.0f : float(std::min(255u, costs[z]));
+                        unsigned char& v = agr[z * sliceSize + xyOffset];
+                        v = static_cast<unsigned char>(std::fmin(255.0f, (float(v) * path + pathCost) / (path + 1)));
+                    }
+
+                    std::swap(prevCosts, costs);
+                    prevColor = &color;
+                }
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+Point3d PlaneSweepingCpu::getDeviceMemoryInfo()
+{
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const double freeMB = double(memInfo.freeRam) / (1024.0 * 1024.0);
+    const double totalMB = double(memInfo.totalRam) / (1024.0 * 1024.0);
+    return Point3d(freeMB, totalMB, totalMB - freeMB);
+}
+
+bool PlaneSweepingCpu::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                            int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    long t1 = clock();
+
+    depthMap::fuseDepthSimMapsGaussianKernelVoting(w, h, *oDepthSimMap, *dataMaps, nSamplesHalf, nDepthsToRefine,
+                                                   sigma);
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                          StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                          int nIters, int yFrom, int hPart)
+{
+    long t1 = clock();
+
+    const int w = mp->getWidth(rc);
+    const int h = hPart;
+
+    const Image& rImg = getCameraImages(rc).levels[0];
+    const Camera rCam(*mp, rc, 1);
+
+    const StaticVector<DepthSim>& midDepthPixSizeMap = *(*dataMaps)[0];
+    const StaticVector<DepthSim>& fusedDepthSimMap = *(*dataMaps)[1];
+
+    // optimized (depth, sim) of the part, the iterations use the depths of the previous one
+    std::vector<DepthSim> optDepthSimMap(w * h);
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            optDepthSimMap[y * w + x] =
+                DepthSim(midDepthPixSizeMap[(y + yFrom) * w + x].depth, fusedDepthSimMap[(y + yFrom) * w + x].sim);
+    std::vector<DepthSim> nextDepthSimMap(optDepthSimMap);
+
+    // (smooth step, energy) of a pixel from its 4 neighbours
+    const auto getCellSmoothStepEnergy = [&](int x, int y) {
+        const float d0 = optDepthSimMap[y * w + x].depth;
+        if(d0 <= 0.0f)
+            return DepthSim(0.0f, 180.0f);
+
+        const Point3d p0 = rCam.pixelTo3D(Point2d(x, y + yFrom), d0);
+
+        // left, right, up, bottom
+        const int neighbours[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        Point3d pts[4];
+        bool valid[4];
+        Point3d cg(0.0, 0.0, 0.0);
+        int n = 0;
+        for(int k = 0; k < 4; ++k)
+        {
+            const int xn = std::min(std::max(x + neighbours[k][0], 0), w - 1);
+            const int yn = std::min(std::max(y + neighbours[k][1], 0), h - 1);
+            const float dn = optDepthSimMap[yn * w + xn].depth;
+            valid[k] = (dn > 0.0f);
+            if(valid[k])
+            {
+                pts[k] = rCam.pixelTo3D(Point2d(xn, yn + yFrom), dn);
+                cg = cg + pts[k];
+                ++n;
+            }
+        }
+
+        float smoothStep = 0.0f;
+        if(n > 1)
+        {
+            cg = cg / double(n);
+            const Point3d vect = (rCam.C - p0).normalize();
+            const Point3d cgOnRay = closestPointToLine3D(&cg, &p0, &vect);
+            smoothStep = (rCam.C - cgOnRay).size() - d0;
+        }
+
+        float energy = 180.0f;
+        float e = 0.0f;
+        bool ok = false;
+        for(int k = 0; k < 4; k += 2)
+        {
+            if(valid[k] && valid[k + 1])
+            {
+                e = std::max(e, 180.0f - float(angleBetwABandAC(p0, pts[k], pts[k + 1])));
+                ok = true;
+            }
+        }
+        if(ok)
+            energy = e;
+
+        return DepthSim(smoothStep, energy);
+    };
+
+    for(int iter = 0; iter < nIters; ++iter)
+    {
+#pragma omp parallel for
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const DepthSim& midDepthPixSize = midDepthPixSizeMap[(y + yFrom) * w + x];
+                const DepthSim& fusedDepthSim = fusedDepthSimMap[(y + yFrom) * w + x];
+                DepthSim optDepthSim = optDepthSimMap[y * w + x];
+
+                const float depthOpt = optDepthSim.depth;
+                if(depthOpt > 0.0f)
+                {
+                    const float maxStep = midDepthPixSize.sim / 10.0f;
+                    const DepthSim depthSmoothStepEnergy = getCellSmoothStepEnergy(x, y);
+                    const float depthSmoothStep = std::max(-maxStep, std::min(maxStep, depthSmoothStepEnergy.depth));
+                    const float depthPhotoStep =
+                        std::max(-maxStep, std::min(maxStep, fusedDepthSim.depth - depthOpt));
+                    const float depthVisStep = midDepthPixSize.depth - depthOpt;
+
+                    const float depthSmoothVal = depthSmoothStepEnergy.sim;
+                    const float depthPhotoStepVal = fusedDepthSim.sim;
+
+                    const float varianceGray = rImg.at(x, y + yFrom).w;
+                    const float varianceGrayAndleWeight = sigmoid2(5.0f, 30.0f, 40.0f, 20.0f, varianceGray);
+                    const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthPhotoStepVal);
+                    const float photoWeight = sigmoid(0.0f, 1.0f, 30.0f, varianceGrayAndleWeight, depthSmoothVal);
+                    const float smoothWeight = 1.0f - photoWeight;
+                    const float visWeight =
+                        1.0f - sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::abs(depthVisStep / midDepthPixSize.sim));
+
+                    const float depthOptStep =
+                        visWeight * depthVisStep +
+                        (1.0f - visWeight) * (photoWeight * simWeight * depthPhotoStep + smoothWeight * depthSmoothStep);
+
+                    optDepthSim.depth = depthOpt + depthOptStep;
+                    optDepthSim.sim = (1.0f - visWeight) * photoWeight * simWeight * depthPhotoStepVal +
+                                      (1.0f - visWeight) * smoothWeight * (depthSmoothVal / 20.0f);
+                }
+                nextDepthSimMap[y * w + x] = optDepthSim;
+            }
+        }
+        std::swap(optDepthSimMap, nextDepthSimMap);
+    }
+
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            (*oDepthSimMap)[(y + yFrom) * w + x] = optDepthSimMap[y * w + x];
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    const Image& rImg = getCameraImages(rc).levels[scale - 1];
+    const LabPixel maskColorLab = rgb2lab(maskColor);
+
+    const int wStep = w / step;
+    const int hStep = h / step;
+
+#pragma omp parallel for
+    for(int y = 0; y < hStep; ++y)
+    {
+        for(int x = 0; x < wStep; ++x)
+        {
+            const LabPixel& color = rImg.at(x * step, y * step);
+            (*oMap)[y * wStep + x] =
+                (color.x == maskColorLab.x) && (color.y == maskColorLab.y) && (color.z == maskColorLab.z);
+        }
+    }
+    return true;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
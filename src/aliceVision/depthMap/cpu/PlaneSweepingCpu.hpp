@@ -0,0 +1,106 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/// Lab color (x: L, y: a, z: b) and gradient magnitude (w), as in the CUDA textures
+struct LabPixel
+{
+    unsigned char x = 0;
+    unsigned char y = 0;
+    unsigned char z = 0;
+    unsigned char w = 0;
+};
+
+/**
+ * @brief Convert a color to Lab (scaled by 2.55) exactly as the CUDA rgb2lab_kernel
+ * @note The gradient magnitude (w) is left to 0.
+ */
+LabPixel rgb2lab(const rgb& c);
+
+/**
+ * @brief Fuse the (depth, sim) maps with a gaussian kernel voting around the mid depths
+ *        (CPU version of ps_fuseDepthSimMapsGaussianKernelVoting)
+ * @param[in] w, h The maps dimensions
+ * @param[out] oDepthSimMap The fused (depth, sim) map, of size w * h
+ * @param[in] dataMaps (midDepth, pixSize) map followed by the (depth, sim) maps to fuse
+ * @param[in] nSamplesHalf The number of depth samples on each side of the mid depth
+ * @param[in] nDepthsToRefine The number of refined depths per pixel size
+ * @param[in] sigma The gaussian kernel sigma (in samples)
+ */
+void fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                                          const StaticVector<StaticVector<DepthSim>*>& dataMaps, int nSamplesHalf,
+                                          int nDepthsToRefine, float sigma);
+
+/**
+ * @brief CPU implementation of the plane sweeping kernels (OpenMP).
+ *
+ * It follows the CUDA kernels: the images are converted to Lab (+ gradient magnitude
+ * in the 4th channel) at each scale and the similarity is the weighted NCC
+ * computed on a patch oriented between the two cameras.
+ * The patch samples are computed in contiguous arrays so the NCC accumulation is vectorized.
+ */
+class PlaneSweepingCpu : public PlaneSweeping
+{
+public:
+    PlaneSweepingCpu(mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc,
+                     int _scales);
+    ~PlaneSweepingCpu() override;
+
+    bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
+                        int wsh) override;
+    bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr,
+                        int wsh) override;
+    bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                            StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                            float gammaP, float epipShift, int xFrom, int wPart) override;
+
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                              StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                              float epipShift) override;
+    bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1,
+                              unsigned char P2) override;
+
+    Point3d getDeviceMemoryInfo() override;
+
+    bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                              const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                              int nSamplesHalf, int nDepthsToRefine, float sigma) override;
+    bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                            StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nIters,
+                                            int yFrom, int hPart) override;
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) override;
+
+private:
+    /// Lab images of a camera at all the scales
+    struct CameraImages;
+
+    /**
+     * @brief Get the images of a camera, loaded from the images cache if needed
+     * @note The least recently used camera is replaced, so the images of the
+     *       nImgsInMemAtTime last requested cameras stay valid.
+     */
+    const CameraImages& getCameraImages(int rc);
+
+    int varianceWSH;
+    int nImgsInMemAtTime;
+    long camsTime = 0;
+    std::vector<std::unique_ptr<CameraImages>> cams;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -978,12 +978,6 @@ void ps_computeSimilarityVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     cudaBindTextureToArray(r4tex, ps_texs_arr[cams[0]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
-    int c = 1;
-    ps_init_target_camera_matrices(cams[c]->P, cams[c]->iP, cams[c]->R, cams[c]->iR, cams[c]->K, cams[c]->iK,
-                                   cams[c]->C);
-    cudaBindTextureToArray(t4tex, ps_texs_arr[cams[c]->camId * scales + scale]->getArray(),
-                           cudaCreateChannelDesc<uchar4>());
-
     //--------------------------------------------------------------------------------------------------
     // init similarity volume
     for(int z = 0; z < volDimZ; z++)
@@ -995,23 +989,33 @@ void ps_computeSimilarityVolume(CudaArray<uchar4, 2>** ps_texs_arr,
 
     //--------------------------------------------------------------------------------------------------
     // compute similarity volume
+    // each target camera is swept in turn, volume_saveSliceToVolume_kernel keeps the best similarity
     CudaDeviceMemoryPitched<unsigned char, 2> slice_dmp(CudaSize<2>(nDepthsToSearch, slicesAtTime));
-    for(int t = 0; t < ntimes; t++)
+    for(int c = 1; c < ncams; c++)
     {
-        volume_slice_kernel<<<grid, block>>>(slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch, nDepths,
-                                             slicesAtTime, width, height, wsh, t, npixs, gammaC, gammaP, epipShift);
-        cudaThreadSynchronize();
+        ps_init_target_camera_matrices(cams[c]->P, cams[c]->iP, cams[c]->R, cams[c]->iR, cams[c]->K, cams[c]->iK,
+                                       cams[c]->C);
+        cudaBindTextureToArray(t4tex, ps_texs_arr[cams[c]->camId * scales + scale]->getArray(),
+                               cudaCreateChannelDesc<uchar4>());
 
-        volume_saveSliceToVolume_kernel<<<grid, block>>>(vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0],
-                                                         slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch,
-                                                         nDepths, slicesAtTime, width, height, t, npixs, volStepXY,
-                                                         volDimX, volDimY, volDimZ, volLUX, volLUY, volLUZ);
-        cudaThreadSynchronize();
-        CHECK_CUDA_ERROR();
+        for(int t = 0; t < ntimes; t++)
+        {
+            volume_slice_kernel<<<grid, block>>>(slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch, nDepths,
+                                                 slicesAtTime, width, height, wsh, t, npixs, gammaC, gammaP, epipShift);
+            cudaThreadSynchronize();
+
+            volume_saveSliceToVolume_kernel<<<grid, block>>>(vol_dmp.getBuffer(), vol_dmp.stride()[1], vol_dmp.stride()[0],
+                                                             slice_dmp.getBuffer(), slice_dmp.stride()[0], nDepthsToSearch,
+                                                             nDepths, slicesAtTime, width, height, t, npixs, volStepXY,
+                                                             volDimX, volDimY, volDimZ, volLUX, volLUY, volLUZ);
+            cudaThreadSynchronize();
+            CHECK_CUDA_ERROR();
+        };
+
+        cudaUnbindTexture(t4tex);
     };
 
     cudaUnbindTexture(r4tex);
-    cudaUnbindTexture(t4tex);
     cudaUnbindTexture(volPixsTex);
     cudaUnbindTexture(depthsTex);
 
@@ -2851,15 +2855,12 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odep
 void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
                                            CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
                                            CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
-                                           int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
-                                           cameraStruct** cams, int ncams, int width, int height, int scale,
+                                           int nIters, cameraStruct** cams, int ncams, int width, int height, int scale,
                                            int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom)
 {
     clock_t tall = tic();
     testCUDAdeviceNo(CUDAdeviceNo);
 
-    float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
-
     ///////////////////////////////////////////////////////////////////////////////
     // setup block and grid
     int block_size = 16;
@@ -2899,7 +2900,7 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
         fuse_optimizeDepthSimMap_kernel<<<grid, block>>>(optDepthSimMap_dmp.getBuffer(), optDepthSimMap_dmp.stride()[0],
                                                          dataMaps_dmp[0]->getBuffer(), dataMaps_dmp[0]->stride()[0],
                                                          dataMaps_dmp[1]->getBuffer(), dataMaps_dmp[1]->stride()[0],
-                                                         width, height, iter, samplesPerPixSize, yFrom);
+                                                         width, height, iter, yFrom);
         cudaThreadSynchronize();
 
         cudaUnbindTexture(depthsTex);
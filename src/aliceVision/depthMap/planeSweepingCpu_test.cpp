@@ -0,0 +1,85 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE planeSweepingCpu
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_rgb2lab)
+{
+  // reference values of the CUDA rgb2lab_kernel (float to unsigned char cast, no clamping)
+  const std::vector<rgb> colors = {rgb(0, 0, 0), rgb(255, 0, 0), rgb(0, 255, 0), rgb(0, 0, 255), rgb(128, 64, 32)};
+  const std::vector<std::vector<int>> labs = {{0, 0, 0}, {135, 204, 171}, {223, 37, 212}, {82, 201, 237}, {156, 37, 71}};
+
+  for(std::size_t i = 0; i < colors.size(); ++i)
+  {
+    const LabPixel lab = rgb2lab(colors[i]);
+    BOOST_CHECK_EQUAL(int(lab.x), labs[i][0]);
+    BOOST_CHECK_EQUAL(int(lab.y), labs[i][1]);
+    BOOST_CHECK_EQUAL(int(lab.z), labs[i][2]);
+    BOOST_CHECK_EQUAL(int(lab.w), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_fuseDepthSimMapsGaussianKernelVoting)
+{
+  const int w = 3;
+  const int h = 2;
+  const int nSamplesHalf = 150;
+  const int nDepthsToRefine = 31;
+  const float sigma = 2.0f;
+  // 10 samples per pixel size
+  const float stepSize = 0.1f;
+
+  StaticVector<DepthSim> midDepthPixSizeMap;
+  StaticVector<DepthSim> goodMap;
+  StaticVector<DepthSim> badMap;
+  midDepthPixSizeMap.resize(w * h, DepthSim(10.0f, 1.0f));
+  goodMap.resize(w * h, DepthSim(-1.0f, 1.0f));
+  badMap.resize(w * h, DepthSim(-1.0f, 1.0f));
+
+  // reference fused map
+  StaticVector<DepthSim> refMap;
+  refMap.resize(w * h, DepthSim(-1.0f, 1.0f));
+
+  for(int i = 0; i < w * h; ++i)
+  {
+    // the depths are on the samples: the best sample has the depth of the similar map
+    const int sample = i - 2;
+    goodMap[i] = DepthSim(10.0f - sample * stepSize, -1.0f);
+    badMap[i] = DepthSim(10.0f + 5.0f * stepSize, 1.0f);
+    refMap[i].depth = goodMap[i].depth;
+  }
+
+  // no mid depth: no fused depth
+  midDepthPixSizeMap[w * h - 1] = DepthSim(-1.0f, 1.0f);
+  refMap[w * h - 1] = DepthSim(-1.0f, 1.0f);
+
+  StaticVector<StaticVector<DepthSim>*> dataMaps;
+  dataMaps.push_back(&midDepthPixSizeMap);
+  dataMaps.push_back(&goodMap);
+  dataMaps.push_back(&badMap);
+
+  StaticVector<DepthSim> fusedMap;
+  fusedMap.resize(w * h);
+  fuseDepthSimMapsGaussianKernelVoting(w, h, fusedMap, dataMaps, nSamplesHalf, nDepthsToRefine, sigma);
+
+  for(int i = 0; i < w * h; ++i)
+  {
+    BOOST_CHECK_CLOSE(fusedMap[i].depth, refMap[i].depth, 1e-3);
+    if(refMap[i].depth > 0.0f)
+      BOOST_CHECK_LT(fusedMap[i].sim, -0.9f);
+    else
+      BOOST_CHECK_EQUAL(fusedMap[i].sim, 1.0f);
+  }
+}
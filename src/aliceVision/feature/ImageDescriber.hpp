@@ -185,6 +185,17 @@ public:
   {
     regions->LoadFeatures(sfileNameFeats);
   }
+
+  // IO - one binary file for region features and descriptors
+
+  void LoadBinary(Regions* regions,
+    const std::string& sfileNameRegions) const
+  {
+    regions->LoadBinary(sfileNameRegions);
+  }
+
+  void SaveBinary(const Regions* regions,
+    const std::string& sfileNameRegions) const;
 };
 
 /**
@@ -11,6 +11,7 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/feature/binaryRegionsIO.hpp>
 #include <aliceVision/matching/metric.hpp>
 
 #include <string>
@@ -66,6 +67,24 @@ public:
   virtual void LoadFeatures(
     const std::string& sfileNameFeats) = 0;
 
+  //--
+  // IO - one binary file for region features and descriptors (see BinaryRegionsHeader)
+  //--
+
+  virtual void LoadBinary(const std::string& sfileNameRegions) = 0;
+
+  virtual void SaveBinary(const std::string& sfileNameRegions) const = 0;
+
+  virtual void LoadFeaturesBinary(const std::string& sfileNameRegions) = 0;
+
+  /**
+   * @brief Create read-only regions of the same type, directly backed
+   *        by the memory-mapped binary regions file (no copy).
+   * @param[in] sfileNameRegions The binary regions file (.regions)
+   * @return the mapped regions
+   */
+  virtual Regions* MappedClone(const std::string& sfileNameRegions) const = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
@@ -83,6 +102,9 @@ public:
   /// Return the number of defined regions
   virtual std::size_t RegionCount() const = 0;
 
+  /// Return the memory used by the features and descriptors (in bytes)
+  virtual std::size_t MemorySize() const = 0;
+
   /**
    * @brief Return a blind pointer to the container of the descriptors array.
    *
@@ -239,6 +261,26 @@ public:
     saveDescsToBinFile(sfileNameDescs, _vec_descs);
   }
 
+  /// Read the regions and their corresponding descriptors from a binary regions file.
+  void LoadBinary(const std::string& sfileNameRegions) override
+  {
+    loadRegionsFromBinFile(sfileNameRegions, this->_vec_feats, &_vec_descs);
+  }
+
+  /// Export the regions and their corresponding descriptors in a binary regions file.
+  void SaveBinary(const std::string& sfileNameRegions) const override
+  {
+    saveRegionsToBinFile(sfileNameRegions, this->_vec_feats, _vec_descs);
+  }
+
+  /// Read only the regions from a binary regions file.
+  void LoadFeaturesBinary(const std::string& sfileNameRegions) override
+  {
+    loadRegionsFromBinFile<FeatT, DescriptorT>(sfileNameRegions, this->_vec_feats, nullptr);
+  }
+
+  Regions* MappedClone(const std::string& sfileNameRegions) const override;
+
   /// Mutable and non-mutable DescriptorT getters.
   inline std::vector<DescriptorT> & Descriptors() { return _vec_descs; }
   inline const std::vector<DescriptorT> & Descriptors() const { return _vec_descs; }
@@ -249,6 +291,11 @@ public:
 
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
+  std::size_t MemorySize() const override
+  {
+    return this->_vec_feats.capacity() * sizeof(FeatT) + _vec_descs.capacity() * sizeof(DescriptorT);
+  }
+
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
@@ -317,6 +364,199 @@ public:
   }
 };
 
+/**
+ * @brief Read-only regions backed by a memory-mapped binary regions file.
+ *
+ * Features and descriptors are used in place from the mapped file.
+ * All the regions created from it (EmptyClone, createFilteredRegions)
+ * are regular FeatDescRegions.
+ *
+ * @note It is not a FeatRegions, so getSIOPointFeatures() returns an empty vector
+ *       and code relying on a dynamic_cast to FeatDescRegions needs loaded regions.
+ */
+template<typename FeatT, typename T, std::size_t L, ERegionType regionType>
+class MappedRegions : public Regions
+{
+public:
+  typedef MappedRegions<FeatT, T, L, regionType> This;
+  /// Owning regions type
+  typedef FeatDescRegions<FeatT, T, L, regionType> OwningRegionsT;
+  typedef FeatT FeatureT;
+  typedef Descriptor<T, L> DescriptorT;
+
+  explicit MappedRegions(const std::string& sfileNameRegions)
+    : _file(new MappedFile(sfileNameRegions))
+  {
+    if(_file->size() < sizeof(BinaryRegionsHeader))
+      throw std::runtime_error("Invalid regions binary file '" + sfileNameRegions + "', can't read the header.");
+
+    const BinaryRegionsHeader& header = *reinterpret_cast<const BinaryRegionsHeader*>(_file->data());
+    checkBinaryRegionsHeader(header, sfileNameRegions, sizeof(FeatureT), L, sizeof(T));
+
+    checkBinaryRegionsFileSize(header, sfileNameRegions, _file->size());
+
+    _count = header.count;
+    _feats = reinterpret_cast<const FeatureT*>(_file->data() + header.featuresOffset);
+    _descs = reinterpret_cast<const DescriptorT*>(_file->data() + header.descriptorsOffset);
+  }
+
+  void Load(const std::string&, const std::string&) override
+  {
+    throw std::logic_error("Can't load files in read-only memory-mapped regions.");
+  }
+
+  void LoadFeatures(const std::string&) override
+  {
+    throw std::logic_error("Can't load files in read-only memory-mapped regions.");
+  }
+
+  void LoadBinary(const std::string&) override
+  {
+    throw std::logic_error("Can't load files in read-only memory-mapped regions.");
+  }
+
+  void LoadFeaturesBinary(const std::string&) override
+  {
+    throw std::logic_error("Can't load files in read-only memory-mapped regions.");
+  }
+
+  void Save(const std::string& sfileNameFeats, const std::string& sfileNameDescs) const override
+  {
+    toOwningRegions().Save(sfileNameFeats, sfileNameDescs);
+  }
+
+  void SaveDesc(const std::string& sfileNameDescs) const override
+  {
+    toOwningRegions().SaveDesc(sfileNameDescs);
+  }
+
+  void SaveBinary(const std::string& sfileNameRegions) const override
+  {
+    toOwningRegions().SaveBinary(sfileNameRegions);
+  }
+
+  Regions* MappedClone(const std::string& sfileNameRegions) const override
+  {
+    return new This(sfileNameRegions);
+  }
+
+  std::string Type_id() const override {return typeid(T).name();}
+  std::size_t DescriptorLength() const override {return static_cast<std::size_t>(L);}
+
+  bool IsScalar() const override { return regionType == ERegionType::Scalar; }
+  bool IsBinary() const override { return regionType == ERegionType::Binary; }
+
+  PointFeatures GetRegionsPositions() const override
+  {
+    return PointFeatures(_feats, _feats + _count);
+  }
+
+  Vec2 GetRegionPosition(std::size_t i) const override
+  {
+    return Vec2f(_feats[i].coords()).cast<double>();
+  }
+
+  std::size_t RegionCount() const override { return _count; }
+
+  /// Mapped data (resident once accessed)
+  std::size_t MemorySize() const override
+  {
+    return _count * sizeof(FeatureT) + ((_descs != nullptr) ? _count * sizeof(DescriptorT) : 0);
+  }
+
+  /// Non-mutable features and descriptors getters (contiguous arrays of RegionCount() elements).
+  inline const FeatureT* FeaturesData() const { return _feats; }
+  inline const DescriptorT* DescriptorsData() const { return _descs; }
+
+  /// The descriptors are not stored in an std::vector, use DescriptorRawData() instead
+  const void* blindDescriptors() const override
+  {
+    throw std::logic_error("No descriptors container in read-only memory-mapped regions.");
+  }
+
+  const void* DescriptorRawData() const override { return _descs; }
+
+  void clearDescriptors() override
+  {
+    _descs = nullptr;
+  }
+
+  double SquaredDescriptorDistance(std::size_t i, const Regions* genericRegions, std::size_t j) const override
+  {
+    assert(i < _count);
+    assert(genericRegions);
+    assert(j < genericRegions->RegionCount());
+
+    // works with both mapped and owning regions of the same type
+    const T* descJ = reinterpret_cast<const T*>(genericRegions->DescriptorRawData()) + j * L;
+    static typename SquaredMetric<T, regionType>::Metric metric;
+    return metric(_descs[i].getData(), descJ, L);
+  }
+
+  /**
+   * @brief Add the Inth region to another Region container
+   * @param[in] i: index of the region to copy
+   * @param[out] outRegionContainer: the output region group (owning regions, see EmptyClone)
+   */
+  void CopyRegion(std::size_t i, Regions* outRegionContainer) const override
+  {
+    assert(i < _count);
+    OwningRegionsT* outRegions = static_cast<OwningRegionsT*>(outRegionContainer);
+    outRegions->Features().push_back(_feats[i]);
+    outRegions->Descriptors().push_back(_descs[i]);
+  }
+
+  Regions* EmptyClone() const override
+  {
+    return new OwningRegionsT();
+  }
+
+  std::unique_ptr<Regions> createFilteredRegions(
+                     const std::vector<FeatureInImage>& featuresInImage,
+                     std::vector<IndexT>& out_associated3dPoint,
+                     std::map<IndexT, IndexT>& out_mapFullToLocal) const override
+  {
+    out_associated3dPoint.clear();
+    out_mapFullToLocal.clear();
+
+    OwningRegionsT* regionsPtr = new OwningRegionsT;
+    std::unique_ptr<Regions> regions(regionsPtr);
+    regionsPtr->Features().reserve(featuresInImage.size());
+    regionsPtr->Descriptors().reserve(featuresInImage.size());
+    out_associated3dPoint.reserve(featuresInImage.size());
+    for(std::size_t i = 0; i < featuresInImage.size(); ++i)
+    {
+      const FeatureInImage & feat = featuresInImage[i];
+      regionsPtr->Features().push_back(_feats[feat._featureIndex]);
+      regionsPtr->Descriptors().push_back(_descs[feat._featureIndex]);
+      out_mapFullToLocal[feat._featureIndex] = i;
+      out_associated3dPoint.push_back(feat._point3dId);
+    }
+    return regions;
+  }
+
+private:
+
+  OwningRegionsT toOwningRegions() const
+  {
+    OwningRegionsT regions;
+    regions.Features().assign(_feats, _feats + _count);
+    if(_descs != nullptr)
+      regions.Descriptors().assign(_descs, _descs + _count);
+    return regions;
+  }
+
+  std::shared_ptr<MappedFile> _file;
+  std::size_t _count = 0;
+  const FeatureT* _feats = nullptr;
+  const DescriptorT* _descs = nullptr;
+};
+
+template<typename FeatT, typename T, std::size_t L, ERegionType regionType>
+Regions* FeatDescRegions<FeatT, T, L, regionType>::MappedClone(const std::string& sfileNameRegions) const
+{
+  return new MappedRegions<FeatT, T, L, regionType>(sfileNameRegions);
+}
 
 template<typename FeatT, typename T, std::size_t L>
 using ScalarRegions = FeatDescRegions<FeatT, T, L, ERegionType::Scalar>;
@@ -0,0 +1,161 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryRegionsIO.hpp"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstring>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+const char BINARY_REGIONS_MAGIC[8] = {'A', 'V', 'R', 'E', 'G', 'I', 'O', 'N'};
+
+inline std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + BINARY_REGIONS_ALIGNMENT - 1) / BINARY_REGIONS_ALIGNMENT * BINARY_REGIONS_ALIGNMENT;
+}
+
+} // namespace
+
+BinaryRegionsHeader createBinaryRegionsHeader(std::size_t featureSize,
+                                              std::size_t descriptorLength,
+                                              std::size_t descriptorElementSize,
+                                              std::size_t count)
+{
+  BinaryRegionsHeader header;
+  std::memcpy(header.magic, BINARY_REGIONS_MAGIC, sizeof(header.magic));
+  header.version = BINARY_REGIONS_VERSION;
+  header.featureSize = static_cast<std::uint32_t>(featureSize);
+  header.descriptorLength = static_cast<std::uint32_t>(descriptorLength);
+  header.descriptorElementSize = static_cast<std::uint32_t>(descriptorElementSize);
+  header.count = count;
+  header.featuresOffset = alignOffset(sizeof(BinaryRegionsHeader));
+  header.descriptorsOffset = alignOffset(header.featuresOffset + header.count * header.featureSize);
+  return header;
+}
+
+void checkBinaryRegionsHeader(const BinaryRegionsHeader& header,
+                              const std::string& filename,
+                              std::size_t featureSize,
+                              std::size_t descriptorLength,
+                              std::size_t descriptorElementSize)
+{
+  if(std::memcmp(header.magic, BINARY_REGIONS_MAGIC, sizeof(header.magic)) != 0)
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', wrong file signature.");
+
+  if(header.version != BINARY_REGIONS_VERSION)
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', unsupported version " + std::to_string(header.version) + ".");
+
+  if(header.featureSize != featureSize ||
+     header.descriptorLength != descriptorLength ||
+     header.descriptorElementSize != descriptorElementSize)
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', regions type mismatch.");
+
+  if(header.featuresOffset % BINARY_REGIONS_ALIGNMENT != 0 ||
+     header.descriptorsOffset % BINARY_REGIONS_ALIGNMENT != 0 ||
+     header.descriptorsOffset < header.featuresOffset ||
+     header.count > (header.descriptorsOffset - header.featuresOffset) / header.featureSize)
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', corrupted header.");
+}
+
+void checkBinaryRegionsFileSize(const BinaryRegionsHeader& header,
+                                const std::string& filename,
+                                std::uint64_t fileSize)
+{
+  // compare by division to avoid overflows with a corrupted count
+  const std::uint64_t descriptorSize = header.descriptorSize();
+  if(fileSize < header.descriptorsOffset ||
+     (descriptorSize > 0 && header.count > (fileSize - header.descriptorsOffset) / descriptorSize))
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', truncated file.");
+}
+
+BinaryRegionsHeader readBinaryRegionsHeader(std::istream& stream,
+                                            const std::string& filename,
+                                            std::size_t featureSize,
+                                            std::size_t descriptorLength,
+                                            std::size_t descriptorElementSize)
+{
+  BinaryRegionsHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(BinaryRegionsHeader));
+
+  if(!stream.good())
+    throw std::runtime_error("Invalid regions binary file '" + filename + "', can't read the header.");
+
+  checkBinaryRegionsHeader(header, filename, featureSize, descriptorLength, descriptorElementSize);
+  return header;
+}
+
+void writeBinaryRegionsFile(const std::string& filename,
+                            const BinaryRegionsHeader& header,
+                            const void* features,
+                            const void* descriptors)
+{
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save regions binary file, can't open '" + filename + "' !");
+
+  const std::vector<char> padding(BINARY_REGIONS_ALIGNMENT, 0);
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryRegionsHeader));
+  file.write(padding.data(), header.featuresOffset - sizeof(BinaryRegionsHeader));
+
+  const std::uint64_t featuresSize = header.count * header.featureSize;
+  if(featuresSize > 0)
+    file.write(reinterpret_cast<const char*>(features), featuresSize);
+  file.write(padding.data(), header.descriptorsOffset - header.featuresOffset - featuresSize);
+
+  const std::uint64_t descriptorsSize = header.count * header.descriptorSize();
+  if(descriptorsSize > 0)
+    file.write(reinterpret_cast<const char*>(descriptors), descriptorsSize);
+
+  if(!file.good())
+    throw std::runtime_error("Can't save regions binary file, '" + filename + "' is incorrect !");
+}
+
+struct MappedFile::Impl
+{
+  boost::iostreams::mapped_file_source source;
+};
+
+MappedFile::MappedFile(const std::string& filename)
+  : _impl(new Impl)
+{
+  try
+  {
+    _impl->source.open(filename);
+  }
+  catch(const std::exception& e)
+  {
+    throw std::runtime_error("Can't map file '" + filename + "' in memory: " + e.what());
+  }
+
+  if(!_impl->source.is_open())
+    throw std::runtime_error("Can't map file '" + filename + "' in memory.");
+}
+
+MappedFile::~MappedFile()
+{
+  if(_impl->source.is_open())
+    _impl->source.close();
+}
+
+const char* MappedFile::data() const
+{
+  return _impl->source.data();
+}
+
+std::size_t MappedFile::size() const
+{
+  return _impl->source.size();
+}
+
+} // namespace feature
+} // namespace aliceVision
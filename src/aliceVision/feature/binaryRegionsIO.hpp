@@ -0,0 +1,219 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+/// Version of the binary regions file format (.regions)
+static const std::uint32_t BINARY_REGIONS_VERSION = 1;
+
+/// Alignment in bytes of the features and descriptors arrays in a binary regions file
+static const std::size_t BINARY_REGIONS_ALIGNMENT = 64;
+
+/**
+ * @brief Header of a binary regions file (.regions).
+ *
+ * A binary regions file stores the features and the descriptors of one view:
+ * - the header,
+ * - the features array (raw FeatT values) at featuresOffset,
+ * - the descriptors array (raw DescriptorT values) at descriptorsOffset.
+ *
+ * Both arrays start on a BINARY_REGIONS_ALIGNMENT boundary,
+ * so they can be used in place once the file is memory-mapped.
+ * Values are stored with the native endianness.
+ */
+struct BinaryRegionsHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  /// size in bytes of one feature
+  std::uint32_t featureSize;
+  /// number of elements of one descriptor
+  std::uint32_t descriptorLength;
+  /// size in bytes of one descriptor element
+  std::uint32_t descriptorElementSize;
+  /// number of regions
+  std::uint64_t count;
+  /// position in bytes of the features array
+  std::uint64_t featuresOffset;
+  /// position in bytes of the descriptors array
+  std::uint64_t descriptorsOffset;
+
+  /// @return the size in bytes of one descriptor
+  std::size_t descriptorSize() const
+  {
+    return static_cast<std::size_t>(descriptorLength) * descriptorElementSize;
+  }
+};
+
+/**
+ * @brief Create a binary regions file header with the arrays offsets
+ * @param[in] featureSize The size in bytes of one feature
+ * @param[in] descriptorLength The number of elements of one descriptor
+ * @param[in] descriptorElementSize The size in bytes of one descriptor element
+ * @param[in] count The number of regions
+ * @return the header
+ */
+BinaryRegionsHeader createBinaryRegionsHeader(std::size_t featureSize,
+                                              std::size_t descriptorLength,
+                                              std::size_t descriptorElementSize,
+                                              std::size_t count);
+
+/**
+ * @brief Read and check the header of a binary regions file
+ * @param[in,out] stream The input binary stream, positioned at the beginning of the file
+ * @param[in] filename The file name (for error messages)
+ * @param[in] featureSize The expected size in bytes of one feature
+ * @param[in] descriptorLength The expected number of elements of one descriptor
+ * @param[in] descriptorElementSize The expected size in bytes of one descriptor element
+ * @return the header
+ * @throw std::runtime_error if the header is invalid or does not correspond to the expected regions type
+ */
+BinaryRegionsHeader readBinaryRegionsHeader(std::istream& stream,
+                                            const std::string& filename,
+                                            std::size_t featureSize,
+                                            std::size_t descriptorLength,
+                                            std::size_t descriptorElementSize);
+
+/**
+ * @brief Check the header of a binary regions file
+ * @see readBinaryRegionsHeader
+ */
+void checkBinaryRegionsHeader(const BinaryRegionsHeader& header,
+                              const std::string& filename,
+                              std::size_t featureSize,
+                              std::size_t descriptorLength,
+                              std::size_t descriptorElementSize);
+
+/**
+ * @brief Check that a binary regions file is large enough for the arrays described by its header
+ * @param[in] header The checked file header (see checkBinaryRegionsHeader)
+ * @param[in] filename The file name (for error messages)
+ * @param[in] fileSize The file size in bytes
+ * @throw std::runtime_error if the file is truncated or the regions count is corrupted
+ */
+void checkBinaryRegionsFileSize(const BinaryRegionsHeader& header,
+                                const std::string& filename,
+                                std::uint64_t fileSize);
+
+/**
+ * @brief Write a binary regions file
+ * @param[in] filename The file name (usually .regions)
+ * @param[in] header The file header (see createBinaryRegionsHeader)
+ * @param[in] features Pointer to the features array
+ * @param[in] descriptors Pointer to the descriptors array (can be null if header.count is 0)
+ */
+void writeBinaryRegionsFile(const std::string& filename,
+                            const BinaryRegionsHeader& header,
+                            const void* features,
+                            const void* descriptors);
+
+/**
+ * @brief Read-only memory-mapped file
+ */
+class MappedFile
+{
+public:
+  /**
+   * @brief Map a file in memory
+   * @param[in] filename The file to map
+   * @throw std::runtime_error if the file can't be mapped
+   */
+  explicit MappedFile(const std::string& filename);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /// @return a pointer to the first byte of the file
+  const char* data() const;
+
+  /// @return the file size in bytes
+  std::size_t size() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+
+/**
+ * @brief Load features and descriptors from a binary regions file.
+ * @param[in] sfileNameRegions The file name (usually .regions)
+ * @param[out] vec_feats The loaded features
+ * @param[out] vec_descs The loaded descriptors (if null, only the features are read)
+ */
+template<typename FeatureT, typename DescriptorT>
+void loadRegionsFromBinFile(const std::string& sfileNameRegions,
+                            std::vector<FeatureT>& vec_feats,
+                            std::vector<DescriptorT>* vec_descs)
+{
+  std::ifstream fileIn(sfileNameRegions.c_str(), std::ios::in | std::ios::binary);
+
+  if(!fileIn.is_open())
+    throw std::runtime_error("Can't load regions binary file, can't open '" + sfileNameRegions + "' !");
+
+  const BinaryRegionsHeader header = readBinaryRegionsHeader(fileIn, sfileNameRegions,
+                                                             sizeof(FeatureT),
+                                                             DescriptorT::static_size,
+                                                             sizeof(typename DescriptorT::bin_type));
+
+  // check the regions count against the file size before any allocation
+  fileIn.seekg(0, std::ios::end);
+  checkBinaryRegionsFileSize(header, sfileNameRegions, static_cast<std::uint64_t>(fileIn.tellg()));
+
+  vec_feats.resize(header.count);
+  fileIn.seekg(header.featuresOffset);
+  fileIn.read(reinterpret_cast<char*>(vec_feats.data()), header.count * sizeof(FeatureT));
+
+  if(vec_descs != nullptr)
+  {
+    vec_descs->resize(header.count);
+    fileIn.seekg(header.descriptorsOffset);
+    fileIn.read(reinterpret_cast<char*>(vec_descs->data()), header.count * sizeof(DescriptorT));
+  }
+
+  if(!fileIn.good())
+    throw std::runtime_error("Can't load regions binary file, '" + sfileNameRegions + "' is incorrect !");
+}
+
+/**
+ * @brief Save features and descriptors in a binary regions file.
+ * @param[in] sfileNameRegions The file name (usually .regions)
+ * @param[in] vec_feats The features
+ * @param[in] vec_descs The descriptors (same size as the features)
+ */
+template<typename FeatureT, typename DescriptorT>
+void saveRegionsToBinFile(const std::string& sfileNameRegions,
+                          const std::vector<FeatureT>& vec_feats,
+                          const std::vector<DescriptorT>& vec_descs)
+{
+  if(vec_feats.size() != vec_descs.size())
+    throw std::runtime_error("Can't save regions binary file '" + sfileNameRegions + "', features and descriptors count mismatch !");
+
+  static_assert(sizeof(DescriptorT) == DescriptorT::static_size * sizeof(typename DescriptorT::bin_type),
+                "Descriptor type should be a plain array of values.");
+
+  const BinaryRegionsHeader header = createBinaryRegionsHeader(sizeof(FeatureT),
+                                                               DescriptorT::static_size,
+                                                               sizeof(typename DescriptorT::bin_type),
+                                                               vec_feats.size());
+
+  writeBinaryRegionsFile(sfileNameRegions, header, vec_feats.data(), vec_descs.data());
+}
+
+} // namespace feature
+} // namespace aliceVision
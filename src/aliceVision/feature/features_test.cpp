@@ -7,9 +7,11 @@
 
 #include "aliceVision/feature/feature.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <iterator>
+#include <limits>
 #include <vector>
 
 #define BOOST_TEST_MODULE Feature
@@ -122,3 +124,81 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//--
+//-- Binary regions interface test
+//--
+BOOST_AUTO_TEST_CASE(regionsIO_BINARY) {
+  SIFT_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(SIOPointFeature(i, i*2, i*3, i*4));
+    SIFT_Regions::DescriptorT desc;
+    for(int j = 0; j < 128; ++j)
+      desc[j] = (i + j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+
+  //Save them to a file
+  BOOST_CHECK_NO_THROW(regions.SaveBinary("tempRegions.regions"));
+
+  //Read the saved data and compare to input (to check write/read IO)
+  SIFT_Regions regionsRead;
+  BOOST_CHECK_NO_THROW(regionsRead.LoadBinary("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, regionsRead.RegionCount());
+  BOOST_CHECK_EQUAL(CARD, regionsRead.Descriptors().size());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(regions.Features()[i], regionsRead.Features()[i]);
+    BOOST_CHECK(regions.Descriptors()[i] == regionsRead.Descriptors()[i]);
+  }
+
+  //Read only the features
+  SIFT_Regions featuresRead;
+  BOOST_CHECK_NO_THROW(featuresRead.LoadFeaturesBinary("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, featuresRead.RegionCount());
+  BOOST_CHECK(featuresRead.Descriptors().empty());
+
+  //Use the memory-mapped file and compare to input
+  std::unique_ptr<Regions> mappedRegions(regions.MappedClone("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, mappedRegions->RegionCount());
+
+  const SIFT_Regions::DescriptorT* mappedDescs = reinterpret_cast<const SIFT_Regions::DescriptorT*>(mappedRegions->DescriptorRawData());
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(regions.GetRegionPosition(i), mappedRegions->GetRegionPosition(i));
+    BOOST_CHECK(regions.Descriptors()[i] == mappedDescs[i]);
+    BOOST_CHECK_EQUAL(0.0, mappedRegions->SquaredDescriptorDistance(i, &regions, i));
+  }
+
+  //Try to read the file with another regions type
+  AKAZE_Float_Regions akazeRegions;
+  BOOST_CHECK_THROW(akazeRegions.LoadBinary("tempRegions.regions"), std::exception);
+
+  //Read the whole file to build corrupted copies
+  std::ifstream fileIn("tempRegions.regions", std::ios::in | std::ios::binary);
+  const std::vector<char> fileData((std::istreambuf_iterator<char>(fileIn)), std::istreambuf_iterator<char>());
+  fileIn.close();
+
+  //Truncated file
+  {
+    std::ofstream fileOut("tempRegionsTruncated.regions", std::ios::out | std::ios::binary);
+    fileOut.write(fileData.data(), fileData.size() - sizeof(SIFT_Regions::DescriptorT));
+  }
+  SIFT_Regions truncatedRead;
+  BOOST_CHECK_THROW(truncatedRead.LoadBinary("tempRegionsTruncated.regions"), std::exception);
+  BOOST_CHECK_THROW(regions.MappedClone("tempRegionsTruncated.regions"), std::exception);
+
+  //Corrupted regions count (must be rejected before any allocation)
+  {
+    BinaryRegionsHeader header;
+    std::memcpy(&header, fileData.data(), sizeof(BinaryRegionsHeader));
+    header.count = std::numeric_limits<std::uint64_t>::max() / 2;
+    std::vector<char> corruptedData = fileData;
+    std::memcpy(corruptedData.data(), &header, sizeof(BinaryRegionsHeader));
+    std::ofstream fileOut("tempRegionsCorrupted.regions", std::ios::out | std::ios::binary);
+    fileOut.write(corruptedData.data(), corruptedData.size());
+  }
+  SIFT_Regions corruptedRead;
+  BOOST_CHECK_THROW(corruptedRead.LoadBinary("tempRegionsCorrupted.regions"), std::exception);
+  BOOST_CHECK_THROW(regions.MappedClone("tempRegionsCorrupted.regions"), std::exception);
+}
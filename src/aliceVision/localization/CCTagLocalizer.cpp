@@ -293,6 +293,7 @@ bool CCTagLocalizer::localize(const feature::MapRegionsPerDesc & genQueryRegions
   timer.reset();
   // estimate the pose
   resectionData.error_max = param->_errorMax;
+  resectionData.nfaMode = param->_nfaMode;
   ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
   const bool bResection = sfm::SfMLocalizer::Localize(imageSize,
                                                       // pass the input intrinsic if they are valid, null otherwise
@@ -11,6 +11,7 @@
 #include <aliceVision/camera/PinholeRadial.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
 #include <aliceVision/localization/LocalizationResult.hpp>
 
 namespace aliceVision {
@@ -26,6 +27,7 @@ struct LocalizerParameters
     , _errorMax(std::numeric_limits<double>::infinity())
     , _resectionEstimator(robustEstimation::ERobustEstimator::ACRANSAC)
     , _matchingEstimator(robustEstimation::ERobustEstimator::ACRANSAC)
+    , _nfaMode(robustEstimation::EACRansacNFA::EXACT)
     , _useLocalizeRigNaive(false)
     , _angularThreshold(degreeToRadian(0.1))
   {}
@@ -46,6 +48,8 @@ struct LocalizerParameters
   robustEstimation::ERobustEstimator _resectionEstimator;
   /// the type of *sac framework to use for matching
   robustEstimation::ERobustEstimator _matchingEstimator;
+  /// the NFA evaluation of the A Contrario estimations (resection and matching)
+  robustEstimation::EACRansacNFA _nfaMode;
   /// force the use of the rig localization without openGV
   bool _useLocalizeRigNaive;
   /// in rad, it is the maximum angular error for the opengv rig resection
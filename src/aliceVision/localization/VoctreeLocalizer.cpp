@@ -357,11 +357,12 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
       }
 
       // Load from files
-      std::unique_ptr<feature::Regions> currRegions = sfm::loadRegions(featuresFolders, id_view, *imageDescriber);
+      // the regions are only quantized and filtered, so a binary regions file is used in place (memory-mapped)
+      std::unique_ptr<feature::Regions> currRegions = sfm::loadRegions(featuresFolders, id_view, *imageDescriber, true);
 
       if(descType == _voctreeDescType)
       {
-        voctree::SparseHistogram histo = _voctree->quantizeToSparse(currRegions->blindDescriptors());
+        voctree::SparseHistogram histo = _voctree->quantizeToSparse(currRegions->DescriptorRawData(), currRegions->RegionCount());
 #pragma omp critical
         {
           _database.insert(id_view, histo);
@@ -397,7 +398,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
   // pass the descriptors through the vocabulary tree to get the visual words
   // associated to each feature
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
+  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->DescriptorRawData(), queryRegions.at(_voctreeDescType)->RegionCount());
   
   // Request closest images from voctree
   std::vector<voctree::DocMatch> matchedImages;
@@ -467,7 +468,8 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                                       queryImageSize,
                                       std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
                                       featureMatches,
-                                      param._matchingEstimator);
+                                      param._matchingEstimator,
+                                      param._nfaMode);
     if (!matchWorked)
     {
       ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
@@ -534,6 +536,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
     // estimate the pose
     // Do the resectioning: compute the camera pose.
     resectionData.error_max = param._errorMax;
+    resectionData.nfaMode = param._nfaMode;
     ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
     bool bResection = sfm::SfMLocalizer::Localize(queryImageSize,
                                                    // pass the input intrinsic if they are valid, null otherwise
@@ -650,6 +653,7 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
   // estimate the pose
   // Do the resectioning: compute the camera pose.
   resectionData.error_max = param._errorMax;
+  resectionData.nfaMode = param._nfaMode;
   ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
   const bool bResection = sfm::SfMLocalizer::Localize(queryImageSize,
                                                       // pass the input intrinsic if they are valid, null otherwise
@@ -762,7 +766,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
     ALICEVISION_LOG_WARNING("[database]\t No feature type " << feature::EImageDescriberType_enumToString(_voctreeDescType) << " in query region.");
     return;
   }
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
+  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->DescriptorRawData(), queryRegions.at(_voctreeDescType)->RegionCount());
   
   // Request closest images from voctree
   _database.find(requestImageWords, (param._numResults==0) ? (_database.size()) : (param._numResults) , out_matchedImages);
@@ -835,7 +839,8 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                       imageSize,
                                       std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
                                       featureMatches,
-                                      param._matchingEstimator);
+                                      param._matchingEstimator,
+                                      param._nfaMode);
     if (!matchWorked)
     {
 //      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
@@ -1007,7 +1012,8 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
                                       queryImageSize,
                                       frameImageSize, 
                                       featureMatches,
-                                      param._matchingEstimator);
+                                      param._matchingEstimator,
+                                      param._nfaMode);
     if (!matchWorked)
     {
       continue;
@@ -1058,7 +1064,8 @@ bool VoctreeLocalizer::robustMatching(matching::RegionsDatabaseMatcherPerDesc &
                                       const std::pair<std::size_t,std::size_t> & imageSizeI,     // size of the first image @fixme change the API of the kernel!! 
                                       const std::pair<std::size_t,std::size_t> & imageSizeJ,     // size of the second image
                                       matching::MatchesPerDescType & out_featureMatches,
-                                      robustEstimation::ERobustEstimator estimator) const
+                                      robustEstimation::ERobustEstimator estimator,
+                                      robustEstimation::EACRansacNFA nfaMode) const
 {
   // get the intrinsics of the query camera
   if ((queryIntrinsicsBase != nullptr) && !isPinhole(queryIntrinsicsBase->getType()))
@@ -1099,6 +1106,7 @@ bool VoctreeLocalizer::robustMatching(matching::RegionsDatabaseMatcherPerDesc &
 
   // perform the geometric filtering
   matchingImageCollection::GeometricFilterMatrix_F_AC geometricFilter(matchingError, 5000, estimator);
+  geometricFilter.m_nfaMode = nfaMode;
 
   matching::MatchesPerDescType geometricInliersPerType;
   EstimationStatus estimationState = geometricFilter.geometricEstimation(
@@ -296,6 +296,7 @@ private:
    * @param[in] imageSizeJ
    * @param[out] vec_featureMatches
    * @param[in] estimator
+   * @param[in] nfaMode
    * @return
    */
   bool robustMatching(matching::RegionsDatabaseMatcherPerDesc & matchers,
@@ -309,7 +310,8 @@ private:
                       const std::pair<size_t,size_t> & imageSizeI,     // size of the image in matcher  
                       const std::pair<size_t,size_t> & imageSizeJ,     // size of the query image
                       matching::MatchesPerDescType & out_featureMatches,
-                      robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC) const;
+                      robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC,
+                      robustEstimation::EACRansacNFA nfaMode = robustEstimation::EACRansacNFA::EXACT) const;
   
   void getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc& matchers,
                                  const std::pair<std::size_t, std::size_t> & imageSize,
@@ -0,0 +1,203 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/numeric/numeric.hpp"
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Brute force matcher computing the squared L2 distances by blocks:
+ *   ||q - d||^2 = ||q||^2 + ||d||^2 - 2 q.d
+ * The dot products of a tile of queries against a tile of the database are computed
+ * with a single matrix product (Eigen GEMM), the tiles being sized to stay in cache.
+ *
+ * Only the N best neighbours of each query are kept while scanning the database tiles,
+ * so the memory usage does not depend on the database size.
+ *
+ * @note For integer descriptors (like unsigned char SIFT) all the intermediate values
+ * are exactly represented in float, so the distances are the same as ArrayMatcher_bruteForce.
+ * For floating point descriptors the expansion loses precision when the terms nearly cancel,
+ * so near-tie neighbours may differ: it is only used by the BRUTE_FORCE_L2_TILED matcher type.
+ */
+template < typename Scalar = float, typename Metric = L2_Simple<Scalar> >
+class ArrayMatcher_bruteForceTiled : public ArrayMatcher<Scalar, Metric>
+{
+public:
+  typedef typename Metric::ResultType DistanceType;
+
+  static_assert(std::is_floating_point<DistanceType>::value,
+                "ArrayMatcher_bruteForceTiled needs a floating point squared L2 distance.");
+
+  /// Number of query rows processed together
+  static const int queryTileSize = 128;
+  /// Number of database rows processed together
+  static const int databaseTileSize = 512;
+
+  ArrayMatcher_bruteForceTiled() {}
+  virtual ~ArrayMatcher_bruteForceTiled() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1)
+    {
+      _database.resize(0, 0);
+      _databaseSquaredNorms.resize(0);
+      return false;
+    }
+    _database = Eigen::Map<const ScalarMat>(dataset, nbRows, dimension).template cast<DistanceType>();
+    _databaseSquaredNorms = _database.rowwise().squaredNorm();
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour(const Scalar * query,
+                       int * indice, DistanceType * distance)
+  {
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+      return false;
+    *indice = indices.front()._j;
+    *distance = distances.front();
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    if (_database.rows() == 0)
+      return false;
+
+    if (NN > _database.rows() || nbQuery < 1)
+      return false;
+
+    const int dimension = _database.cols();
+    const int nbDatabase = _database.rows();
+    const int nbQueryTiles = (nbQuery + queryTileSize - 1) / queryTileSize;
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int queryTile = 0; queryTile < nbQueryTiles; ++queryTile)
+    {
+      const int queryBegin = queryTile * queryTileSize;
+      const int queryCount = std::min(queryTileSize, nbQuery - queryBegin);
+
+      const RealMat queries = Eigen::Map<const ScalarMat>(query + std::size_t(queryBegin) * dimension,
+                                                          queryCount, dimension).template cast<DistanceType>();
+      const RealVec querySquaredNorms = queries.rowwise().squaredNorm();
+
+      // N best neighbours of each query of the tile, sorted by increasing distance
+      std::vector<DistanceType> bestDistances(queryCount * NN, std::numeric_limits<DistanceType>::max());
+      std::vector<int> bestIndices(queryCount * NN, -1);
+
+      RealMat dotProducts(queryCount, databaseTileSize);
+      for (int databaseBegin = 0; databaseBegin < nbDatabase; databaseBegin += databaseTileSize)
+      {
+        const int databaseCount = std::min(databaseTileSize, nbDatabase - databaseBegin);
+
+        dotProducts.leftCols(databaseCount).noalias() =
+          queries * _database.middleRows(databaseBegin, databaseCount).transpose();
+
+        for (int q = 0; q < queryCount; ++q)
+        {
+          DistanceType* queryBestDistances = &bestDistances[q * NN];
+          int* queryBestIndices = &bestIndices[q * NN];
+
+          for (int d = 0; d < databaseCount; ++d)
+          {
+            const DistanceType dist = std::max(DistanceType(0),
+              querySquaredNorms(q) + _databaseSquaredNorms(databaseBegin + d) - 2 * dotProducts(q, d));
+
+            if (dist >= queryBestDistances[NN - 1])
+              continue;
+
+            // insert the candidate in the sorted N best list
+            std::size_t k = NN - 1;
+            while (k > 0 && dist < queryBestDistances[k - 1])
+            {
+              queryBestDistances[k] = queryBestDistances[k - 1];
+              queryBestIndices[k] = queryBestIndices[k - 1];
+              --k;
+            }
+            queryBestDistances[k] = dist;
+            queryBestIndices[k] = databaseBegin + d;
+          }
+        }
+      }
+
+      for (int q = 0; q < queryCount; ++q)
+      {
+        const int queryIndex = queryBegin + q;
+        for (std::size_t i = 0; i < NN; ++i)
+        {
+          (*pvec_distances)[queryIndex * NN + i] = bestDistances[q * NN + i];
+          (*pvec_indices)[queryIndex * NN + i] = IndMatch(queryIndex, bestIndices[q * NN + i]);
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ScalarMat;
+  typedef Eigen::Matrix<DistanceType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RealMat;
+  typedef Eigen::Matrix<DistanceType, Eigen::Dynamic, 1> RealVec;
+
+  /// Database descriptors converted to the distance type
+  RealMat _database;
+  /// Squared norm of each database descriptor
+  RealVec _databaseSquaredNorms;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -129,7 +129,7 @@ class ArrayMatcher_cascadeHashing  : public ArrayMatcher<Scalar, Metric>
       hashed_query, mat_query,
       hashed_base_, *memMapping,
       pvec_indices, pvec_distances,
-      NN);
+      NN, &scratch_);
 
     return true;
   };
@@ -141,6 +141,8 @@ private:
   CascadeHasher cascade_hasher_;
   HashedDescriptions hashed_base_;
   Eigen::VectorXf zero_mean_descriptor_;
+  /// Reuse the matching buffers between the queries
+  CascadeHashingScratch scratch_;
 };
 
 }  // namespace matching
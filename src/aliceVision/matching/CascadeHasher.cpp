@@ -0,0 +1,224 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CascadeHasher.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+/// Cascade hashing index file signature
+const char CASCADE_HASHING_INDEX_MAGIC[8] = {'A', 'V', 'C', 'H', 'A', 'S', 'H', 'I'};
+/// Cascade hashing parameters file signature
+const char CASCADE_HASHING_PARAMS_MAGIC[8] = {'A', 'V', 'C', 'H', 'A', 'S', 'H', 'P'};
+/// Cascade hashing files format version
+const std::uint32_t CASCADE_HASHING_VERSION = 1;
+
+/**
+ * @brief Header of a cascade hashing index file.
+ *
+ * The header is followed by the hash codes, the bucket ids,
+ * the bucket offsets and the bucket descriptions arrays (see HashedDescriptions).
+ */
+struct CascadeHashingIndexHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t blockSize;
+  std::uint64_t fingerprint;
+  std::uint64_t nbDescriptions;
+  std::uint64_t nbBlocksPerCode;
+  std::uint32_t nbBucketGroups;
+  std::uint32_t nbBucketsPerGroup;
+};
+
+/**
+ * @brief Header of a cascade hashing parameters file.
+ *
+ * The header is followed by the zero mean descriptor (dimension floats).
+ */
+struct CascadeHashingParamsHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t seed;
+  std::uint64_t dimension;
+};
+
+template <typename T>
+inline void writeArray(std::ofstream& stream, const std::vector<T>& data)
+{
+  stream.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+}
+
+template <typename T>
+inline void readArray(std::ifstream& stream, std::vector<T>& data, std::size_t size)
+{
+  data.resize(size);
+  stream.read(reinterpret_cast<char*>(data.data()), size * sizeof(T));
+}
+
+/// Write in a temporary file then rename it, so a concurrent reader never sees a partial file
+template <typename WriteFunc>
+bool writeFile(const std::string& filepath, WriteFunc write)
+{
+  std::string tmpPath;
+  try
+  {
+    const fs::path bPath = fs::path(filepath);
+    tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      if(!stream.is_open())
+      {
+        ALICEVISION_LOG_WARNING("Can't create cascade hashing file: " << tmpPath);
+        return false;
+      }
+      write(stream);
+      if(!stream.good())
+      {
+        ALICEVISION_LOG_WARNING("Can't write cascade hashing file: " << tmpPath);
+        stream.close();
+        fs::remove(tmpPath);
+        return false;
+      }
+    }
+    fs::rename(tmpPath, filepath);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Can't save cascade hashing file: " << filepath << ": " << e.what());
+    boost::system::error_code ec;
+    if(!tmpPath.empty())
+      fs::remove(tmpPath, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool saveHashedDescriptions(const std::string& filepath, const HashedDescriptions& hashed_descriptions, std::uint64_t fingerprint)
+{
+  return writeFile(filepath, [&](std::ofstream& stream)
+  {
+    CascadeHashingIndexHeader header;
+    std::memcpy(header.magic, CASCADE_HASHING_INDEX_MAGIC, sizeof(header.magic));
+    header.version = CASCADE_HASHING_VERSION;
+    header.blockSize = sizeof(HashedDescriptions::BlockType);
+    header.fingerprint = fingerprint;
+    header.nbDescriptions = hashed_descriptions.nb_descriptions;
+    header.nbBlocksPerCode = hashed_descriptions.nb_blocks_per_code;
+    header.nbBucketGroups = hashed_descriptions.nb_bucket_groups;
+    header.nbBucketsPerGroup = hashed_descriptions.nb_buckets_per_group;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(CascadeHashingIndexHeader));
+    writeArray(stream, hashed_descriptions.hash_codes);
+    writeArray(stream, hashed_descriptions.bucket_ids);
+    writeArray(stream, hashed_descriptions.bucket_offsets);
+    writeArray(stream, hashed_descriptions.bucket_descriptions);
+  });
+}
+
+bool loadHashedDescriptions(const std::string& filepath, std::uint64_t fingerprint, std::size_t nb_descriptions, HashedDescriptions& hashed_descriptions)
+{
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  CascadeHashingIndexHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(CascadeHashingIndexHeader));
+
+  if(!stream.good() ||
+     std::memcmp(header.magic, CASCADE_HASHING_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != CASCADE_HASHING_VERSION ||
+     header.blockSize != sizeof(HashedDescriptions::BlockType))
+  {
+    ALICEVISION_LOG_WARNING("Invalid cascade hashing index file: " << filepath);
+    return false;
+  }
+
+  // the index has been created with other hashing functions or descriptions
+  if(header.fingerprint != fingerprint || header.nbDescriptions != nb_descriptions)
+    return false;
+
+  HashedDescriptions loaded;
+  loaded.nb_descriptions = header.nbDescriptions;
+  loaded.nb_blocks_per_code = header.nbBlocksPerCode;
+  loaded.nb_bucket_groups = header.nbBucketGroups;
+  loaded.nb_buckets_per_group = header.nbBucketsPerGroup;
+
+  readArray(stream, loaded.hash_codes, loaded.nb_descriptions * loaded.nb_blocks_per_code);
+  readArray(stream, loaded.bucket_ids, loaded.nb_descriptions * loaded.nb_bucket_groups);
+  readArray(stream, loaded.bucket_offsets, loaded.nb_bucket_groups * (loaded.nb_buckets_per_group + 1));
+  readArray(stream, loaded.bucket_descriptions, loaded.nb_descriptions * loaded.nb_bucket_groups);
+
+  if(!stream.good())
+  {
+    ALICEVISION_LOG_WARNING("Truncated cascade hashing index file: " << filepath);
+    return false;
+  }
+
+  hashed_descriptions = std::move(loaded);
+  return true;
+}
+
+bool saveCascadeHashingParameters(const std::string& filepath, unsigned int seed, const Eigen::VectorXf& zero_mean_descriptor)
+{
+  return writeFile(filepath, [&](std::ofstream& stream)
+  {
+    CascadeHashingParamsHeader header;
+    std::memcpy(header.magic, CASCADE_HASHING_PARAMS_MAGIC, sizeof(header.magic));
+    header.version = CASCADE_HASHING_VERSION;
+    header.seed = seed;
+    header.dimension = zero_mean_descriptor.size();
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(CascadeHashingParamsHeader));
+    stream.write(reinterpret_cast<const char*>(zero_mean_descriptor.data()), zero_mean_descriptor.size() * sizeof(float));
+  });
+}
+
+bool loadCascadeHashingParameters(const std::string& filepath, unsigned int& seed, Eigen::VectorXf& zero_mean_descriptor)
+{
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  CascadeHashingParamsHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(CascadeHashingParamsHeader));
+
+  if(!stream.good() ||
+     std::memcmp(header.magic, CASCADE_HASHING_PARAMS_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != CASCADE_HASHING_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("Invalid cascade hashing parameters file: " << filepath);
+    return false;
+  }
+
+  Eigen::VectorXf zeroMean(header.dimension);
+  stream.read(reinterpret_cast<char*>(zeroMean.data()), header.dimension * sizeof(float));
+  if(!stream.good())
+  {
+    ALICEVISION_LOG_WARNING("Truncated cascade hashing parameters file: " << filepath);
+    return false;
+  }
+
+  seed = header.seed;
+  zero_mean_descriptor = std::move(zeroMean);
+  return true;
+}
+
+} // namespace matching
+} // namespace aliceVision
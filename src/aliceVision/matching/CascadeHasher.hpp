@@ -11,31 +11,116 @@
 #include "aliceVision/matching/metric.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/stl/DynamicBitset.hpp"
+#include "aliceVision/system/randomSeed.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
-struct HashedDescription {
-  // Hash code generated by the primary hashing function.
-  stl::dynamic_bitset hash_code;
-
-  // Each bucket_ids[x] = y means the descriptor belongs to bucket y in bucket
-  // group x.
+/**
+ * @brief Cascade hashing index of a set of descriptions.
+ *
+ * All the data is stored in flat arrays (no allocation per description or per bucket)
+ * so the index can be saved and loaded as a few contiguous blocks.
+ */
+struct HashedDescriptions
+{
+  typedef stl::dynamic_bitset::BlockType BlockType;
+
+  /// number of indexed descriptions
+  std::size_t nb_descriptions = 0;
+  /// number of blocks of each hash code
+  std::size_t nb_blocks_per_code = 0;
+  int nb_bucket_groups = 0;
+  int nb_buckets_per_group = 0;
+
+  /// hash codes generated by the primary hashing function (nb_blocks_per_code blocks per description)
+  std::vector<BlockType> hash_codes;
+  /// bucket_ids[i * nb_bucket_groups + x] = y means the description i belongs to bucket y in bucket group x
   std::vector<uint16_t> bucket_ids;
-};
+  /// description ids of the bucket y of group x: [bucket_offsets[x * (nb_buckets_per_group + 1) + y], bucket_offsets[... + y + 1])
+  std::vector<int> bucket_offsets;
+  std::vector<int> bucket_descriptions;
+
+  inline const BlockType* hashCode(std::size_t i) const
+  {
+    return hash_codes.data() + i * nb_blocks_per_code;
+  }
 
-struct HashedDescriptions{
-  // The hash information.
-  std::vector<HashedDescription> hashed_desc;
+  inline uint16_t bucketId(std::size_t i, int group) const
+  {
+    return bucket_ids[i * nb_bucket_groups + group];
+  }
+
+  inline const int* bucketBegin(int group, uint16_t bucket) const
+  {
+    return bucket_descriptions.data() + bucket_offsets[group * (nb_buckets_per_group + 1) + bucket];
+  }
 
-  typedef std::vector<int> Bucket;
-  // buckets[bucket_group][bucket_id] = bucket (container of description ids).
-  std::vector<std::vector<Bucket> > buckets;
+  inline const int* bucketEnd(int group, uint16_t bucket) const
+  {
+    return bucket_descriptions.data() + bucket_offsets[group * (nb_buckets_per_group + 1) + bucket + 1];
+  }
 };
 
+/**
+ * @brief Scratch buffers of Match_HashedDescriptions.
+ * Keep one per thread to reuse the allocations between the queries and the image pairs.
+ */
+struct CascadeHashingScratch
+{
+  /// unique candidate descriptions of the current query
+  std::vector<int> candidate_descriptions;
+  /// hamming distance of each candidate
+  std::vector<unsigned int> candidate_hamming_distances;
+  /// number of candidates for each hamming distance
+  std::vector<int> nb_candidates_per_hamming_distance;
+  /// used_description[i] != 0 if the description i is already a candidate of the current query
+  std::vector<unsigned char> used_description;
+};
+
+/**
+ * @brief Save a cascade hashing index.
+ * @param[in] filepath the index file
+ * @param[in] hashed_descriptions the index
+ * @param[in] fingerprint fingerprint of the hashing functions (see CascadeHasher::GetFingerprint)
+ * @return true if the index has been saved
+ */
+bool saveHashedDescriptions(const std::string& filepath, const HashedDescriptions& hashed_descriptions, std::uint64_t fingerprint);
+
+/**
+ * @brief Load a cascade hashing index.
+ * @param[in] filepath the index file
+ * @param[in] fingerprint expected fingerprint of the hashing functions
+ * @param[in] nb_descriptions expected number of descriptions
+ * @param[out] hashed_descriptions the index
+ * @return false if the file does not exist or has been created with other hashing functions or descriptions
+ */
+bool loadHashedDescriptions(const std::string& filepath, std::uint64_t fingerprint, std::size_t nb_descriptions, HashedDescriptions& hashed_descriptions);
+
+/**
+ * @brief Save the parameters shared by the cascade hashing indexes of a collection of views.
+ * @param[in] filepath the parameters file
+ * @param[in] seed seed of the hashing functions
+ * @param[in] zero_mean_descriptor zero mean descriptor of the collection
+ * @return true if the parameters have been saved
+ */
+bool saveCascadeHashingParameters(const std::string& filepath, unsigned int seed, const Eigen::VectorXf& zero_mean_descriptor);
+
+/**
+ * @brief Load the parameters shared by the cascade hashing indexes of a collection of views.
+ * @param[in] filepath the parameters file
+ * @param[out] seed seed of the hashing functions
+ * @param[out] zero_mean_descriptor zero mean descriptor of the collection
+ */
+bool loadCascadeHashingParameters(const std::string& filepath, unsigned int& seed, Eigen::VectorXf& zero_mean_descriptor);
+
 /**
  * This hasher will hash descriptors with a two-step hashing system:
  * 1. it generates a hash code,
@@ -78,7 +163,8 @@ public:
   (
     const uint8_t nb_hash_code = 128,
     const uint8_t nb_bucket_groups = 6,
-    const uint8_t nb_bits_per_bucket = 10)
+    const uint8_t nb_bits_per_bucket = 10,
+    const unsigned int seed = system::getRandomSeed())
   {
     nb_bucket_groups_= nb_bucket_groups;
     nb_hash_code_ = nb_hash_code;
@@ -89,8 +175,7 @@ public:
     // Box Muller transform is used in the original paper to get fast random number
     // from a normal distribution with <mean = 0> and <variance = 1>.
     // Here we use C++11 normal distribution random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::normal_distribution<> d(0,1);
 
     primary_hash_projection_.resize(nb_hash_code, nb_hash_code);
@@ -138,6 +223,29 @@ public:
     return zero_mean_descriptor / static_cast<double>(nbDescriptions);
   }
 
+  /**
+   * @brief Fingerprint of the hashing functions and of the zero mean descriptor.
+   * Hashed descriptions can only be matched together if they have the same fingerprint.
+   */
+  std::uint64_t GetFingerprint(const Eigen::VectorXf& zero_mean_descriptor) const
+  {
+    // FNV-1a hash
+    std::uint64_t hash = 14695981039346656037ULL;
+    const auto hashBytes = [&hash](const void* data, std::size_t size)
+    {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for(std::size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    };
+    const int params[] = {nb_hash_code_, nb_bucket_groups_, nb_bits_per_bucket_};
+    hashBytes(params, sizeof(params));
+    hashBytes(primary_hash_projection_.data(), primary_hash_projection_.size() * sizeof(float));
+    for(const Eigen::MatrixXf& projection : secondary_hash_projection_)
+      hashBytes(projection.data(), projection.size() * sizeof(float));
+    hashBytes(zero_mean_descriptor.data(), zero_mean_descriptor.size() * sizeof(float));
+    return hash;
+  }
+
 
   template <typename MatrixT>
   HashedDescriptions CreateHashedDescriptions
@@ -150,65 +258,86 @@ public:
     //   1) Compute hash code and hash buckets (based on the zero_mean_descriptor).
     //   2) Construct buckets.
 
+    typedef HashedDescriptions::BlockType BlockType;
+    const int bits_per_block = stl::dynamic_bitset::bits_per_block;
+
     HashedDescriptions hashed_descriptions;
     if (descriptions.rows() == 0) {
       return hashed_descriptions;
     }
 
+    const typename MatrixT::Index nbDescriptions = descriptions.rows();
+    hashed_descriptions.nb_descriptions = nbDescriptions;
+    hashed_descriptions.nb_blocks_per_code = (nb_hash_code_ + bits_per_block - 1) / bits_per_block;
+    hashed_descriptions.nb_bucket_groups = nb_bucket_groups_;
+    hashed_descriptions.nb_buckets_per_group = nb_buckets_per_group_;
+
     // Create hash codes for each description.
     {
-      // Allocate space for hash codes.
-      const typename MatrixT::Index nbDescriptions = descriptions.rows();
-      hashed_descriptions.hashed_desc.resize(nbDescriptions);
+      // Allocate space for hash codes and bucket ids.
+      hashed_descriptions.hash_codes.assign(nbDescriptions * hashed_descriptions.nb_blocks_per_code, 0);
+      hashed_descriptions.bucket_ids.resize(nbDescriptions * nb_bucket_groups_);
+
       Eigen::VectorXf descriptor(descriptions.cols());
+      Eigen::VectorXf primary_projection(nb_hash_code_);
+      Eigen::VectorXf secondary_projection(nb_bits_per_bucket_);
       for (int i = 0; i < nbDescriptions; ++i)
       {
-        // Allocate space for each bucket id.
-        hashed_descriptions.hashed_desc[i].bucket_ids.resize(nb_bucket_groups_);
-
         for (int k = 0; k < descriptions.cols(); ++k)
         {
           descriptor(k) = descriptions(i,k);
         }
         descriptor -= zero_mean_descriptor;
 
-        auto& hash_code = hashed_descriptions.hashed_desc[i].hash_code;
-        hash_code = stl::dynamic_bitset(descriptions.cols());
-
         // Compute hash code.
-        const Eigen::VectorXf primary_projection = primary_hash_projection_ * descriptor;
+        BlockType* hash_code = hashed_descriptions.hash_codes.data() + i * hashed_descriptions.nb_blocks_per_code;
+        primary_projection.noalias() = primary_hash_projection_ * descriptor;
         for (int j = 0; j < nb_hash_code_; ++j)
         {
-          hash_code[j] = primary_projection(j) > 0;
+          if (primary_projection(j) > 0)
+            hash_code[j / bits_per_block] |= BlockType(1) << (j % bits_per_block);
         }
 
         // Determine the bucket index for each group.
-        Eigen::VectorXf secondary_projection;
         for (int j = 0; j < nb_bucket_groups_; ++j)
         {
           uint16_t bucket_id = 0;
-          secondary_projection = secondary_hash_projection_[j] * descriptor;
+          secondary_projection.noalias() = secondary_hash_projection_[j] * descriptor;
 
           for (int k = 0; k < nb_bits_per_bucket_; ++k)
           {
             bucket_id = (bucket_id << 1) + (secondary_projection(k) > 0 ? 1 : 0);
           }
-          hashed_descriptions.hashed_desc[i].bucket_ids[j] = bucket_id;
+          hashed_descriptions.bucket_ids[i * nb_bucket_groups_ + j] = bucket_id;
         }
       }
     }
-    // Build the Buckets
+    // Build the Buckets (counting sort of the description ids by bucket)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
-      for (int i = 0; i < nb_bucket_groups_; ++i)
+      std::vector<int>& offsets = hashed_descriptions.bucket_offsets;
+      offsets.assign(nb_bucket_groups_ * (nb_buckets_per_group_ + 1), 0);
+      for (int i = 0; i < nbDescriptions; ++i)
+      {
+        for (int j = 0; j < nb_bucket_groups_; ++j)
+          ++offsets[j * (nb_buckets_per_group_ + 1) + hashed_descriptions.bucket_ids[i * nb_bucket_groups_ + j] + 1];
+      }
+      for (int j = 0; j < nb_bucket_groups_; ++j)
       {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+        int* groupOffsets = offsets.data() + j * (nb_buckets_per_group_ + 1);
+        groupOffsets[0] = j * nbDescriptions;
+        for (int k = 0; k < nb_buckets_per_group_; ++k)
+          groupOffsets[k + 1] += groupOffsets[k];
+      }
 
-        // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+      // Add the descriptor ID to the proper bucket group and id (in increasing order).
+      std::vector<int> cursors(offsets);
+      hashed_descriptions.bucket_descriptions.resize(nbDescriptions * nb_bucket_groups_);
+      for (int i = 0; i < nbDescriptions; ++i)
+      {
+        for (int j = 0; j < nb_bucket_groups_; ++j)
         {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
+          const uint16_t bucket_id = hashed_descriptions.bucket_ids[i * nb_bucket_groups_ + j];
+          hashed_descriptions.bucket_descriptions[cursors[j * (nb_buckets_per_group_ + 1) + bucket_id]++] = i;
         }
       }
     }
@@ -217,6 +346,7 @@ public:
 
   // Matches two collection of hashed descriptions with a fast matching scheme
   // based on the hash codes previously generated.
+  // The optional scratch buffers are reused between calls to avoid the allocations.
   template <typename MatrixT, typename DistanceType>
   void Match_HashedDescriptions
   (
@@ -226,7 +356,8 @@ public:
     const MatrixT & descriptions2,
     IndMatches * pvec_indices,
     std::vector<DistanceType> * pvec_distances,
-    const int NN = 2
+    const int NN = 2,
+    CascadeHashingScratch * scratch = nullptr
   ) const
   {
     typedef L2_Vectorized<typename MatrixT::Scalar> MetricT;
@@ -234,99 +365,119 @@ public:
 
     static const int kNumTopCandidates = 10;
 
-    // Preallocate the candidate descriptors container.
-    std::vector<int> candidate_descriptors;
-    candidate_descriptors.reserve(hashed_descriptions2.hashed_desc.size());
+    CascadeHashingScratch localScratch;
+    if (scratch == nullptr)
+      scratch = &localScratch;
 
-    // Preallocated hamming distances. Each column indicates the hamming distance
-    // and the rows collect the descriptor ids with that
-    // distance. num_descriptors_with_hamming_distance keeps track of how many
-    // descriptors have that distance.
-    Eigen::MatrixXi candidate_hamming_distances(
-      hashed_descriptions2.hashed_desc.size(), nb_hash_code_ + 1);
-    Eigen::VectorXi num_descriptors_with_hamming_distance(nb_hash_code_ + 1);
+    // Candidate descriptors of the query, and their hamming distances.
+    std::vector<int>& candidate_descriptors = scratch->candidate_descriptions;
+    std::vector<unsigned int>& candidate_hamming_distances = scratch->candidate_hamming_distances;
+    // Keep track of how many descriptors have each hamming distance.
+    std::vector<int>& num_descriptors_with_hamming_distance = scratch->nb_candidates_per_hamming_distance;
+    num_descriptors_with_hamming_distance.resize(nb_hash_code_ + 1);
 
-    // Preallocate the container for keeping euclidean distances.
-    std::vector<std::pair<DistanceType, int> > candidate_euclidean_distances;
-    candidate_euclidean_distances.reserve(kNumTopCandidates);
+    // Container for keeping the euclidean distances of the top candidates.
+    std::pair<DistanceType, int> candidate_euclidean_distances[kNumTopCandidates];
 
-    // A preallocated vector to determine if we have already used a particular
-    // feature for matching (i.e., prevents duplicates).
-    std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
+    // Determine if we have already used a particular feature for matching (i.e., prevents duplicates).
+    std::vector<unsigned char>& used_descriptor = scratch->used_description;
+    if (used_descriptor.size() < hashed_descriptions2.nb_descriptions)
+      used_descriptor.resize(hashed_descriptions2.nb_descriptions, 0);
 
-    typedef matching::Hamming<stl::dynamic_bitset::BlockType> HammingMetricType;
+    typedef matching::Hamming<HashedDescriptions::BlockType> HammingMetricType;
     static const HammingMetricType metricH = {};
-    for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
+    for (int i = 0; i < hashed_descriptions1.nb_descriptions; ++i)
     {
       candidate_descriptors.clear();
-      num_descriptors_with_hamming_distance.setZero();
-      candidate_euclidean_distances.clear();
-
-      const auto& hashed_desc = hashed_descriptions1.hashed_desc[i];
+      std::fill(num_descriptors_with_hamming_distance.begin(), num_descriptors_with_hamming_distance.end(), 0);
 
       // Accumulate all descriptors in each bucket group that are in the same
-      // bucket id as the query descriptor.
+      // bucket id as the query descriptor (each descriptor is kept once).
+      std::size_t nb_candidates = 0;
       for (int j = 0; j < nb_bucket_groups_; ++j)
       {
-        const uint16_t bucket_id = hashed_desc.bucket_ids[j];
-        for (const auto& feature_id : hashed_descriptions2.buckets[j][bucket_id])
+        const uint16_t bucket_id = hashed_descriptions1.bucketId(i, j);
+        const int* bucketEnd = hashed_descriptions2.bucketEnd(j, bucket_id);
+        for (const int* feature_id = hashed_descriptions2.bucketBegin(j, bucket_id); feature_id != bucketEnd; ++feature_id)
         {
-          candidate_descriptors.emplace_back(feature_id);
-          used_descriptor[feature_id] = false;
+          ++nb_candidates;
+          if (!used_descriptor[*feature_id])
+          {
+            used_descriptor[*feature_id] = 1;
+            candidate_descriptors.push_back(*feature_id);
+          }
         }
       }
+      for (const int candidate_id : candidate_descriptors)
+        used_descriptor[candidate_id] = 0;
 
       // Skip matching this descriptor if there are not at least NN candidates.
-      if (candidate_descriptors.size() <= NN)
+      if (nb_candidates <= NN)
       {
         continue;
       }
 
-      // Compute the hamming distance of all candidates based on the comp hash
-      // code. Put the descriptors into buckets corresponding to their hamming
-      // distance.
-      for (const int candidate_id : candidate_descriptors)
+      // Compute the hamming distance of all candidates based on the comp hash code.
+      // The metric size is a number of BlockType (not of bytes), so the whole hash code is compared.
+      const HashedDescriptions::BlockType* hash_code = hashed_descriptions1.hashCode(i);
+      const std::size_t hash_code_size = hashed_descriptions1.nb_blocks_per_code;
+      candidate_hamming_distances.resize(candidate_descriptors.size());
+      for (std::size_t k = 0; k < candidate_descriptors.size(); ++k)
+      {
+        const typename HammingMetricType::ResultType hamming_distance = metricH(
+          hash_code,
+          hashed_descriptions2.hashCode(candidate_descriptors[k]),
+          hash_code_size);
+        candidate_hamming_distances[k] = hamming_distance;
+        ++num_descriptors_with_hamming_distance[hamming_distance];
+      }
+
+      // Find the hamming distance of the k-th best candidate.
+      int max_hamming_distance = 0;
+      int nb_above_max_distance = 0;
+      for (int nb_selected = 0; max_hamming_distance <= nb_hash_code_; ++max_hamming_distance)
       {
-        if (!used_descriptor[candidate_id]) // avoid selecting the same candidate multiple times
+        nb_selected += num_descriptors_with_hamming_distance[max_hamming_distance];
+        if (nb_selected >= kNumTopCandidates)
         {
-          used_descriptor[candidate_id] = true;
-
-          const HammingMetricType::ResultType hamming_distance = metricH(
-            hashed_desc.hash_code.data(),
-            hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
-            hashed_desc.hash_code.num_blocks());
-          candidate_hamming_distances(
-              num_descriptors_with_hamming_distance(hamming_distance)++,
-              hamming_distance) = candidate_id;
+          nb_above_max_distance = nb_selected - kNumTopCandidates;
+          break;
         }
       }
+      // Number of candidates to keep at the max hamming distance (in candidate order).
+      int nb_at_max_distance = (max_hamming_distance <= nb_hash_code_) ?
+        num_descriptors_with_hamming_distance[max_hamming_distance] - nb_above_max_distance : 0;
 
-      // Compute the euclidean distance of the k descriptors with the best hamming
-      // distance.
-      candidate_euclidean_distances.reserve(kNumTopCandidates);
-      for (int j = 0; j < candidate_hamming_distances.cols() &&
-        (candidate_euclidean_distances.size() < kNumTopCandidates); ++j)
+      // Compute the euclidean distance of the k descriptors with the best hamming distance.
+      int nb_euclidean_distances = 0;
+      for (std::size_t k = 0; k < candidate_descriptors.size() && nb_euclidean_distances < kNumTopCandidates; ++k)
       {
-        for(int k = 0; k < num_descriptors_with_hamming_distance(j) &&
-          (candidate_euclidean_distances.size() < kNumTopCandidates); ++k)
+        const int hamming_distance = candidate_hamming_distances[k];
+        if (hamming_distance > max_hamming_distance)
+          continue;
+        if (hamming_distance == max_hamming_distance)
         {
-          const int candidate_id = candidate_hamming_distances(k, j);
-          const DistanceType distance = metric(
-            descriptions2.row(candidate_id).data(),
-            descriptions1.row(i).data(),
-            descriptions1.cols());
-
-          candidate_euclidean_distances.emplace_back(distance, candidate_id);
+          if (nb_at_max_distance == 0)
+            continue;
+          --nb_at_max_distance;
         }
+
+        const int candidate_id = candidate_descriptors[k];
+        const DistanceType distance = metric(
+          descriptions2.row(candidate_id).data(),
+          descriptions1.row(i).data(),
+          descriptions1.cols());
+
+        candidate_euclidean_distances[nb_euclidean_distances++] = std::make_pair(distance, candidate_id);
       }
 
       // Assert that each query is having at least NN retrieved neighbors
-      if (candidate_euclidean_distances.size() >= NN)
+      if (nb_euclidean_distances >= NN)
       {
         // Find the top NN candidates based on euclidean distance.
-        std::partial_sort(candidate_euclidean_distances.begin(),
-          candidate_euclidean_distances.begin() + NN,
-          candidate_euclidean_distances.end());
+        std::partial_sort(candidate_euclidean_distances,
+          candidate_euclidean_distances + NN,
+          candidate_euclidean_distances + nb_euclidean_distances);
         // save resulting neighbors
         for (int l = 0; l < NN; ++l)
         {
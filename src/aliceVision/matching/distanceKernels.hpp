@@ -0,0 +1,408 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/cpu.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Descriptor distance kernels for each x86 instruction set extension.
+// All the kernels are compiled in the same binary (using per-function target attributes)
+// and the fastest one supported by the CPU is selected at runtime with system::get_cpu_features().
+// On other architectures only the scalar kernels are available.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ALICEVISION_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define ALICEVISION_SIMD_X86 0
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ALICEVISION_SIMD_X86_64 1
+#else
+#define ALICEVISION_SIMD_X86_64 0
+#endif
+
+#if ALICEVISION_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define ALICEVISION_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ALICEVISION_SIMD_TARGET(isa)
+#endif
+
+// AVX-512 VNNI and VPOPCNTDQ intrinsics need a recent compiler
+#if ALICEVISION_SIMD_X86 && ((defined(__clang__) && __clang_major__ >= 6) || \
+                             (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8) || \
+                             (defined(_MSC_VER) && _MSC_VER >= 1920))
+#define ALICEVISION_SIMD_AVX512_EXTENSIONS 1
+#else
+#define ALICEVISION_SIMD_AVX512_EXTENSIONS 0
+#endif
+
+namespace aliceVision {
+namespace matching {
+namespace simd {
+
+typedef float (*L2FloatKernel)(const float*, const float*, std::size_t);
+typedef float (*L2UcharKernel)(const unsigned char*, const unsigned char*, std::size_t);
+typedef unsigned int (*HammingKernel)(const unsigned char*, const unsigned char*, std::size_t);
+
+// Scalar kernels
+
+inline float l2_scalar(const float* a, const float* b, std::size_t size)
+{
+  float result = 0.f;
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+inline std::uint32_t l2_scalar_u32(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  std::uint32_t result = 0;
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += diff * diff;
+  }
+  return result;
+}
+
+inline float l2_scalar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return static_cast<float>(l2_scalar_u32(a, b, size));
+}
+
+inline unsigned int popcount64_scalar(std::uint64_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(n);
+#else
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline unsigned int hamming_scalar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= size; i += 8)
+  {
+    std::uint64_t wa, wb;
+    std::memcpy(&wa, a + i, 8);
+    std::memcpy(&wb, b + i, 8);
+    result += popcount64_scalar(wa ^ wb);
+  }
+  for(; i < size; ++i)
+    result += popcount64_scalar(a[i] ^ b[i]);
+  return result;
+}
+
+#if ALICEVISION_SIMD_X86
+
+// Horizontal sums
+
+ALICEVISION_SIMD_TARGET("sse2")
+inline float hsum_sse2(__m128 v)
+{
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+ALICEVISION_SIMD_TARGET("sse2")
+inline std::uint32_t hsum_epi32_sse2(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+ALICEVISION_SIMD_TARGET("avx2")
+inline std::uint32_t hsum_epi32_avx2(__m256i v)
+{
+  return hsum_epi32_sse2(_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+// SSE2 kernels
+
+ALICEVISION_SIMD_TARGET("sse2")
+inline float l2_sse2(const float* a, const float* b, std::size_t size)
+{
+  __m128 acc = _mm_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    const __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    acc = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+  }
+  return hsum_sse2(acc) + l2_scalar(a + i, b + i, size - i);
+}
+
+ALICEVISION_SIMD_TARGET("sse2")
+inline float l2_sse2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const __m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+    const __m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(diffLo, diffLo));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(diffHi, diffHi));
+  }
+  return static_cast<float>(hsum_epi32_sse2(acc) + l2_scalar_u32(a + i, b + i, size - i));
+}
+
+#if ALICEVISION_SIMD_X86_64
+ALICEVISION_SIMD_TARGET("popcnt")
+inline unsigned int hamming_popcnt(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  std::uint64_t result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= size; i += 8)
+  {
+    std::uint64_t wa, wb;
+    std::memcpy(&wa, a + i, 8);
+    std::memcpy(&wb, b + i, 8);
+    result += _mm_popcnt_u64(wa ^ wb);
+  }
+  return static_cast<unsigned int>(result) + hamming_scalar(a + i, b + i, size - i);
+}
+#endif
+
+// AVX2 kernels
+
+ALICEVISION_SIMD_TARGET("avx2,fma")
+inline float l2_avx2(const float* a, const float* b, std::size_t size)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    const __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(diff0, diff0, acc0);
+    acc1 = _mm256_fmadd_ps(diff1, diff1, acc1);
+  }
+  for(; i + 8 <= size; i += 8)
+  {
+    const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(diff, diff, acc0);
+  }
+  const __m256 acc = _mm256_add_ps(acc0, acc1);
+  const __m128 acc128 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  return hsum_sse2(acc128) + l2_scalar(a + i, b + i, size - i);
+}
+
+ALICEVISION_SIMD_TARGET("avx2")
+inline float l2_avx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    const __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    const __m256i diff = _mm256_sub_epi16(va, vb);
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+  }
+  return static_cast<float>(hsum_epi32_avx2(acc) + l2_scalar_u32(a + i, b + i, size - i));
+}
+
+ALICEVISION_SIMD_TARGET("avx2")
+inline unsigned int hamming_avx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  // count the bits of each nibble with a lookup table (Mula's algorithm)
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i lo = _mm256_and_si256(v, lowMask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+    const __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  const std::uint64_t result = static_cast<std::uint64_t>(_mm_cvtsi128_si32(acc128)) +
+                               static_cast<std::uint64_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(acc128, acc128)));
+  return static_cast<unsigned int>(result) + hamming_scalar(a + i, b + i, size - i);
+}
+
+// AVX-512 kernels
+
+ALICEVISION_SIMD_TARGET("avx512f")
+inline float l2_avx512(const float* a, const float* b, std::size_t size)
+{
+  __m512 acc = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc = _mm512_fmadd_ps(diff, diff, acc);
+  }
+  if(i < size)
+  {
+    // masked loads for the remaining values
+    const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1u);
+    const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    acc = _mm512_fmadd_ps(diff, diff, acc);
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+ALICEVISION_SIMD_TARGET("avx512f,avx512bw")
+inline float l2_avx512(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i diff = _mm512_sub_epi16(va, vb);
+    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+  }
+  return static_cast<float>(static_cast<std::uint32_t>(_mm512_reduce_add_epi32(acc)) + l2_scalar_u32(a + i, b + i, size - i));
+}
+
+#if ALICEVISION_SIMD_AVX512_EXTENSIONS
+ALICEVISION_SIMD_TARGET("avx512f,avx512bw,avx512vnni")
+inline float l2_avx512vnni(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i diff = _mm512_sub_epi16(va, vb);
+    acc = _mm512_dpwssd_epi32(acc, diff, diff);
+  }
+  return static_cast<float>(static_cast<std::uint32_t>(_mm512_reduce_add_epi32(acc)) + l2_scalar_u32(a + i, b + i, size - i));
+}
+
+ALICEVISION_SIMD_TARGET("avx512f,avx512vpopcntdq")
+inline unsigned int hamming_avx512(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 64 <= size; i += 64)
+  {
+    const __m512i v = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+  }
+  return static_cast<unsigned int>(_mm512_reduce_add_epi64(acc)) + hamming_scalar(a + i, b + i, size - i);
+}
+#endif // ALICEVISION_SIMD_AVX512_EXTENSIONS
+
+#endif // ALICEVISION_SIMD_X86
+
+// Runtime dispatch
+
+inline L2FloatKernel selectL2FloatKernel(const system::CpuFeatures& cpu)
+{
+#if ALICEVISION_SIMD_X86
+  if(cpu.avx512f)
+    return &l2_avx512;
+  if(cpu.avx2 && cpu.fma)
+    return &l2_avx2;
+  if(cpu.sse2)
+    return &l2_sse2;
+#endif
+  return &l2_scalar;
+}
+
+inline L2UcharKernel selectL2UcharKernel(const system::CpuFeatures& cpu)
+{
+#if ALICEVISION_SIMD_X86
+#if ALICEVISION_SIMD_AVX512_EXTENSIONS
+  if(cpu.avx512bw && cpu.avx512vnni)
+    return &l2_avx512vnni;
+#endif
+  if(cpu.avx512bw)
+    return &l2_avx512;
+  if(cpu.avx2)
+    return &l2_avx2;
+  if(cpu.sse2)
+    return &l2_sse2;
+#endif
+  return &l2_scalar;
+}
+
+inline HammingKernel selectHammingKernel(const system::CpuFeatures& cpu)
+{
+#if ALICEVISION_SIMD_X86
+#if ALICEVISION_SIMD_AVX512_EXTENSIONS
+  if(cpu.avx512vpopcntdq)
+    return &hamming_avx512;
+#endif
+  if(cpu.avx2)
+    return &hamming_avx2;
+#if ALICEVISION_SIMD_X86_64
+  if(cpu.popcnt)
+    return &hamming_popcnt;
+#endif
+#endif
+  return &hamming_scalar;
+}
+
+/**
+ * @brief Squared Euclidean distance between two float vectors,
+ * using the fastest kernel supported by the CPU.
+ */
+inline float l2(const float* a, const float* b, std::size_t size)
+{
+  static const L2FloatKernel kernel = selectL2FloatKernel(system::get_cpu_features());
+  return kernel(a, b, size);
+}
+
+/**
+ * @brief Squared Euclidean distance between two unsigned char vectors,
+ * using the fastest kernel supported by the CPU.
+ * @note The distance is computed exactly with integers (up to 33000 elements).
+ */
+inline float l2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  static const L2UcharKernel kernel = selectL2UcharKernel(system::get_cpu_features());
+  return kernel(a, b, size);
+}
+
+/**
+ * @brief Hamming distance between two binary buffers of size bytes,
+ * using the fastest kernel supported by the CPU.
+ */
+inline unsigned int hamming(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  static const HammingKernel kernel = selectHammingKernel(system::get_cpu_features());
+  return kernel(a, b, size);
+}
+
+} // namespace simd
+} // namespace matching
+} // namespace aliceVision
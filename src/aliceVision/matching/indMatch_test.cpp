@@ -10,6 +10,14 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <vector>
+
 #define BOOST_TEST_MODULE IndMatch
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -87,6 +95,138 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary)
+{
+  const std::string testFolder = "matchingBinaryTest";
+  for(bool matchFilePerImage : {false, true})
+  {
+    boost::filesystem::create_directory(testFolder);
+
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{5,3},{1,1000},{200000,7}};
+    matches[std::make_pair(0,2)][EImageDescriberType::UNKNOWN] = {{0,0}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1},{2,2}};
+    matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{10,20},{9,19}};
+
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+
+    // Load all the pairs
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {0, 1, 2}, {testFolder}, {}));
+      BOOST_CHECK_EQUAL(matches.size(), loadedMatches.size());
+      for(const auto& pairMatches : matches)
+      {
+        BOOST_CHECK_EQUAL(1, loadedMatches.count(pairMatches.first));
+        for(const auto& descMatches : pairMatches.second)
+        {
+          const IndMatches& loaded = loadedMatches.at(pairMatches.first).at(descMatches.first);
+          BOOST_CHECK_EQUAL(descMatches.second.size(), loaded.size());
+          for(std::size_t i = 0; i < loaded.size(); ++i)
+            BOOST_CHECK_EQUAL(descMatches.second[i], loaded[i]);
+        }
+      }
+    }
+
+    // Load only the pairs between a subset of views
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {1, 2}, {testFolder}, {}));
+      BOOST_CHECK_EQUAL(1, loadedMatches.size());
+      BOOST_CHECK_EQUAL(3, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN).size());
+      BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT).size());
+    }
+
+    boost::filesystem::remove_all(testFolder);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary_Corrupted)
+{
+  const std::string testFolder = (fs::temp_directory_path() / fs::unique_path("matchingCorruptedTest-%%%%%%")).string();
+  boost::filesystem::create_directory(testFolder);
+
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{5,3},{1,1000}};
+  BOOST_CHECK(Save(matches, testFolder, "bin", false));
+
+  const std::string filepath = (fs::path(testFolder) / "matches.bin").string();
+  std::ifstream fileIn(filepath, std::ios::in | std::ios::binary);
+  const std::vector<char> fileData((std::istreambuf_iterator<char>(fileIn)), std::istreambuf_iterator<char>());
+  fileIn.close();
+
+  // header: magic (8), version (4), reserved (4), nbPairs (8), indexOffset (8)
+  // index entry: I (4), J (4), offset (8), size (8)
+  const std::size_t nbPairsOffset = 16;
+  const std::size_t indexOffsetOffset = 24;
+  std::uint64_t indexOffset = 0;
+  std::memcpy(&indexOffset, fileData.data() + indexOffsetOffset, sizeof(indexOffset));
+
+  const auto checkCorrupted = [&](std::size_t fieldOffset)
+  {
+    std::vector<char> corruptedData = fileData;
+    const std::uint64_t hugeValue = std::numeric_limits<std::uint64_t>::max() / 2;
+    std::memcpy(corruptedData.data() + fieldOffset, &hugeValue, sizeof(hugeValue));
+    {
+      std::ofstream fileOut(filepath, std::ios::out | std::ios::binary);
+      fileOut.write(corruptedData.data(), corruptedData.size());
+    }
+    // must be rejected before any allocation
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(!LoadMatchFile(loadedMatches, filepath, {}));
+    BOOST_CHECK(loadedMatches.empty());
+  };
+
+  // corrupted pairs count
+  checkCorrupted(nbPairsOffset);
+  // corrupted size of the first pair data block
+  checkCorrupted(indexOffset + 16);
+
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_TextAndBinary)
+{
+  const std::string testFolder = (fs::temp_directory_path() / fs::unique_path("matchingTextAndBinaryTest-%%%%%%")).string();
+  boost::filesystem::create_directory(testFolder);
+
+  PairwiseMatches textMatches;
+  textMatches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+  PairwiseMatches binaryMatches;
+  binaryMatches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0}};
+
+  BOOST_CHECK(Save(textMatches, testFolder, "txt", false));
+  BOOST_CHECK(Save(binaryMatches, testFolder, "bin", false));
+
+  const fs::path textPath = fs::path(testFolder) / "matches.txt";
+  const fs::path binaryPath = fs::path(testFolder) / "matches.bin";
+  const std::time_t time = fs::last_write_time(binaryPath);
+
+  // the most recent file is used
+  {
+    fs::last_write_time(textPath, time + 10);
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, {}, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.count(std::make_pair(0,1)));
+  }
+  {
+    fs::last_write_time(textPath, time - 10);
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, {}, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.count(std::make_pair(1,2)));
+  }
+  // ambiguous if written at the same time
+  {
+    fs::last_write_time(textPath, time);
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(!Load(loadedMatches, {}, {testFolder}, {}));
+  }
+
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -12,6 +12,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <map>
 #include <fstream>
 #include <iterator>
@@ -23,7 +26,267 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
-bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
+namespace {
+
+/// Binary matches file signature
+const char BINARY_MATCHES_MAGIC[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', 'S'};
+/// Binary matches file format version
+const std::uint32_t BINARY_MATCHES_VERSION = 1;
+
+/**
+ * @brief Header of a binary matches file (.bin).
+ *
+ * The file contains the header, the data block of each pair and the pair index table
+ * (one BinaryMatchesPairEntry per pair, sorted by pair) at indexOffset.
+ *
+ * A pair data block is a sequence of unsigned LEB128 varints:
+ * nbDescType, then for each descType:
+ * descTypeNameLength, descTypeName (raw chars), nbMatches,
+ * then for each match the zigzag-encoded deltas of _i and _j with the previous match.
+ */
+struct BinaryMatchesHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t nbPairs;
+  std::uint64_t indexOffset;
+};
+
+struct BinaryMatchesPairEntry
+{
+  std::uint32_t I;
+  std::uint32_t J;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+inline void writeVarint(std::string& buffer, std::uint64_t value)
+{
+  while(value >= 0x80)
+  {
+    buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+inline bool readVarint(const char*& it, const char* end, std::uint64_t& value)
+{
+  value = 0;
+  for(int shift = 0; it != end && shift < 64; shift += 7)
+  {
+    const std::uint8_t byte = static_cast<std::uint8_t>(*it++);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+inline std::uint64_t zigzagEncode(std::int64_t value)
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzagDecode(std::uint64_t value)
+{
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+} // namespace
+
+void encodeMatchesPerDescType(const MatchesPerDescType& matchesPerDesc, std::string& buffer)
+{
+  writeVarint(buffer, matchesPerDesc.size());
+  for(const auto& m: matchesPerDesc)
+  {
+    const std::string descTypeStr = feature::EImageDescriberType_enumToString(m.first);
+    writeVarint(buffer, descTypeStr.size());
+    buffer.append(descTypeStr);
+    writeVarint(buffer, m.second.size());
+
+    std::int64_t prevI = 0;
+    std::int64_t prevJ = 0;
+    for(const IndMatch& match: m.second)
+    {
+      writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._i) - prevI));
+      writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._j) - prevJ));
+      prevI = match._i;
+      prevJ = match._j;
+    }
+  }
+}
+
+bool decodeMatchesPerDescType(const std::string& buffer, MatchesPerDescType& matchesPerDesc)
+{
+  const char* it = buffer.data();
+  const char* end = buffer.data() + buffer.size();
+
+  std::uint64_t nbDescType = 0;
+  if(!readVarint(it, end, nbDescType))
+    return false;
+
+  for(std::uint64_t d = 0; d < nbDescType; ++d)
+  {
+    std::uint64_t descTypeStrSize = 0;
+    if(!readVarint(it, end, descTypeStrSize) || descTypeStrSize > static_cast<std::uint64_t>(end - it))
+      return false;
+    const std::string descTypeStr(it, descTypeStrSize);
+    it += descTypeStrSize;
+
+    std::uint64_t nbMatches = 0;
+    if(!readVarint(it, end, nbMatches) || nbMatches > static_cast<std::uint64_t>(end - it))
+      return false;
+
+    IndMatches& matchesOfDesc = matchesPerDesc[feature::EImageDescriberType_stringToEnum(descTypeStr)];
+    matchesOfDesc.resize(nbMatches);
+
+    std::int64_t prevI = 0;
+    std::int64_t prevJ = 0;
+    for(IndMatch& match: matchesOfDesc)
+    {
+      std::uint64_t deltaI = 0;
+      std::uint64_t deltaJ = 0;
+      if(!readVarint(it, end, deltaI) || !readVarint(it, end, deltaJ))
+        return false;
+      prevI += zigzagDecode(deltaI);
+      prevJ += zigzagDecode(deltaJ);
+      match._i = static_cast<IndexT>(prevI);
+      match._j = static_cast<IndexT>(prevJ);
+    }
+  }
+  return it == end;
+}
+
+namespace {
+
+inline bool isPairInViews(const Pair& pair, const std::set<IndexT>& viewsKeys)
+{
+  return viewsKeys.empty() ||
+         (viewsKeys.find(pair.first) != viewsKeys.end() &&
+          viewsKeys.find(pair.second) != viewsKeys.end());
+}
+
+bool LoadBinaryMatchFile(PairwiseMatches& matches, const std::string& filepath, const std::set<IndexT>& viewsKeys)
+{
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  BinaryMatchesHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(BinaryMatchesHeader));
+
+  if(!stream.good() ||
+     std::memcmp(header.magic, BINARY_MATCHES_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != BINARY_MATCHES_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matching file: " << filepath);
+    return false;
+  }
+
+  stream.seekg(0, std::ios::end);
+  const std::uint64_t fileSize = static_cast<std::uint64_t>(stream.tellg());
+
+  // check the pair index table against the file size before any allocation
+  // (compare by division to avoid overflows with a corrupted count)
+  if(header.indexOffset < sizeof(BinaryMatchesHeader) ||
+     header.indexOffset > fileSize ||
+     header.nbPairs > (fileSize - header.indexOffset) / sizeof(BinaryMatchesPairEntry))
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matching file index: " << filepath);
+    return false;
+  }
+
+  // read the pair index table
+  std::vector<BinaryMatchesPairEntry> index(header.nbPairs);
+  stream.seekg(header.indexOffset);
+  stream.read(reinterpret_cast<char*>(index.data()), header.nbPairs * sizeof(BinaryMatchesPairEntry));
+
+  if(!stream.good())
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary matching file index: " << filepath);
+    return false;
+  }
+
+  // only read the data blocks of the requested pairs
+  std::string buffer;
+  for(const BinaryMatchesPairEntry& entry: index)
+  {
+    const Pair pair(entry.I, entry.J);
+    if(!isPairInViews(pair, viewsKeys))
+      continue;
+
+    // the data block must be between the header and the index table
+    if(entry.offset < sizeof(BinaryMatchesHeader) ||
+       entry.offset > header.indexOffset ||
+       entry.size > header.indexOffset - entry.offset)
+    {
+      ALICEVISION_LOG_WARNING("Invalid binary matching file data for pair (" << entry.I << ", " << entry.J << "): " << filepath);
+      return false;
+    }
+
+    buffer.resize(entry.size);
+    stream.seekg(entry.offset);
+    stream.read(&buffer[0], entry.size);
+
+    MatchesPerDescType matchesPerDesc;
+    if(!stream.good() || !decodeMatchesPerDescType(buffer, matchesPerDesc))
+    {
+      ALICEVISION_LOG_WARNING("Invalid binary matching file data for pair (" << entry.I << ", " << entry.J << "): " << filepath);
+      return false;
+    }
+    for(auto& m: matchesPerDesc)
+      matches[pair][m.first] = std::move(m.second);
+  }
+  return true;
+}
+
+/**
+ * @brief Select the matches file to load when both the text and the binary formats can exist.
+ * @note If both files exist, the most recently written one is used,
+ *       so a stale file from a previous run in the other format is ignored.
+ * @param[in] textPath The text matches file path (.txt)
+ * @param[in] binaryPath The binary matches file path (.bin)
+ * @param[out] matchFilePath The selected file path, empty if none exists
+ * @return false if both files exist with the same modification time (ambiguous)
+ */
+bool selectMatchFile(const fs::path& textPath, const fs::path& binaryPath, std::string& matchFilePath)
+{
+  matchFilePath.clear();
+
+  const bool textExists = fs::exists(textPath);
+  const bool binaryExists = fs::exists(binaryPath);
+
+  if(textExists && binaryExists)
+  {
+    const std::time_t textTime = fs::last_write_time(textPath);
+    const std::time_t binaryTime = fs::last_write_time(binaryPath);
+
+    if(textTime == binaryTime)
+    {
+      ALICEVISION_LOG_ERROR("Can't choose between the matches files '" << textPath.string() << "' and '"
+                            << binaryPath.string() << "' written at the same time, remove one of them.");
+      return false;
+    }
+
+    matchFilePath = (binaryTime > textTime) ? binaryPath.string() : textPath.string();
+    ALICEVISION_LOG_WARNING("Both text and binary matches files exist, the most recent one is used: '" << matchFilePath << "'.");
+  }
+  else if(binaryExists)
+  {
+    matchFilePath = binaryPath.string();
+  }
+  else if(textExists)
+  {
+    matchFilePath = textPath.string();
+  }
+  return true;
+}
+
+} // namespace
+
+bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath, const std::set<IndexT>& viewsKeys)
 {
   const std::string ext = fs::extension(filepath);
 
@@ -50,6 +313,7 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     std::size_t nbDescType = 0;
     while(stream >> I >> J >> nbDescType)
     {
+      const bool keepPair = isPairInViews(std::make_pair(I,J), viewsKeys);
       for(std::size_t i = 0; i < nbDescType; ++i)
       {
         std::string descTypeStr;
@@ -64,12 +328,17 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
         {
           stream >> matchesPerDesc[i];
         }
-        matches[std::make_pair(I,J)][descType] = std::move(matchesPerDesc);
+        if(keepPair)
+          matches[std::make_pair(I,J)][descType] = std::move(matchesPerDesc);
       }
     }
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    return LoadBinaryMatchFile(matches, filepath, viewsKeys);
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -139,7 +408,10 @@ bool LoadMatchFilePerImage(
   const std::string& folder,
   const std::string& basename)
 {
+  const std::string binaryBasename = fs::path(basename).replace_extension(".bin").string();
+
   int nbLoadedMatchFiles = 0;
+  bool ambiguousMatchFile = false;
   // Load one match file per image
   #pragma omp parallel for num_threads(3)
   for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(viewsKeys.size()); ++i)
@@ -147,13 +419,23 @@ bool LoadMatchFilePerImage(
     std::set<IndexT>::const_iterator it = viewsKeys.begin();
     std::advance(it, i);
     const IndexT idView = *it;
-    const std::string matchFilename = std::to_string(idView) + "." + basename;
+    const fs::path binaryMatchPath = fs::path(folder) / (std::to_string(idView) + "." + binaryBasename);
+    const fs::path textMatchPath = fs::path(folder) / (std::to_string(idView) + "." + basename);
+    std::string matchFilename;
+    if(!selectMatchFile(textMatchPath, binaryMatchPath, matchFilename))
+    {
+      #pragma omp critical
+      {
+        ambiguousMatchFile = true;
+      }
+      continue;
+    }
     PairwiseMatches fileMatches;
-    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string() ))
+    if(matchFilename.empty() || !LoadMatchFile(fileMatches, matchFilename, viewsKeys))
     {
       #pragma omp critical
       {
-        ALICEVISION_LOG_DEBUG("Unable to load match file: " << matchFilename << " in: " << folder);
+        ALICEVISION_LOG_DEBUG("Unable to load match file: " << textMatchPath.filename().string() << " in: " << folder);
       }
       continue;
     }
@@ -167,6 +449,8 @@ bool LoadMatchFilePerImage(
       }
     }
   }
+  if(ambiguousMatchFile)
+    return false;
   if(nbLoadedMatchFiles == 0)
   {
     ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
@@ -193,13 +477,19 @@ bool Load(
 {
   bool res = false;
   const std::string fileName = "matches.txt";
+  const std::string binaryFileName = "matches.bin";
 
   for(const std::string& folder : folders)
   {
     const fs::path filePath = fs::path(folder) / fileName;
+    const fs::path binaryFilePath = fs::path(folder) / binaryFileName;
+
+    std::string matchFilePath;
+    if(!selectMatchFile(filePath, binaryFilePath, matchFilePath))
+      return false;
 
-    if(fs::exists(filePath))
-      res = LoadMatchFile(matches, filePath.string());
+    if(!matchFilePath.empty())
+      res = LoadMatchFile(matches, matchFilePath, viewsKeysFilter);
     else
       res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, fileName);
   }
@@ -267,6 +557,64 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // write temporary file
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+
+      BinaryMatchesHeader header;
+      std::memcpy(header.magic, BINARY_MATCHES_MAGIC, sizeof(header.magic));
+      header.version = BINARY_MATCHES_VERSION;
+      header.reserved = 0;
+      header.nbPairs = std::distance(matchBegin, matchEnd);
+      header.indexOffset = 0;
+
+      // header placeholder, updated once the index offset is known
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(BinaryMatchesHeader));
+
+      std::vector<BinaryMatchesPairEntry> index;
+      index.reserve(header.nbPairs);
+
+      std::uint64_t offset = sizeof(BinaryMatchesHeader);
+      std::string buffer;
+      for(PairwiseMatches::const_iterator match = matchBegin;
+        match != matchEnd;
+        ++match)
+      {
+        buffer.clear();
+        encodeMatchesPerDescType(match->second, buffer);
+        stream.write(buffer.data(), buffer.size());
+
+        BinaryMatchesPairEntry entry;
+        entry.I = match->first.first;
+        entry.J = match->first.second;
+        entry.offset = offset;
+        entry.size = buffer.size();
+        index.push_back(entry);
+
+        offset += buffer.size();
+      }
+
+      header.indexOffset = offset;
+      stream.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BinaryMatchesPairEntry));
+      stream.seekp(0);
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(BinaryMatchesHeader));
+
+      if(!stream.good())
+        throw std::runtime_error("Can't write matches file: " + tmpPath);
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -287,6 +635,8 @@ public:
 
     if(m_ext == ".txt")
       saveTxt(filepath, m_matches.begin(), m_matches.end());
+    else if(m_ext == ".bin")
+      saveBin(filepath, m_matches.begin(), m_matches.end());
     else
       throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
   }
@@ -312,6 +662,8 @@ public:
       
       if(m_ext == ".txt")
         saveTxt(filepath, matchBegin, match);
+      else if(m_ext == ".bin")
+        saveBin(filepath, matchBegin, match);
       else
         throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
 
@@ -9,6 +9,7 @@
 
 #include <aliceVision/matching/IndMatch.hpp>
 
+#include <set>
 #include <string>
 
 namespace aliceVision {
@@ -18,27 +19,40 @@ namespace matching {
 /**
  * @brief Load a match file.
  *
+ * Supported formats:
+ * - .txt: text file,
+ * - .bin: binary file with delta/varint encoded indexes and a pair index table,
+ *         only the data of the requested pairs is read.
+ *
  * @param[out] matches: container for the output matches
- * @param[in] folder: folder containing the match files
+ * @param[in] filepath: the match file
+ * @param[in] viewsKeys: load only the pairs between these views (all the pairs if empty)
  */
 bool LoadMatchFile(
   PairwiseMatches& matches,
-  const std::string& folder,
-  const std::string& filename);
+  const std::string& filepath,
+  const std::set<IndexT>& viewsKeys = std::set<IndexT>());
 
 /**
  * @brief Load the match file for each image.
+ * @note The binary file (.bin) is used if it exists, instead of the given basename extension.
+ *       If both files exist, the most recently written one is used.
  *
  * @param[out] matches: container for the output matches
+ * @param[in] viewsKeys: the views to load
  * @param[in] folder: folder containing the match files
+ * @param[in] basename: match file basename (e.g. matches.txt)
  */
 bool LoadMatchFilePerImage(
   PairwiseMatches& matches,
   const std::set<IndexT>& viewsKeys,
-  const std::string& folder);
+  const std::string& folder,
+  const std::string& basename);
 
 /**
  * @brief Load match files.
+ * @note If both the text (matches.txt) and the binary (matches.bin) files exist
+ *       in a folder, the most recently written one is used.
  *
  * @param[out] matches: container for the output matches
  * @param[in] sfm_data
@@ -66,6 +80,22 @@ void filterTopMatches(
   PairwiseMatches& allMatches,
   const int limitNum);
 
+/**
+ * @brief Append the compact binary encoding of the matches of one pair to a buffer
+ *        (the data block of a pair in the binary match files).
+ * @param[in] matchesPerDesc: the matches of one pair
+ * @param[in,out] buffer: the output buffer
+ */
+void encodeMatchesPerDescType(const MatchesPerDescType& matchesPerDesc, std::string& buffer);
+
+/**
+ * @brief Decode the matches of one pair encoded by encodeMatchesPerDescType().
+ * @param[in] buffer: the encoded matches
+ * @param[out] matchesPerDesc: the matches of the pair
+ * @return false if the buffer is invalid
+ */
+bool decodeMatchesPerDescType(const std::string& buffer, MatchesPerDescType& matchesPerDesc);
+
 /**
  * @brief Save match files.
  *
@@ -17,6 +17,7 @@ std::string EMatcherType_enumToString(EMatcherType matcherType)
   switch(matcherType)
   {
     case EMatcherType::BRUTE_FORCE_L2:          return "BRUTE_FORCE_L2";
+    case EMatcherType::BRUTE_FORCE_L2_TILED:    return "BRUTE_FORCE_L2_TILED";
     case EMatcherType::ANN_L2:                  return "ANN_L2";
     case EMatcherType::CASCADE_HASHING_L2:      return "CASCADE_HASHING_L2";
     case EMatcherType::FAST_CASCADE_HASHING_L2: return "FAST_CASCADE_HASHING_L2";
@@ -28,6 +29,7 @@ std::string EMatcherType_enumToString(EMatcherType matcherType)
 EMatcherType EMatcherType_stringToEnum(const std::string& matcherType)
 {
   if(matcherType == "BRUTE_FORCE_L2")           return EMatcherType::BRUTE_FORCE_L2;
+  if(matcherType == "BRUTE_FORCE_L2_TILED")     return EMatcherType::BRUTE_FORCE_L2_TILED;
   if(matcherType == "ANN_L2")                   return EMatcherType::ANN_L2;
   if(matcherType == "CASCADE_HASHING_L2")       return EMatcherType::CASCADE_HASHING_L2;
   if(matcherType == "FAST_CASCADE_HASHING_L2")  return EMatcherType::FAST_CASCADE_HASHING_L2;
@@ -15,6 +15,7 @@ namespace matching {
 enum EMatcherType
 {
   BRUTE_FORCE_L2,
+  BRUTE_FORCE_L2_TILED,
   ANN_L2,
   CASCADE_HASHING_L2,
   FAST_CASCADE_HASHING_L2,
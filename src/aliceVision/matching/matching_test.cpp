@@ -7,9 +7,13 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceTiled.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 #include <iostream>
+#include <random>
+
+#include <boost/filesystem.hpp>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -19,6 +23,8 @@ using namespace std;
 using namespace aliceVision;
 using namespace matching;
 
+namespace fs = boost::filesystem;
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim1)
 {
   const float array[] = {0, 1, 2, 3, 4};
@@ -82,6 +88,77 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim4)
   BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceTiled_NN)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+  // no 3, because it involve the same dist as 1,1
+  ArrayMatcher_bruteForceTiled<float> matcher;
+  BOOST_CHECK( matcher.Build(array, 5, 1) );
+
+  const float query[] = {2};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query,1, &vec_nIndice, &vec_fDistance, 5) );
+
+  BOOST_CHECK_EQUAL( 5, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( 5, vec_fDistance.size());
+
+  // Check distances:
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[0]- Square(2.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[1]- Square(1.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[2]- Square(0.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[3]- Square(5.0f-2.0f)), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[4]- Square(6.0f-2.0f)), 1e-6);
+
+  // Check indexes:
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(0,3), vec_nIndice[3]);
+  BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceTiled_vs_bruteForce)
+{
+  // more rows than the tile sizes, with incomplete last tiles
+  const int nbDatabase = 1100;
+  const int nbQuery = 300;
+  const int dimension = 128;
+  const size_t NN = 2;
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<unsigned char> database(nbDatabase * dimension);
+  std::vector<unsigned char> queries(nbQuery * dimension);
+  for (unsigned char& v : database)
+    v = static_cast<unsigned char>(dist(gen));
+  for (unsigned char& v : queries)
+    v = static_cast<unsigned char>(dist(gen));
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  ArrayMatcher_bruteForce<unsigned char, MetricT> matcher;
+  ArrayMatcher_bruteForceTiled<unsigned char, MetricT> matcherTiled;
+  BOOST_CHECK( matcher.Build(database.data(), nbDatabase, dimension) );
+  BOOST_CHECK( matcherTiled.Build(database.data(), nbDatabase, dimension) );
+
+  IndMatches indices, indicesTiled;
+  vector<float> distances, distancesTiled;
+  BOOST_CHECK( matcher.SearchNeighbours(queries.data(), nbQuery, &indices, &distances, NN) );
+  BOOST_CHECK( matcherTiled.SearchNeighbours(queries.data(), nbQuery, &indicesTiled, &distancesTiled, NN) );
+
+  BOOST_CHECK_EQUAL(indices.size(), indicesTiled.size());
+  BOOST_CHECK_EQUAL(distances.size(), distancesTiled.size());
+  for (size_t i = 0; i < distances.size(); ++i)
+  {
+    // integer descriptors: distances are exactly computed
+    BOOST_CHECK_EQUAL(distances[i], distancesTiled[i]);
+    BOOST_CHECK_EQUAL(indices[i]._i, indicesTiled[i]._i);
+    // neighbours with the same distance may be swapped
+    if (distances[i] != distances[i ^ 1])
+      BOOST_CHECK_EQUAL(indices[i]._j, indicesTiled[i]._j);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -148,3 +225,84 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Index_IO)
+{
+  typedef Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> DescriptorsMat;
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  // the second set of descriptors is a noisy copy of the first one
+  DescriptorsMat descriptors1(500, 128);
+  DescriptorsMat descriptors2(500, 128);
+  for(int i = 0; i < descriptors1.rows(); ++i)
+  {
+    for(int k = 0; k < descriptors1.cols(); ++k)
+    {
+      descriptors1(i, k) = distribution(generator);
+      descriptors2(i, k) = std::min(255, descriptors1(i, k) + distribution(generator) % 8);
+    }
+  }
+
+  CascadeHasher hasher;
+  hasher.Init(128, 6, 10, 42);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(descriptors1);
+  const std::uint64_t fingerprint = hasher.GetFingerprint(zeroMean);
+
+  const HashedDescriptions hashed1 = hasher.CreateHashedDescriptions(descriptors1, zeroMean);
+  const HashedDescriptions hashed2 = hasher.CreateHashedDescriptions(descriptors2, zeroMean);
+
+  // each description is in one bucket of each group
+  BOOST_CHECK_EQUAL(hashed1.nb_descriptions, 500);
+  BOOST_CHECK_EQUAL(hashed1.bucket_descriptions.size(), 500 * 6);
+  BOOST_CHECK_EQUAL(hashed1.bucket_offsets.back(), 500 * 6);
+
+  // the same seed gives the same hashing functions
+  {
+    CascadeHasher sameHasher;
+    sameHasher.Init(128, 6, 10, 42);
+    BOOST_CHECK_EQUAL(sameHasher.GetFingerprint(zeroMean), fingerprint);
+  }
+
+  const fs::path testFolder = fs::temp_directory_path() / fs::unique_path("cascadeHashingTest-%%%%%%");
+  fs::create_directory(testFolder);
+  const std::string indexFilename = (testFolder / "cascadeHashing_IO.hash").string();
+
+  // an index that can't be written is not saved, without throwing
+  BOOST_CHECK(!saveHashedDescriptions((testFolder / "missingFolder" / "cascadeHashing_IO.hash").string(), hashed1, fingerprint));
+  BOOST_CHECK(!saveCascadeHashingParameters((testFolder / "missingFolder" / "params.cascadeHashing").string(), 42, zeroMean));
+
+  BOOST_CHECK(saveHashedDescriptions(indexFilename, hashed1, fingerprint));
+
+  HashedDescriptions loaded;
+  BOOST_CHECK(!loadHashedDescriptions(indexFilename, fingerprint + 1, 500, loaded));
+  BOOST_CHECK(!loadHashedDescriptions(indexFilename, fingerprint, 499, loaded));
+  BOOST_CHECK(loadHashedDescriptions(indexFilename, fingerprint, 500, loaded));
+  fs::remove_all(testFolder);
+  BOOST_CHECK(loaded.hash_codes == hashed1.hash_codes);
+  BOOST_CHECK(loaded.bucket_ids == hashed1.bucket_ids);
+  BOOST_CHECK(loaded.bucket_offsets == hashed1.bucket_offsets);
+  BOOST_CHECK(loaded.bucket_descriptions == hashed1.bucket_descriptions);
+
+  // the loaded index gives the same matches, with or without reused scratch buffers
+  IndMatches matches;
+  std::vector<int> distances;
+  hasher.Match_HashedDescriptions<DescriptorsMat, int>(hashed2, descriptors2, hashed1, descriptors1, &matches, &distances);
+
+  CascadeHashingScratch scratch;
+  for(int run = 0; run < 2; ++run)
+  {
+    IndMatches loadedMatches;
+    std::vector<int> loadedDistances;
+    hasher.Match_HashedDescriptions<DescriptorsMat, int>(hashed2, descriptors2, loaded, descriptors1, &loadedMatches, &loadedDistances, 2, &scratch);
+    BOOST_CHECK(loadedMatches == matches);
+    BOOST_CHECK(loadedDistances == distances);
+  }
+
+  // most of the nearest neighbors are the original descriptors
+  std::size_t nbGoodMatches = 0;
+  for(std::size_t i = 0; i < matches.size(); i += 2)
+    nbGoodMatches += (matches[i]._i == matches[i]._j);
+  BOOST_CHECK_GT(nbGoodMatches, 400);
+}
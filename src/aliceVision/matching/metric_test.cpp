@@ -7,7 +7,9 @@
 
 #include "aliceVision/matching/metric.hpp"
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 #include <boost/test/included/unit_test.hpp>
@@ -133,3 +135,89 @@ BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET_RAW_MEMORY_32BITS)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Metric_HAMMING_BLOCKS_SIZE)
+{
+  // the size is a number of ElementType: all the bits of the blocks are compared
+  const uint64_t a[2] = {0xFFFFFFFFFFFFFFFFULL, 0x0ULL};
+  const uint64_t b[2] = {0x0ULL, 0xFFULL};
+
+  Hamming<uint64_t> metricHammingBlocks;
+  BOOST_CHECK_EQUAL(72, metricHammingBlocks(a, b, 2));
+  BOOST_CHECK_EQUAL(64, metricHammingBlocks(a, b, 1));
+
+  Hamming<unsigned char> metricHammingBytes;
+  BOOST_CHECK_EQUAL(72, metricHammingBytes(reinterpret_cast<const unsigned char*>(a),
+                                           reinterpret_cast<const unsigned char*>(b),
+                                           2 * sizeof(uint64_t)));
+}
+
+BOOST_AUTO_TEST_CASE(Metric_SIMD_kernels)
+{
+  const system::CpuFeatures& cpu = system::get_cpu_features();
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> realDist(-1.f, 1.f);
+  std::uniform_int_distribution<int> byteDist(0, 255);
+
+  // sizes that are not always a multiple of the SIMD registers width
+  const std::size_t sizes[] = {0, 1, 7, 31, 61, 64, 128, 131, 256, 515};
+  for(const std::size_t size : sizes)
+  {
+    std::vector<float> fa(size), fb(size);
+    std::vector<unsigned char> ua(size), ub(size);
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      fa[i] = realDist(gen);
+      fb[i] = realDist(gen);
+      ua[i] = static_cast<unsigned char>(byteDist(gen));
+      ub[i] = static_cast<unsigned char>(byteDist(gen));
+    }
+
+    const float gtL2Float = L2_Simple<float>()(fa.data(), fb.data(), size);
+    const float gtL2Uchar = L2_Simple<unsigned char>()(ua.data(), ub.data(), size);
+    unsigned int gtHamming = 0;
+    for(std::size_t i = 0; i < size; ++i)
+      gtHamming += std::bitset<8>(ua[i] ^ ub[i]).count();
+
+    const float tolerance = 1e-4f * (1.f + gtL2Float);
+
+    // dispatched kernels
+    BOOST_CHECK_SMALL(L2_Vectorized<float>()(fa.data(), fb.data(), size) - gtL2Float, tolerance);
+    BOOST_CHECK_EQUAL(gtL2Uchar, L2_Vectorized<unsigned char>()(ua.data(), ub.data(), size));
+    BOOST_CHECK_EQUAL(gtHamming, Hamming<unsigned char>()(ua.data(), ub.data(), size));
+
+    // each kernel supported by this CPU
+    BOOST_CHECK_SMALL(simd::l2_scalar(fa.data(), fb.data(), size) - gtL2Float, tolerance);
+    BOOST_CHECK_EQUAL(gtL2Uchar, simd::l2_scalar(ua.data(), ub.data(), size));
+    BOOST_CHECK_EQUAL(gtHamming, simd::hamming_scalar(ua.data(), ub.data(), size));
+#if ALICEVISION_SIMD_X86
+    if(cpu.sse2)
+    {
+      BOOST_CHECK_SMALL(simd::l2_sse2(fa.data(), fb.data(), size) - gtL2Float, tolerance);
+      BOOST_CHECK_EQUAL(gtL2Uchar, simd::l2_sse2(ua.data(), ub.data(), size));
+    }
+#if ALICEVISION_SIMD_X86_64
+    if(cpu.popcnt)
+      BOOST_CHECK_EQUAL(gtHamming, simd::hamming_popcnt(ua.data(), ub.data(), size));
+#endif
+    if(cpu.avx2 && cpu.fma)
+      BOOST_CHECK_SMALL(simd::l2_avx2(fa.data(), fb.data(), size) - gtL2Float, tolerance);
+    if(cpu.avx2)
+    {
+      BOOST_CHECK_EQUAL(gtL2Uchar, simd::l2_avx2(ua.data(), ub.data(), size));
+      BOOST_CHECK_EQUAL(gtHamming, simd::hamming_avx2(ua.data(), ub.data(), size));
+    }
+    if(cpu.avx512f)
+      BOOST_CHECK_SMALL(simd::l2_avx512(fa.data(), fb.data(), size) - gtL2Float, tolerance);
+    if(cpu.avx512bw)
+      BOOST_CHECK_EQUAL(gtL2Uchar, simd::l2_avx512(ua.data(), ub.data(), size));
+#if ALICEVISION_SIMD_AVX512_EXTENSIONS
+    if(cpu.avx512bw && cpu.avx512vnni)
+      BOOST_CHECK_EQUAL(gtL2Uchar, simd::l2_avx512vnni(ua.data(), ub.data(), size));
+    if(cpu.avx512vpopcntdq)
+      BOOST_CHECK_EQUAL(gtHamming, simd::hamming_avx512(ua.data(), ub.data(), size));
+#endif
+#endif
+  }
+}
@@ -12,9 +12,16 @@
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp>
+#include <aliceVision/matchingImageCollection/geometricFilterUtils.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/randomSeed.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <vector>
 #include <map>
 
@@ -49,45 +56,90 @@ void robustModelEstimation(
   out_geometricMatches.clear();
 
   boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
-  
-#pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putativeMatches.size(); ++i)
-  {
-    PairwiseMatches::const_iterator iter = putativeMatches.begin();
-    std::advance(iter, i);
 
-    const Pair currentPair = iter->first;
-    const MatchesPerDescType& putativeMatchesPerType = iter->second;
-    const Pair& imagePair = iter->first;
+  // largest pairs first, pairs of the same view together
+  const std::vector<PairwiseMatches::const_iterator> pairs = getGeometricFilteringOrder(putativeMatches);
+
+  // per-thread results, merged at the end to avoid contention on the output map
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::vector<std::pair<Pair, MatchesPerDescType>>> threadMatches(nbThreads);
+  std::vector<std::vector<PairTiming>> threadTimings(nbThreads);
+
+  // update the progress bar by steps of ~1%
+  const std::size_t progressStep = std::max<std::size_t>(1, pairs.size() / 100);
+
+#pragma omp parallel
+  {
+    std::vector<std::pair<Pair, MatchesPerDescType>>& localMatches = threadMatches[omp_get_thread_num()];
+    std::vector<PairTiming>& localTimings = threadTimings[omp_get_thread_num()];
+    std::size_t nbProcessed = 0;
 
-    // apply the geometric filter (robust model estimation)
+#pragma omp for schedule(dynamic)
+    for(int i = 0; i < (int)pairs.size(); ++i)
     {
-      MatchesPerDescType inliers;
-      GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
-      const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
-      if(state.hasStrongSupport)
+      system::Timer timer;
+      const Pair& imagePair = pairs[i]->first;
+      const MatchesPerDescType& putativeMatchesPerType = pairs[i]->second;
+      // random numbers of the robust estimation only depend on the pair
+      system::RandomTaskScope randomTask((static_cast<uint64_t>(imagePair.first) << 32) | imagePair.second);
+
+      // apply the geometric filter (robust model estimation)
       {
-        if(guidedMatching)
+        MatchesPerDescType inliers;
+        GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
+        const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
+        if(state.hasStrongSupport)
         {
-          MatchesPerDescType guidedGeometricInliers;
-          geometricFilter.Geometry_guided_matching(sfmData, regionsPerView, imagePair, distanceRatio, guidedGeometricInliers);
-          //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
-          std::swap(inliers, guidedGeometricInliers);
+          if(guidedMatching)
+          {
+            MatchesPerDescType guidedGeometricInliers;
+            geometricFilter.Geometry_guided_matching(sfmData, regionsPerView, imagePair, distanceRatio, guidedGeometricInliers);
+            //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
+            std::swap(inliers, guidedGeometricInliers);
+          }
+          localMatches.emplace_back(imagePair, std::move(inliers));
         }
+      }
+
+      localTimings.push_back({imagePair, putativeMatchesPerType.getNbAllMatches(), timer.elapsedMs()});
 
+      if(++nbProcessed == progressStep)
+      {
 #pragma omp critical
         {
-          out_geometricMatches.emplace(currentPair, std::move(inliers));
+          progressBar += nbProcessed;
         }
-
+        nbProcessed = 0;
       }
     }
 
-#pragma omp critical
+    if(nbProcessed > 0)
     {
-      ++progressBar;
+#pragma omp critical
+      {
+        progressBar += nbProcessed;
+      }
     }
   }
+
+  // merge the per-thread results
+  std::vector<std::pair<Pair, MatchesPerDescType>> allMatches;
+  std::vector<PairTiming> allTimings;
+  allTimings.reserve(pairs.size());
+  for(int t = 0; t < nbThreads; ++t)
+  {
+    std::move(threadMatches[t].begin(), threadMatches[t].end(), std::back_inserter(allMatches));
+    allTimings.insert(allTimings.end(), threadTimings[t].begin(), threadTimings[t].end());
+  }
+  std::sort(allMatches.begin(), allMatches.end(), [](const std::pair<Pair, MatchesPerDescType>& a,
+                                                     const std::pair<Pair, MatchesPerDescType>& b)
+  {
+    return a.first < b.first;
+  });
+  for(auto& matches : allMatches)
+    out_geometricMatches.emplace_hint(out_geometricMatches.end(), matches.first, std::move(matches.second));
+
+  logTimingsHistogram(allTimings);
 }
 
 } // namespace matchingImageCollection
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+
 namespace aliceVision {
 
 
@@ -34,6 +36,9 @@ struct GeometricFilterMatrix
     : m_dPrecision(precision)
     , m_dPrecision_robust(precisionRobust)
     , m_stIteration(stIteration)
+    , m_nfaMode(robustEstimation::EACRansacNFA::EXACT)
+    , m_useSPRT(false)
+    , m_useGridGuidedMatching(false)
   {}
 
   /**
@@ -58,6 +63,9 @@ struct GeometricFilterMatrix
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
   std::size_t m_stIteration; //maximal number of iteration for robust estimation
+  robustEstimation::EACRansacNFA m_nfaMode; //NFA evaluation of the A Contrario robust estimation (HISTOGRAM only sorts a part of the residuals)
+  bool m_useSPRT; //early rejection of the bad models during the robust estimation
+  bool m_useGridGuidedMatching; //guided matching only compares the features of the cells close to the epipolar line / homography transfer
 };
 
 
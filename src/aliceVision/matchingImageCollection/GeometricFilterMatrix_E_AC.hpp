@@ -94,7 +94,7 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_E, upper_bound_precision);
+    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_E, upper_bound_precision, false, m_nfaMode, nullptr, m_useSPRT);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
@@ -160,14 +160,28 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
       Mat3 F;
       FundamentalFromEssential(m_E, ptrPinhole_I->K(), ptrPinhole_J->K(), &F);
 
-      robustEstimation::GuidedMatching<Mat3,
-            aliceVision::fundamental::kernel::EpipolarDistanceError>(
-            //aliceVision::fundamental::kernel::SymmetricEpipolarDistanceError>(
-        F,
-        cam_I, regionsPerView.getAllRegions(viewId_I),
-        cam_J, regionsPerView.getAllRegions(viewId_J),
-        Square(m_dPrecision_robust), Square(dDistanceRatio),
-        matches);
+      if(m_useGridGuidedMatching)
+      {
+        robustEstimation::GuidedMatching_Grid<Mat3,
+              aliceVision::fundamental::kernel::EpipolarDistanceError,
+              robustEstimation::EpipolarBandSearchArea>(
+          F,
+          cam_I, regionsPerView.getAllRegions(viewId_I),
+          cam_J, regionsPerView.getAllRegions(viewId_J),
+          Square(m_dPrecision_robust), Square(dDistanceRatio),
+          matches);
+      }
+      else
+      {
+        robustEstimation::GuidedMatching<Mat3,
+              aliceVision::fundamental::kernel::EpipolarDistanceError>(
+              //aliceVision::fundamental::kernel::SymmetricEpipolarDistanceError>(
+          F,
+          cam_I, regionsPerView.getAllRegions(viewId_I),
+          cam_J, regionsPerView.getAllRegions(viewId_J),
+          Square(m_dPrecision_robust), Square(dDistanceRatio),
+          matches);
+      }
     }
     return matches.getNbAllMatches() != 0;
   }
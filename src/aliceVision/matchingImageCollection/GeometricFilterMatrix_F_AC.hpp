@@ -172,7 +172,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
         // Robustly estimate the Fundamental matrix with A Contrario ransac
         const double upper_bound_precision = Square(m_dPrecision);
         const std::pair<double,double> ACRansacOut =
-          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision);
+          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision, false, m_nfaMode, nullptr, m_useSPRT);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -204,7 +204,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
         const double normalizedThreshold = Square(m_dPrecision * kernel.normalizer2()(0, 0));
         ScoreEvaluator<KernelType> scorer(normalizedThreshold);
 
-        m_F = LO_RANSAC(kernel, scorer, &out_inliers);
+        m_F = LO_RANSAC(kernel, scorer, &out_inliers, nullptr, false, 100, 1e-2, m_useSPRT);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -253,15 +253,29 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
           sfmData->getIntrinsics().at(view_J->getIntrinsicId()).get() : nullptr;
 
       // Check the features correspondences that agree in the geometric and photometric domain
-      robustEstimation::GuidedMatching<Mat3,
-                                     fundamental::kernel::EpipolarDistanceError>(
-        m_F,
-        cam_I, // camera::IntrinsicBase
-        regionsPerView.getAllRegions(viewId_I), // feature::Regions
-        cam_J, // camera::IntrinsicBase
-        regionsPerView.getAllRegions(viewId_J), // feature::Regions
-        Square(m_dPrecision_robust), Square(dDistanceRatio),
-        matches);
+      if(m_useGridGuidedMatching)
+      {
+        robustEstimation::GuidedMatching_Grid<Mat3,
+                                              fundamental::kernel::EpipolarDistanceError,
+                                              robustEstimation::EpipolarBandSearchArea>(
+          m_F,
+          cam_I, regionsPerView.getAllRegions(viewId_I),
+          cam_J, regionsPerView.getAllRegions(viewId_J),
+          Square(m_dPrecision_robust), Square(dDistanceRatio),
+          matches);
+      }
+      else
+      {
+        robustEstimation::GuidedMatching<Mat3,
+                                       fundamental::kernel::EpipolarDistanceError>(
+          m_F,
+          cam_I, // camera::IntrinsicBase
+          regionsPerView.getAllRegions(viewId_I), // feature::Regions
+          cam_J, // camera::IntrinsicBase
+          regionsPerView.getAllRegions(viewId_J), // feature::Regions
+          Square(m_dPrecision_robust), Square(dDistanceRatio),
+          matches);
+      }
     }
     return matches.getNbAllMatches() != 0;
   }
@@ -76,7 +76,7 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision);
+    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision, false, m_nfaMode, nullptr, m_useSPRT);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
@@ -223,9 +223,14 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
           createMatricesWithUndistortFeatures(cam_I, pointsFeaturesI, xI);
           createMatricesWithUndistortFeatures(cam_J, pointsFeaturesJ, xJ);
 
-          robustEstimation::GuidedMatching
-            <Mat3, aliceVision::homography::kernel::AsymmetricError>(
-            m_H, xI, xJ, Square(m_dPrecision_robust), localMatches);
+          if(m_useGridGuidedMatching)
+            robustEstimation::GuidedMatching_Grid
+              <Mat3, aliceVision::homography::kernel::AsymmetricError, robustEstimation::HomographyDiskSearchArea>(
+              m_H, xI, xJ, Square(m_dPrecision_robust), localMatches);
+          else
+            robustEstimation::GuidedMatching
+              <Mat3, aliceVision::homography::kernel::AsymmetricError>(
+              m_H, xI, xJ, Square(m_dPrecision_robust), localMatches);
 
           // Remove matches that have the same (X,Y) coordinates
           matching::IndMatchDecorator<float> matchDeduplicator(localMatches, pointsFeaturesI, pointsFeaturesJ);
@@ -236,13 +241,22 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
       else
       {
         // Filtering based on region positions and regions descriptors
-        robustEstimation::GuidedMatching
-          <Mat3, aliceVision::homography::kernel::AsymmetricError>(
-          m_H,
-          cam_I, regionsPerView.getAllRegions(viewId_I),
-          cam_J, regionsPerView.getAllRegions(viewId_J),
-          Square(m_dPrecision_robust), Square(dDistanceRatio),
-          matches);
+        if(m_useGridGuidedMatching)
+          robustEstimation::GuidedMatching_Grid
+            <Mat3, aliceVision::homography::kernel::AsymmetricError, robustEstimation::HomographyDiskSearchArea>(
+            m_H,
+            cam_I, regionsPerView.getAllRegions(viewId_I),
+            cam_J, regionsPerView.getAllRegions(viewId_J),
+            Square(m_dPrecision_robust), Square(dDistanceRatio),
+            matches);
+        else
+          robustEstimation::GuidedMatching
+            <Mat3, aliceVision::homography::kernel::AsymmetricError>(
+            m_H,
+            cam_I, regionsPerView.getAllRegions(viewId_I),
+            cam_J, regionsPerView.getAllRegions(viewId_J),
+            Square(m_dPrecision_robust), Square(dDistanceRatio),
+            matches);
       }
     }
     return matches.getNbAllMatches() != 0;
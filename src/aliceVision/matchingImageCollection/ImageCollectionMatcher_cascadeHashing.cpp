@@ -9,10 +9,18 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+#include <atomic>
+#include <random>
+
+namespace fs = boost::filesystem;
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -22,13 +30,27 @@ using namespace aliceVision::feature;
 ImageCollectionMatcher_cascadeHashing
 ::ImageCollectionMatcher_cascadeHashing
 (
-  float distRatio
-):IImageCollectionMatcher(), f_dist_ratio_(distRatio)
+  float distRatio,
+  const std::vector<std::string>& indexFolders
+):IImageCollectionMatcher(), f_dist_ratio_(distRatio), index_folders_(indexFolders)
 {
 }
 
 namespace impl
 {
+/// Check that the folder of the on-disk index exists or can be created,
+/// the index files written in it are checked when they are saved
+inline bool checkIndexFolder(const std::string& folder)
+{
+  boost::system::error_code ec;
+  if (!fs::is_directory(folder, ec))
+    fs::create_directories(folder, ec);
+  if (fs::is_directory(folder, ec))
+    return true;
+  ALICEVISION_LOG_WARNING("Can't use the cascade hashing index folder '" << folder << "', the cascade hashing index is not saved.");
+  return false;
+}
+
 template <typename ScalarT>
 void Match
 (
@@ -36,6 +58,7 @@ void Match
   const PairSet & pairs,
   EImageDescriberType descType,
   float fDistRatio,
+  const std::vector<std::string>& indexFolders,
   PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
 )
 {
@@ -53,29 +76,38 @@ void Match
     used_index.insert(iter->second);
   }
 
+  const std::vector<IndexT> used_views(used_index.begin(), used_index.end());
+
   typedef Eigen::Matrix<ScalarT, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BaseMat;
 
-  // Init the cascade hasher
-  CascadeHasher cascade_hasher;
+  const std::string descTypeName = EImageDescriberType_enumToString(descType);
+  std::size_t dimension = 0;
   if (!used_index.empty())
+    dimension = regionsPerView.getRegions(*used_index.begin(), descType).DescriptorLength();
+
+  // Reuse the hashing parameters of the index folders, so the saved indexes stay valid
+  unsigned int seed = system::getRandomSeed();
+  Eigen::VectorXf zero_mean_descriptor;
+  bool reuseParameters = false;
+  std::atomic_bool saveIndex(!indexFolders.empty() && checkIndexFolder(indexFolders.front()));
+  const std::string parametersFilename = descTypeName + ".cascadeHashing";
+  for (const std::string& folder : indexFolders)
   {
-    const IndexT I = *used_index.begin();
-    const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-    const size_t dimension = regionsI.DescriptorLength();
-    cascade_hasher.Init(dimension);
+    if (loadCascadeHashingParameters((fs::path(folder) / parametersFilename).string(), seed, zero_mean_descriptor) &&
+        zero_mean_descriptor.size() == dimension)
+    {
+      reuseParameters = true;
+      break;
+    }
   }
 
-  std::map<IndexT, HashedDescriptions> hashed_base_;
-
   // Compute the zero mean descriptor that will be used for hashing (one for all the image regions)
-  Eigen::VectorXf zero_mean_descriptor;
+  if (!reuseParameters)
   {
     Eigen::MatrixXf matForZeroMean;
-    for (int i =0; i < used_index.size(); ++i)
+    for (int i =0; i < used_views.size(); ++i)
     {
-      std::set<IndexT>::const_iterator iter = used_index.begin();
-      std::advance(iter, i);
-      const IndexT I = *iter;
+      const IndexT I = used_views[i];
       const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
       const ScalarT * tabI =
         reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
@@ -92,29 +124,74 @@ void Match
       }
     }
     zero_mean_descriptor = CascadeHasher::GetZeroMeanDescriptor(matForZeroMean);
+
+    // the on-disk index is only written if its parameters are saved
+    if (saveIndex && !saveCascadeHashingParameters((fs::path(indexFolders.front()) / parametersFilename).string(), seed, zero_mean_descriptor))
+    {
+      ALICEVISION_LOG_WARNING("Can't save the cascade hashing parameters in '" << indexFolders.front() << "', the cascade hashing index is not saved.");
+      saveIndex = false;
+    }
   }
 
-  // Index the input regions
+  // Init the cascade hasher
+  CascadeHasher cascade_hasher;
+  if (dimension > 0)
+    cascade_hasher.Init(dimension, 6, 10, seed);
+  const std::uint64_t fingerprint = cascade_hasher.GetFingerprint(zero_mean_descriptor);
+
+  std::map<IndexT, HashedDescriptions> hashed_base_;
+
+  // Index the input regions (or load their saved index)
   #pragma omp parallel for schedule(dynamic)
-  for (int i =0; i < used_index.size(); ++i)
+  for (int i =0; i < used_views.size(); ++i)
   {
-    std::set<IndexT>::const_iterator iter = used_index.begin();
-    std::advance(iter, i);
-    const IndexT I = *iter;
+    const IndexT I = used_views[i];
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-    const ScalarT * tabI =
-      reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
-    const size_t dimension = regionsI.DescriptorLength();
+    const std::string indexFilename = std::to_string(I) + "." + descTypeName + ".hash";
 
-    Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-    HashedDescriptions hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
-      zero_mean_descriptor);
+    HashedDescriptions hashed_description;
+    bool loaded = false;
+    // exceptions can't escape the parallel region, the on-disk index is optional
+    try
+    {
+      for (const std::string& folder : indexFolders)
+      {
+        loaded = loadHashedDescriptions((fs::path(folder) / indexFilename).string(), fingerprint, regionsI.RegionCount(), hashed_description);
+        if (loaded)
+          break;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Can't load the cascade hashing index of the view " << I << ": " << e.what());
+      loaded = false;
+    }
+
+    if (!loaded)
+    {
+      const ScalarT * tabI =
+        reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
+
+      Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
+      hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
+        zero_mean_descriptor);
+
+      if (saveIndex && !saveHashedDescriptions((fs::path(indexFolders.front()) / indexFilename).string(), hashed_description, fingerprint))
+      {
+        // warn once, the other views are not saved either
+        if (saveIndex.exchange(false))
+          ALICEVISION_LOG_WARNING("Can't save the cascade hashing index in '" << indexFolders.front() << "', the matching continues without the on-disk index.");
+      }
+    }
     #pragma omp critical
     {
       hashed_base_[I] = std::move(hashed_description);
     }
   }
 
+  // Matching buffers reused by each thread
+  std::vector<CascadeHashingScratch> scratches(omp_get_max_threads());
+
   // Perform matching between all the pairs
   for (Map_vectorT::const_iterator iter = map_Pairs.begin();
     iter != map_Pairs.end(); ++iter)
@@ -132,21 +209,20 @@ void Match
     const std::vector<feature::PointFeature> pointFeaturesI = regionsI.GetRegionsPositions();
     const ScalarT * tabI =
       reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
-    const size_t dimension = regionsI.DescriptorLength();
     Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
     #pragma omp parallel for schedule(dynamic)
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
       size_t J = indexToCompare[j];
-      const feature::Regions &regionsJ = regionsPerView.getRegions(I, descType);
 
       if (!regionsPerView.viewExist(J)
-          || regionsI.Type_id() != regionsJ.Type_id())
+          || regionsI.Type_id() != regionsPerView.getRegions(J, descType).Type_id())
       {
         #pragma omp critical
         ++my_progress_bar;
         continue;
       }
+      const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
 
       // Matrix representation of the query input data;
       const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
@@ -160,9 +236,10 @@ void Match
 
       // Match the query descriptors to the database
       cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
-        &pvec_indices, &pvec_distances);
+        hashed_base_.at(J), mat_J,
+        hashed_base_.at(I), mat_I,
+        &pvec_indices, &pvec_distances,
+        2, &scratches[omp_get_thread_num()]);
 
       std::vector<int> vec_nn_ratio_idx;
       // Filter the matches using a distance ratio test:
@@ -234,6 +311,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      index_folders_,
       map_PutativesMatches);
   }
   else
@@ -244,6 +322,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      index_folders_,
       map_PutativesMatches);
   }
   else
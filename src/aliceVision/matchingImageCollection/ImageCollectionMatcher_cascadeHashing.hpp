@@ -19,6 +19,8 @@ namespace matchingImageCollection {
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
  * @note: Cascade hashing tables are computed once and used for all the regions.
+ *        If index folders are given, the hashing parameters and the tables of each view
+ *        are saved in the first folder and reused by the next matching runs.
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
 class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
@@ -26,7 +28,8 @@ class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
   public:
   ImageCollectionMatcher_cascadeHashing
   (
-    float dist_ratio
+    float dist_ratio,
+    const std::vector<std::string>& indexFolders = std::vector<std::string>()
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -40,6 +43,8 @@ class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
   private:
   // Distance ratio used to discard spurious correspondence
   float f_dist_ratio_;
+  // Folders of the persistent cascade hashing indexes
+  std::vector<std::string> index_folders_;
 };
 
 } // namespace aliceVision
@@ -0,0 +1,126 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsCache.hpp"
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <atomic>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+RegionsCache::RegionsCache(const sfm::SfMData& sfmData,
+                           const std::vector<std::string>& folders,
+                           const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+                           std::size_t maxMemorySize)
+  : _featuresFolders(sfmData.getFeaturesFolders()) // add sfm features folders
+  , _imageDescriberTypes(imageDescriberTypes)
+  , _maxMemorySize(maxMemorySize)
+{
+  _featuresFolders.insert(_featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
+
+  for(const feature::EImageDescriberType descType : _imageDescriberTypes)
+    _imageDescribers.push_back(feature::createImageDescriber(descType));
+}
+
+bool RegionsCache::load(const std::vector<IndexT>& viewIds, std::set<IndexT>& loadedViewIds)
+{
+  loadedViewIds.clear();
+
+  // release the views that are not used by the batch
+  const std::set<IndexT> batchViewIds(viewIds.begin(), viewIds.end());
+  std::vector<IndexT> toRelease;
+  for(const auto& viewMemorySize : _viewMemorySizes)
+  {
+    if(batchViewIds.count(viewMemorySize.first) == 0)
+      toRelease.push_back(viewMemorySize.first);
+  }
+  for(const IndexT viewId : toRelease)
+    release(viewId);
+
+  const std::size_t nbThreads = 3;
+  std::size_t nbLoaded = 0;
+  std::size_t v = 0;
+
+  // load the missing views by chunks of parallel loads until the memory budget is reached
+  while(v < viewIds.size() && (loadedViewIds.size() < 2 || _memorySize < _maxMemorySize))
+  {
+    std::vector<IndexT> toLoad;
+    for(; v < viewIds.size() && toLoad.size() < nbThreads; ++v)
+    {
+      const IndexT viewId = viewIds.at(v);
+      loadedViewIds.insert(viewId);
+      if(_viewMemorySizes.count(viewId) == 0)
+        toLoad.push_back(viewId);
+    }
+
+    std::atomic_bool invalid(false);
+
+#pragma omp parallel for num_threads(nbThreads)
+    for(int i = 0; i < (int)toLoad.size(); ++i)
+    {
+      const IndexT viewId = toLoad.at(i);
+      for(std::size_t d = 0; d < _imageDescriberTypes.size() && !invalid; ++d)
+      {
+        // exceptions can't escape the parallel region
+        std::unique_ptr<feature::Regions> regionsPtr;
+        try
+        {
+          regionsPtr = sfm::loadRegions(_featuresFolders, viewId, *_imageDescribers.at(d));
+        }
+        catch(const std::exception& e)
+        {
+          ALICEVISION_LOG_ERROR("Can't load the regions of the view " << viewId << ": " << e.what());
+          invalid = true;
+          break;
+        }
+        const std::size_t memorySize = regionsPtr->MemorySize();
+#pragma omp critical
+        {
+          _regionsPerView.addRegions(viewId, _imageDescriberTypes.at(d), regionsPtr.release());
+          _viewMemorySizes[viewId] += memorySize;
+          _memorySize += memorySize;
+        }
+      }
+    }
+
+    if(invalid)
+      return false;
+
+    nbLoaded += toLoad.size();
+  }
+
+  // the views already loaded stay in memory, they are usable by the batch
+  for(; v < viewIds.size(); ++v)
+  {
+    if(_viewMemorySizes.count(viewIds.at(v)) != 0)
+      loadedViewIds.insert(viewIds.at(v));
+  }
+
+  if(_memorySize > _maxMemorySize)
+  {
+    ALICEVISION_LOG_WARNING("The regions of the " << loadedViewIds.size() << " loaded views use "
+                            << _memorySize / (1024 * 1024) << " MB, more than the memory budget ("
+                            << _maxMemorySize / (1024 * 1024) << " MB).");
+  }
+
+  ALICEVISION_LOG_DEBUG("Regions cache: " << toRelease.size() << " views released, " << nbLoaded
+                        << " views loaded, " << _viewMemorySizes.size() << " views in memory ("
+                        << _memorySize / (1024 * 1024) << " MB), "
+                        << viewIds.size() - loadedViewIds.size() << " views left for the next batch.");
+  return true;
+}
+
+void RegionsCache::release(IndexT viewId)
+{
+  _memorySize -= _viewMemorySizes.at(viewId);
+  _viewMemorySizes.erase(viewId);
+  _regionsPerView.removeRegions(viewId);
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Cache of the view regions of the current batch of image pairs.
+ *
+ * Used to match the image pairs by batches without loading the regions
+ * of all the views at once: the views of consecutive batches stay loaded,
+ * the other ones are released. The views of a batch are loaded until
+ * the memory budget is reached, the caller matches the pairs of the loaded
+ * views and loads the remaining views with the remaining pairs.
+ */
+class RegionsCache
+{
+public:
+
+  /**
+   * @param[in] sfmData The SfMData container
+   * @param[in] folders The feature folders
+   * @param[in] imageDescriberTypes The imageDescriber types
+   * @param[in] maxMemorySize The memory budget of the loaded regions (in bytes)
+   */
+  RegionsCache(const sfm::SfMData& sfmData,
+               const std::vector<std::string>& folders,
+               const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
+               std::size_t maxMemorySize);
+
+  /**
+   * @brief Load the regions of the given views, in the given order, until the memory budget is reached.
+   * The loaded views that are not in the given views are released first.
+   * The first two views are always loaded, and the budget can be exceeded
+   * by the views loaded in parallel when it is reached.
+   * @param[in] viewIds The views needed by the next batch of pairs, the views of its first pair first
+   * @param[out] loadedViewIds The given views whose regions are loaded
+   * @return true if the regions are correctly loaded
+   */
+  bool load(const std::vector<IndexT>& viewIds, std::set<IndexT>& loadedViewIds);
+
+  const feature::RegionsPerView& getRegionsPerView() const
+  {
+    return _regionsPerView;
+  }
+
+  std::size_t getMemorySize() const
+  {
+    return _memorySize;
+  }
+
+private:
+  void release(IndexT viewId);
+
+  std::vector<std::string> _featuresFolders;
+  std::vector<feature::EImageDescriberType> _imageDescriberTypes;
+  std::vector<std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
+  std::size_t _maxMemorySize;
+  std::size_t _memorySize = 0;
+
+  feature::RegionsPerView _regionsPerView;
+  /// memory size of the regions of each loaded view
+  std::map<IndexT, std::size_t> _viewMemorySizes;
+};
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
@@ -5,8 +5,15 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "geometricFilterUtils.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
 #include <ceres/ceres.h>
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -423,5 +430,83 @@ bool refineHomography(const Mat2X& features_I,
 
   return true;
 }
+
+std::vector<matching::PairwiseMatches::const_iterator> getGeometricFilteringOrder(const matching::PairwiseMatches& putativeMatches)
+{
+  std::vector<std::pair<int, matching::PairwiseMatches::const_iterator>> binnedPairs;
+  binnedPairs.reserve(putativeMatches.size());
+  for(auto it = putativeMatches.begin(); it != putativeMatches.end(); ++it)
+  {
+    int bin = 0;
+    for(int nbMatches = it->second.getNbAllMatches(); nbMatches > 1; nbMatches >>= 1)
+      ++bin;
+    binnedPairs.emplace_back(bin, it);
+  }
+
+  // the map is sorted by image pair, so the stable sort keeps the pairs of a view together in each bin
+  std::stable_sort(binnedPairs.begin(), binnedPairs.end(), [](const std::pair<int, matching::PairwiseMatches::const_iterator>& a,
+                                                               const std::pair<int, matching::PairwiseMatches::const_iterator>& b)
+  {
+    return a.first > b.first;
+  });
+
+  std::vector<matching::PairwiseMatches::const_iterator> pairs;
+  pairs.reserve(binnedPairs.size());
+  for(const auto& binnedPair : binnedPairs)
+    pairs.push_back(binnedPair.second);
+  return pairs;
+}
+
+std::vector<std::size_t> computeTimingsHistogram(const std::vector<PairTiming>& timings)
+{
+  std::vector<std::size_t> histogram;
+  for(const PairTiming& timing : timings)
+  {
+    std::size_t bin = 0;
+    for(double upperBound = 1.0; timing.elapsedMs >= upperBound; upperBound *= 2.0)
+      ++bin;
+    if(bin >= histogram.size())
+      histogram.resize(bin + 1, 0);
+    ++histogram[bin];
+  }
+  return histogram;
+}
+
+void logTimingsHistogram(const std::vector<PairTiming>& timings)
+{
+  if(timings.empty())
+    return;
+
+  const std::vector<std::size_t> histogram = computeTimingsHistogram(timings);
+
+  double totalMs = 0.0;
+  for(const PairTiming& timing : timings)
+    totalMs += timing.elapsedMs;
+
+  std::ostringstream os;
+  os << "Geometric filtering time per image pair (" << timings.size() << " pairs, total: " << system::prettyTime(totalMs)
+     << ", mean: " << totalMs / timings.size() << " ms):";
+  for(std::size_t b = 0; b < histogram.size(); ++b)
+  {
+    if(histogram[b] == 0)
+      continue;
+    os << "\n\t- [" << ((b == 0) ? 0.0 : std::ldexp(1.0, b - 1)) << ", " << std::ldexp(1.0, b) << ") ms: " << histogram[b] << " pairs";
+  }
+
+  // slowest image pairs
+  std::vector<PairTiming> slowest = timings;
+  const std::size_t nbSlowest = std::min<std::size_t>(5, slowest.size());
+  std::partial_sort(slowest.begin(), slowest.begin() + nbSlowest, slowest.end(), [](const PairTiming& a, const PairTiming& b)
+  {
+    return a.elapsedMs > b.elapsedMs;
+  });
+  os << "\nSlowest image pairs:";
+  for(std::size_t i = 0; i < nbSlowest; ++i)
+    os << "\n\t- (" << slowest[i].pair.first << ", " << slowest[i].pair.second << "): " << slowest[i].elapsedMs << " ms, "
+       << slowest[i].nbPutativeMatches << " putative matches";
+
+  ALICEVISION_LOG_INFO(os.str());
 }
-}
\ No newline at end of file
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
@@ -13,6 +13,8 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -285,5 +287,38 @@ bool refineHomography(const Mat2X& features_I,
                       std::set<IndexT>& bestMatchesId,
                       double homographyTolerance);
 
+/**
+ * @brief Get the processing order of the image pairs for the geometric filtering.
+ * The pairs are sorted by decreasing number of putative matches (power of 2 bins),
+ * so the largest pairs are not processed last by a single thread,
+ * and by image pair in each bin, so the pairs of a view are processed together
+ * and its regions stay in cache.
+ * @param[in] putativeMatches The putative matches of all the image pairs.
+ * @return The image pairs (iterators in \c putativeMatches) in processing order.
+ */
+std::vector<matching::PairwiseMatches::const_iterator> getGeometricFilteringOrder(const matching::PairwiseMatches& putativeMatches);
+
+/// Elapsed time of the geometric filtering of an image pair
+struct PairTiming
+{
+  Pair pair;
+  std::size_t nbPutativeMatches;
+  double elapsedMs;
+};
+
+/**
+ * @brief Compute the histogram of the elapsed times: the bin 0 counts the times below 1ms
+ * and the bin b > 0 counts the times in [2^(b-1), 2^b) ms.
+ * @param[in] timings The elapsed time of each image pair.
+ * @return The number of image pairs in each bin.
+ */
+std::vector<std::size_t> computeTimingsHistogram(const std::vector<PairTiming>& timings);
+
+/**
+ * @brief Log the histogram of the elapsed times and the slowest image pairs.
+ * @param[in] timings The elapsed time of each image pair.
+ */
+void logTimingsHistogram(const std::vector<PairTiming>& timings);
+
 } // namespace aliceVision
 } // namespace matchingImageCollection
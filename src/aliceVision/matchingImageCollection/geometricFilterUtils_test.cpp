@@ -75,4 +75,39 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_similarityEstimation)
 //    std::cout << result.isZero() << std::endl;
 //    std::cout <<  point.cast<double>() - ptIp_hom.hnormalized() << std::endl;
   }
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_geometricFilteringOrder)
+{
+  // number of putative matches per image pair
+  const std::map<Pair, std::size_t> nbMatchesPerPair = {
+    {{0, 1}, 10}, {{0, 2}, 1000}, {{0, 3}, 12}, {{1, 2}, 900}, {{1, 3}, 5}, {{2, 3}, 1020}};
+
+  matching::PairwiseMatches putativeMatches;
+  for(const auto& nbMatches : nbMatchesPerPair)
+    putativeMatches[nbMatches.first][feature::EImageDescriberType::SIFT].resize(nbMatches.second);
+
+  const std::vector<matching::PairwiseMatches::const_iterator> order = matchingImageCollection::getGeometricFilteringOrder(putativeMatches);
+  BOOST_CHECK_EQUAL(order.size(), putativeMatches.size());
+
+  // largest pairs first (1000, 900 and 1020 are in the same bin), image pair order in each bin
+  const std::vector<Pair> expected = {{0, 2}, {1, 2}, {2, 3}, {0, 1}, {0, 3}, {1, 3}};
+  for(std::size_t i = 0; i < expected.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(order[i]->first.first, expected[i].first);
+    BOOST_CHECK_EQUAL(order[i]->first.second, expected[i].second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_timingsHistogram)
+{
+  BOOST_CHECK(matchingImageCollection::computeTimingsHistogram({}).empty());
+
+  const std::vector<matchingImageCollection::PairTiming> timings = {
+    {{0, 1}, 10, 0.5}, {{0, 2}, 10, 0.9}, {{0, 3}, 10, 1.0}, {{1, 2}, 10, 3.0}, {{1, 3}, 10, 100.0}};
+
+  // bins: [0, 1), [1, 2), [2, 4), [4, 8), [8, 16), [16, 32), [32, 64), [64, 128)
+  const std::vector<std::size_t> histogram = matchingImageCollection::computeTimingsHistogram(timings);
+  const std::vector<std::size_t> expected = {2, 1, 1, 0, 0, 0, 0, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(histogram.begin(), histogram.end(), expected.begin(), expected.end());
+}
@@ -16,9 +16,12 @@ namespace matchingImageCollection {
 /**
  * 
  * @param matcherType
+ * @param distRatio
+ * @param cascadeHashingIndexFolders folders of the persistent cascade hashing indexes (FAST_CASCADE_HASHING_L2 only)
  * @return 
  */
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio);
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio,
+                                                                      const std::vector<std::string>& cascadeHashingIndexFolders = std::vector<std::string>());
 
 
 } // namespace matching
@@ -11,6 +11,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <map>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -123,4 +124,50 @@ bool savePairs(const std::string &sFileName, const PairSet & pairs)
   return bOk;
 }
 
+std::vector<std::vector<PairSet>> splitPairsInBatches(const PairSet& pairs, std::size_t maxViewsPerBatch)
+{
+  std::set<IndexT> views;
+  for(const Pair& pair : pairs)
+  {
+    views.insert(pair.first);
+    views.insert(pair.second);
+  }
+
+  std::vector<std::vector<PairSet>> batches;
+  if(pairs.empty())
+    return batches;
+
+  if(maxViewsPerBatch == 0 || views.size() <= maxViewsPerBatch)
+  {
+    batches.emplace_back(1, pairs);
+    return batches;
+  }
+
+  // blocks of consecutive views, a batch holds the views of two blocks
+  const std::size_t blockSize = std::max<std::size_t>(1, maxViewsPerBatch / 2);
+  std::map<IndexT, std::size_t> viewBlocks;
+  std::size_t viewIndex = 0;
+  for(const IndexT viewId : views)
+    viewBlocks.emplace_hint(viewBlocks.end(), viewId, viewIndex++ / blockSize);
+
+  // (I-block, J-block) tiles of the pairs matrix
+  const std::size_t nbBlocks = (views.size() + blockSize - 1) / blockSize;
+  std::vector<std::map<std::size_t, PairSet>> tiles(nbBlocks);
+  for(const Pair& pair : pairs)
+  {
+    PairSet& tile = tiles.at(viewBlocks.at(pair.first))[viewBlocks.at(pair.second)];
+    tile.insert(tile.end(), pair);
+  }
+
+  for(std::map<std::size_t, PairSet>& blockTiles : tiles)
+  {
+    if(blockTiles.empty())
+      continue;
+    batches.emplace_back();
+    for(auto& tile : blockTiles)
+      batches.back().push_back(std::move(tile.second));
+  }
+  return batches;
+}
+
 }; // namespace aliceVision
@@ -11,6 +11,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 
 #include <algorithm>
+#include <vector>
 
 namespace aliceVision {
 
@@ -30,4 +31,16 @@ bool loadPairs(
 /// I K
 bool savePairs(const std::string &sFileName, const PairSet & pairs);
 
+/**
+ * @brief Split a set of pairs in batches of view blocks.
+ * The views are split in blocks of maxViewsPerBatch / 2 consecutive views and a batch holds
+ * the pairs (I, J) of an I-block and a J-block, so the views of a batch fit the budget.
+ * The batches are grouped by I-block: all the pairs of a first view I are in the same group,
+ * so the matches of a view can be saved in a single file per group.
+ * @param[in] pairs The pairs to split
+ * @param[in] maxViewsPerBatch The maximum number of views per batch (at least 2), 0 for a single batch
+ * @return the batches of pairs, grouped by I-block
+ */
+std::vector<std::vector<PairSet>> splitPairsInBatches(const PairSet& pairs, std::size_t maxViewsPerBatch);
+
 }; // namespace aliceVision
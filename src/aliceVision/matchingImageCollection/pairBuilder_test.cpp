@@ -12,6 +12,9 @@
 #include <iostream>
 #include <algorithm>
 #include <memory>
+#include <set>
+
+#include <boost/filesystem.hpp>
 
 #define BOOST_TEST_MODULE matchingImageCollectionPairBuilder
 #include <boost/test/included/unit_test.hpp>
@@ -20,6 +23,8 @@
 using namespace std;
 using namespace aliceVision;
 
+namespace fs = boost::filesystem;
+
 // Check pairs follow a weak ordering pair.first < pair.second
 template<typename IterablePairs>
 bool checkPairOrder(const IterablePairs & pairs)
@@ -73,9 +78,70 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
   pairSetGTsorted.insert( std::make_pair(0,2) );
   pairSetGTsorted.insert( std::make_pair(1,2) );
 
-  BOOST_CHECK( savePairs("pairsT_IO.txt", pairSetGT));
+  const std::string filename = (fs::temp_directory_path() / fs::unique_path("pairsT_IO-%%%%%%.txt")).string();
+  BOOST_CHECK( savePairs(filename, pairSetGT));
 
   PairSet loaded_Pairs;
-  BOOST_CHECK( loadPairs("pairsT_IO.txt", loaded_Pairs));
+  BOOST_CHECK( loadPairs(filename, loaded_Pairs));
   BOOST_CHECK( std::equal(loaded_Pairs.begin(), loaded_Pairs.end(), pairSetGTsorted.begin()) );
+  fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_splitPairsInBatches)
+{
+  sfm::Views views;
+  for(IndexT i = 0; i < 11; ++i)
+    views[i] = std::make_shared<sfm::View>("filepath", i);
+
+  const PairSet pairs = exhaustivePairs(views);
+
+  BOOST_CHECK(splitPairsInBatches(PairSet(), 4).empty());
+
+  for(std::size_t maxViewsPerBatch : {2, 3, 4, 5, 8})
+  {
+    const std::vector<std::vector<PairSet>> batches = splitPairsInBatches(pairs, maxViewsPerBatch);
+    BOOST_CHECK_GT(batches.size(), 1);
+
+    PairSet merged;
+    std::set<IndexT> groupsFirstViews;
+    for(const std::vector<PairSet>& group : batches)
+    {
+      std::set<IndexT> firstViews;
+      for(const PairSet& batch : group)
+      {
+        BOOST_CHECK(!batch.empty());
+
+        // the views of a batch fit the budget
+        std::set<IndexT> batchViews;
+        for(const Pair& pair : batch)
+        {
+          batchViews.insert(pair.first);
+          batchViews.insert(pair.second);
+          firstViews.insert(pair.first);
+        }
+        BOOST_CHECK_LE(batchViews.size(), maxViewsPerBatch);
+
+        const std::size_t nbPairs = merged.size();
+        merged.insert(batch.begin(), batch.end());
+        BOOST_CHECK_EQUAL(nbPairs + batch.size(), merged.size());
+      }
+
+      // the pairs of a first view are in a single group
+      for(const IndexT viewId : firstViews)
+        BOOST_CHECK(groupsFirstViews.insert(viewId).second);
+    }
+    BOOST_CHECK(merged == pairs);
+  }
+  {
+    const std::vector<std::vector<PairSet>> batches = splitPairsInBatches(pairs, 0);
+    BOOST_CHECK_EQUAL(1, batches.size());
+    BOOST_CHECK_EQUAL(1, batches[0].size());
+    BOOST_CHECK(batches[0][0] == pairs);
+  }
+  {
+    const std::vector<std::vector<PairSet>> batches = splitPairsInBatches(pairs, views.size());
+    BOOST_CHECK_EQUAL(1, batches.size());
+    BOOST_CHECK_EQUAL(1, batches[0].size());
+    BOOST_CHECK(batches[0][0] == pairs);
+  }
 }
@@ -86,7 +86,39 @@ inline void EncodeEpipolarEquation(const TMatX &x1, const TMatX &x2, TMatA *A, c
   }
 }
 
+/**
+ * Compute the epipolar terms of all the correspondences (columns of x1 and x2) in a single pass
+ * and store error(F_xSqNorm, Ft_ySqNorm, yFx) in errors, where F_xSqNorm and Ft_ySqNorm are
+ * the squared norms of the first two coordinates of F * [x1|1] and F^T * [x2|1],
+ * and yFx = [x2|1]^T * F * [x1|1].
+ * The loop only uses scalars so the compiler can vectorize it.
+ */
+template <typename ErrorFunctor>
+inline void EpipolarErrors(const Mat3 &F, const Mat &x1, const Mat &x2, vector<double> &errors, ErrorFunctor error) {
+  assert(x1.rows() == 2 && x2.rows() == 2);
+  assert(x1.cols() == x2.cols());
+  const Mat::Index n = x1.cols();
+  errors.resize(n);
+  const double *p1 = x1.data();
+  const double *p2 = x2.data();
+  double *e = errors.data();
+  const double f00 = F(0,0), f01 = F(0,1), f02 = F(0,2);
+  const double f10 = F(1,0), f11 = F(1,1), f12 = F(1,2);
+  const double f20 = F(2,0), f21 = F(2,1), f22 = F(2,2);
+  for (Mat::Index i = 0; i < n; ++i) {
+    const double x = p1[2 * i], y = p1[2 * i + 1];
+    const double u = p2[2 * i], v = p2[2 * i + 1];
+    const double Fx0 = f00 * x + f01 * y + f02;
+    const double Fx1 = f10 * x + f11 * y + f12;
+    const double Fx2 = f20 * x + f21 * y + f22;
+    const double Fty0 = f00 * u + f10 * v + f20;
+    const double Fty1 = f01 * u + f11 * v + f21;
+    e[i] = error(Fx0 * Fx0 + Fx1 * Fx1, Fty0 * Fty0 + Fty1 * Fty1, u * Fx0 + v * Fx1 + Fx2);
+  }
+}
+
 /// Compute SampsonError related to the Fundamental matrix and 2 correspondences
+/// (Errors() computes the error of all the correspondences at once)
 struct SampsonError {
   static double Error(const Mat3 &F, const Vec2 &x1, const Vec2 &x2) {
     Vec3 x(x1(0), x1(1), 1.0);
@@ -97,6 +129,12 @@ struct SampsonError {
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm()
                                 + Ft_y.head<2>().squaredNorm());
   }
+
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, vector<double> &errors) {
+    EpipolarErrors(F, x1, x2, errors, [](double F_xSqNorm, double Ft_ySqNorm, double yFx) {
+      return Square(yFx) / (F_xSqNorm + Ft_ySqNorm);
+    });
+  }
 };
 
 struct SymmetricEpipolarDistanceError {
@@ -110,6 +148,12 @@ struct SymmetricEpipolarDistanceError {
                                 + 1.0 / Ft_y.head<2>().squaredNorm())
       / 4.0;  // The divide by 4 is to make this match the Sampson distance.
   }
+
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, vector<double> &errors) {
+    EpipolarErrors(F, x1, x2, errors, [](double F_xSqNorm, double Ft_ySqNorm, double yFx) {
+      return Square(yFx) * (1.0 / F_xSqNorm + 1.0 / Ft_ySqNorm) / 4.0;
+    });
+  }
 };
 
 struct EpipolarDistanceError {
@@ -121,6 +165,12 @@ struct EpipolarDistanceError {
     Vec3 F_x = F * x;
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, vector<double> &errors) {
+    EpipolarErrors(F, x1, x2, errors, [](double F_xSqNorm, double Ft_ySqNorm, double yFx) {
+      return Square(yFx) / F_xSqNorm;
+    });
+  }
 };
 typedef EpipolarDistanceError SimpleError;
 
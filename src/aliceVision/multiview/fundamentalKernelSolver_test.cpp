@@ -8,6 +8,13 @@
 
 #include "aliceVision/multiview/fundamentalKernelSolver.hpp"
 #include "aliceVision/multiview/projection.hpp"
+#include "aliceVision/multiview/NViewDataSet.hpp"
+#include "aliceVision/robustEstimation/ACRansac.hpp"
+#include "aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp"
+#include "aliceVision/robustEstimation/LORansacKernelAdaptor.hpp"
+#include "aliceVision/robustEstimation/ScoreEvaluator.hpp"
+
+#include <random>
 
 #define BOOST_TEST_MODULE fundamentalKernelSolver
 #include <boost/test/included/unit_test.hpp>
@@ -121,3 +128,139 @@ BOOST_AUTO_TEST_CASE(EightPointTest_Normalized_EasyCase) {
   typedef fundamental::kernel::NormalizedEightPointKernel Kernel;
   BOOST_CHECK(ExpectKernelProperties<Kernel>(x1, x2));
 }
+
+template <typename ErrorT>
+void ExpectBatchedErrors(const Mat3 &F, const Mat &x1, const Mat &x2) {
+  vector<double> errors;
+  ErrorT::Errors(F, x1, x2, errors);
+  BOOST_CHECK_EQUAL(x1.cols(), errors.size());
+  for (int i = 0; i < x1.cols(); ++i) {
+    const double error = ErrorT::Error(F, x1.col(i), x2.col(i));
+    BOOST_CHECK_SMALL(errors[i] - error, 1e-9 * (1.0 + error));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FundamentalErrors_Batched) {
+  Mat3 F;
+  F << 0.1, -2.0,  3.0,
+       4.0,  0.5, -6.0,
+      -3.0,  8.0,  1.0;
+  const Mat x1 = Mat::Random(2, 50) * 100.0;
+  const Mat x2 = Mat::Random(2, 50) * 100.0;
+
+  ExpectBatchedErrors<fundamental::kernel::SampsonError>(F, x1, x2);
+  ExpectBatchedErrors<fundamental::kernel::SymmetricEpipolarDistanceError>(F, x1, x2);
+  ExpectBatchedErrors<fundamental::kernel::EpipolarDistanceError>(F, x1, x2);
+}
+
+BOOST_AUTO_TEST_CASE(FundamentalErrors_Subset) {
+
+  using namespace aliceVision::robustEstimation;
+
+  Mat3 F;
+  F << 0.1, -2.0,  3.0,
+       4.0,  0.5, -6.0,
+      -3.0,  8.0,  1.0;
+  const Mat x1 = (Mat::Random(2, 50).array() + 1.0) * 500.0;
+  const Mat x2 = (Mat::Random(2, 50).array() + 1.0) * 500.0;
+
+  typedef KernelAdaptorLoRansac<
+    fundamental::kernel::SevenPointSolver,
+    fundamental::kernel::SampsonError,
+    UnnormalizerT,
+    Mat3,
+    fundamental::kernel::EightPointSolver> KernelType;
+  const KernelType kernel(x1, 1000, 1000, x2, 1000, 1000, false);
+
+  const std::vector<std::size_t> samples = {3, 7, 8, 21, 42, 49};
+  vector<double> errors, subsetErrors;
+  kernel.Errors(F, errors);
+  kernel.Errors(F, samples, subsetErrors);
+  BOOST_CHECK_EQUAL(samples.size(), subsetErrors.size());
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    BOOST_CHECK_SMALL(subsetErrors[i] - errors[samples[i]], 1e-9 * (1.0 + errors[samples[i]]));
+
+  // the weights are computed from the errors of the inliers only
+  vector<double> weights;
+  kernel.computeWeights(F, samples, weights);
+  BOOST_CHECK_EQUAL(samples.size(), weights.size());
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    BOOST_CHECK_CLOSE(weights[i], 1.0 / Square(std::max(0.001, errors[samples[i]])), 1e-6);
+
+  // the score of a subset only depends on the errors of the subset
+  const double threshold = errors[samples[2]];
+  const ScoreEvaluator<KernelType> scorer(threshold);
+  std::vector<std::size_t> inliers;
+  const double cost = scorer.Score(kernel, F, samples, &inliers);
+  double expectedCost = 0.0;
+  std::vector<std::size_t> expectedInliers;
+  for (const std::size_t sample : samples)
+  {
+    expectedCost += errors[sample];
+    if (errors[sample] < threshold)
+      expectedInliers.push_back(sample);
+  }
+  BOOST_CHECK_CLOSE(cost, expectedCost, 1e-6);
+  BOOST_CHECK(inliers == expectedInliers);
+}
+
+// Check that the histogram NFA of ACRANSAC finds the same fundamental matrix as the exact NFA
+// on a realistic camera pair with noisy observations and outliers
+
+BOOST_AUTO_TEST_CASE(Fundamental_ACRansac_HistogramNFA) {
+
+  using namespace aliceVision::robustEstimation;
+
+  const int width = 1000;
+  const int height = 1000;
+  const std::size_t nbPoints = 400;
+  const std::size_t nbOutliers = 100;
+  const NViewDataSet d = NRealisticCamerasRing(2, nbPoints,
+    NViewDatasetConfigurator(1000,1000,500,500,5,0));
+
+  std::mt19937 gen(0);
+  std::normal_distribution<double> noise(0.0, 0.5);
+  std::uniform_real_distribution<double> imagePoint(0.0, width);
+
+  Mat x1 = d._x[0];
+  Mat x2 = d._x[1];
+  for (std::size_t i = 0; i < nbPoints; ++i)
+  {
+    x1.col(i) += Vec2(noise(gen), noise(gen));
+    x2.col(i) += Vec2(noise(gen), noise(gen));
+  }
+  for (std::size_t i = 0; i < nbOutliers; ++i)
+    x2.col(i) = Vec2(imagePoint(gen), imagePoint(gen));
+
+  // the kernel of the fundamental matrix geometric filter
+  typedef ACKernelAdaptor<
+    fundamental::kernel::SevenPointSolver,
+    fundamental::kernel::SimpleError,
+    UnnormalizerT,
+    Mat3> KernelType;
+  const KernelType kernel(x1, width, height, x2, width, height, true);
+
+  for (std::size_t trial = 0; trial < 5; ++trial)
+  {
+    // same random samples for both modes
+    std::mt19937 generatorExact(trial);
+    std::mt19937 generatorHistogram(trial);
+
+    std::vector<std::size_t> inliersExact, inliersHistogram;
+    Mat3 FExact, FHistogram;
+    const std::pair<double,double> retExact = ACRANSAC(kernel, inliersExact, 1024, &FExact,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::EXACT, &generatorExact);
+    const std::pair<double,double> retHistogram = ACRANSAC(kernel, inliersHistogram, 1024, &FHistogram,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::HISTOGRAM, &generatorHistogram);
+
+    // the same models are evaluated, so the same samples are drawn in the optimization phase
+    BOOST_CHECK(inliersExact == inliersHistogram);
+    BOOST_CHECK_EQUAL(retExact.first, retHistogram.first);
+    BOOST_CHECK_EQUAL(retExact.second, retHistogram.second);
+    BOOST_CHECK_SMALL(NormLInfinity(FExact - FHistogram), 1e-12 * NormLInfinity(FExact));
+
+    // most of the noisy points are inliers
+    BOOST_CHECK(inliersHistogram.size() > 0.95 * (nbPoints - nbOutliers));
+    BOOST_CHECK(retHistogram.second < 0);
+  }
+}
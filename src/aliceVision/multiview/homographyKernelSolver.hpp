@@ -42,6 +42,27 @@ struct AsymmetricError {
     Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
     return (x2 - x2_est).squaredNorm();
   }
+
+  // Error of all the correspondences (columns of x1 and x2) at once.
+  // The loop only uses scalars so the compiler can vectorize it.
+  static void Errors(const Mat3 &H, const Mat &x1, const Mat &x2, vector<double> &errors) {
+    assert(x1.cols() == x2.cols());
+    const Mat::Index n = x1.cols();
+    errors.resize(n);
+    const double *p1 = x1.data();
+    const double *p2 = x2.data();
+    double *e = errors.data();
+    const double h00 = H(0,0), h01 = H(0,1), h02 = H(0,2);
+    const double h10 = H(1,0), h11 = H(1,1), h12 = H(1,2);
+    const double h20 = H(2,0), h21 = H(2,1), h22 = H(2,2);
+    for (Mat::Index i = 0; i < n; ++i) {
+      const double x = p1[2 * i], y = p1[2 * i + 1];
+      const double invZ = 1.0 / (h20 * x + h21 * y + h22);
+      const double dx = p2[2 * i] - (h00 * x + h01 * y + h02) * invZ;
+      const double dy = p2[2 * i + 1] - (h10 * x + h11 * y + h12) * invZ;
+      e[i] = dx * dx + dy * dy;
+    }
+  }
 };
 
 // Kernel that works on original data point
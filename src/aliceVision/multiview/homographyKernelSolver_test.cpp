@@ -90,3 +90,20 @@ BOOST_AUTO_TEST_CASE(HomographyKernelTest_Fitting_Normalized) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(HomographyError_Batched) {
+  Mat3 H;
+  H << 1, -0.2,  3,
+       0.4,  1.5, -6,
+      -0.007,  0.008,  1;
+  const Mat x = Mat::Random(2, 50) * 100.0;
+  const Mat y = Mat::Random(2, 50) * 100.0;
+
+  vector<double> errors;
+  homography::kernel::AsymmetricError::Errors(H, x, y, errors);
+  BOOST_CHECK_EQUAL(x.cols(), errors.size());
+  for (int i = 0; i < x.cols(); ++i) {
+    const double error = homography::kernel::AsymmetricError::Error(H, x.col(i), y.col(i));
+    BOOST_CHECK_SMALL(errors[i] - error, 1e-9 * (1.0 + error));
+  }
+}
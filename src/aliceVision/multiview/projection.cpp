@@ -194,6 +194,31 @@ Mat2X Project(const Mat34 &P, const Mat4X &X)
   return Mat3X(P * X).colwise().hnormalized();
 }
 
+void SquaredReprojectionErrors(const Mat34 &P, const Mat &x, const Mat &X, std::vector<double> &errors)
+{
+  assert(x.rows() == 2);
+  assert(X.rows() == 3);
+  assert(x.cols() == X.cols());
+
+  // single pass with scalars only, so the compiler can vectorize the loop
+  const Mat::Index n = x.cols();
+  errors.resize(n);
+  const double *px = x.data();
+  const double *pX = X.data();
+  double *e = errors.data();
+  const double p00 = P(0,0), p01 = P(0,1), p02 = P(0,2), p03 = P(0,3);
+  const double p10 = P(1,0), p11 = P(1,1), p12 = P(1,2), p13 = P(1,3);
+  const double p20 = P(2,0), p21 = P(2,1), p22 = P(2,2), p23 = P(2,3);
+  for(Mat::Index i = 0; i < n; ++i)
+  {
+    const double X0 = pX[3 * i], X1 = pX[3 * i + 1], X2 = pX[3 * i + 2];
+    const double invZ = 1.0 / (p20 * X0 + p21 * X1 + p22 * X2 + p23);
+    const double dx = px[2 * i] - (p00 * X0 + p01 * X1 + p02 * X2 + p03) * invZ;
+    const double dy = px[2 * i + 1] - (p10 * X0 + p11 * X1 + p12 * X2 + p13) * invZ;
+    e[i] = dx * dx + dy * dy;
+  }
+}
+
 void HomogeneousToEuclidean(const Vec4 &H, Vec3 *X)
 {
   assert(X != nullptr);
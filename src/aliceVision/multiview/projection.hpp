@@ -10,6 +10,8 @@
 
 #include <aliceVision/numeric/numeric.hpp>
 
+#include <vector>
+
 /// Collection of function related to the classic Projection matrix used
 ///  in computer vision. P = K[R|t] with [t]=[-RC] Cf HZ
 namespace aliceVision {
@@ -43,6 +45,9 @@ Mat2X Project(const Mat34 &P, const Mat3X &X);
 // Return P*[X|1.0] for the X list of point (4D point).
 Mat2X Project(const Mat34 &P, const Mat4X &X);
 
+// Compute the squared reprojection errors ||x_i - P*[X_i|1.0]||^2 for the x (2D) / X (3D) list of points.
+void SquaredReprojectionErrors(const Mat34 &P, const Mat &x, const Mat &X, std::vector<double> &errors);
+
 // Change homogeneous coordinates to euclidean.
 void HomogeneousToEuclidean(const Vec4 &H, Vec3 *X);
 
@@ -288,6 +288,13 @@ double P3PSolver::Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D)
   return (pt2D - Project(P, pt3D)).norm();
 }
 
+void P3PSolver::Errors(const Mat34 & P, const Mat & pt2D, const Mat & pt3D, std::vector<double> & errors)
+{
+  SquaredReprojectionErrors(P, pt2D, pt3D, errors);
+  for(double & e : errors)
+    e = std::sqrt(e);
+}
+
 P3P_ResectionKernel_K::P3P_ResectionKernel_K(const Mat2X &x_camera, const Mat3X &X, const Mat3 &K /*= Mat3::Identity()*/)
 : x_image_(x_camera), X_(X), K_(K)
 {
@@ -57,6 +57,9 @@ struct P3PSolver
 
   // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
   static double Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D);
+
+  // Compute the residuals of all the points at once
+  static void Errors(const Mat34 & P, const Mat & pt2D, const Mat & pt3D, std::vector<double> & errors);
 };
 
 class P3P_ResectionKernel_K
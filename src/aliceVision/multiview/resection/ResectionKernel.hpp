@@ -35,6 +35,13 @@ struct SixPointResectionSolver {
     Vec2 x = Project(P, pt3D);
     return (x-pt2D).norm();
   }
+
+  // Compute the residuals of all the points at once
+  static void Errors(const Mat34 & P, const Mat & pt2D, const Mat & pt3D, std::vector<double> & errors){
+    SquaredReprojectionErrors(P, pt2D, pt3D, errors);
+    for(double & e : errors)
+      e = std::sqrt(e);
+  }
 };
 
 //-- Generic Solver for the 6pt Resection algorithm using linear least squares.
@@ -121,6 +128,13 @@ struct EpnpSolver {
   static double Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D) {
     return (pt2D - Project(P, pt3D)).norm();
   }
+
+  // Compute the residuals of all the points at once
+  static void Errors(const Mat34 & P, const Mat & pt2D, const Mat & pt3D, std::vector<double> & errors) {
+    SquaredReprojectionErrors(P, pt2D, pt3D, errors);
+    for(double & e : errors)
+      e = std::sqrt(e);
+  }
 };
 
 class ResectionKernel_K {
@@ -8,7 +8,10 @@
 #include "aliceVision/multiview/NViewDataSet.hpp"
 #include "aliceVision/multiview/resection/ResectionKernel.hpp"
 #include "aliceVision/multiview/resection/P3PSolver.hpp"
+#include "aliceVision/robustEstimation/ACRansac.hpp"
+#include "aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp"
 
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE ResectionKernel
@@ -51,6 +54,98 @@ BOOST_AUTO_TEST_CASE(Resection_Kernel_Multiview) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Resection_Errors_Batched) {
+
+  const NViewDataSet d = NRealisticCamerasRing(3, 20,
+    NViewDatasetConfigurator(1000,1000,500,500,5,0));
+
+  // perturb the observations so the errors are not all null
+  const Mat x = d._x[1] + Mat::Random(2, 20) * 2.0;
+  const Mat X = d._X;
+  const Mat34 P = d.P(1);
+
+  std::vector<double> errors, errorsP3P;
+  aliceVision::resection::kernel::SixPointResectionSolver::Errors(P, x, X, errors);
+  aliceVision::resection::P3PSolver::Errors(P, x, X, errorsP3P);
+  BOOST_CHECK_EQUAL(x.cols(), errors.size());
+  BOOST_CHECK_EQUAL(x.cols(), errorsP3P.size());
+  for (std::size_t i = 0; i < x.cols(); ++i) {
+    const double error = aliceVision::resection::kernel::SixPointResectionSolver::Error(P, x.col(i), X.col(i));
+    BOOST_CHECK_SMALL(errors[i] - error, 1e-9);
+    BOOST_CHECK_SMALL(errorsP3P[i] - error, 1e-9);
+  }
+}
+
+struct ResectionSquaredResidualError
+{
+  static double Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D)
+  {
+    return (Project(P, pt3D) - pt2D).squaredNorm();
+  }
+};
+
+// Check that the histogram NFA of ACRANSAC finds the same resection as the exact NFA
+// on a realistic camera ring with noisy observations and outliers
+
+BOOST_AUTO_TEST_CASE(Resection_ACRansac_HistogramNFA) {
+
+  using namespace aliceVision::robustEstimation;
+
+  const int width = 1000;
+  const int height = 1000;
+  const std::size_t nbPoints = 400;
+  const std::size_t nbOutliers = 100;
+  const NViewDataSet d = NRealisticCamerasRing(3, nbPoints,
+    NViewDatasetConfigurator(1000,1000,500,500,5,0));
+  const int nResectionCameraIndex = 1;
+
+  std::mt19937 gen(0);
+  std::normal_distribution<double> noise(0.0, 0.5);
+  std::uniform_real_distribution<double> imagePoint(0.0, width);
+
+  Mat x = d._x[nResectionCameraIndex];
+  for (std::size_t i = 0; i < nbPoints; ++i)
+    x.col(i) += Vec2(noise(gen), noise(gen));
+  for (std::size_t i = 0; i < nbOutliers; ++i)
+    x.col(i) = Vec2(imagePoint(gen), imagePoint(gen));
+  const Mat X = d._X;
+
+  typedef ACKernelAdaptorResection<
+    aliceVision::resection::kernel::SixPointResectionSolver,
+    ResectionSquaredResidualError, UnnormalizerResection, Mat34> KernelType;
+  const KernelType kernel(x, width, height, X);
+
+  for (std::size_t trial = 0; trial < 5; ++trial)
+  {
+    // same random samples for both modes
+    std::mt19937 generatorExact(trial);
+    std::mt19937 generatorHistogram(trial);
+
+    std::vector<std::size_t> inliersExact, inliersHistogram;
+    Mat34 PExact, PHistogram;
+    const std::pair<double,double> retExact = ACRANSAC(kernel, inliersExact, 1024, &PExact,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::EXACT, &generatorExact);
+    const std::pair<double,double> retHistogram = ACRANSAC(kernel, inliersHistogram, 1024, &PHistogram,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::HISTOGRAM, &generatorHistogram);
+
+    // the same models are evaluated, so the same samples are drawn in the optimization phase
+    BOOST_CHECK(inliersExact == inliersHistogram);
+    BOOST_CHECK_EQUAL(retExact.first, retHistogram.first);
+    BOOST_CHECK_EQUAL(retExact.second, retHistogram.second);
+    EXPECT_MATRIX_NEAR(PExact, PHistogram, 1e-12);
+
+    // no outlier is an inlier and most of the noisy points are inliers
+    BOOST_CHECK(inliersHistogram.size() > 0.95 * (nbPoints - nbOutliers));
+    BOOST_CHECK(inliersHistogram.size() <= nbPoints - nbOutliers);
+    for (const std::size_t index : inliersHistogram)
+      BOOST_CHECK(index >= nbOutliers);
+
+    // the model reprojects the points close to their true projections
+    for (std::size_t i = 0; i < nbPoints; ++i)
+      BOOST_CHECK_SMALL((Project(PHistogram, Vec3(X.col(i))) - Vec2(d._x[nResectionCameraIndex].col(i))).norm(), 3.0);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(P3P_Kneip_CVPR11_Multiview) {
 
   const int nViews = 3;
@@ -37,14 +37,22 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/SPRT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -145,6 +153,247 @@ inline ErrorIndex bestNFA(
 }
 
 
+/**
+ * @brief NFA evaluation mode of ACRANSAC
+ */
+enum class EACRansacNFA
+{
+  EXACT = 0,     //< sort all the residuals of each model (O(n log n))
+  HISTOGRAM      //< bin the residuals in a fixed logarithmic histogram and only sort the bins which may contain the best NFA
+};
+
+inline std::string EACRansacNFA_enumToString(EACRansacNFA nfaMode)
+{
+  switch(nfaMode)
+  {
+    case EACRansacNFA::EXACT:
+      return "exact";
+    case EACRansacNFA::HISTOGRAM:
+      return "histogram";
+  }
+  throw std::out_of_range("Invalid ACRansac NFA mode Enum");
+}
+
+inline EACRansacNFA EACRansacNFA_stringToEnum(const std::string& nfaMode)
+{
+  if(nfaMode == "exact")
+    return EACRansacNFA::EXACT;
+  if(nfaMode == "histogram")
+    return EACRansacNFA::HISTOGRAM;
+  throw std::out_of_range("Invalid ACRansac NFA mode string " + nfaMode);
+}
+
+inline std::ostream& operator<<(std::ostream& os, EACRansacNFA e)
+{
+  return os << EACRansacNFA_enumToString(e);
+}
+
+inline std::istream& operator>>(std::istream& in, EACRansacNFA& nfaMode)
+{
+  std::string token;
+  in >> token;
+  nfaMode = EACRansacNFA_stringToEnum(token);
+  return in;
+}
+
+/**
+ * @brief Find best NFA without sorting all the residuals.
+ *
+ * The residuals are binned in a fixed logarithmic histogram (8 bins per octave
+ * in [2^-40, 2^40], the bin index is read from the bits of the double).
+ * The NFA is evaluated at the end of each bin with the largest residual of the bin,
+ * which is the exact NFA for this number of inliers. The NFA increases with the residual,
+ * so the NFA evaluated with the smallest residual of a bin is a lower bound of the NFA
+ * inside the bin. Only the residuals of the bins whose lower bound is not above the best
+ * NFA at the end of a bin are sorted, which gives the same minimum as sorting all the residuals.
+ *
+ * The buffers are kept between the calls, so it should be reused for all the models.
+ */
+class HistogramNFA
+{
+public:
+  HistogramNFA()
+    : _counts(nbBins)
+    , _binMin(nbBins)
+    , _binMax(nbBins)
+    , _refinedBins(nbBins)
+  {}
+
+  /**
+   * @brief Find best NFA and its index wrt square error threshold in residuals.
+   * @see bestNFA
+   * @return (NFA, number of inliers)
+   */
+  ErrorIndex bestNFA(
+    int startIndex, //number of point required for estimation
+    double logalpha0,
+    const std::vector<double>& residuals,
+    double loge0,
+    double maxThreshold,
+    const std::vector<float> &logc_n,
+    const std::vector<float> &logc_k,
+    double multError = 1.0)
+  {
+    ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), startIndex);
+    _maxThreshold = maxThreshold;
+    _bestBin = nbBins;
+
+    std::fill(_counts.begin(), _counts.end(), 0);
+    std::fill(_binMin.begin(), _binMin.end(), std::numeric_limits<double>::infinity());
+    std::fill(_binMax.begin(), _binMax.end(), 0.0);
+    for(const double error : residuals)
+    {
+      if(!(error <= maxThreshold))
+        continue;
+      const std::size_t b = binIndex(error);
+      ++_counts[b];
+      _binMin[b] = std::min(_binMin[b], error);
+      _binMax[b] = std::max(_binMax[b], error);
+    }
+
+    const auto nfa = [&](std::size_t k, double error)
+    {
+      const double logalpha = logalpha0 + multError * log10(error + std::numeric_limits<float>::epsilon());
+      return loge0 + logalpha * (double) (k - startIndex) + logc_n[k] + logc_k[k];
+    };
+
+    // exact NFA at the end of each bin
+    double bestEndNFA = std::numeric_limits<double>::infinity();
+    std::size_t k = 0;
+    for(std::size_t b = 0; b < nbBins; ++b)
+    {
+      if(_counts[b] == 0)
+        continue;
+      k += _counts[b];
+      if(k > (std::size_t) startIndex)
+        bestEndNFA = std::min(bestEndNFA, nfa(k, _binMax[b]));
+    }
+    if(bestEndNFA == std::numeric_limits<double>::infinity())
+      return bestIndex;
+
+    // the bins which may contain a better NFA than the best end of bin
+    std::fill(_refinedBins.begin(), _refinedBins.end(), false);
+    k = 0;
+    for(std::size_t b = 0; b < nbBins; ++b)
+    {
+      if(_counts[b] == 0)
+        continue;
+      const double logalphaMin = logalpha0 + multError * log10(_binMin[b] + std::numeric_limits<float>::epsilon());
+      for(std::size_t kBin = k + 1; kBin <= k + _counts[b]; ++kBin)
+      {
+        if(kBin <= (std::size_t) startIndex)
+          continue;
+        if(loge0 + logalphaMin * (double) (kBin - startIndex) + logc_n[kBin] + logc_k[kBin] <= bestEndNFA)
+        {
+          _refinedBins[b] = true;
+          break;
+        }
+      }
+      k += _counts[b];
+    }
+
+    _refined.clear();
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      const double error = residuals[i];
+      if(error <= maxThreshold && _refinedBins[binIndex(error)])
+        _refined.emplace_back(error, i);
+    }
+    std::sort(_refined.begin(), _refined.end());
+
+    // exact NFA in the refined bins, in the order of the sorted residuals
+    std::size_t refinedIndex = 0;
+    k = 0;
+    for(std::size_t b = 0; b < nbBins; ++b)
+    {
+      if(_counts[b] == 0)
+        continue;
+      if(_refinedBins[b])
+      {
+        for(std::size_t i = 0; i < _counts[b]; ++i)
+        {
+          const std::size_t kRefined = k + i + 1;
+          if(kRefined <= (std::size_t) startIndex)
+            continue;
+          const double value = nfa(kRefined, _refined[refinedIndex + i].first);
+          if(value < bestIndex.first)
+          {
+            bestIndex = ErrorIndex(value, kRefined);
+            _bestBin = b;
+            _bestBinRefinedIndex = refinedIndex;
+            _nbInliersBefore = k;
+          }
+        }
+        refinedIndex += _counts[b];
+      }
+      k += _counts[b];
+    }
+    return bestIndex;
+  }
+
+  /**
+   * @brief Get the inliers and the error threshold of the last bestNFA call
+   * @note The inliers are sorted by residual as in the exact mode, the optimization
+   *       phase of ACRANSAC then draws the same samples among them.
+   *       It is only called for the better models, so this sort is rare.
+   * @param[in] residuals the residuals given to bestNFA
+   * @param[in] best the result of bestNFA
+   * @param[out] inliers the inliers indexes
+   * @return the error threshold
+   */
+  double getInliers(const std::vector<double>& residuals, const ErrorIndex& best, std::vector<std::size_t>& inliers)
+  {
+    // all the residuals binned before the bin of the best NFA
+    _inliers.clear();
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      if(residuals[i] <= _maxThreshold && binIndex(residuals[i]) < _bestBin)
+        _inliers.emplace_back(residuals[i], i);
+    }
+    std::sort(_inliers.begin(), _inliers.end());
+
+    inliers.clear();
+    inliers.reserve(best.second);
+    for(const ErrorIndex& inlier : _inliers)
+      inliers.push_back(inlier.second);
+    // and the best sorted residuals of this bin
+    const std::size_t nbRefined = best.second - _nbInliersBefore;
+    for(std::size_t i = 0; i < nbRefined; ++i)
+      inliers.push_back(_refined[_bestBinRefinedIndex + i].second);
+    return _refined[_bestBinRefinedIndex + nbRefined - 1].first;
+  }
+
+private:
+  static const int mantissaBits = 3;       // 8 bins per octave
+  static const int minExponent = -40;      // smaller residuals are in the first bin
+  static const std::size_t nbBins = 80 << mantissaBits; // [2^-40, 2^40]
+
+  static std::size_t binIndex(double error)
+  {
+    static const double minError = std::ldexp(1.0, minExponent);
+    if(!(error > minError))
+      return 0;
+    // the binary representation of positive doubles is monotonic: exponent then mantissa
+    std::uint64_t bits;
+    std::memcpy(&bits, &error, sizeof(bits));
+    std::uint64_t minBits;
+    std::memcpy(&minBits, &minError, sizeof(minBits));
+    const std::uint64_t b = (bits >> (52 - mantissaBits)) - (minBits >> (52 - mantissaBits));
+    return std::min<std::uint64_t>(b, nbBins - 1);
+  }
+
+  std::vector<std::size_t> _counts;
+  std::vector<double> _binMin;
+  std::vector<double> _binMax;
+  std::vector<bool> _refinedBins;
+  std::vector<ErrorIndex> _refined;
+  std::vector<ErrorIndex> _inliers;
+  std::size_t _bestBin = 0;
+  std::size_t _bestBinRefinedIndex = 0;
+  std::size_t _nbInliersBefore = 0;
+  double _maxThreshold = 0.0;
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -154,6 +403,11 @@ inline ErrorIndex bestNFA(
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
  * @param[in] bVerbose display console log
+ * @param[in] nfaMode NFA evaluation: exact (sort the residuals) or histogram (sort-free)
+ * @param[in] randomNumberGenerator random number generator for the samples
+ *            (if nullptr, a generator seeded by system::getRandomSeed is used)
+ * @param[in] useSPRT reject the models that are unlikely to be better than the best model so far
+ *            with a sequential probability ratio test, before computing all their residuals
  *
  * @return (errorMax, minNFA)
  */
@@ -163,7 +417,10 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   size_t nIter = 1024,
   typename Kernel::Model * model = nullptr,
   double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false)
+  bool bVerbose = false,
+  EACRansacNFA nfaMode = EACRansacNFA::EXACT,
+  std::mt19937* randomNumberGenerator = nullptr,
+  bool useSPRT = false)
 {
   vec_inliers.clear();
 
@@ -176,8 +433,27 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
+  std::vector<ErrorIndex> vec_residuals; // [residual,index]
   std::vector<double> vec_residuals_(nData);
+  HistogramNFA histogramNFA;
+  if(nfaMode == EACRansacNFA::EXACT)
+    vec_residuals.resize(nData);
+
+  std::mt19937 defaultGenerator;
+  if(randomNumberGenerator == nullptr)
+    defaultGenerator.seed(system::getRandomSeed());
+  std::mt19937& generator = (randomNumberGenerator != nullptr) ? *randomNumberGenerator : defaultGenerator;
+
+  // Early rejection of the bad models (against the best model so far)
+  std::unique_ptr<SPRT> sprt;
+  if(useSPRT)
+    sprt.reset(new SPRT(nData, generator));
+
+  // Buffers reused by all the iterations
+  std::vector<std::size_t> vec_sample; // Sample indices
+  vec_sample.reserve(sizeSample);
+  std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+  vec_models.reserve(Kernel::MAX_MODELS);
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
   std::vector<size_t> vec_index(nData);
@@ -201,19 +477,22 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   // Main estimation loop.
   for (size_t iter=0; iter < nIter; ++iter)
   {
-    std::vector< std::size_t> vec_sample(sizeSample); // Sample indices
     if (bACRansacMode)
-      UniformSample(sizeSample, vec_index, vec_sample); // Get random sample
+      UniformSample(sizeSample, vec_index, generator, vec_sample); // Get random sample
     else
-      UniformSample(sizeSample, nData, vec_sample); // Get random sample
+      UniformSample(sizeSample, nData, generator, vec_sample); // Get random sample
 
-    std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+    vec_models.clear();
     kernel.Fit(vec_sample, &vec_models);
 
     // Evaluate models
     bool better = false;
     for (size_t k = 0; k < vec_models.size(); ++k)
     {
+      // Reject the models that are very unlikely to be better than the best one
+      if (sprt && minNFA < 0 && !sprt->isGoodModel(kernel, vec_models[k], errorMax))
+        continue;
+
       // Residuals computation and ordering
       kernel.Errors(vec_models[k], vec_residuals_);
 
@@ -228,7 +507,41 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
         if (nInlier > 2.5 * sizeSample) // does the model is meaningful
           bACRansacMode = true;
       }
-      if (bACRansacMode)
+      if (bACRansacMode && nfaMode == EACRansacNFA::HISTOGRAM)
+      {
+        // Most meaningful discrimination inliers/outliers (without sorting all the residuals)
+        const ErrorIndex best = histogramNFA.bestNFA(
+          sizeSample,
+          kernel.logalpha0(),
+          vec_residuals_,
+          loge0,
+          maxThreshold,
+          vec_logc_n,
+          vec_logc_k,
+          kernel.multError());
+
+        if (best.first < minNFA)
+        {
+          // A better model was found
+          better = true;
+          minNFA = best.first;
+          errorMax = histogramNFA.getInliers(vec_residuals_, best, vec_inliers); // Error threshold
+          if(model) *model = vec_models[k];
+          if(sprt) sprt->setEpsilon(best.second / double(nData));
+
+          if(bVerbose)
+          {
+            ALICEVISION_LOG_DEBUG("  nfa=" << minNFA
+              << " inliers=" << best.second << "/" << nData
+              << " precisionNormalized=" << errorMax
+              << " precision=" << kernel.unormalizeError(errorMax)
+              << " (iter=" << iter
+              << ",sample=" << vec_sample
+              << ")");
+          }
+        }
+      }
+      else if (bACRansacMode)
       {
         for (size_t i = 0; i < nData; ++i)
         {
@@ -258,6 +571,7 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
             vec_inliers[i] = vec_residuals[i].second;
           errorMax = vec_residuals[best.second-1].first; // Error threshold
           if(model) *model = vec_models[k];
+          if(sprt) sprt->setEpsilon(best.second / double(nData));
 
           if(bVerbose)
           {
@@ -30,6 +30,9 @@
 #include <aliceVision/multiview/conditioning.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
+
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace aliceVision {
@@ -85,6 +88,70 @@ inline bool hasStrongSupport(const matching::MatchesPerDescType& matchesPerDesc,
 }
 
 
+/// Check if the error functor ErrorT provides a batched
+/// ErrorT::Errors(model, x1, x2, errors) to compute the errors of all the correspondences at once
+template <typename ErrorT, typename Model, typename = void>
+struct HasBatchedErrors : std::false_type {};
+
+template <typename ErrorT, typename Model>
+struct HasBatchedErrors<ErrorT, Model, decltype(ErrorT::Errors(std::declval<const Model&>(),
+                                                               std::declval<const Mat&>(),
+                                                               std::declval<const Mat&>(),
+                                                               std::declval<std::vector<double>&>()), void())>
+  : std::true_type {};
+
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, std::vector<double> &errors, std::true_type)
+{
+  ErrorT::Errors(model, x1, x2, errors);
+}
+
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, std::vector<double> &errors, std::false_type)
+{
+  errors.resize(x1.cols());
+  for(std::size_t sample = 0; sample < x1.cols(); ++sample)
+    errors[sample] = ErrorT::Error(model, x1.col(sample), x2.col(sample));
+}
+
+/**
+ * @brief Compute the errors of all the correspondences (columns of x1 and x2) for a given model.
+ *        The batched ErrorT::Errors is used if available, ErrorT::Error is called
+ *        for each correspondence otherwise.
+ */
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, std::vector<double> &errors)
+{
+  computeErrors<ErrorT>(model, x1, x2, errors, HasBatchedErrors<ErrorT, Model>());
+}
+
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, const std::vector<std::size_t> &samples,
+                          std::vector<double> &errors, std::true_type)
+{
+  ErrorT::Errors(model, ExtractColumns(x1, samples), ExtractColumns(x2, samples), errors);
+}
+
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, const std::vector<std::size_t> &samples,
+                          std::vector<double> &errors, std::false_type)
+{
+  errors.resize(samples.size());
+  for(std::size_t i = 0; i < samples.size(); ++i)
+    errors[i] = ErrorT::Error(model, x1.col(samples[i]), x2.col(samples[i]));
+}
+
+/**
+ * @brief Compute the errors of the given correspondences (columns of x1 and x2) for a given model.
+ *        Only the requested columns are evaluated, errors[i] is the error of samples[i].
+ */
+template <typename ErrorT, typename Model>
+inline void computeErrors(const Model &model, const Mat &x1, const Mat &x2, const std::vector<std::size_t> &samples,
+                          std::vector<double> &errors)
+{
+  computeErrors<ErrorT>(model, x1, x2, samples, errors, HasBatchedErrors<ErrorT, Model>());
+}
+
 /// Two view Kernel adapter for the A contrario model estimator
 /// Handle data normalization and compute the corresponding logalpha 0
 ///  that depends of the error model (point to line, or point to point)
@@ -154,9 +221,12 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+    computeErrors<ErrorT>(model, x1_, x2_, vec_errors);
+  }
+
+  void Errors(const Model & model, const std::vector<std::size_t> & samples, std::vector<double> & vec_errors) const
+  {
+    computeErrors<ErrorT>(model, x1_, x2_, samples, vec_errors);
   }
 
   std::size_t NumSamples() const
@@ -242,9 +312,12 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    computeErrors<ErrorT>(model, x2d_, x3D_, vec_errors);
+  }
+
+  void Errors(const Model & model, const std::vector<std::size_t> & samples, std::vector<double> & vec_errors) const
+  {
+    computeErrors<ErrorT>(model, x2d_, x3D_, samples, vec_errors);
   }
 
   std::size_t NumSamples() const
@@ -322,9 +395,12 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    computeErrors<ErrorT>(model, x2d_, x3D_, vec_errors);
+  }
+
+  void Errors(const Model & model, const std::vector<std::size_t> & samples, std::vector<double> & vec_errors) const
+  {
+    computeErrors<ErrorT>(model, x2d_, x3D_, samples, vec_errors);
   }
 
   std::size_t NumSamples() const { return x2d_.cols(); }
@@ -411,9 +487,7 @@ public:
   {
     Mat3 F;
     FundamentalFromEssential(model, K1_, K2_, &F);
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+    computeErrors<ErrorT>(F, x1_, x2_, vec_errors);
   }
 
   std::size_t NumSamples() const { return x1_.cols(); }
@@ -9,9 +9,12 @@
 #include "aliceVision/robustEstimation/randSampling.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
 #include "aliceVision/robustEstimation/ransacTools.hpp"
+#include "aliceVision/robustEstimation/SPRT.hpp"
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <iostream>
+#include <random>
 #include <vector>
 #include <iterator>
 
@@ -379,6 +382,8 @@ double localOptimization(const Kernel &kernel,
  * @param[in] bVerbose Enable/Disable log messages
  * @param[in] max_iterations Maximum number of iterations for the ransac part.
  * @param[in] outliers_probability The wanted probability of picking outliers.
+ * @param[in] useSPRT Reject the models that are unlikely to have more inliers than
+ * the best model so far with a sequential probability ratio test, before scoring them.
  * @return The best model found.
  */
 template<typename Kernel, typename Scorer>
@@ -388,7 +393,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
                                 double *best_score = NULL,
                                 bool bVerbose = false,
                                 std::size_t max_iterations = 100,
-                                double outliers_probability = 1e-2)
+                                double outliers_probability = 1e-2,
+                                bool useSPRT = false)
 {
   assert(outliers_probability < 1.0);
   assert(outliers_probability > 0.0);
@@ -416,10 +422,17 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
   std::vector<std::size_t> all_samples(total_samples);
   std::iota(all_samples.begin(), all_samples.end(), 0);
 
+  std::mt19937 generator(system::getRandomSeed());
+
+  // Early rejection of the bad models (against the best model so far)
+  std::unique_ptr<SPRT> sprt;
+  if(useSPRT)
+    sprt.reset(new SPRT(total_samples, generator));
+
   for(iteration = 0; iteration < max_iterations; ++iteration) 
   {
     std::vector<std::size_t> sample;
-    UniformSample(min_samples, total_samples, sample);
+    UniformSample(min_samples, total_samples, generator, sample);
 
     std::vector<typename Kernel::Model> models;
     kernel.Fit(sample, &models);
@@ -427,6 +440,9 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
     // Compute the inlier list for each fit.
     for(std::size_t i = 0; i < models.size(); ++i) 
     {
+      if(sprt && bestNumInliers > 0 && !sprt->isGoodModel(kernel, models[i], scorer.getThreshold()))
+        continue;
+
       std::vector<std::size_t> inliers;
       double score = scorer.Score(kernel, models[i], all_samples, &inliers);
       if(bVerbose)
@@ -463,6 +479,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
         
         bestNumInliers = inliers.size();
         bestInlierRatio = inliers.size() / double(total_samples);
+        if(sprt)
+          sprt->setEpsilon(bestInlierRatio);
 
         if (best_inliers) 
         {
@@ -77,14 +77,12 @@ public:
                       std::vector<double> & vec_weights, 
                       const double eps = 0.001) const
   {
-    const auto numInliers = inliers.size();
-    vec_weights.resize(numInliers);
-    for(std::size_t sample = 0; sample < numInliers; ++sample)
+    // only the errors of the inliers are computed
+    this->Errors(model, inliers, vec_weights);
+    for(double& weight : vec_weights)
     {
-      const auto idx = inliers[sample];
-      vec_weights[sample] = ErrorT::Error(model, this->x1_.col(idx), this->x2_.col(idx));
       // avoid division by zero
-      vec_weights[sample] = 1.0 / std::pow(std::max(eps, vec_weights[sample]), 2.0);
+      weight = 1.0 / std::pow(std::max(eps, weight), 2.0);
     }
   }
 
@@ -144,14 +142,12 @@ class KernelAdaptorResectionLORansac_K :
                       std::vector<double> & vec_weights, 
                       const double eps = 0.001) const
   {
-    const auto numInliers = inliers.size();
-    vec_weights.resize(numInliers);
-    for(std::size_t sample = 0; sample < numInliers; ++sample)
+    // only the errors of the inliers are computed
+    this->Errors(model, inliers, vec_weights);
+    for(double& weight : vec_weights)
     {
-      const auto idx = inliers[sample];
-      vec_weights[sample] = ErrorT::Error(model, this->x2d_.col(idx), this->x3D_.col(idx));
       // avoid division by zero
-      vec_weights[sample] = 1/std::pow(std::max(eps, vec_weights[sample]), 2);
+      weight = 1.0 / std::pow(std::max(eps, weight), 2.0);
     }
   }
 };
@@ -0,0 +1,144 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Sequential Probability Ratio Test (SPRT) used to reject bad models early.
+ *
+ * The data points are verified one by one (in a random order) and the verification
+ * stops as soon as the likelihood ratio between the "bad model" and the "good model"
+ * hypotheses exceeds the decision threshold A.
+ * The probability that a point is consistent with a bad model (delta) is estimated
+ * from the rejected models, the probability that a point is consistent with a good
+ * model (epsilon) is the inlier ratio of the best model so far.
+ *
+ * Ondrej Chum, Jiri Matas:
+ * Optimal Randomized RANSAC. PAMI 2008.
+ */
+class SPRT
+{
+public:
+  /**
+   * @param[in] nbData number of data points
+   * @param[in] generator random number generator used to draw the verification order
+   * @param[in] epsilon initial probability that a point is consistent with a good model
+   * @param[in] delta initial probability that a point is consistent with a bad model
+   * @param[in] modelCost time to estimate the models of a sample, in units of the verification time of one point
+   */
+  SPRT(std::size_t nbData, std::mt19937& generator, double epsilon = 0.1, double delta = 0.01, double modelCost = 200.0)
+    : _order(nbData)
+    , _epsilon(epsilon)
+    , _delta(delta)
+    , _modelCost(modelCost)
+  {
+    std::iota(_order.begin(), _order.end(), 0);
+    std::shuffle(_order.begin(), _order.end(), generator);
+    updateDecisionThreshold();
+  }
+
+  /**
+   * @brief Verify a model until it is rejected or all the points have been verified
+   * @param[in] kernel kernel providing Error(sample, model)
+   * @param[in] model model to verify
+   * @param[in] threshold error threshold of the consistent points
+   * @return false if the model has been rejected
+   */
+  template<typename Kernel>
+  bool isGoodModel(const Kernel& kernel, const typename Kernel::Model& model, double threshold)
+  {
+    if(!_enabled)
+      return true;
+
+    double logLambda = 0.0;
+    std::size_t nbConsistent = 0;
+    for(std::size_t i = 0; i < _order.size(); ++i)
+    {
+      if(kernel.Error(_order[i], model) <= threshold)
+      {
+        ++nbConsistent;
+        logLambda += _logConsistent;
+      }
+      else
+      {
+        logLambda += _logInconsistent;
+      }
+
+      if(logLambda > _logA)
+      {
+        ++_nbRejected;
+        _nbRejectedConsistent += nbConsistent;
+        _nbRejectedVerified += i + 1;
+
+        // update the delta estimation if it changed significantly
+        const double delta = std::max(0.001, _nbRejectedConsistent / double(_nbRejectedVerified));
+        if(std::abs(delta - _delta) > 0.05 * _delta)
+        {
+          _delta = delta;
+          updateDecisionThreshold();
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Update the probability that a point is consistent with a good model
+   * @param[in] epsilon inlier ratio of the best model so far
+   */
+  void setEpsilon(double epsilon)
+  {
+    _epsilon = epsilon;
+    updateDecisionThreshold();
+  }
+
+  std::size_t nbRejected() const { return _nbRejected; }
+
+private:
+  void updateDecisionThreshold()
+  {
+    // the test is only meaningful if a good model has more consistent points than a bad one
+    _enabled = (_delta < _epsilon) && (_epsilon < 1.0);
+    if(!_enabled)
+      return;
+
+    _logConsistent = std::log(_delta / _epsilon);
+    _logInconsistent = std::log((1.0 - _delta) / (1.0 - _epsilon));
+
+    // optimal decision threshold: A = C * modelCost + 1 + log(A) (fixed point iteration)
+    const double C = (1.0 - _delta) * std::log((1.0 - _delta) / (1.0 - _epsilon)) + _delta * std::log(_delta / _epsilon);
+    const double K = C * _modelCost + 1.0;
+    double A = K;
+    for(int i = 0; i < 10; ++i)
+      A = K + std::log(A);
+    _logA = std::log(A);
+  }
+
+  std::vector<std::size_t> _order;
+  double _epsilon;
+  double _delta;
+  double _modelCost;
+  double _logA = 0.0;
+  double _logConsistent = 0.0;
+  double _logInconsistent = 0.0;
+  bool _enabled = false;
+  std::size_t _nbRejected = 0;
+  std::size_t _nbRejectedConsistent = 0;
+  std::size_t _nbRejectedVerified = 0;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
@@ -7,23 +7,95 @@
 
 #pragma once
 
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace aliceVision {
 namespace robustEstimation{
 
 using namespace std;
 
+/// Check if the kernel provides Kernel::Errors(model, samples, errors)
+/// to compute the errors of a set of samples at once
+/// (such a kernel also provides Kernel::Errors(model, errors) for all its samples)
+template <typename Kernel, typename = void>
+struct HasKernelErrors : std::false_type {};
+
+template <typename Kernel>
+struct HasKernelErrors<Kernel, decltype(std::declval<const Kernel&>().Errors(std::declval<const typename Kernel::Model&>(),
+                                                                             std::declval<const std::vector<std::size_t>&>(),
+                                                                             std::declval<std::vector<double>&>()), void())>
+  : std::true_type {};
+
 /// Templated Functor class to evaluate a given model over a set of samples.
 template<typename Kernel>
 class ScoreEvaluator {
 public:
   ScoreEvaluator(double threshold) : threshold_(threshold) {}
 
+  /**
+   * @brief Compute the cost of a model (sum of the errors) and its inliers.
+   *        The errors of the given samples are computed in a single Kernel::Errors call
+   *        if the kernel provides it, Kernel::Error is called for each sample otherwise.
+   */
   template <typename T>
   double Score(const Kernel &kernel,
                const typename Kernel::Model &model,
                const std::vector<T> &samples,
                std::vector<T> *inliers,
                double threshold) const
+  {
+    return Score(kernel, model, samples, inliers, threshold,
+                 std::integral_constant<bool, HasKernelErrors<Kernel>::value && std::is_same<T, std::size_t>::value>());
+  }
+
+  template <typename T>
+  double Score(const Kernel &kernel,
+               const typename Kernel::Model &model,
+               const std::vector<T> &samples,
+               std::vector<T> *inliers) const
+  {
+    return Score(kernel, model, samples, inliers, threshold_);
+  }
+  
+  double getThreshold() const {return threshold_;} 
+  
+private:
+  template <typename T>
+  double Score(const Kernel &kernel,
+               const typename Kernel::Model &model,
+               const std::vector<T> &samples,
+               std::vector<T> *inliers,
+               double threshold,
+               std::true_type) const
+  {
+    std::vector<double> errors;
+    const bool allSamples = (samples.size() == kernel.NumSamples());
+    // only the errors of the given samples are computed
+    if(allSamples)
+      kernel.Errors(model, errors);
+    else
+      kernel.Errors(model, samples, errors);
+
+    double cost = 0.0;
+    for(std::size_t j = 0; j < samples.size(); ++j)
+    {
+      const double error = allSamples ? errors[samples[j]] : errors[j];
+      cost += error;
+      if(error < threshold)
+        inliers->push_back(samples[j]);
+    }
+    return cost;
+  }
+
+  template <typename T>
+  double Score(const Kernel &kernel,
+               const typename Kernel::Model &model,
+               const std::vector<T> &samples,
+               std::vector<T> *inliers,
+               double threshold,
+               std::false_type) const
   {
     double cost = 0.0;
     for (size_t j = 0; j < samples.size(); ++j) 
@@ -43,18 +115,6 @@ public:
     return cost;
   }
 
-  template <typename T>
-  double Score(const Kernel &kernel,
-               const typename Kernel::Model &model,
-               const std::vector<T> &samples,
-               std::vector<T> *inliers) const
-  {
-    return Score(kernel, model, samples, inliers, threshold_);
-  }
-  
-  double getThreshold() const {return threshold_;} 
-  
-private:
   double threshold_;
 };
 
@@ -11,6 +11,7 @@
 #include <aliceVision/robustEstimation/LineKernel.hpp>
 #include <aliceVision/robustEstimation/ACRansac.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 #include <glog/logging.h>
 
 #include "lineTestGenerator.hpp"
@@ -362,3 +363,204 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// Test the sort-free (histogram) NFA evaluation against the exact one
+
+BOOST_AUTO_TEST_CASE(RansacLineFitter_HistogramNFA)
+{
+  const int S = 100;
+  const int W = S, H = S;
+  const float outlierRatio = .3f;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  for(std::size_t i = 0; i < 10; ++i)
+  {
+    const double gaussianNoiseLevel = i / 10. * 5.;
+    const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+
+    Mat2X points(2, numPoints);
+    std::vector<std::size_t> vec_inliersGT;
+    generateLine(numPoints, outlierRatio, gaussianNoiseLevel, GTModel, gen, points, vec_inliersGT);
+
+    ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, W, H);
+
+    // same random samples for both modes
+    std::mt19937 generatorExact(i);
+    std::mt19937 generatorHistogram(i);
+
+    std::vector<std::size_t> inliersExact, inliersHistogram;
+    Vec2 lineExact, lineHistogram;
+    const std::pair<double,double> retExact = ACRANSAC(lineKernel, inliersExact, 1000, &lineExact,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::EXACT, &generatorExact);
+    const std::pair<double,double> retHistogram = ACRANSAC(lineKernel, inliersHistogram, 1000, &lineHistogram,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::HISTOGRAM, &generatorHistogram);
+
+    BOOST_CHECK(inliersHistogram.size() <= vec_inliersGT.size());
+    BOOST_CHECK(std::abs(double(inliersHistogram.size()) - double(inliersExact.size())) <= 0.05 * numPoints);
+    BOOST_CHECK(retHistogram.second < 0); // meaningful model
+    BOOST_CHECK_SMALL(retHistogram.second - retExact.second, 0.1 * std::abs(retExact.second) + 1.0);
+
+    // the inliers are the residuals below the threshold
+    std::vector<double> residuals(numPoints);
+    lineKernel.Errors(lineHistogram, residuals);
+    std::size_t nbBelowThreshold = 0;
+    for(const double r : residuals)
+      nbBelowThreshold += (lineKernel.unormalizeError(r) <= retHistogram.first) ? 1 : 0;
+    BOOST_CHECK_EQUAL(nbBelowThreshold, inliersHistogram.size());
+  }
+}
+
+// Test that ACRANSAC is repeatable with a seeded random number generator
+
+BOOST_AUTO_TEST_CASE(RansacLineFitter_DeterministicGenerator)
+{
+  const int S = 100;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, .3f, 2.0, GTModel, gen, points, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, S, S);
+
+  for(const EACRansacNFA nfaMode : {EACRansacNFA::EXACT, EACRansacNFA::HISTOGRAM})
+  {
+    std::mt19937 generatorA(42);
+    std::mt19937 generatorB(42);
+    std::vector<std::size_t> inliersA, inliersB;
+    Vec2 lineA, lineB;
+    const std::pair<double,double> retA = ACRANSAC(lineKernel, inliersA, 1000, &lineA,
+      std::numeric_limits<double>::infinity(), false, nfaMode, &generatorA);
+    const std::pair<double,double> retB = ACRANSAC(lineKernel, inliersB, 1000, &lineB,
+      std::numeric_limits<double>::infinity(), false, nfaMode, &generatorB);
+
+    BOOST_CHECK(inliersA == inliersB);
+    BOOST_CHECK_EQUAL(retA.first, retB.first);
+    BOOST_CHECK_EQUAL(retA.second, retB.second);
+    BOOST_CHECK_EQUAL(lineA, lineB);
+  }
+}
+
+// Test that the random numbers of a task do not depend on the thread running it in deterministic mode
+
+BOOST_AUTO_TEST_CASE(RansacLineFitter_DeterministicMode)
+{
+  const int S = 100;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, .3f, 2.0, GTModel, gen, points, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, S, S);
+
+  system::setDeterministicMode(42);
+
+  // seeds of a task
+  std::vector<unsigned int> seedsA, seedsB;
+  {
+    system::RandomTaskScope randomTask(3);
+    seedsA = {system::getRandomSeed(), system::getRandomSeed()};
+  }
+  const unsigned int seedOutsideTask = system::getRandomSeed();
+  {
+    system::RandomTaskScope randomTask(3);
+    seedsB = {system::getRandomSeed(), system::getRandomSeed()};
+  }
+  BOOST_CHECK(seedsA == seedsB);
+  BOOST_CHECK_NE(seedsA[0], seedsA[1]);
+  BOOST_CHECK_NE(seedOutsideTask, seedsA[0]);
+
+  // same results for each task, whatever the thread scheduling
+  const int nbTasks = 16;
+  std::vector<std::vector<std::size_t>> inliersA(nbTasks), inliersB(nbTasks);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < nbTasks; ++i)
+  {
+    system::RandomTaskScope randomTask(i);
+    ACRANSAC(lineKernel, inliersA[i], 100);
+  }
+  for(int i = nbTasks - 1; i >= 0; --i)
+  {
+    system::RandomTaskScope randomTask(i);
+    ACRANSAC(lineKernel, inliersB[i], 100);
+  }
+  BOOST_CHECK(inliersA == inliersB);
+
+  system::unsetDeterministicMode();
+  BOOST_CHECK(!system::isDeterministicMode());
+}
+
+BOOST_AUTO_TEST_CASE(RansacLineFitter_SPRT)
+{
+  const int S = 100;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  std::size_t nbWorse = 0;
+  for(std::size_t i = 0; i < 10; ++i)
+  {
+    const double gaussianNoiseLevel = i / 10. * 5.;
+    const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+
+    Mat2X points(2, numPoints);
+    std::vector<std::size_t> vec_inliersGT;
+    generateLine(numPoints, .5f, gaussianNoiseLevel, GTModel, gen, points, vec_inliersGT);
+
+    ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, S, S);
+
+    std::mt19937 generator(i);
+    std::mt19937 generatorSPRT(i);
+    std::vector<std::size_t> inliers, inliersSPRT;
+    Vec2 line, lineSPRT;
+    const std::pair<double,double> ret = ACRANSAC(lineKernel, inliers, 1000, &line,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::EXACT, &generator);
+    const std::pair<double,double> retSPRT = ACRANSAC(lineKernel, inliersSPRT, 1000, &lineSPRT,
+      std::numeric_limits<double>::infinity(), false, EACRansacNFA::EXACT, &generatorSPRT, true);
+
+    BOOST_CHECK(retSPRT.second < 0); // meaningful model
+    BOOST_CHECK(inliersSPRT.size() <= vec_inliersGT.size() + 0.05 * numPoints);
+
+    // the SPRT can reject a good model, but rarely
+    if(retSPRT.second > 0.9 * ret.second)
+      ++nbWorse;
+  }
+  BOOST_CHECK(nbWorse <= 1);
+}
+
+BOOST_AUTO_TEST_CASE(SPRT_RejectBadModels)
+{
+  const int S = 100;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, .5f, 0.0, GTModel, gen, points, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, S, S);
+
+  std::mt19937 generator(0);
+  SPRT sprt(numPoints, generator);
+  sprt.setEpsilon(vec_inliersGT.size() / double(numPoints));
+
+  // the ground truth model is accepted
+  BOOST_CHECK(sprt.isGoodModel(lineKernel, GTModel, 1e-3));
+
+  // a wrong model is rejected
+  Vec2 wrongModel;
+  wrongModel << 2, -.3;
+  BOOST_CHECK(!sprt.isGoodModel(lineKernel, wrongModel, 1e-3));
+  BOOST_CHECK_EQUAL(sprt.nbRejected(), 1);
+}
@@ -14,6 +14,9 @@
 #include "aliceVision/feature/Regions.hpp"
 #include "aliceVision/camera/IntrinsicBase.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 namespace aliceVision {
@@ -456,5 +459,327 @@ void GuidedMatching_Fundamental_Fast(
   }
 }
 
+/**
+ * @brief Regular grid of 2D positions, used to only visit the positions
+ * that are close to a point or to a line (instead of all of them).
+ * The indices of the positions are stored sorted by cell.
+ */
+class PositionsGrid
+{
+public:
+  /**
+   * @param[in] positions the 2D positions to index
+   * @param[in] minCellSize the minimal size of a cell (in pixels), the cells are
+   *            enlarged to contain a few positions on average
+   */
+  PositionsGrid(const std::vector<Vec2>& positions, double minCellSize)
+  {
+    _cellOffsets.assign(1, 0);
+    if(positions.empty())
+      return;
+
+    Vec2 minPos = positions.front();
+    Vec2 maxPos = positions.front();
+    for(const Vec2& pos : positions)
+    {
+      minPos = minPos.cwiseMin(pos);
+      maxPos = maxPos.cwiseMax(pos);
+    }
+
+    // about 4 positions per cell on average
+    const Vec2 extent = maxPos - minPos;
+    _cellSize = std::max(1.0, std::max(minCellSize, std::sqrt(4.0 * extent(0) * extent(1) / positions.size())));
+    _origin = minPos;
+    _nbCols = static_cast<int>(extent(0) / _cellSize) + 1;
+    _nbRows = static_cast<int>(extent(1) / _cellSize) + 1;
+
+    // count the positions per cell, then fill the cells
+    std::vector<std::size_t> cellOfPosition(positions.size());
+    _cellOffsets.assign(_nbCols * _nbRows + 1, 0);
+    for(std::size_t i = 0; i < positions.size(); ++i)
+    {
+      const int col = std::min(_nbCols - 1, static_cast<int>((positions[i](0) - _origin(0)) / _cellSize));
+      const int row = std::min(_nbRows - 1, static_cast<int>((positions[i](1) - _origin(1)) / _cellSize));
+      cellOfPosition[i] = row * _nbCols + col;
+      ++_cellOffsets[cellOfPosition[i] + 1];
+    }
+    for(std::size_t c = 1; c < _cellOffsets.size(); ++c)
+      _cellOffsets[c] += _cellOffsets[c - 1];
+
+    std::vector<std::size_t> cellFill(_cellOffsets.begin(), _cellOffsets.end() - 1);
+    _indices.resize(positions.size());
+    for(std::size_t i = 0; i < positions.size(); ++i)
+      _indices[cellFill[cellOfPosition[i]]++] = i;
+  }
+
+  /**
+   * @brief Call f(index) for the positions of the cells intersecting a disk
+   * @param[in] center the disk center
+   * @param[in] radius the disk radius
+   * @param[in] f the functor called on each position index
+   */
+  template<typename Functor>
+  void forEachInDisk(const Vec2& center, double radius, Functor& f) const
+  {
+    int colBegin, colEnd, rowBegin, rowEnd;
+    if(!cellRange(center(0) - radius, center(0) + radius, _origin(0), _nbCols, colBegin, colEnd) ||
+       !cellRange(center(1) - radius, center(1) + radius, _origin(1), _nbRows, rowBegin, rowEnd))
+      return;
+
+    for(int row = rowBegin; row <= rowEnd; ++row)
+      for(int col = colBegin; col <= colEnd; ++col)
+        visitCell(row, col, f);
+  }
+
+  /**
+   * @brief Call f(index) for the positions of the cells intersecting the band
+   * of a given half width around a line
+   * @param[in] line the line (a, b, c) with ax + by + c = 0
+   * @param[in] halfWidth the half width of the band (in pixels)
+   * @param[in] f the functor called on each position index
+   */
+  template<typename Functor>
+  void forEachInBand(const Vec3& line, double halfWidth, Functor& f) const
+  {
+    const double a = line(0);
+    const double b = line(1);
+    const double c = line(2);
+    const double norm = std::sqrt(a * a + b * b);
+    if(norm == 0.0)
+      return;
+
+    // walk along the main direction of the line: the columns if the line is
+    // rather horizontal, the rows otherwise
+    const bool walkColumns = (std::abs(b) >= std::abs(a));
+    const double u = walkColumns ? a : b;
+    const double v = walkColumns ? b : a;
+    const int nbSteps = walkColumns ? _nbCols : _nbRows;
+    const int nbCells = walkColumns ? _nbRows : _nbCols;
+    const double stepOrigin = walkColumns ? _origin(0) : _origin(1);
+    const double cellOrigin = walkColumns ? _origin(1) : _origin(0);
+    const double bandOffset = halfWidth * norm / std::abs(v);
+
+    for(int step = 0; step < nbSteps; ++step)
+    {
+      // line coordinates at both sides of the step
+      const double s0 = stepOrigin + step * _cellSize;
+      const double t0 = -(u * s0 + c) / v;
+      const double t1 = -(u * (s0 + _cellSize) + c) / v;
+
+      int cellBegin, cellEnd;
+      if(!cellRange(std::min(t0, t1) - bandOffset, std::max(t0, t1) + bandOffset, cellOrigin, nbCells, cellBegin, cellEnd))
+        continue;
+
+      for(int cell = cellBegin; cell <= cellEnd; ++cell)
+      {
+        if(walkColumns)
+          visitCell(cell, step, f);
+        else
+          visitCell(step, cell, f);
+      }
+    }
+  }
+
+private:
+  /// Compute the range of cells [first, last] covering the interval [lo, hi]
+  inline bool cellRange(double lo, double hi, double origin, int nbCells, int& first, int& last) const
+  {
+    const double firstCell = std::floor((lo - origin) / _cellSize);
+    const double lastCell = std::floor((hi - origin) / _cellSize);
+    if(!(lastCell >= 0.0 && firstCell < nbCells)) // also rejects NaN
+      return false;
+    first = static_cast<int>(std::max(0.0, firstCell));
+    last = static_cast<int>(std::min(nbCells - 1.0, lastCell));
+    return true;
+  }
+
+  template<typename Functor>
+  inline void visitCell(int row, int col, Functor& f) const
+  {
+    const std::size_t cell = row * _nbCols + col;
+    for(std::size_t k = _cellOffsets[cell]; k < _cellOffsets[cell + 1]; ++k)
+      f(_indices[k]);
+  }
+
+  Vec2 _origin = Vec2::Zero();
+  double _cellSize = 1.0;
+  int _nbCols = 0;
+  int _nbRows = 0;
+  std::vector<std::size_t> _cellOffsets;
+  std::vector<std::size_t> _indices;
+};
+
+/**
+ * @brief Search area of the guided matching with a fundamental matrix:
+ * the band around the epipolar line of the left point in the right image.
+ */
+struct EpipolarBandSearchArea
+{
+  template<typename Functor>
+  static void visit(const Mat3& F, const PositionsGrid& grid, const Vec2& xLeft, double errorTh, Functor& f)
+  {
+    grid.forEachInBand(F * Vec3(xLeft(0), xLeft(1), 1.), std::sqrt(errorTh), f);
+  }
+};
+
+/**
+ * @brief Search area of the guided matching with an homography:
+ * the disk around the projection of the left point in the right image.
+ */
+struct HomographyDiskSearchArea
+{
+  template<typename Functor>
+  static void visit(const Mat3& H, const PositionsGrid& grid, const Vec2& xLeft, double errorTh, Functor& f)
+  {
+    const Vec3 x = H * Vec3(xLeft(0), xLeft(1), 1.);
+    if(x(2) == 0.0)
+      return;
+    grid.forEachInDisk(x.head<2>() / x(2), std::sqrt(errorTh), f);
+  }
+};
+
+/**
+ * @brief Guided Matching (features only) accelerated by a grid of the right points:
+ * Same results as GuidedMatching but the geometric error is only computed for the
+ * right points close to the left point transfer (given by SearchAreaArg).
+ */
+template<
+  typename ModelArg,      // The used model type
+  typename ErrorArg,      // The metric to compute distance to the model
+  typename SearchAreaArg> // The area of the right image where the error can be below the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod, // The model
+  const Mat & xLeft,    // The left data points
+  const Mat & xRight,   // The right data points
+  double errorTh,       // Maximal authorized error threshold
+  matching::IndMatches & out_validMatches) // Ouput corresponding index
+{
+  assert(xLeft.rows() == xRight.rows());
+
+  std::vector<Vec2> rPositions(xRight.cols());
+  for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    rPositions[j] = xRight.col(j);
+  const PositionsGrid grid(rPositions, 2.0 * std::sqrt(errorTh));
+
+  std::vector<matching::IndMatch> bestMatches(xLeft.cols(), matching::IndMatch(UndefinedIndexT, UndefinedIndexT));
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(xLeft.cols()); ++i)
+  {
+    const Vec2 xL = xLeft.col(i);
+    double min = std::numeric_limits<double>::max();
+    // smallest error, smallest right index on equality (as the exhaustive search)
+    auto updateMatch = [&](std::size_t j)
+    {
+      const double err = ErrorArg::Error(mod, xL, rPositions[j]);
+      if(err < errorTh && (err < min || (err == min && j < bestMatches[i]._j)))
+      {
+        min = err;
+        bestMatches[i] = matching::IndMatch(i, j);
+      }
+    };
+    SearchAreaArg::visit(mod, grid, xL, errorTh, updateMatch);
+  }
+
+  for(const matching::IndMatch& match : bestMatches)
+  {
+    if(match._i != UndefinedIndexT)
+      out_validMatches.push_back(match);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_validMatches);
+}
+
+/**
+ * @brief Guided Matching (features + descriptors with distance ratio) accelerated by a grid of the right features:
+ * Same results as GuidedMatching but the descriptor distances are only computed for the
+ * right features close to the left feature transfer (given by SearchAreaArg),
+ * in parallel over the left features.
+ */
+template<
+  typename ModelArg,      // The used model type
+  typename ErrorArg,      // The metric to compute distance to the model
+  typename SearchAreaArg> // The area of the right image where the error can be below the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod, // The model
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & out_matches) // Ouput corresponding index
+{
+  // Build region positions arrays (in order to un-distord on-demand point position once)
+  std::vector<Vec2> lRegionsPos(lRegions.RegionCount());
+  std::vector<Vec2> rRegionsPos(rRegions.RegionCount());
+
+  const bool undistortL = (camL && camL->isValid());
+  const bool undistortR = (camR && camR->isValid());
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+    lRegionsPos[i] = undistortL ? camL->get_ud_pixel(lRegions.GetRegionPosition(i)) : lRegions.GetRegionPosition(i);
+  for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    rRegionsPos[j] = undistortR ? camR->get_ud_pixel(rRegions.GetRegionPosition(j)) : rRegions.GetRegionPosition(j);
+
+  const PositionsGrid grid(rRegionsPos, 2.0 * std::sqrt(errorTh));
+
+  std::vector<distanceRatio<double> > dR(lRegions.RegionCount());
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(lRegions.RegionCount()); ++i)
+  {
+    distanceRatio<double>& dRi = dR[i];
+    auto updateMatch = [&](std::size_t j)
+    {
+      // Compute the geometric error: error to the model
+      if(ErrorArg::Error(mod, lRegionsPos[i], rRegionsPos[j]) < errorTh)
+      {
+        // Update the corresponding points & distance (if required)
+        dRi.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+      }
+    };
+    SearchAreaArg::visit(mod, grid, lRegionsPos[i], errorTh, updateMatch);
+  }
+
+  for(std::size_t i = 0; i < dR.size(); ++i)
+  {
+    // Add correspondence only iff the distance ratio is valid
+    if(dR[i].isValid(distRatio))
+      out_matches.emplace_back(i, dR[i].idx);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_matches);
+}
+
+/**
+ * @brief Guided Matching (features + descriptors with distance ratio) accelerated by a grid of the right features,
+ * for each common describer type.
+ */
+template<
+  typename ModelArg,      // The used model type
+  typename ErrorArg,      // The metric to compute distance to the model
+  typename SearchAreaArg> // The area of the right image where the error can be below the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod, // The model
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold
+  double distRatio,     // Maximal authorized distance ratio
+  matching::MatchesPerDescType & out_matchesPerDesc) // Ouput corresponding index
+{
+  const std::vector<feature::EImageDescriberType> descTypes = getCommonDescTypes(lRegions, rRegions);
+  if(descTypes.empty())
+    return;
+
+  for(const feature::EImageDescriberType descType: descTypes)
+  {
+    GuidedMatching_Grid<ModelArg, ErrorArg, SearchAreaArg>(mod, camL, *lRegions.at(descType), camR, *rRegions.at(descType), errorTh, distRatio, out_matchesPerDesc[descType]);
+  }
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
@@ -0,0 +1,217 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/robustEstimation/guidedMatching.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE guidedMatching
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+// Squared distance of the right point to the epipolar line of the left point
+struct EpipolarLineError
+{
+  static double Error(const Mat3& F, const Vec2& x1, const Vec2& x2)
+  {
+    const Vec3 F_x = F * Vec3(x1(0), x1(1), 1.0);
+    return Square(F_x.dot(Vec3(x2(0), x2(1), 1.0))) / F_x.head<2>().squaredNorm();
+  }
+};
+
+// Squared distance of the right point to the projection of the left point
+struct HomographyTransferError
+{
+  static double Error(const Mat3& H, const Vec2& x1, const Vec2& x2)
+  {
+    const Vec3 x = H * Vec3(x1(0), x1(1), 1.0);
+    return (x2 - x.head<2>() / x(2)).squaredNorm();
+  }
+};
+
+const int imageWidth = 1000;
+const int imageHeight = 800;
+
+// Add a feature with a random descriptor (or a noisy copy of a given descriptor)
+void addFeature(feature::SIFT_Regions& regions, const Vec2& pos, std::mt19937& gen,
+                const feature::SIFT_Regions::DescriptorT* copiedDesc = nullptr)
+{
+  std::uniform_int_distribution<int> valueDistribution(0, 255);
+  std::uniform_int_distribution<int> noiseDistribution(-3, 3);
+
+  feature::SIFT_Regions::DescriptorT desc;
+  for(std::size_t k = 0; k < desc.size(); ++k)
+  {
+    if(copiedDesc)
+      desc[k] = static_cast<unsigned char>(std::max(0, std::min(255, (*copiedDesc)[k] + noiseDistribution(gen))));
+    else
+      desc[k] = static_cast<unsigned char>(valueDistribution(gen));
+  }
+  regions.Features().emplace_back(pos(0), pos(1));
+  regions.Descriptors().push_back(desc);
+}
+
+// Generate the features of two images related by the model:
+// the right feature of each left feature is transferred with the given functor
+template<typename TransferFunctor>
+void generateRegions(std::size_t nbFeatures, const TransferFunctor& transfer, std::mt19937& gen,
+                     feature::SIFT_Regions& lRegions, feature::SIFT_Regions& rRegions)
+{
+  std::uniform_real_distribution<double> xDistribution(0.0, imageWidth);
+  std::uniform_real_distribution<double> yDistribution(0.0, imageHeight);
+  std::normal_distribution<double> noiseDistribution(0.0, 0.5);
+
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    const Vec2 xL(xDistribution(gen), yDistribution(gen));
+    addFeature(lRegions, xL, gen);
+
+    // 20% of the right features are unrelated to the left ones
+    if(i % 5 == 0)
+      addFeature(rRegions, Vec2(xDistribution(gen), yDistribution(gen)), gen);
+    else
+      addFeature(rRegions, transfer(xL) + Vec2(noiseDistribution(gen), noiseDistribution(gen)), gen, &lRegions.Descriptors().back());
+  }
+}
+
+Mat3 skew(const Vec3& v)
+{
+  Mat3 m;
+  m << 0, -v(2), v(1),
+       v(2), 0, -v(0),
+       -v(1), v(0), 0;
+  return m;
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Grid_Fundamental)
+{
+  std::mt19937 gen(0);
+
+  // two cameras looking at a plane at depth 10, F = K^-T [t]x R K^-1
+  Mat3 K;
+  K << 1000, 0, imageWidth / 2,
+       0, 1000, imageHeight / 2,
+       0, 0, 1;
+  const Mat3 R = Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix();
+  const Vec3 t(-1.0, 0.1, 0.2);
+  const Mat3 F = K.inverse().transpose() * skew(t) * R * K.inverse();
+
+  const auto transfer = [&](const Vec2& xL)
+  {
+    const Vec3 X = K.inverse() * Vec3(xL(0), xL(1), 1.0) * 10.0;
+    const Vec3 xR = K * (R * X + t);
+    return Vec2(xR.head<2>() / xR(2));
+  };
+
+  feature::SIFT_Regions lRegions, rRegions;
+  generateRegions(3000, transfer, gen, lRegions, rRegions);
+
+  const double errorTh = Square(4.0);
+  const double distRatio = Square(0.8);
+
+  matching::IndMatches exhaustiveMatches, gridMatches;
+  GuidedMatching<Mat3, EpipolarLineError>(F, nullptr, lRegions, nullptr, rRegions, errorTh, distRatio, exhaustiveMatches);
+  GuidedMatching_Grid<Mat3, EpipolarLineError, EpipolarBandSearchArea>(F, nullptr, lRegions, nullptr, rRegions, errorTh, distRatio, gridMatches);
+
+  BOOST_CHECK(exhaustiveMatches.size() > 2000);
+  BOOST_CHECK(exhaustiveMatches == gridMatches);
+
+  // features only
+  Mat xL(2, lRegions.RegionCount()), xR(2, rRegions.RegionCount());
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+    xL.col(i) = lRegions.GetRegionPosition(i);
+  for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    xR.col(j) = rRegions.GetRegionPosition(j);
+
+  matching::IndMatches exhaustivePosMatches, gridPosMatches;
+  GuidedMatching<Mat3, EpipolarLineError>(F, xL, xR, errorTh, exhaustivePosMatches);
+  GuidedMatching_Grid<Mat3, EpipolarLineError, EpipolarBandSearchArea>(F, xL, xR, errorTh, gridPosMatches);
+
+  BOOST_CHECK(!exhaustivePosMatches.empty());
+  BOOST_CHECK(exhaustivePosMatches == gridPosMatches);
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Grid_Homography)
+{
+  std::mt19937 gen(1);
+
+  Mat3 H;
+  H << 0.9, -0.2, 80.0,
+       0.15, 1.05, -30.0,
+       1e-4, -5e-5, 1.0;
+
+  const auto transfer = [&](const Vec2& xL)
+  {
+    const Vec3 xR = H * Vec3(xL(0), xL(1), 1.0);
+    return Vec2(xR.head<2>() / xR(2));
+  };
+
+  feature::SIFT_Regions lRegions, rRegions;
+  generateRegions(3000, transfer, gen, lRegions, rRegions);
+
+  const double errorTh = Square(4.0);
+  const double distRatio = Square(0.8);
+
+  matching::IndMatches exhaustiveMatches, gridMatches;
+  GuidedMatching<Mat3, HomographyTransferError>(H, nullptr, lRegions, nullptr, rRegions, errorTh, distRatio, exhaustiveMatches);
+  GuidedMatching_Grid<Mat3, HomographyTransferError, HomographyDiskSearchArea>(H, nullptr, lRegions, nullptr, rRegions, errorTh, distRatio, gridMatches);
+
+  // the distance ratio needs a second candidate in the search area
+  BOOST_CHECK(!exhaustiveMatches.empty());
+  BOOST_CHECK(exhaustiveMatches == gridMatches);
+
+  // features only
+  Mat xL(2, lRegions.RegionCount()), xR(2, rRegions.RegionCount());
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+    xL.col(i) = lRegions.GetRegionPosition(i);
+  for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    xR.col(j) = rRegions.GetRegionPosition(j);
+
+  matching::IndMatches exhaustivePosMatches, gridPosMatches;
+  GuidedMatching<Mat3, HomographyTransferError>(H, xL, xR, errorTh, exhaustivePosMatches);
+  GuidedMatching_Grid<Mat3, HomographyTransferError, HomographyDiskSearchArea>(H, xL, xR, errorTh, gridPosMatches);
+
+  BOOST_CHECK(exhaustivePosMatches.size() > 2000);
+  BOOST_CHECK(exhaustivePosMatches == gridPosMatches);
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_PositionsGrid_Band)
+{
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<double> distribution(-50.0, 150.0);
+
+  std::vector<Vec2> positions(5000);
+  for(Vec2& pos : positions)
+    pos = Vec2(distribution(gen), distribution(gen));
+
+  const PositionsGrid grid(positions, 4.0);
+
+  // all the positions close to the line are visited, whatever its direction
+  for(const Vec3& line : {Vec3(0.0, 1.0, -20.0), Vec3(1.0, 0.0, -75.0), Vec3(0.3, -0.7, 10.0), Vec3(-2.0, 0.5, 40.0)})
+  {
+    std::vector<bool> visited(positions.size(), false);
+    auto visit = [&](std::size_t j) { visited[j] = true; };
+    grid.forEachInBand(line, 3.0, visit);
+
+    std::size_t nbClose = 0;
+    for(std::size_t j = 0; j < positions.size(); ++j)
+    {
+      const double dist = std::abs(line.dot(Vec3(positions[j](0), positions[j](1), 1.0))) / line.head<2>().norm();
+      if(dist < 3.0)
+      {
+        ++nbClose;
+        BOOST_CHECK(visited[j]);
+      }
+    }
+    BOOST_CHECK(nbClose > 0);
+    // only a small part of the positions is visited
+    BOOST_CHECK(std::count(visited.begin(), visited.end(), true) < positions.size() / 4);
+  }
+}
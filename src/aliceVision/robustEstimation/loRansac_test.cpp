@@ -19,6 +19,8 @@
 #include <vector>
 #include <string>
 
+#include <boost/filesystem.hpp>
+
 #define BOOST_TEST_MODULE robustEstimationLORansac
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -101,7 +103,8 @@ void lineFittingTest(std::size_t numPoints,
   const std::string base = "testRansac_line_t" + std::to_string(threshold) + "_n" + std::to_string(gaussianNoiseLevel);
   const int W = std::abs(xy(0, 0) - xy(0, numPoints - 1));
   const int H = (int) std::fabs(xy(1, 0) - xy(1, numPoints - 1));
-  drawTest(base + "_LORANSACtrial" + std::to_string(0) + ".svg",
+  // the debug drawing is written in the temporary directory, not in the working directory
+  drawTest((boost::filesystem::temp_directory_path() / (base + "_LORANSACtrial" + std::to_string(0) + ".svg")).string(),
            W, H,
            GTModel,
            estimatedModel,
@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <aliceVision/system/randomSeed.hpp>
+
 #include <set>
 #include <unordered_set>
 #include <algorithm>
 #include <cstdlib>
 #include <random>
 #include <cassert>
+#include <type_traits>
+#include <vector>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -45,8 +49,7 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   static_assert(std::is_integral<IntT>::value, "Only integer types are supported");
 
   
-  std::random_device rd;
-  std::mt19937 generator(rd());
+  std::mt19937 generator(system::getRandomSeed());
 
   if(numSamples * 1.5 > rangeSize)
   {
@@ -136,6 +139,62 @@ inline void UniformSample(std::size_t numSamples,
   UniformSample(0, upperBound, numSamples, samples);
 }
 
+/**
+ * @brief Generate a unique random samples in the range [0 upperBound),
+ * using the given random number generator.
+ *
+ * The samples are written in the given vector (no allocation if its capacity is enough),
+ * it is intended for the small samples of the robust estimators (Robert Floyd's algorithm).
+ *
+ * @param[in] numSamples Number of unique samples to draw.
+ * @param[in] upperBound The value at the end of the range (not included).
+ * @param[in,out] generator The random number generator.
+ * @param[out] samples The vector containing the samples.
+ */
+template<typename IntT, typename RandomGeneratorT>
+inline typename std::enable_if<!std::is_integral<RandomGeneratorT>::value>::type
+UniformSample(std::size_t numSamples,
+              std::size_t upperBound,
+              RandomGeneratorT& generator,
+              std::vector<IntT>& samples)
+{
+  assert(numSamples <= upperBound);
+  static_assert(std::is_integral<IntT>::value, "Only integer types are supported");
+
+  samples.clear();
+  for(std::size_t d = upperBound - numSamples; d < upperBound; ++d)
+  {
+    const IntT t = static_cast<IntT>(std::uniform_int_distribution<std::size_t>(0, d)(generator));
+    if(std::find(samples.begin(), samples.end(), t) == samples.end())
+      samples.push_back(t);
+    else
+      samples.push_back(static_cast<IntT>(d));
+  }
+  assert(samples.size() == numSamples);
+}
+
+/**
+ * @brief Generate a random sequence containing a sampling without replacement of
+ * of the elements of the input vector, using the given random number generator.
+ *
+ * @param[in] sampleSize The size of the sample to generate.
+ * @param[in] elements The possible data indices.
+ * @param[in,out] generator The random number generator.
+ * @param[out] sample The random sample of sizeSample indices.
+ */
+template<typename RandomGeneratorT>
+inline void UniformSample(std::size_t sampleSize,
+                          const std::vector<std::size_t>& elements,
+                          RandomGeneratorT& generator,
+                          std::vector<std::size_t>& sample)
+{
+  UniformSample(sampleSize, elements.size(), generator, sample);
+  for(auto& s : sample)
+  {
+    s = elements[ s ];
+  }
+}
+
 /**
  * @brief Generate a random sequence containing a sampling without replacement of
  * of the elements of the input vector.
@@ -11,6 +11,8 @@
 
 #include <ceres/rotation.h>
 
+#include <exception>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -18,7 +20,7 @@ using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
 /// Create the appropriate cost functor according the provided input camera intrinsic model
-ceres::CostFunction * createCostFunctionFromIntrinsics(IntrinsicBase * intrinsic, const Vec2 & observation)
+ceres::CostFunction * createCostFunctionFromIntrinsics(const IntrinsicBase * intrinsic, const Vec2 & observation)
 {
   switch(intrinsic->getType())
   {
@@ -50,7 +52,7 @@ ceres::CostFunction * createCostFunctionFromIntrinsics(IntrinsicBase * intrinsic
 }
 
 /// Create the appropriate cost functor according the provided input rig camera intrinsic model
-ceres::CostFunction * createRigCostFunctionFromIntrinsics(IntrinsicBase * intrinsic, const Vec2 & observation)
+ceres::CostFunction * createRigCostFunctionFromIntrinsics(const IntrinsicBase * intrinsic, const Vec2 & observation)
 {
   switch(intrinsic->getType())
   {
@@ -81,6 +83,49 @@ ceres::CostFunction * createRigCostFunctionFromIntrinsics(IntrinsicBase * intrin
   }
 }
 
+/// Create the appropriate cost function with analytic derivatives according the provided input camera intrinsic model
+ceres::CostFunction * createAnalyticCostFunctionFromIntrinsics(const IntrinsicBase * intrinsic, const Vec2 & observation)
+{
+  switch(intrinsic->getType())
+  {
+    case PINHOLE_CAMERA:
+      return new ResidualErrorCostFunction<Distortion_None>(observation.data());
+    case PINHOLE_CAMERA_RADIAL1:
+      return new ResidualErrorCostFunction<Distortion_RadialK1>(observation.data());
+    case PINHOLE_CAMERA_RADIAL3:
+      return new ResidualErrorCostFunction<Distortion_RadialK3>(observation.data());
+    case PINHOLE_CAMERA_BROWN:
+      return new ResidualErrorCostFunction<Distortion_BrownT2>(observation.data());
+    case PINHOLE_CAMERA_FISHEYE:
+      return new ResidualErrorCostFunction<Distortion_Fisheye>(observation.data());
+    case PINHOLE_CAMERA_FISHEYE1:
+      return new ResidualErrorCostFunction<Distortion_Fisheye1>(observation.data());
+    default:
+      throw std::logic_error("Unrecognized intrinsic type in BA.");
+  }
+}
+
+/// Create the appropriate cost function with analytic derivatives according the provided input rig camera intrinsic model
+ceres::CostFunction * createAnalyticRigCostFunctionFromIntrinsics(const IntrinsicBase * intrinsic, const Vec2 & observation)
+{
+  switch(intrinsic->getType())
+  {
+    case PINHOLE_CAMERA:
+      return new ResidualErrorRigCostFunction<Distortion_None>(observation.data());
+    case PINHOLE_CAMERA_RADIAL1:
+      return new ResidualErrorRigCostFunction<Distortion_RadialK1>(observation.data());
+    case PINHOLE_CAMERA_RADIAL3:
+      return new ResidualErrorRigCostFunction<Distortion_RadialK3>(observation.data());
+    case PINHOLE_CAMERA_BROWN:
+      return new ResidualErrorRigCostFunction<Distortion_BrownT2>(observation.data());
+    case PINHOLE_CAMERA_FISHEYE:
+      return new ResidualErrorRigCostFunction<Distortion_Fisheye>(observation.data());
+    case PINHOLE_CAMERA_FISHEYE1:
+      return new ResidualErrorRigCostFunction<Distortion_Fisheye1>(observation.data());
+    default:
+      throw std::logic_error("Unrecognized intrinsic type in BA.");
+  }
+}
 
 void addPose(ceres::Problem& problem,
              BA_Refine refineOptions,
@@ -150,7 +195,8 @@ BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultith
     _nbThreads = 1;
 
   _bCeres_Summary = false;
-  
+  _bAnalyticDerivatives = true;
+
   // Use dense BA by default
   setDenseBA();
 }
@@ -365,24 +411,74 @@ void BundleAdjustmentCeres::createProblem(SfMData & sfm_data, BA_Refine refineOp
   ceres::LossFunction * p_LossFunction = new ceres::HuberLoss(Square(4.0));
   // TODO: make the LOSS function and the parameter an option
 
-  // For all visibility add reprojections errors:
+  // Index the observations of the landmarks
+  std::vector<Landmark*> landmarks;
+  std::vector<std::size_t> residualOffsets;
+  landmarks.reserve(sfm_data.structure.size());
+  residualOffsets.reserve(sfm_data.structure.size() + 1);
+  residualOffsets.push_back(0);
   for(auto& landmarkIt: sfm_data.structure)
   {
-    const Observations & observations = landmarkIt.second.observations;
+    landmarks.push_back(&landmarkIt.second);
+    residualOffsets.push_back(residualOffsets.back() + landmarkIt.second.observations.size());
+  }
+
+  // Create the cost functions in parallel.
+  // Each cost function stores the observed image location and compares the reprojection against the observation.
+  std::vector<ceres::CostFunction*> costFunctions(residualOffsets.back(), nullptr);
+  std::exception_ptr costFunctionError;
+
+  #pragma omp parallel for schedule(dynamic) num_threads(_aliceVision_options._nbThreads)
+  for(int i = 0; i < landmarks.size(); ++i)
+  {
+    std::size_t r = residualOffsets[i];
+    for(const auto& observationIt: landmarks[i]->observations)
+    {
+      try
+      {
+        const View * view = sfm_data.views.at(observationIt.first).get();
+        const IntrinsicBase * intrinsic = sfm_data.intrinsics.at(view->getIntrinsicId()).get();
+
+        if(view->isPartOfRig())
+          costFunctions[r] = _aliceVision_options._bAnalyticDerivatives ?
+                createAnalyticRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x) :
+                createRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x);
+        else
+          costFunctions[r] = _aliceVision_options._bAnalyticDerivatives ?
+                createAnalyticCostFunctionFromIntrinsics(intrinsic, observationIt.second.x) :
+                createCostFunctionFromIntrinsics(intrinsic, observationIt.second.x);
+      }
+      catch(...)
+      {
+        #pragma omp critical
+        costFunctionError = std::current_exception();
+      }
+      ++r;
+    }
+  }
+
+  if(costFunctionError)
+  {
+    for(ceres::CostFunction* costFunction: costFunctions)
+      delete costFunction;
+    std::rethrow_exception(costFunctionError);
+  }
+
+  // For all visibility add reprojections errors (ceres::Problem is not thread-safe):
+  for(std::size_t i = 0; i < landmarks.size(); ++i)
+  {
+    Landmark& landmark = *landmarks[i];
+    std::size_t r = residualOffsets[i];
     // Iterate over 2D observation associated to the 3D landmark
-    for (const auto& observationIt: observations)
+    for (const auto& observationIt: landmark.observations)
     {
       // Build the residual block corresponding to the track observation:
       const View * view = sfm_data.views.at(observationIt.first).get();
 
       // Each Residual block takes a point and a camera as input and outputs a 2
-      // dimensional residual. Internally, the cost function stores the observed
-      // image location and compares the reprojection against the observation.
-
+      // dimensional residual.
       if(view->isPartOfRig())
       {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfm_data.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
-
         const Rig& rig = sfm_data.getRig(*view);
         const RigSubPose& rigSubPose = rig.getSubPose(view->getSubPoseId());
         assert(rigSubPose.status != ERigSubPoseStatus::UNINITIALIZED);
@@ -390,28 +486,27 @@ void BundleAdjustmentCeres::createProblem(SfMData & sfm_data, BA_Refine refineOp
         double* subpose_ptr = &map_subposes.at(view->getRigId()).at(view->getSubPoseId())[0];
 
         problem.AddResidualBlock(
-          costFunction,
+          costFunctions[r],
           p_LossFunction,
           &map_intrinsics[view->getIntrinsicId()][0],
           &map_poses[view->getPoseId()][0],
           subpose_ptr, // subpose of the cameras rig
-          landmarkIt.second.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
+          landmark.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
       }
       else
       {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfm_data.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
-
         problem.AddResidualBlock(
-          costFunction,
+          costFunctions[r],
           p_LossFunction,
           &map_intrinsics[view->getIntrinsicId()][0],
           &map_poses[view->getPoseId()][0],
-          landmarkIt.second.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
+          landmark.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
       }
+      ++r;
     }
-    parameterBlocks.push_back(landmarkIt.second.X.data());
+    parameterBlocks.push_back(landmark.X.data());
     if (!(refineOptions & BA_REFINE_STRUCTURE))
-      problem.SetParameterBlockConstant(landmarkIt.second.X.data());
+      problem.SetParameterBlockConstant(landmark.X.data());
   }
 }
 
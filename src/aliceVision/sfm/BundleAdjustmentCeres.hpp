@@ -10,14 +10,19 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <ceres/ceres.h>
 
 namespace aliceVision {
 namespace sfm {
 
 /// Create the appropriate cost functor according the provided input camera intrinsic model
-ceres::CostFunction * createCostFunctionFromIntrinsics(camera::IntrinsicBase * intrinsic, const Vec2 & observation);
-ceres::CostFunction * createRigCostFunctionFromIntrinsics(camera::IntrinsicBase * intrinsic, const Vec2 & observation);
+ceres::CostFunction * createCostFunctionFromIntrinsics(const camera::IntrinsicBase * intrinsic, const Vec2 & observation);
+ceres::CostFunction * createRigCostFunctionFromIntrinsics(const camera::IntrinsicBase * intrinsic, const Vec2 & observation);
+
+/// Create the appropriate cost function with analytic derivatives according the provided input camera intrinsic model
+ceres::CostFunction * createAnalyticCostFunctionFromIntrinsics(const camera::IntrinsicBase * intrinsic, const Vec2 & observation);
+ceres::CostFunction * createAnalyticRigCostFunctionFromIntrinsics(const camera::IntrinsicBase * intrinsic, const Vec2 & observation);
 
 class BundleAdjustmentCeres : public BundleAdjustment
 {
@@ -30,6 +35,8 @@ public:
     ceres::LinearSolverType _linear_solver_type;
     ceres::PreconditionerType _preconditioner_type;
     ceres::SparseLinearAlgebraLibraryType _sparse_linear_algebra_library_type;
+    /// use the cost functions with analytic derivatives (false: automatic differentiation, for validation)
+    bool _bAnalyticDerivatives;
 
     BA_options(const bool bVerbose = true, bool bmultithreaded = true);
     void setDenseBA();
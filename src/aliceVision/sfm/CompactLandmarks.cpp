@@ -0,0 +1,407 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompactLandmarks.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+const uint32_t compactLandmarksVersion = 1;
+
+template<typename T>
+void writeVector(std::ostream& stream, const std::vector<T>& v)
+{
+  const uint64_t size = v.size();
+  stream.write((const char*) &size, sizeof(uint64_t));
+  stream.write((const char*) v.data(), size * sizeof(T));
+}
+
+/// Number of bytes between the current position and the end of the stream
+uint64_t remainingBytes(std::istream& stream)
+{
+  const std::streampos pos = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  const std::streampos end = stream.tellg();
+  stream.seekg(pos);
+  if(pos < 0 || end < pos)
+    return 0;
+  return static_cast<uint64_t>(end - pos);
+}
+
+template<typename T>
+void readVector(std::istream& stream, std::vector<T>& v)
+{
+  uint64_t size = 0;
+  stream.read((char*) &size, sizeof(uint64_t));
+  if(!stream)
+    return;
+  // a corrupted size would allocate more than the file holds
+  if(size > remainingBytes(stream) / sizeof(T))
+  {
+    stream.setstate(std::ios::failbit);
+    return;
+  }
+  v.resize(size);
+  stream.read((char*) v.data(), size * sizeof(T));
+}
+
+} // namespace
+
+CompactLandmarks::~CompactLandmarks()
+{
+  removeSpillFiles();
+}
+
+CompactLandmarks& CompactLandmarks::operator=(CompactLandmarks&& other)
+{
+  if(this == &other)
+    return *this;
+
+  removeSpillFiles();
+
+  swapLandmarks(other);
+  other.clear();
+  _spillFiles.swap(other._spillFiles);
+  other._spillFiles.clear();
+  _nbSpilled = other._nbSpilled;
+  other._nbSpilled = 0;
+  return *this;
+}
+
+void CompactLandmarks::build(const Landmarks& landmarks)
+{
+  clear();
+
+  // HashMap is not sorted
+  std::vector<Landmarks::const_iterator> sortedLandmarks;
+  sortedLandmarks.reserve(landmarks.size());
+  std::size_t nbObservations = 0;
+  for(auto it = landmarks.begin(); it != landmarks.end(); ++it)
+  {
+    sortedLandmarks.push_back(it);
+    nbObservations += it->second.observations.size();
+  }
+  std::sort(sortedLandmarks.begin(), sortedLandmarks.end(),
+            [](const Landmarks::const_iterator& a, const Landmarks::const_iterator& b) { return a->first < b->first; });
+
+  reserve(sortedLandmarks.size(), nbObservations);
+
+  for(const auto& it : sortedLandmarks)
+  {
+    const Landmark& landmark = it->second;
+    _landmarkIds.push_back(it->first);
+    _x.push_back(static_cast<float>(landmark.X(0)));
+    _y.push_back(static_cast<float>(landmark.X(1)));
+    _z.push_back(static_cast<float>(landmark.X(2)));
+    _descTypes.push_back(landmark.descType);
+    _colors.push_back(landmark.rgb);
+
+    // Observations is a flat_map sorted by view id
+    for(const auto& observation : landmark.observations)
+    {
+      _obsViewIds.push_back(observation.first);
+      _obsFeatIds.push_back(observation.second.id_feat);
+      _obsX.push_back(static_cast<float>(observation.second.x(0)));
+      _obsY.push_back(static_cast<float>(observation.second.x(1)));
+    }
+    _obsOffsets.push_back(_obsViewIds.size());
+  }
+}
+
+void CompactLandmarks::exportToSTL(Landmarks& landmarks) const
+{
+  landmarks.clear();
+  for(IndexT l = 0; l < nbLandmarks(); ++l)
+    landmarks.emplace_hint(landmarks.end(), _landmarkIds[l], landmark(l));
+}
+
+void CompactLandmarks::insert(const Landmarks& landmarks)
+{
+  if(landmarks.empty())
+    return;
+  merge(CompactLandmarks(landmarks));
+}
+
+void CompactLandmarks::clear()
+{
+  _landmarkIds.clear();
+  _x.clear();
+  _y.clear();
+  _z.clear();
+  _descTypes.clear();
+  _colors.clear();
+  _obsOffsets.assign(1, 0);
+  _obsViewIds.clear();
+  _obsFeatIds.clear();
+  _obsX.clear();
+  _obsY.clear();
+}
+
+IndexT CompactLandmarks::landmarkIndex(IndexT landmarkId) const
+{
+  const auto it = std::lower_bound(_landmarkIds.begin(), _landmarkIds.end(), landmarkId);
+  if(it == _landmarkIds.end() || *it != landmarkId)
+    return UndefinedIndexT;
+  return static_cast<IndexT>(it - _landmarkIds.begin());
+}
+
+void CompactLandmarks::setPosition(IndexT index, const Vec3& X)
+{
+  _x[index] = static_cast<float>(X(0));
+  _y[index] = static_cast<float>(X(1));
+  _z[index] = static_cast<float>(X(2));
+}
+
+Landmark CompactLandmarks::landmark(IndexT index) const
+{
+  Landmark landmark(position(index), _descTypes[index], Observations(), _colors[index]);
+  landmark.observations.reserve(observationsEnd(index) - observationsBegin(index));
+  for(std::size_t i = observationsBegin(index); i < observationsEnd(index); ++i)
+    landmark.observations.emplace_hint(landmark.observations.end(), _obsViewIds[i], Observation(observationPosition(i), _obsFeatIds[i]));
+  return landmark;
+}
+
+bool CompactLandmarks::save(const std::string& filename) const
+{
+  std::ofstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Unable to write the landmarks file: " << filename);
+    return false;
+  }
+
+  stream.write((const char*) &compactLandmarksVersion, sizeof(uint32_t));
+  writeVector(stream, _landmarkIds);
+  writeVector(stream, _x);
+  writeVector(stream, _y);
+  writeVector(stream, _z);
+  writeVector(stream, _descTypes);
+  writeVector(stream, _colors);
+  writeVector(stream, _obsOffsets);
+  writeVector(stream, _obsViewIds);
+  writeVector(stream, _obsFeatIds);
+  writeVector(stream, _obsX);
+  writeVector(stream, _obsY);
+
+  if(!stream.good())
+  {
+    ALICEVISION_LOG_ERROR("Failed to write the landmarks file: " << filename);
+    return false;
+  }
+  return true;
+}
+
+bool CompactLandmarks::load(const std::string& filename)
+{
+  clear();
+
+  std::ifstream stream(filename, std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Unable to read the landmarks file: " << filename);
+    return false;
+  }
+
+  uint32_t version = 0;
+  stream.read((char*) &version, sizeof(uint32_t));
+  if(!stream || version != compactLandmarksVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported landmarks file: " << filename);
+    return false;
+  }
+
+  readVector(stream, _landmarkIds);
+  readVector(stream, _x);
+  readVector(stream, _y);
+  readVector(stream, _z);
+  readVector(stream, _descTypes);
+  readVector(stream, _colors);
+  readVector(stream, _obsOffsets);
+  readVector(stream, _obsViewIds);
+  readVector(stream, _obsFeatIds);
+  readVector(stream, _obsX);
+  readVector(stream, _obsY);
+
+  const std::size_t nbLandmarks = _landmarkIds.size();
+  const std::size_t nbObservations = _obsViewIds.size();
+  if(!stream ||
+     _x.size() != nbLandmarks || _y.size() != nbLandmarks || _z.size() != nbLandmarks ||
+     _descTypes.size() != nbLandmarks || _colors.size() != nbLandmarks ||
+     _obsOffsets.size() != nbLandmarks + 1 ||
+     _obsOffsets.back() != nbObservations ||
+     _obsFeatIds.size() != nbObservations || _obsX.size() != nbObservations || _obsY.size() != nbObservations)
+  {
+    ALICEVISION_LOG_ERROR("Failed to read the landmarks file: " << filename);
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool CompactLandmarks::spill(const std::string& folder, const std::set<IndexT>& activeViews)
+{
+  CompactLandmarks active;
+  CompactLandmarks inactive;
+
+  for(IndexT l = 0; l < nbLandmarks(); ++l)
+  {
+    bool isActive = false;
+    for(const IndexT viewId : observationViews(l))
+    {
+      if(activeViews.count(viewId))
+      {
+        isActive = true;
+        break;
+      }
+    }
+    (isActive ? active : inactive).append(*this, l);
+  }
+
+  if(inactive.empty())
+    return true;
+
+  // a new file for each spill: never overwrite the landmarks of a previous spill
+  std::string filename;
+  do
+  {
+    filename = (boost::filesystem::path(folder) / boost::filesystem::unique_path("landmarks_%%%%%%%%%%%%.bin")).string();
+  }
+  while(boost::filesystem::exists(filename) || std::find(_spillFiles.begin(), _spillFiles.end(), filename) != _spillFiles.end());
+
+  if(!inactive.save(filename))
+    return false;
+
+  _spillFiles.push_back(filename);
+  _nbSpilled += inactive.nbLandmarks();
+
+  // release the memory of the spilled landmarks
+  swapLandmarks(active);
+
+  ALICEVISION_LOG_DEBUG("Spilled " << inactive.nbLandmarks() << " landmarks to " << filename << ", " << nbLandmarks() << " landmarks in memory.");
+  return true;
+}
+
+bool CompactLandmarks::restore()
+{
+  // files which can't be read are kept
+  std::vector<std::string> failedFiles;
+
+  for(const std::string& filename : _spillFiles)
+  {
+    CompactLandmarks spilled;
+    if(!spilled.load(filename))
+    {
+      failedFiles.push_back(filename);
+      continue;
+    }
+    boost::filesystem::remove(filename);
+
+    merge(spilled);
+    _nbSpilled -= spilled.nbLandmarks();
+  }
+  _spillFiles.swap(failedFiles);
+  return _spillFiles.empty();
+}
+
+void CompactLandmarks::append(const CompactLandmarks& other, IndexT index)
+{
+  assert(_landmarkIds.empty() || _landmarkIds.back() < other._landmarkIds[index]);
+
+  _landmarkIds.push_back(other._landmarkIds[index]);
+  _x.push_back(other._x[index]);
+  _y.push_back(other._y[index]);
+  _z.push_back(other._z[index]);
+  _descTypes.push_back(other._descTypes[index]);
+  _colors.push_back(other._colors[index]);
+
+  const std::size_t begin = other._obsOffsets[index];
+  const std::size_t end = other._obsOffsets[index + 1];
+  _obsViewIds.insert(_obsViewIds.end(), other._obsViewIds.begin() + begin, other._obsViewIds.begin() + end);
+  _obsFeatIds.insert(_obsFeatIds.end(), other._obsFeatIds.begin() + begin, other._obsFeatIds.begin() + end);
+  _obsX.insert(_obsX.end(), other._obsX.begin() + begin, other._obsX.begin() + end);
+  _obsY.insert(_obsY.end(), other._obsY.begin() + begin, other._obsY.begin() + end);
+  _obsOffsets.push_back(_obsViewIds.size());
+}
+
+void CompactLandmarks::merge(const CompactLandmarks& other)
+{
+  // merge the two sorted storages
+  CompactLandmarks merged;
+  merged.reserve(nbLandmarks() + other.nbLandmarks(), nbObservations() + other.nbObservations());
+  IndexT i = 0;
+  IndexT j = 0;
+  while(i < nbLandmarks() || j < other.nbLandmarks())
+  {
+    if(j == other.nbLandmarks() || (i < nbLandmarks() && _landmarkIds[i] < other._landmarkIds[j]))
+      merged.append(*this, i++);
+    else
+      merged.append(other, j++);
+  }
+  swapLandmarks(merged);
+}
+
+void CompactLandmarks::removeSpillFiles()
+{
+  for(const std::string& filename : _spillFiles)
+    boost::filesystem::remove(filename);
+  _spillFiles.clear();
+  _nbSpilled = 0;
+}
+
+void CompactLandmarks::swapLandmarks(CompactLandmarks& other)
+{
+  _landmarkIds.swap(other._landmarkIds);
+  _x.swap(other._x);
+  _y.swap(other._y);
+  _z.swap(other._z);
+  _descTypes.swap(other._descTypes);
+  _colors.swap(other._colors);
+  _obsOffsets.swap(other._obsOffsets);
+  _obsViewIds.swap(other._obsViewIds);
+  _obsFeatIds.swap(other._obsFeatIds);
+  _obsX.swap(other._obsX);
+  _obsY.swap(other._obsY);
+}
+
+void CompactLandmarks::reserve(std::size_t nbLandmarks, std::size_t nbObservations)
+{
+  _landmarkIds.reserve(nbLandmarks);
+  _x.reserve(nbLandmarks);
+  _y.reserve(nbLandmarks);
+  _z.reserve(nbLandmarks);
+  _descTypes.reserve(nbLandmarks);
+  _colors.reserve(nbLandmarks);
+  _obsOffsets.reserve(nbLandmarks + 1);
+  _obsViewIds.reserve(nbObservations);
+  _obsFeatIds.reserve(nbObservations);
+  _obsX.reserve(nbObservations);
+  _obsY.reserve(nbObservations);
+}
+
+void compactStructure(SfMData& sfmData, CompactLandmarks& landmarks)
+{
+  landmarks.build(sfmData.structure);
+  Landmarks().swap(sfmData.structure);
+}
+
+void expandStructure(const CompactLandmarks& landmarks, SfMData& sfmData)
+{
+  landmarks.exportToSTL(sfmData.structure);
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,214 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/types.hpp>
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Compact landmarks storage with contiguous arrays.
+ *
+ * Landmarks are sorted by landmark id and addressed by their index in [0, nbLandmarks()).
+ * Positions are stored as float in one array per coordinate (SoA), colors and describer
+ * types in separate arrays.
+ * The observations of the landmark at index l are at [observationsBegin(l), observationsEnd(l))
+ * in the view ids, feature ids and float positions arrays, sorted by view id (CSR layout).
+ *
+ * The landmarks which are not observed by a set of active views can be spilled to a
+ * file with spill() and read back with restore(), to bound the memory of large scenes.
+ * The sequential SfM uses it to hold the landmarks that the next resections can't change
+ * (see ReconstructionEngine_sequentialSfM::setCompactInactiveLandmarks).
+ *
+ * The STL Landmarks remain available through build(), exportToSTL() and landmark().
+ */
+class CompactLandmarks
+{
+public:
+  /// Read-only range on a contiguous array
+  template<typename T>
+  struct Range
+  {
+    const T* first;
+    const T* last;
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const T& operator[](std::size_t i) const { return first[i]; }
+  };
+
+  CompactLandmarks()
+    : _obsOffsets(1, 0)
+  {}
+
+  explicit CompactLandmarks(const Landmarks& landmarks)
+  {
+    build(landmarks);
+  }
+
+  ~CompactLandmarks();
+
+  // the spill files are owned by the storage
+  CompactLandmarks(const CompactLandmarks&) = delete;
+  CompactLandmarks& operator=(const CompactLandmarks&) = delete;
+
+  CompactLandmarks(CompactLandmarks&& other)
+    : CompactLandmarks()
+  {
+    *this = std::move(other);
+  }
+
+  /// The spill files of this storage are removed, then the ones of the other storage are taken over
+  CompactLandmarks& operator=(CompactLandmarks&& other);
+
+  /**
+   * @brief Build the storage from STL landmarks
+   * @param[in] landmarks
+   */
+  void build(const Landmarks& landmarks);
+
+  /**
+   * @brief Export the landmarks in memory as STL landmarks (the spilled landmarks are not exported)
+   * @param[out] landmarks
+   */
+  void exportToSTL(Landmarks& landmarks) const;
+
+  /**
+   * @brief Add STL landmarks to the landmarks in memory
+   * @param[in] landmarks landmarks whose ids are not in the storage (neither in memory nor spilled)
+   */
+  void insert(const Landmarks& landmarks);
+
+  void clear();
+
+  std::size_t nbLandmarks() const { return _landmarkIds.size(); }
+  std::size_t nbObservations() const { return _obsViewIds.size(); }
+  bool empty() const { return _landmarkIds.empty(); }
+
+  /// @return the index of the landmark with the given id or UndefinedIndexT
+  IndexT landmarkIndex(IndexT landmarkId) const;
+
+  IndexT landmarkId(IndexT index) const { return _landmarkIds[index]; }
+  feature::EImageDescriberType descType(IndexT index) const { return _descTypes[index]; }
+  const image::RGBColor& color(IndexT index) const { return _colors[index]; }
+
+  Vec3 position(IndexT index) const { return Vec3(_x[index], _y[index], _z[index]); }
+  void setPosition(IndexT index, const Vec3& X);
+
+  std::size_t observationsBegin(IndexT index) const { return _obsOffsets[index]; }
+  std::size_t observationsEnd(IndexT index) const { return _obsOffsets[index + 1]; }
+
+  /// @return the view ids of the observations of a landmark (sorted)
+  Range<IndexT> observationViews(IndexT index) const
+  {
+    return {_obsViewIds.data() + _obsOffsets[index], _obsViewIds.data() + _obsOffsets[index + 1]};
+  }
+
+  /// @return the feature ids of the observations of a landmark (in the order of observationViews)
+  Range<IndexT> observationFeatures(IndexT index) const
+  {
+    return {_obsFeatIds.data() + _obsOffsets[index], _obsFeatIds.data() + _obsOffsets[index + 1]};
+  }
+
+  /// @return the 2D position of an observation, in [observationsBegin(l), observationsEnd(l))
+  Vec2 observationPosition(std::size_t observation) const { return Vec2(_obsX[observation], _obsY[observation]); }
+
+  /// @return the landmark at the given index as a STL Landmark
+  Landmark landmark(IndexT index) const;
+
+  /**
+   * @brief Write the landmarks in memory in a binary file
+   * @param[in] filename
+   * @return true if the file has been written
+   */
+  bool save(const std::string& filename) const;
+
+  /**
+   * @brief Replace the landmarks in memory by the ones of a binary file written by save()
+   * @param[in] filename
+   * @return true if the file has been read
+   */
+  bool load(const std::string& filename);
+
+  /**
+   * @brief Move the landmarks without observation in the active views to a new file
+   * @param[in] folder folder of the spill file, whose unique name is generated (the file is removed by restore())
+   * @param[in] activeViews views whose landmarks are kept in memory
+   * @return true if the landmarks have been spilled
+   */
+  bool spill(const std::string& folder, const std::set<IndexT>& activeViews);
+
+  /**
+   * @brief Read back all the spilled landmarks
+   * @return true if all the spill files have been read
+   */
+  bool restore();
+
+  /// @return the number of landmarks spilled to disk
+  std::size_t nbSpilled() const { return _nbSpilled; }
+
+private:
+  /// Append a landmark of another storage (ids must be appended in increasing order)
+  void append(const CompactLandmarks& other, IndexT index);
+
+  /// Merge the landmarks of another storage (with other ids) with the landmarks in memory
+  void merge(const CompactLandmarks& other);
+
+  /// Remove the spill files
+  void removeSpillFiles();
+
+  /// Swap the landmarks and observations (not the spill files) with another storage
+  void swapLandmarks(CompactLandmarks& other);
+
+  /// Reserve the memory for the given number of landmarks and observations
+  void reserve(std::size_t nbLandmarks, std::size_t nbObservations);
+
+  // landmarks
+  std::vector<IndexT> _landmarkIds;
+  std::vector<float> _x;
+  std::vector<float> _y;
+  std::vector<float> _z;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  std::vector<image::RGBColor> _colors;
+
+  // observations
+  std::vector<std::size_t> _obsOffsets;
+  std::vector<IndexT> _obsViewIds;
+  std::vector<IndexT> _obsFeatIds;
+  std::vector<float> _obsX;
+  std::vector<float> _obsY;
+
+  // spilled landmarks
+  std::vector<std::string> _spillFiles;
+  std::size_t _nbSpilled = 0;
+};
+
+/**
+ * @brief Move the structure of a SfMData into a compact storage, the SfMData structure is released.
+ * @param[in,out] sfmData
+ * @param[out] landmarks
+ */
+void compactStructure(SfMData& sfmData, CompactLandmarks& landmarks);
+
+/**
+ * @brief Set the structure of a SfMData from a compact storage (restore the spilled landmarks first).
+ * @param[in] landmarks
+ * @param[in,out] sfmData
+ */
+void expandStructure(const CompactLandmarks& landmarks, SfMData& sfmData);
+
+} // namespace sfm
+} // namespace aliceVision
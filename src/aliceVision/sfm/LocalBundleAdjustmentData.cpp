@@ -208,7 +208,7 @@ void LocalBundleAdjustmentData::resetParametersCounter()
 
 void LocalBundleAdjustmentData::updateGraphWithNewViews(
     const SfMData& sfm_data, 
-    const track::TracksPerView& map_tracksPerView,
+    const track::CompactTracks& tracks,
     const std::set<IndexT>& newReconstructedViews,
     const std::size_t kMinNbOfMatches)
 {
@@ -276,7 +276,7 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
   if (!addedViewsId.empty())
   {
     // Count the nb of common landmarks between the new views and the all the reconstructed views of the scene
-    std::map<Pair, std::size_t> nbSharedLandmarksPerImagesPair = countSharedLandmarksPerImagesPair(sfm_data, map_tracksPerView, addedViewsId);
+    std::map<Pair, std::size_t> nbSharedLandmarksPerImagesPair = countSharedLandmarksPerImagesPair(sfm_data, tracks, addedViewsId);
     
     for(const auto& x: nbSharedLandmarksPerImagesPair)
     {
@@ -436,30 +436,26 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_
 
 std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerImagesPair(
     const SfMData& sfm_data,
-    const track::TracksPerView& map_tracksPerView,
+    const track::CompactTracks& tracks,
     const std::set<IndexT>& newViewsId)
 {
   std::map<Pair, std::size_t> map_imagesPair_nbSharedLandmarks;
   
-  // Get landmarks id. of all the reconstructed 3D points (: landmarks)
-  // TODO: avoid copy and use boost::transform_iterator
-  std::set<IndexT> landmarkIds;
-  std::transform(sfm_data.getLandmarks().begin(), sfm_data.getLandmarks().end(),
-                 std::inserter(landmarkIds, landmarkIds.begin()),
-                 stl::RetrieveKey());
-  
   for(const auto& viewId: newViewsId)
   {
     // Get all the tracks of the new added view
-    const aliceVision::track::TrackIdSet& newView_trackIds = map_tracksPerView.at(viewId);
+    const track::CompactTracks::Range<IndexT> newView_trackIndexes = tracks.tracksInView(viewId);
     
     // Keep the reconstructed tracks (with an associated landmark)
     std::vector<IndexT> newView_landmarks; // all landmarks (already reconstructed) visible from the new view
     
-    newView_landmarks.reserve(newView_trackIds.size());
-    std::set_intersection(newView_trackIds.begin(), newView_trackIds.end(),
-                          landmarkIds.begin(), landmarkIds.end(),
-                          std::back_inserter(newView_landmarks));
+    newView_landmarks.reserve(newView_trackIndexes.size());
+    for(const IndexT trackIndex: newView_trackIndexes)
+    {
+      const IndexT trackId = static_cast<IndexT>(tracks.trackId(trackIndex));
+      if(sfm_data.getLandmarks().count(trackId))
+        newView_landmarks.push_back(trackId);
+    }
     
     // Retrieve the common track Ids
     for(const auto& landmarkId: newView_landmarks)
@@ -8,6 +8,7 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/track/Track.hpp>
+#include <aliceVision/track/CompactTracks.hpp>
 #include <aliceVision/sfm/SfMData.hpp>
 
 namespace aliceVision {
@@ -98,11 +99,11 @@ public:
   
   /// @brief Complete the graph with the newly resected views or all the posed views if the graph is empty.
   /// @param[in] sfm_data 
-  /// @param[in] map_tracksPerView A map giving the tracks for each view
+  /// @param[in] tracks The tracks, with the tracks per view reverse index
   /// @param[in] newReconstructedViews The list of the newly resected views
   /// @param[in] kMinNbOfMatches The min. number of shared matches to create an edge between two views (nodes)
   void updateGraphWithNewViews(const SfMData& sfm_data, 
-      const track::TracksPerView& map_tracksPerView, 
+      const track::CompactTracks& tracks, 
       const std::set<IndexT> &newReconstructedViews, 
       const std::size_t kMinNbOfMatches = 50);
   
@@ -185,12 +186,12 @@ private:
   
   /// @brief Count the number of shared landmarks between all the new views and each already resected cameras.
   /// @param[in] sfm_data
-  /// @param[in] map_tracksPerView
+  /// @param[in] tracks
   /// @param[in] newViewsId A set with the views index that we want to count matches with resected cameras. 
   /// @return A map giving the number of matches for each images pair.
   static std::map<Pair, std::size_t> countSharedLandmarksPerImagesPair(
       const SfMData& sfm_data,
-      const track::TracksPerView& map_tracksPerView,
+      const track::CompactTracks& tracks,
       const std::set<IndexT>& newViewsId);
   
   /// @brief Return the state of the focal length (constant or not) for a specific intrinsic.
@@ -0,0 +1,410 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/numeric/numeric.hpp"
+#include "ceres/ceres.h"
+#include "ceres/rotation.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+// Define ceres cost functions with analytic derivatives for each AliceVision camera model.
+// They have the same parameter blocks and residuals as the ResidualErrorFunctor_* (autodiff).
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Distortion models used by the analytic cost functions.
+ *
+ * distort() computes (x_d, y_d) = disto(x_u, y_u) and its derivatives:
+ * - d_du: 2x2 (row major) w.r.t. the undistorted point,
+ * - d_ddisto: 2 x nbParams (row major) w.r.t. the distortion parameters.
+ */
+struct Distortion_None
+{
+  static const int nbParams = 0;
+
+  static void distort(const double* /*disto*/, double x_u, double y_u, double* d, double* d_du, double* /*d_ddisto*/)
+  {
+    d[0] = x_u;
+    d[1] = y_u;
+    d_du[0] = 1.0; d_du[1] = 0.0;
+    d_du[2] = 0.0; d_du[3] = 1.0;
+  }
+};
+
+/// Radial distortion with 1 parameter [K1]
+struct Distortion_RadialK1
+{
+  static const int nbParams = 1;
+
+  static void distort(const double* disto, double x_u, double y_u, double* d, double* d_du, double* d_ddisto)
+  {
+    const double k1 = disto[0];
+    const double r2 = x_u * x_u + y_u * y_u;
+    const double r_coeff = 1.0 + k1 * r2;
+
+    d[0] = x_u * r_coeff;
+    d[1] = y_u * r_coeff;
+
+    // d(r_coeff)/d(r2)
+    const double dcoeff = k1;
+    d_du[0] = r_coeff + 2.0 * x_u * x_u * dcoeff; d_du[1] = 2.0 * x_u * y_u * dcoeff;
+    d_du[2] = 2.0 * x_u * y_u * dcoeff;           d_du[3] = r_coeff + 2.0 * y_u * y_u * dcoeff;
+
+    d_ddisto[0] = x_u * r2;
+    d_ddisto[1] = y_u * r2;
+  }
+};
+
+/// Radial distortion with 3 parameters [K1, K2, K3]
+struct Distortion_RadialK3
+{
+  static const int nbParams = 3;
+
+  static void distort(const double* disto, double x_u, double y_u, double* d, double* d_du, double* d_ddisto)
+  {
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+    const double r2 = x_u * x_u + y_u * y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+
+    d[0] = x_u * r_coeff;
+    d[1] = y_u * r_coeff;
+
+    // d(r_coeff)/d(r2)
+    const double dcoeff = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+    d_du[0] = r_coeff + 2.0 * x_u * x_u * dcoeff; d_du[1] = 2.0 * x_u * y_u * dcoeff;
+    d_du[2] = 2.0 * x_u * y_u * dcoeff;           d_du[3] = r_coeff + 2.0 * y_u * y_u * dcoeff;
+
+    d_ddisto[0] = x_u * r2; d_ddisto[1] = x_u * r4; d_ddisto[2] = x_u * r6;
+    d_ddisto[3] = y_u * r2; d_ddisto[4] = y_u * r4; d_ddisto[5] = y_u * r6;
+  }
+};
+
+/// Brown distortion [K1, K2, K3, T1, T2]
+struct Distortion_BrownT2
+{
+  static const int nbParams = 5;
+
+  static void distort(const double* disto, double x_u, double y_u, double* d, double* d_du, double* d_ddisto)
+  {
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+    const double t1 = disto[3];
+    const double t2 = disto[4];
+    const double r2 = x_u * x_u + y_u * y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double t_x = t2 * (r2 + 2.0 * x_u * x_u) + 2.0 * t1 * x_u * y_u;
+    const double t_y = t1 * (r2 + 2.0 * y_u * y_u) + 2.0 * t2 * x_u * y_u;
+
+    d[0] = x_u * r_coeff + t_x;
+    d[1] = y_u * r_coeff + t_y;
+
+    // d(r_coeff)/d(r2)
+    const double dcoeff = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+    d_du[0] = r_coeff + 2.0 * x_u * x_u * dcoeff + 6.0 * t2 * x_u + 2.0 * t1 * y_u;
+    d_du[1] = 2.0 * x_u * y_u * dcoeff + 2.0 * t2 * y_u + 2.0 * t1 * x_u;
+    d_du[2] = 2.0 * x_u * y_u * dcoeff + 2.0 * t1 * x_u + 2.0 * t2 * y_u;
+    d_du[3] = r_coeff + 2.0 * y_u * y_u * dcoeff + 6.0 * t1 * y_u + 2.0 * t2 * x_u;
+
+    d_ddisto[0] = x_u * r2; d_ddisto[1] = x_u * r4; d_ddisto[2] = x_u * r6;
+    d_ddisto[3] = 2.0 * x_u * y_u;
+    d_ddisto[4] = r2 + 2.0 * x_u * x_u;
+    d_ddisto[5] = y_u * r2; d_ddisto[6] = y_u * r4; d_ddisto[7] = y_u * r6;
+    d_ddisto[8] = r2 + 2.0 * y_u * y_u;
+    d_ddisto[9] = 2.0 * x_u * y_u;
+  }
+};
+
+/// Fisheye distortion [K1, K2, K3, K4]
+struct Distortion_Fisheye
+{
+  static const int nbParams = 4;
+
+  static void distort(const double* disto, double x_u, double y_u, double* d, double* d_du, double* d_ddisto)
+  {
+    const double r2 = x_u * x_u + y_u * y_u;
+    const double r = std::sqrt(r2);
+
+    if(r <= 1e-8)
+    {
+      // same as the autodiff functor: no distortion around the center
+      d[0] = x_u;
+      d[1] = y_u;
+      d_du[0] = 1.0; d_du[1] = 0.0;
+      d_du[2] = 0.0; d_du[3] = 1.0;
+      for(int i = 0; i < 2 * nbParams; ++i)
+        d_ddisto[i] = 0.0;
+      return;
+    }
+
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+    const double k4 = disto[3];
+    const double theta = std::atan(r);
+    const double theta2 = theta * theta;
+    const double theta3 = theta2 * theta;
+    const double theta5 = theta3 * theta2;
+    const double theta7 = theta5 * theta2;
+    const double theta9 = theta7 * theta2;
+    const double theta_dist = theta + k1 * theta3 + k2 * theta5 + k3 * theta7 + k4 * theta9;
+    const double cdist = theta_dist / r;
+
+    d[0] = x_u * cdist;
+    d[1] = y_u * cdist;
+
+    const double dtheta_dist = 1.0 + 3.0 * k1 * theta2 + 5.0 * k2 * theta2 * theta2 +
+                               7.0 * k3 * theta3 * theta3 + 9.0 * k4 * theta7 * theta;
+    const double dtheta = 1.0 / (1.0 + r2);
+    // d(cdist)/dr / r
+    const double dcdist = (dtheta_dist * dtheta - cdist) / r2;
+    d_du[0] = cdist + x_u * x_u * dcdist; d_du[1] = x_u * y_u * dcdist;
+    d_du[2] = x_u * y_u * dcdist;         d_du[3] = cdist + y_u * y_u * dcdist;
+
+    d_ddisto[0] = x_u * theta3 / r; d_ddisto[1] = x_u * theta5 / r; d_ddisto[2] = x_u * theta7 / r; d_ddisto[3] = x_u * theta9 / r;
+    d_ddisto[4] = y_u * theta3 / r; d_ddisto[5] = y_u * theta5 / r; d_ddisto[6] = y_u * theta7 / r; d_ddisto[7] = y_u * theta9 / r;
+  }
+};
+
+/// Fisheye distortion with 1 parameter [K1]
+struct Distortion_Fisheye1
+{
+  static const int nbParams = 1;
+
+  static void distort(const double* disto, double x_u, double y_u, double* d, double* d_du, double* d_ddisto)
+  {
+    const double k1 = disto[0];
+    const double r2 = x_u * x_u + y_u * y_u;
+    const double r = std::sqrt(r2);
+    const double s = std::tan(0.5 * k1);
+    const double u = 2.0 * r * s;
+    const double a = std::atan(u);
+    const double r_coeff = a / (k1 * r);
+
+    d[0] = x_u * r_coeff;
+    d[1] = y_u * r_coeff;
+
+    // d(r_coeff)/dr / r
+    const double dcoeff = (2.0 * s / (1.0 + u * u) / k1 - a / k1 / r) / r2;
+    d_du[0] = r_coeff + x_u * x_u * dcoeff; d_du[1] = x_u * y_u * dcoeff;
+    d_du[2] = x_u * y_u * dcoeff;           d_du[3] = r_coeff + y_u * y_u * dcoeff;
+
+    const double dcoeff_dk1 = (1.0 + s * s) / (1.0 + u * u) / k1 - r_coeff / k1;
+    d_ddisto[0] = x_u * dcoeff_dk1;
+    d_ddisto[1] = y_u * dcoeff_dk1;
+  }
+};
+
+/**
+ * @brief Derivative of R(angleAxis) * X w.r.t. the angle axis
+ *
+ * Compact formula: -R [X]x (w w^T + (R^T - I) [w]x) / |w|^2
+ * (first order approximation around 0 as ceres::AngleAxisRotatePoint).
+ */
+inline Mat3 rotatedPointJacobian(const double* angleAxis, const Mat3& R, const Vec3& X)
+{
+  const Vec3 w(angleAxis[0], angleAxis[1], angleAxis[2]);
+  const double theta2 = w.squaredNorm();
+  if(theta2 > std::numeric_limits<double>::epsilon())
+    return -R * CrossProductMatrix(X) * (w * w.transpose() + (R.transpose() - Mat3::Identity()) * CrossProductMatrix(w)) / theta2;
+  return -CrossProductMatrix(X);
+}
+
+/**
+ * @brief Residual of a point in the camera frame and its derivatives
+ * @param[in] cam_K: Camera intrinsics( focal, principal point [x,y], distortion... )
+ * @param[in] X: 3D point in the camera frame
+ * @param[in] pos_2dpoint: the 2D observation
+ * @param[out] out_residuals
+ * @param[out] out_jacobianK: derivative w.r.t. the intrinsics (row major, may be NULL)
+ * @param[out] out_jacobianX: derivative w.r.t. X
+ */
+template <class Distortion>
+void projectWithJacobians(const double* const cam_K,
+                          const Vec3& X,
+                          const double* const pos_2dpoint,
+                          double* out_residuals,
+                          double* out_jacobianK,
+                          Eigen::Matrix<double, 2, 3>& out_jacobianX)
+{
+  const int nbIntrinsicParams = 3 + Distortion::nbParams;
+  const double focal = cam_K[0];
+
+  // Transform the point from homogeneous to euclidean (undistorted point)
+  const double invZ = 1.0 / X(2);
+  const double x_u = X(0) * invZ;
+  const double y_u = X(1) * invZ;
+
+  double d[2];
+  double d_du[4];
+  std::array<double, 2 * Distortion::nbParams> d_ddisto;
+  Distortion::distort(cam_K + 3, x_u, y_u, d, d_du, d_ddisto.data());
+
+  // Apply focal length and principal point to get the final image coordinates
+  out_residuals[0] = cam_K[1] + focal * d[0] - pos_2dpoint[0];
+  out_residuals[1] = cam_K[2] + focal * d[1] - pos_2dpoint[1];
+
+  if(out_jacobianK != nullptr)
+  {
+    double* row0 = out_jacobianK;
+    double* row1 = out_jacobianK + nbIntrinsicParams;
+    row0[0] = d[0]; row0[1] = 1.0; row0[2] = 0.0;
+    row1[0] = d[1]; row1[1] = 0.0; row1[2] = 1.0;
+    for(int i = 0; i < Distortion::nbParams; ++i)
+    {
+      row0[3 + i] = focal * d_ddisto[i];
+      row1[3 + i] = focal * d_ddisto[Distortion::nbParams + i];
+    }
+  }
+
+  Eigen::Matrix<double, 2, 3> du_dX;
+  du_dX << invZ, 0.0, -x_u * invZ,
+           0.0, invZ, -y_u * invZ;
+  out_jacobianX = focal * Eigen::Map<const Eigen::Matrix<double, 2, 2, Eigen::RowMajor>>(d_du) * du_dX;
+}
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2, 3 + Distortion::nbParams, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 + Distortion::nbParams => the intrinsic data block [focal, principal point x, principal point y, distortion...],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <class Distortion>
+class ResidualErrorCostFunction : public ceres::SizedCostFunction<2, 3 + Distortion::nbParams, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const Vec3 pos_3dpoint(parameters[2][0], parameters[2][1], parameters[2][2]);
+
+    // Apply external parameters (Pose)
+    Mat3 R;
+    ceres::AngleAxisToRotationMatrix(cam_Rt, R.data());
+    const Vec3 pos_proj = R * pos_3dpoint + Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply intrinsic parameters
+    Eigen::Matrix<double, 2, 3> d_dproj;
+    projectWithJacobians<Distortion>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                     jacobians ? jacobians[0] : nullptr, d_dproj);
+
+    if(jacobians == nullptr)
+      return true;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> jacobianRt(jacobians[1]);
+      jacobianRt.leftCols<3>() = d_dproj * rotatedPointJacobian(cam_Rt, R, pos_3dpoint);
+      jacobianRt.rightCols<3>() = d_dproj;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> jacobianPoint(jacobians[2]);
+      jacobianPoint = d_dproj * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a rig camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2, 3 + Distortion::nbParams, 6, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 + Distortion::nbParams => the intrinsic data block [focal, principal point x, principal point y, distortion...],
+ *  - 6 => the rig pose data block [R;t],
+ *  - 6 => the rig sub-pose data block [R;t],
+ *  - 3 => a 3D point data block.
+ */
+template <class Distortion>
+class ResidualErrorRigCostFunction : public ceres::SizedCostFunction<2, 3 + Distortion::nbParams, 6, 6, 3>
+{
+public:
+  explicit ResidualErrorRigCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const double* subpose_Rt = parameters[2];
+    const Vec3 pos_3dpoint(parameters[3][0], parameters[3][1], parameters[3][2]);
+
+    // Apply RIG pose
+    Mat3 R;
+    ceres::AngleAxisToRotationMatrix(cam_Rt, R.data());
+    const Vec3 pos_rig = R * pos_3dpoint + Vec3(cam_Rt[3], cam_Rt[4], cam_Rt[5]);
+
+    // Apply RIG sub-pose
+    Mat3 subposeR;
+    ceres::AngleAxisToRotationMatrix(subpose_Rt, subposeR.data());
+    const Vec3 pos_proj = subposeR * pos_rig + Vec3(subpose_Rt[3], subpose_Rt[4], subpose_Rt[5]);
+
+    // Apply intrinsic parameters
+    Eigen::Matrix<double, 2, 3> d_dproj;
+    projectWithJacobians<Distortion>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                     jacobians ? jacobians[0] : nullptr, d_dproj);
+
+    if(jacobians == nullptr)
+      return true;
+
+    const Eigen::Matrix<double, 2, 3> d_drig = d_dproj * subposeR;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> jacobianRt(jacobians[1]);
+      jacobianRt.leftCols<3>() = d_drig * rotatedPointJacobian(cam_Rt, R, pos_3dpoint);
+      jacobianRt.rightCols<3>() = d_drig;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> jacobianSubposeRt(jacobians[2]);
+      jacobianSubposeRt.leftCols<3>() = d_dproj * rotatedPointJacobian(subpose_Rt, subposeR, pos_rig);
+      jacobianSubposeRt.rightCols<3>() = d_dproj;
+    }
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> jacobianPoint(jacobians[3]);
+      jacobianPoint = d_drig * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+} // namespace sfm
+} // namespace aliceVision
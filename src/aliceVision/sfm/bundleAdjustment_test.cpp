@@ -12,6 +12,9 @@
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <memory>
+
+#include <ceres/rotation.h>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 #include <boost/test/included/unit_test.hpp>
@@ -26,7 +29,9 @@ double RMSE(const SfMData & sfmData);
 
 SfMData getInputScene(const NViewDataSet & d, const NViewDatasetConfigurator & config, EINTRINSIC eintrinsic);
 
-track::TracksPerView getTracksPerViews(const SfMData& sfmData);
+track::CompactTracks getTracks(const SfMData& sfmData);
+
+void checkAnalyticJacobians(EINTRINSIC eintrinsic, bool rig);
 
 // Test summary:
 // - Create a SfMData scene from a synthetic dataset
@@ -161,7 +166,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   sfmData.structure[2].observations.erase(0);
   sfmData.structure[2].observations.erase(1);
 
-  track::TracksPerView tracksPerView = getTracksPerViews(sfmData);
+  track::CompactTracks tracks = getTracks(sfmData);
 
   // Set the view "v0' as new (graph-distance(v0) = 0):
   std::set<IndexT> newReconstructedViews;
@@ -196,7 +201,7 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   // Assign the refinement rule for all the parameters (poses, landmarks & intrinsics) according to the LBA strategy:
   // 1. Add the new reconstructed views to the graph
   const std::size_t kMinNbOfMatches = 1;
-  localBAData.updateGraphWithNewViews(sfmData, tracksPerView, newReconstructedViews, kMinNbOfMatches);
+  localBAData.updateGraphWithNewViews(sfmData, tracks, newReconstructedViews, kMinNbOfMatches);
   // 2. Compute the graph-distance between each newly reconstructed views and all the reconstructed views
   localBAData.computeGraphDistances(sfmData, newReconstructedViews);
   // 3. Use the graph-distances to assign a LBA state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
@@ -234,6 +239,20 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK( dResidual_before > dResidual_after);
 }
 
+// Test summary:
+// - Evaluate the cost functions with analytic derivatives and the autodiff cost functions
+//   on the same parameters
+// - Check that residuals and Jacobians are the same for all the camera models
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians) {
+  for(EINTRINSIC eintrinsic : {PINHOLE_CAMERA, PINHOLE_CAMERA_RADIAL1, PINHOLE_CAMERA_RADIAL3,
+                               PINHOLE_CAMERA_BROWN, PINHOLE_CAMERA_FISHEYE, PINHOLE_CAMERA_FISHEYE1})
+  {
+    checkAnalyticJacobians(eintrinsic, false);
+    checkAnalyticJacobians(eintrinsic, true);
+  }
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
@@ -317,28 +336,94 @@ SfMData getInputScene(const NViewDataSet & d, const NViewDatasetConfigurator & c
   return sfm_data;
 }
 
-track::TracksPerView getTracksPerViews(const SfMData& sfmData)
+track::CompactTracks getTracks(const SfMData& sfmData)
 {
-  track::TracksPerView tracksPerView;
+  track::TracksMap tracks;
   for (const auto& landIt : sfmData.getLandmarks())
   {
+    track::Track& track = tracks[landIt.first];
+    track.descType = landIt.second.descType;
     for (const auto& obsIt : landIt.second.observations)
-    {
-      IndexT viewId = obsIt.first;
-      track::TrackIdSet& tracksSet = tracksPerView[viewId];
-      tracksSet.push_back(landIt.first);
-    }
+      track.featPerView[obsIt.first] = obsIt.second.id_feat;
   }
+  return track::CompactTracks(tracks);
+}
+
 
-  // sort tracks Ids in each view
-  #pragma omp parallel for
-  for(int i = 0; i < tracksPerView.size(); ++i)
+void checkAnalyticJacobians(EINTRINSIC eintrinsic, bool rig)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(3, 10, config);
+  SfMData sfmData = getInputScene(d, config, eintrinsic);
+
+  Pinhole* intrinsic = dynamic_cast<Pinhole*>(sfmData.intrinsics.at(0).get());
+  std::vector<double> disto = intrinsic->getDistortionParams();
+  for(std::size_t i = 0; i < disto.size(); ++i)
+    disto[i] = 0.01 * (i + 1);
+  if(eintrinsic == PINHOLE_CAMERA_FISHEYE1)
+    disto[0] = 0.9; // k1 = 0 is not defined for this model
+  intrinsic->setDistortionParams(disto);
+
+  std::vector<double> intrinsicParams = intrinsic->getParams();
+  const std::size_t intrinsicSize = intrinsicParams.size();
+  const double subpose[6] = {0.01, -0.02, 0.03, 0.1, -0.05, 0.02};
+
+  for(const auto& landmarkIt : sfmData.structure)
   {
-    track::TracksPerView::iterator it = tracksPerView.begin();
-    std::advance(it, i);
-    std::sort(it->second.begin(), it->second.end());
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const Pose3 pose = sfmData.getPose(*sfmData.views.at(observationIt.first)).getTransform();
+      double rt[6];
+      ceres::RotationMatrixToAngleAxis(pose.rotation().data(), rt);
+      const Vec3 t = pose.translation();
+      rt[3] = t(0); rt[4] = t(1); rt[5] = t(2);
+      Vec3 X = landmarkIt.second.X;
+
+      std::unique_ptr<ceres::CostFunction> autodiff(rig ?
+            createRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x) :
+            createCostFunctionFromIntrinsics(intrinsic, observationIt.second.x));
+      std::unique_ptr<ceres::CostFunction> analytic(rig ?
+            createAnalyticRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x) :
+            createAnalyticCostFunctionFromIntrinsics(intrinsic, observationIt.second.x));
+
+      std::vector<const double*> parameters = {intrinsicParams.data(), rt};
+      std::vector<std::size_t> blockSizes = {intrinsicSize, 6};
+      if(rig)
+      {
+        parameters.push_back(subpose);
+        blockSizes.push_back(6);
+      }
+      parameters.push_back(X.data());
+      blockSizes.push_back(3);
+
+      std::vector<std::vector<double>> jacobiansAutodiff(parameters.size());
+      std::vector<std::vector<double>> jacobiansAnalytic(parameters.size());
+      std::vector<double*> jacobiansAutodiffPtr(parameters.size());
+      std::vector<double*> jacobiansAnalyticPtr(parameters.size());
+      for(std::size_t b = 0; b < parameters.size(); ++b)
+      {
+        jacobiansAutodiff[b].resize(2 * blockSizes[b]);
+        jacobiansAnalytic[b].resize(2 * blockSizes[b]);
+        jacobiansAutodiffPtr[b] = jacobiansAutodiff[b].data();
+        jacobiansAnalyticPtr[b] = jacobiansAnalytic[b].data();
+      }
+
+      double residualsAutodiff[2];
+      double residualsAnalytic[2];
+      BOOST_CHECK(autodiff->Evaluate(parameters.data(), residualsAutodiff, jacobiansAutodiffPtr.data()));
+      BOOST_CHECK(analytic->Evaluate(parameters.data(), residualsAnalytic, jacobiansAnalyticPtr.data()));
+
+      BOOST_CHECK_SMALL(residualsAutodiff[0] - residualsAnalytic[0], 1e-8);
+      BOOST_CHECK_SMALL(residualsAutodiff[1] - residualsAnalytic[1], 1e-8);
+
+      for(std::size_t b = 0; b < parameters.size(); ++b)
+      {
+        for(std::size_t i = 0; i < jacobiansAutodiff[b].size(); ++i)
+        {
+          const double tolerance = 1e-8 * std::max(1.0, std::abs(jacobiansAutodiff[b][i]));
+          BOOST_CHECK_SMALL(jacobiansAutodiff[b][i] - jacobiansAnalytic[b][i], tolerance);
+        }
+      }
+    }
   }
-
-  return tracksPerView;
 }
-
@@ -0,0 +1,187 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompactLandmarks.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#define BOOST_TEST_MODULE sfmCompactLandmarks
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+/// Round the values to 1/256 so that they are stored exactly as float
+template<typename VecT>
+VecT floatExact(const VecT& v)
+{
+  return (v * 256.0).array().round() / 256.0;
+}
+
+/**
+ * @brief Generate landmarks observed by consecutive views
+ * landmark i is observed by the views [i % nbViews, i % nbViews + 3)
+ */
+Landmarks generateLandmarks(std::size_t nbLandmarks, std::size_t nbViews)
+{
+  Landmarks landmarks;
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    Landmark landmark(floatExact<Vec3>(Vec3::Random() * 10.0), feature::EImageDescriberType::SIFT);
+    landmark.rgb = image::RGBColor(i % 256, (i * 7) % 256, (i * 13) % 256);
+    for(std::size_t v = 0; v < 3; ++v)
+      landmark.observations[(i + v) % nbViews] = Observation(floatExact<Vec2>(Vec2::Random() * 1000.0), i * 3 + v);
+    // sparse landmark ids
+    landmarks[i * 2 + 1] = landmark;
+  }
+  return landmarks;
+}
+
+BOOST_AUTO_TEST_CASE(compactLandmarks_adapters)
+{
+  const Landmarks landmarks = generateLandmarks(500, 20);
+  const CompactLandmarks compactLandmarks(landmarks);
+
+  BOOST_CHECK_EQUAL(landmarks.size(), compactLandmarks.nbLandmarks());
+  BOOST_CHECK_EQUAL(landmarks.size() * 3, compactLandmarks.nbObservations());
+
+  for(IndexT l = 0; l < compactLandmarks.nbLandmarks(); ++l)
+  {
+    const IndexT landmarkId = compactLandmarks.landmarkId(l);
+    BOOST_CHECK_EQUAL(l, compactLandmarks.landmarkIndex(landmarkId));
+    BOOST_CHECK(compactLandmarks.landmark(l) == landmarks.at(landmarkId));
+
+    // observations sorted by view id
+    const auto views = compactLandmarks.observationViews(l);
+    BOOST_CHECK(std::is_sorted(views.begin(), views.end()));
+  }
+  BOOST_CHECK_EQUAL(UndefinedIndexT, compactLandmarks.landmarkIndex(0));
+
+  Landmarks exportedLandmarks;
+  compactLandmarks.exportToSTL(exportedLandmarks);
+  BOOST_CHECK(exportedLandmarks == landmarks);
+
+  // SfMData structure
+  SfMData sfmData;
+  sfmData.structure = landmarks;
+  CompactLandmarks structure;
+  compactStructure(sfmData, structure);
+  BOOST_CHECK(sfmData.structure.empty());
+  expandStructure(structure, sfmData);
+  BOOST_CHECK(sfmData.structure == landmarks);
+}
+
+BOOST_AUTO_TEST_CASE(compactLandmarks_spill)
+{
+  const std::size_t nbViews = 20;
+  const Landmarks landmarks = generateLandmarks(500, nbViews);
+  CompactLandmarks compactLandmarks(landmarks);
+
+  const boost::filesystem::path folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("landmarks_%%%%%%");
+  boost::filesystem::create_directory(folder);
+  const auto nbFiles = [&folder]() {
+    return std::distance(boost::filesystem::directory_iterator(folder), boost::filesystem::directory_iterator());
+  };
+
+  // keep in memory the landmarks observed by the views [0, 5)
+  const std::set<IndexT> activeViews = {0, 1, 2, 3, 4};
+  BOOST_CHECK(compactLandmarks.spill(folder.string(), activeViews));
+  BOOST_CHECK_EQUAL(1, nbFiles());
+  BOOST_CHECK(compactLandmarks.nbSpilled() > 0);
+  BOOST_CHECK_EQUAL(landmarks.size(), compactLandmarks.nbLandmarks() + compactLandmarks.nbSpilled());
+
+  for(IndexT l = 0; l < compactLandmarks.nbLandmarks(); ++l)
+  {
+    const auto views = compactLandmarks.observationViews(l);
+    BOOST_CHECK(std::any_of(views.begin(), views.end(), [&](IndexT viewId) { return activeViews.count(viewId) > 0; }));
+  }
+
+  // spill again with fewer active views, in a new file
+  BOOST_CHECK(compactLandmarks.spill(folder.string(), {0}));
+  BOOST_CHECK_EQUAL(2, nbFiles());
+  BOOST_CHECK_EQUAL(landmarks.size(), compactLandmarks.nbLandmarks() + compactLandmarks.nbSpilled());
+
+  // the storage and its spill files are moved
+  CompactLandmarks movedLandmarks(std::move(compactLandmarks));
+  BOOST_CHECK_EQUAL(0, compactLandmarks.nbSpilled());
+  BOOST_CHECK_EQUAL(landmarks.size(), movedLandmarks.nbLandmarks() + movedLandmarks.nbSpilled());
+
+  BOOST_CHECK(movedLandmarks.restore());
+  BOOST_CHECK_EQUAL(0, nbFiles());
+  BOOST_CHECK_EQUAL(0, movedLandmarks.nbSpilled());
+
+  Landmarks restoredLandmarks;
+  movedLandmarks.exportToSTL(restoredLandmarks);
+  BOOST_CHECK(restoredLandmarks == landmarks);
+
+  // the move assignment removes the spill files of the target
+  CompactLandmarks otherLandmarks(landmarks);
+  BOOST_CHECK(otherLandmarks.spill(folder.string(), {0}));
+  BOOST_CHECK_EQUAL(1, nbFiles());
+  otherLandmarks = std::move(movedLandmarks);
+  BOOST_CHECK_EQUAL(0, nbFiles());
+  BOOST_CHECK_EQUAL(0, otherLandmarks.nbSpilled());
+  BOOST_CHECK_EQUAL(landmarks.size(), otherLandmarks.nbLandmarks());
+
+  boost::filesystem::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(compactLandmarks_insert)
+{
+  const Landmarks landmarks = generateLandmarks(500, 20);
+
+  // split the landmarks in two interleaved sets of ids
+  Landmarks firstLandmarks;
+  Landmarks secondLandmarks;
+  for(const auto& landmarkPair : landmarks)
+    (((landmarkPair.first / 2) % 2) ? secondLandmarks : firstLandmarks).insert(landmarkPair);
+
+  CompactLandmarks compactLandmarks(firstLandmarks);
+  compactLandmarks.insert(secondLandmarks);
+  BOOST_CHECK_EQUAL(landmarks.size(), compactLandmarks.nbLandmarks());
+
+  Landmarks exportedLandmarks;
+  compactLandmarks.exportToSTL(exportedLandmarks);
+  BOOST_CHECK(exportedLandmarks == landmarks);
+}
+
+BOOST_AUTO_TEST_CASE(compactLandmarks_corruptedFile)
+{
+  const Landmarks landmarks = generateLandmarks(100, 10);
+  const CompactLandmarks compactLandmarks(landmarks);
+
+  const std::string filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("landmarks_%%%%%%.bin")).string();
+  BOOST_CHECK(compactLandmarks.save(filename));
+
+  CompactLandmarks loadedLandmarks;
+  BOOST_CHECK(loadedLandmarks.load(filename));
+  BOOST_CHECK_EQUAL(landmarks.size(), loadedLandmarks.nbLandmarks());
+
+  // a landmark ids count larger than the file fails cleanly, without allocating it
+  {
+    std::fstream stream(filename, std::ios::in | std::ios::out | std::ios::binary);
+    const uint64_t size = std::numeric_limits<uint64_t>::max() / 8;
+    stream.seekp(sizeof(uint32_t));
+    stream.write((const char*) &size, sizeof(uint64_t));
+  }
+  BOOST_CHECK(!loadedLandmarks.load(filename));
+  BOOST_CHECK_EQUAL(0, loadedLandmarks.nbLandmarks());
+
+  // a truncated file fails cleanly
+  BOOST_CHECK(compactLandmarks.save(filename));
+  boost::filesystem::resize_file(filename, boost::filesystem::file_size(filename) - 10);
+  BOOST_CHECK(!loadedLandmarks.load(filename));
+
+  boost::filesystem::remove(filename);
+}
@@ -0,0 +1,190 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ContentCache.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/// Binary entries extension
+const std::string BINARY_ENTRY_EXTENSION = ".bin";
+
+/// @return a unique temporary path next to the given path
+std::string getTemporaryPath(const std::string& path)
+{
+  return path + "." + fs::unique_path().string() + ".tmp";
+}
+
+/// Create the parent folder of an entry (may be created by another thread at the same time)
+void createParentFolder(const std::string& path)
+{
+  boost::system::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+}
+
+/// Remove a temporary file left by a failed write, without throwing
+void removeTemporaryFile(const std::string& tmpPath)
+{
+  boost::system::error_code ec;
+  fs::remove(tmpPath, ec);
+}
+
+} // namespace
+
+const int ContentCache::VERSION;
+
+ContentKey::ContentKey()
+{
+  add("aliceVision::ContentCache");
+  add(ContentCache::VERSION);
+}
+
+ContentKey& ContentKey::add(const std::string& value)
+{
+  add(static_cast<uint64_t>(value.size()));
+  _sha256.update(value);
+  return *this;
+}
+
+std::string ContentCache::getPath(const std::string& category, const std::string& key, const std::string& extension) const
+{
+  return (fs::path(_folder) / category / (key + extension)).string();
+}
+
+bool ContentCache::exists(const std::string& category, const std::string& key, const std::string& extension) const
+{
+  boost::system::error_code ec;
+  return isEnabled() && fs::exists(getPath(category, key, extension), ec);
+}
+
+bool ContentCache::load(const std::string& category, const std::string& key, std::string& data) const
+{
+  if(!isEnabled())
+    return false;
+
+  const std::string path = getPath(category, key, BINARY_ENTRY_EXTENSION);
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  try
+  {
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    if(stream.bad())
+    {
+      ALICEVISION_LOG_WARNING("Unable to read the cache entry '" << path << "'.");
+      return false;
+    }
+    data = buffer.str();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Unable to read the cache entry '" << path << "': " << e.what());
+    return false;
+  }
+  return true;
+}
+
+bool ContentCache::store(const std::string& category, const std::string& key, const std::string& data) const
+{
+  if(!isEnabled())
+    return false;
+
+  const std::string path = getPath(category, key, BINARY_ENTRY_EXTENSION);
+  std::string tmpPath;
+
+  try
+  {
+    tmpPath = getTemporaryPath(path);
+    createParentFolder(path);
+
+    {
+      std::ofstream stream(tmpPath, std::ios::out | std::ios::binary);
+      stream.write(data.data(), data.size());
+      if(!stream.good())
+        throw std::runtime_error("Can't write the temporary file '" + tmpPath + "'");
+    }
+
+    fs::rename(tmpPath, path);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Unable to store the cache entry '" << path << "': " << e.what());
+    if(!tmpPath.empty())
+      removeTemporaryFile(tmpPath);
+    return false;
+  }
+  return true;
+}
+
+bool ContentCache::restoreFile(const std::string& category, const std::string& key, const std::string& extension, const std::string& filepath) const
+{
+  if(!isEnabled())
+    return false;
+
+  const std::string path = getPath(category, key, extension);
+  std::string tmpPath;
+
+  try
+  {
+    if(!fs::exists(path))
+      return false;
+
+    tmpPath = getTemporaryPath(filepath);
+    fs::copy_file(path, tmpPath, fs::copy_option::overwrite_if_exists);
+    fs::rename(tmpPath, filepath);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Unable to restore the cache entry '" << path << "': " << e.what());
+    if(!tmpPath.empty())
+      removeTemporaryFile(tmpPath);
+    return false;
+  }
+  return true;
+}
+
+bool ContentCache::storeFile(const std::string& category, const std::string& key, const std::string& extension, const std::string& filepath) const
+{
+  if(!isEnabled())
+    return false;
+
+  const std::string path = getPath(category, key, extension);
+  std::string tmpPath;
+
+  try
+  {
+    tmpPath = getTemporaryPath(path);
+    createParentFolder(path);
+
+    fs::copy_file(filepath, tmpPath, fs::copy_option::overwrite_if_exists);
+    fs::rename(tmpPath, path);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Unable to store the cache entry '" << path << "': " << e.what());
+    if(!tmpPath.empty())
+      removeTemporaryFile(tmpPath);
+    return false;
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,145 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Sha256.hpp>
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Key of a content cache entry: SHA-256 digest of all the inputs used to compute the entry,
+ * salted with the cache format version (ContentCache::VERSION).
+ * Each value is added with its size, so different sequences of values give different keys.
+ */
+class ContentKey
+{
+public:
+  ContentKey();
+
+  ContentKey& add(const std::string& value);
+
+  ContentKey& add(const char* value)
+  {
+    return add(std::string(value));
+  }
+
+  /// Add a number, by its binary representation
+  template<typename T>
+  ContentKey& add(T value)
+  {
+    static_assert(std::is_arithmetic<T>::value, "ContentKey: only numbers and strings can be added.");
+    _sha256.update(&value, sizeof(T));
+    return *this;
+  }
+
+  /// @return the key (hexadecimal SHA-256 digest)
+  std::string digest() const
+  {
+    return _sha256.hexDigest();
+  }
+
+private:
+  system::Sha256 _sha256;
+};
+
+/**
+ * @brief Content-addressed cache of the intermediate products of the pipeline.
+ *
+ * Each entry is a file of a category (e.g. features, matches) named by a key,
+ * the digest of all the inputs used to compute the entry (see ContentKey, computeFileUID, computeRegionsUID).
+ * So the per-view and per-pair products can be reused by another run,
+ * whatever its view ids and output folders, and only the new views and pairs are computed.
+ *
+ * The entries are written in a temporary file and renamed,
+ * so the cache can be shared by concurrent threads and processes.
+ * The cache never throws: a failure to read or write an entry is logged,
+ * its temporary file is removed and the entry is computed again.
+ */
+class ContentCache
+{
+public:
+  /// Version of the cache format, to increment when the content of the entries changes
+  static const int VERSION = 1;
+
+  /**
+   * @param[in] folder The cache folder, the cache is disabled if empty
+   */
+  explicit ContentCache(const std::string& folder = "")
+    : _folder(folder)
+  {}
+
+  bool isEnabled() const
+  {
+    return !_folder.empty();
+  }
+
+  const std::string& getFolder() const
+  {
+    return _folder;
+  }
+
+  /**
+   * @brief Get the path of an entry
+   * @param[in] category The entry category (subfolder of the cache)
+   * @param[in] key The entry key
+   * @param[in] extension The entry file extension (e.g. ".SIFT.feat")
+   * @return the entry path
+   */
+  std::string getPath(const std::string& category, const std::string& key, const std::string& extension) const;
+
+  /// @return true if the entry exists
+  bool exists(const std::string& category, const std::string& key, const std::string& extension) const;
+
+  /**
+   * @brief Read a binary entry
+   * @param[in] category The entry category
+   * @param[in] key The entry key
+   * @param[out] data The entry content
+   * @return false if the cache is disabled or the entry does not exist
+   */
+  bool load(const std::string& category, const std::string& key, std::string& data) const;
+
+  /**
+   * @brief Write a binary entry, does nothing if the cache is disabled
+   * @param[in] category The entry category
+   * @param[in] key The entry key
+   * @param[in] data The entry content
+   * @return false if the cache is disabled or the entry can't be written
+   */
+  bool store(const std::string& category, const std::string& key, const std::string& data) const;
+
+  /**
+   * @brief Copy a file entry to the given file
+   * @param[in] category The entry category
+   * @param[in] key The entry key
+   * @param[in] extension The entry file extension
+   * @param[in] filepath The destination file
+   * @return false if the cache is disabled, the entry does not exist or can't be copied
+   */
+  bool restoreFile(const std::string& category, const std::string& key, const std::string& extension, const std::string& filepath) const;
+
+  /**
+   * @brief Copy the given file in a file entry, does nothing if the cache is disabled
+   * @param[in] category The entry category
+   * @param[in] key The entry key
+   * @param[in] extension The entry file extension
+   * @param[in] filepath The source file
+   * @return false if the cache is disabled or the entry can't be written
+   */
+  bool storeFile(const std::string& category, const std::string& key, const std::string& extension, const std::string& filepath) const;
+
+private:
+  std::string _folder;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,185 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/ContentCache.hpp>
+#include <aliceVision/sfm/utils/uid.hpp>
+#include <aliceVision/matching/io.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+#define BOOST_TEST_MODULE sfmContentCache
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace fs = boost::filesystem;
+
+void writeFile(const std::string& filepath, const std::string& content)
+{
+  std::ofstream stream(filepath, std::ios::out | std::ios::binary);
+  stream << content;
+}
+
+std::string readFile(const std::string& filepath)
+{
+  std::ifstream stream(filepath, std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+BOOST_AUTO_TEST_CASE(ContentCache_fileUID)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("fileUID_%%%%%%");
+  fs::create_directories(folder);
+
+  const std::string content(10000, 'a');
+  writeFile((folder / "a.txt").string(), content);
+  writeFile((folder / "b.txt").string(), content);
+  writeFile((folder / "c.txt").string(), content + "b");
+
+  // the UID is the SHA-256 digest of the content, it does not depend on the filename
+  writeFile((folder / "abc.txt").string(), "abc");
+  BOOST_CHECK_EQUAL(computeFileUID((folder / "abc.txt").string()), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  BOOST_CHECK_EQUAL(computeFileUID((folder / "a.txt").string()), computeFileUID((folder / "b.txt").string()));
+  BOOST_CHECK_NE(computeFileUID((folder / "a.txt").string()), computeFileUID((folder / "c.txt").string()));
+  BOOST_CHECK_THROW(computeFileUID((folder / "d.txt").string()), std::runtime_error);
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(ContentCache_sha256)
+{
+  // FIPS 180-2 test vectors
+  system::Sha256 empty;
+  BOOST_CHECK_EQUAL(empty.hexDigest(), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+  const std::string message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  system::Sha256 sha256;
+  sha256.update(message);
+  BOOST_CHECK_EQUAL(sha256.hexDigest(), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  // same digest when the data is added by parts
+  system::Sha256 sha256Parts;
+  for(std::size_t i = 0; i < message.size(); i += 5)
+    sha256Parts.update(message.substr(i, 5));
+  BOOST_CHECK_EQUAL(sha256Parts.hexDigest(), sha256.hexDigest());
+
+  system::Sha256 sha256Million;
+  const std::string block(1000, 'a');
+  for(int i = 0; i < 1000; ++i)
+    sha256Million.update(block);
+  BOOST_CHECK_EQUAL(sha256Million.hexDigest(), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+BOOST_AUTO_TEST_CASE(ContentCache_keys)
+{
+  const std::string key = ContentKey().add("ab").add("c").add(1).digest();
+  BOOST_CHECK_EQUAL(key.size(), 64);
+  BOOST_CHECK_EQUAL(key, ContentKey().add("ab").add("c").add(1).digest());
+
+  // the values are delimited
+  BOOST_CHECK_NE(key, ContentKey().add("a").add("bc").add(1).digest());
+  // the number types are different values
+  BOOST_CHECK_NE(key, ContentKey().add("ab").add("c").add(1.0).digest());
+  BOOST_CHECK_NE(key, ContentKey().add("ab").add("c").add(2).digest());
+
+  // the keys are salted with the cache version: not the plain digest of the values
+  system::Sha256 sha256;
+  sha256.update("abc");
+  BOOST_CHECK_NE(ContentKey().add("abc").digest(), sha256.hexDigest());
+}
+
+BOOST_AUTO_TEST_CASE(ContentCache_entries)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("contentCache_%%%%%%");
+  const ContentCache cache(folder.string());
+  BOOST_CHECK(cache.isEnabled());
+
+  // binary entries
+  std::string data;
+  BOOST_CHECK(!cache.load("matches", "42", data));
+  BOOST_CHECK(cache.store("matches", "42", std::string("\0abc\n", 5)));
+  BOOST_CHECK(cache.load("matches", "42", data));
+  BOOST_CHECK_EQUAL(data, std::string("\0abc\n", 5));
+  BOOST_CHECK(!cache.load("matches", "43", data));
+  BOOST_CHECK(!cache.load("features", "42", data));
+
+  // file entries
+  const std::string source = (fs::temp_directory_path() / fs::unique_path("source_%%%%%%.feat")).string();
+  const std::string destination = (fs::temp_directory_path() / fs::unique_path("destination_%%%%%%.feat")).string();
+  writeFile(source, "1 2 3 4\n");
+
+  BOOST_CHECK(!cache.exists("features", "7", ".SIFT.feat"));
+  BOOST_CHECK(!cache.restoreFile("features", "7", ".SIFT.feat", destination));
+  BOOST_CHECK(cache.storeFile("features", "7", ".SIFT.feat", source));
+  BOOST_CHECK(cache.exists("features", "7", ".SIFT.feat"));
+  BOOST_CHECK(!cache.exists("features", "7", ".SIFT.desc"));
+  BOOST_CHECK(cache.restoreFile("features", "7", ".SIFT.feat", destination));
+  BOOST_CHECK_EQUAL(readFile(destination), "1 2 3 4\n");
+
+  // the failures are not thrown, the entries are not stored
+  writeFile((folder / "blocked").string(), "");
+  BOOST_CHECK(!cache.store("blocked", "42", "abc"));
+  BOOST_CHECK(!cache.storeFile("blocked", "7", ".SIFT.feat", source));
+  BOOST_CHECK(!cache.storeFile("features", "8", ".SIFT.feat", source + ".missing"));
+  BOOST_CHECK(!cache.exists("features", "8", ".SIFT.feat"));
+  BOOST_CHECK(!cache.restoreFile("features", "7", ".SIFT.feat", (folder / "blocked" / "destination.feat").string()));
+
+  // no temporary file left
+  std::size_t nbFiles = 0;
+  for(fs::recursive_directory_iterator it(folder), end; it != end; ++it)
+  {
+    if(fs::is_regular_file(it->path()))
+      ++nbFiles;
+  }
+  BOOST_CHECK_EQUAL(nbFiles, 3);
+
+  fs::remove(source);
+  fs::remove(destination);
+  fs::remove_all(folder);
+
+  // disabled cache
+  const ContentCache disabledCache;
+  BOOST_CHECK(!disabledCache.isEnabled());
+  BOOST_CHECK(!disabledCache.store("matches", "42", "abc"));
+  BOOST_CHECK(!disabledCache.load("matches", "42", data));
+}
+
+BOOST_AUTO_TEST_CASE(ContentCache_matches)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("contentCache_%%%%%%");
+  const ContentCache cache(folder.string());
+
+  matching::MatchesPerDescType matches;
+  matches[feature::EImageDescriberType::SIFT] = {{0, 5}, {3, 2}, {10, 100}};
+  matches[feature::EImageDescriberType::AKAZE] = {{7, 1}};
+
+  std::string buffer;
+  matching::encodeMatchesPerDescType(matches, buffer);
+  cache.store("matches", "1", buffer);
+
+  // a pair without matches is also an entry
+  buffer.clear();
+  matching::encodeMatchesPerDescType(matching::MatchesPerDescType(), buffer);
+  cache.store("matches", "2", buffer);
+
+  matching::MatchesPerDescType loadedMatches;
+  BOOST_CHECK(cache.load("matches", "1", buffer));
+  BOOST_CHECK(matching::decodeMatchesPerDescType(buffer, loadedMatches));
+  BOOST_CHECK_EQUAL(loadedMatches.size(), 2);
+  BOOST_CHECK(loadedMatches.at(feature::EImageDescriberType::SIFT) == matches.at(feature::EImageDescriberType::SIFT));
+  BOOST_CHECK(loadedMatches.at(feature::EImageDescriberType::AKAZE) == matches.at(feature::EImageDescriberType::AKAZE));
+
+  loadedMatches.clear();
+  BOOST_CHECK(cache.load("matches", "2", buffer));
+  BOOST_CHECK(matching::decodeMatchesPerDescType(buffer, loadedMatches));
+  BOOST_CHECK(loadedMatches.empty());
+
+  fs::remove_all(folder);
+}
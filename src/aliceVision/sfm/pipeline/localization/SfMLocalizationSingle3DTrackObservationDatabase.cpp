@@ -97,6 +97,7 @@ namespace sfm {
     if (resection_data_ptr)
     {
       resection_data.error_max = resection_data_ptr->error_max;
+      resection_data.nfaMode = resection_data_ptr->nfaMode;
     }
     resection_data.pt3D.resize(3, vec_putative_matches.size());
     resection_data.pt2D.resize(2, vec_putative_matches.size());
@@ -30,6 +30,12 @@ struct ResectionSquaredResidualError
     const Vec2 x = Project(P, pt3D);
     return (x - pt2D).squaredNorm();
   }
+
+  // Compute the squared residuals of all the points at once
+  static void Errors(const Mat34 & P, const Mat & pt2D, const Mat & pt3D, std::vector<double> & errors)
+  {
+    SquaredReprojectionErrors(P, pt2D, pt3D, errors);
+  }
 };
 
 bool SfMLocalizer::Localize
@@ -70,7 +76,7 @@ bool SfMLocalizer::Localize
       resection_data.pt3D);
     // Robust estimation of the Projection matrix and its precision
     const std::pair<double,double> ACRansacOut =
-      aliceVision::robustEstimation::ACRANSAC(kernel, resection_data.vec_inliers, resection_data.max_iteration, &P, dPrecision, true);
+      aliceVision::robustEstimation::ACRANSAC(kernel, resection_data.vec_inliers, resection_data.max_iteration, &P, dPrecision, true, resection_data.nfaMode);
     // Update the upper bound precision of the model found by AC-RANSAC
     resection_data.error_max = ACRansacOut.first;
   }
@@ -107,7 +113,7 @@ bool SfMLocalizer::Localize
 
         // Robust estimation of the Projection matrix and its precision
         const std::pair<double, double> ACRansacOut =
-                aliceVision::robustEstimation::ACRANSAC(kernel, resection_data.vec_inliers, resection_data.max_iteration, &P, dPrecision, true);
+                aliceVision::robustEstimation::ACRANSAC(kernel, resection_data.vec_inliers, resection_data.max_iteration, &P, dPrecision, true, resection_data.nfaMode);
         // Update the upper bound precision of the model found by AC-RANSAC
         resection_data.error_max = ACRansacOut.first;
         break;
@@ -11,6 +11,7 @@
 #include "aliceVision/sfm/SfMData.hpp"
 #include "aliceVision/feature/RegionsPerView.hpp"
 #include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
 
 #include <cstddef>
 #include <limits>
@@ -42,6 +43,9 @@ struct ImageLocalizerMatchData
   /// Upper bound pixel(s) tolerance for residual errors
   double error_max = std::numeric_limits<double>::infinity();
   size_t max_iteration = 4096;
+
+  /// NFA evaluation of the A Contrario resection (HISTOGRAM only sorts a part of the residuals)
+  robustEstimation::EACRansacNFA nfaMode = robustEstimation::EACRansacNFA::EXACT;
 };
 
 class SfMLocalizer
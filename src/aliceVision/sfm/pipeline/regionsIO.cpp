@@ -7,60 +7,153 @@
 
 #include "regionsIO.hpp"
 
+#include <aliceVision/sfm/pipeline/ContentCache.hpp>
+#include <aliceVision/sfm/utils/uid.hpp>
+
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <ctime>
 
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
 namespace sfm {
 
-std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
-                                              IndexT viewId,
-                                              const feature::ImageDescriber& imageDescriber)
+namespace {
+
+/**
+ * @brief Choose between the binary regions file and the text files of the same folder.
+ * @note If both formats exist, the most recently written one is used,
+ *       so a stale file from a previous extraction in the other format is ignored.
+ * @param[in] regionsPath The binary regions file (.regions)
+ * @param[in] textPaths The text regions files (.feat and .desc or .feat only)
+ * @return true if the binary regions file has to be used
+ */
+bool useBinaryRegionsFile(const fs::path& regionsPath, const std::vector<fs::path>& textPaths)
 {
-  assert(!folders.empty());
+  if(!fs::exists(regionsPath))
+    return false;
 
-  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType());
+  std::time_t textTime = 0;
+  for(const fs::path& textPath : textPaths)
+  {
+    if(!fs::exists(textPath))
+      return true;
+    const std::time_t time = fs::last_write_time(textPath);
+    textTime = (textTime == 0) ? time : std::min(textTime, time);
+  }
+
+  const std::time_t regionsTime = fs::last_write_time(regionsPath);
+
+  if(regionsTime == textTime)
+    throw std::runtime_error("Can't choose between the binary regions file '" + regionsPath.string() +
+                             "' and the text regions files written at the same time, remove one of them.");
+
+  const bool useBinary = (regionsTime > textTime);
+  ALICEVISION_LOG_WARNING("Both binary and text regions files exist in '" << regionsPath.parent_path().string() << "', "
+                          "the most recent one is used: '" << (useBinary ? regionsPath : textPaths.front()).string() << "'.");
+  return useBinary;
+}
+
+/**
+ * @brief Find the regions files of a view, the last folder containing them is used.
+ * @return false if there is neither a binary regions file nor features and descriptors files
+ */
+bool findRegionsFiles(const std::vector<std::string>& folders,
+                      IndexT viewId,
+                      feature::EImageDescriberType imageDescriberType,
+                      std::string& featFilename,
+                      std::string& descFilename,
+                      std::string& regionsFilename)
+{
+  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
   const std::string basename = std::to_string(viewId);
 
-  std::string featFilename;
-  std::string descFilename;
+  featFilename.clear();
+  descFilename.clear();
+  regionsFilename.clear();
 
   for(const std::string& folder : folders)
   {
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
     const fs::path descPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".desc");
+    const fs::path regionsPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".regions");
 
-    if(fs::exists(featPath) && fs::exists(descPath))
+    if(useBinaryRegionsFile(regionsPath, {featPath, descPath}))
+    {
+      regionsFilename = regionsPath.string();
+      featFilename.clear();
+      descFilename.clear();
+    }
+    else if(fs::exists(featPath) && fs::exists(descPath))
     {
       featFilename = featPath.string();
       descFilename = descPath.string();
+      regionsFilename.clear();
     }
   }
 
-  if(featFilename.empty() || descFilename.empty())
-    throw std::runtime_error("Can't find view " + basename + " region files");
+  return !regionsFilename.empty() || (!featFilename.empty() && !descFilename.empty());
+}
+
+} // namespace
+
+std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
+                                              IndexT viewId,
+                                              const feature::ImageDescriber& imageDescriber,
+                                              bool memoryMapped)
+{
+  assert(!folders.empty());
+
+  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType());
+  const std::string basename = std::to_string(viewId);
+
+  std::string featFilename;
+  std::string descFilename;
+  std::string regionsFilename;
 
-  ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
-  ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+  if(!findRegionsFiles(folders, viewId, imageDescriber.getDescriberType(), featFilename, descFilename, regionsFilename))
+    throw std::runtime_error("Can't find view " + basename + " region files");
 
   std::unique_ptr<feature::Regions> regionsPtr;
   imageDescriber.allocate(regionsPtr);
 
   try
   {
-    regionsPtr->Load(featFilename, descFilename);
+    if(!regionsFilename.empty())
+    {
+      ALICEVISION_LOG_TRACE("Regions filename: " << regionsFilename);
+
+      if(memoryMapped)
+        regionsPtr.reset(regionsPtr->MappedClone(regionsFilename));
+      else
+        regionsPtr->LoadBinary(regionsFilename);
+    }
+    else
+    {
+      ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
+      ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+
+      regionsPtr->Load(featFilename, descFilename);
+    }
   }
   catch(const std::exception& e)
   {
     std::stringstream ss;
     ss << "Invalid " << imageDescriberTypeName << " regions files for the view " << basename << " : \n";
-    ss << "\t- Features file : " << featFilename << "\n";
-    ss << "\t- Descriptors file: " << descFilename << "\n";
+    if(!regionsFilename.empty())
+    {
+      ss << "\t- Regions file : " << regionsFilename << "\n";
+    }
+    else
+    {
+      ss << "\t- Features file : " << featFilename << "\n";
+      ss << "\t- Descriptors file: " << descFilename << "\n";
+    }
     ss << "\t  " << e.what() << "\n";
     ALICEVISION_LOG_ERROR(ss.str());
 
@@ -81,12 +174,23 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
   const std::string basename = std::to_string(viewId);
 
   std::string featFilename;
+  bool isBinary = false;
 
   for(const std::string& folder : folders)
   {
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
-    if(fs::exists(featPath))
+    const fs::path regionsPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".regions");
+
+    if(useBinaryRegionsFile(regionsPath, {featPath}))
+    {
+      featFilename = regionsPath.string();
+      isBinary = true;
+    }
+    else if(fs::exists(featPath))
+    {
       featFilename = featPath.string();
+      isBinary = false;
+    }
   }
 
   if(featFilename.empty())
@@ -99,7 +203,10 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
 
   try
   {
-    regionsPtr->LoadFeatures(featFilename);
+    if(isBinary)
+      regionsPtr->LoadFeaturesBinary(featFilename);
+    else
+      regionsPtr->LoadFeatures(featFilename);
   }
   catch(const std::exception& e)
   {
@@ -206,5 +313,33 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
 }
 
   
+std::string computeRegionsUID(const std::vector<std::string>& folders,
+                              IndexT viewId,
+                              const std::vector<feature::EImageDescriberType>& imageDescriberTypes)
+{
+  ContentKey uid;
+  for(const feature::EImageDescriberType imageDescriberType : imageDescriberTypes)
+  {
+    std::string featFilename;
+    std::string descFilename;
+    std::string regionsFilename;
+
+    if(!findRegionsFiles(folders, viewId, imageDescriberType, featFilename, descFilename, regionsFilename))
+      throw std::runtime_error("Can't find view " + std::to_string(viewId) + " region files");
+
+    uid.add(feature::EImageDescriberType_enumToString(imageDescriberType));
+    if(!regionsFilename.empty())
+    {
+      uid.add(computeFileUID(regionsFilename));
+    }
+    else
+    {
+      uid.add(computeFileUID(featFilename));
+      uid.add(computeFileUID(descFilename));
+    }
+  }
+  return uid.digest();
+}
+
 } // namespace sfm
 } // namespace aliceVision
@@ -21,12 +21,16 @@ namespace sfm {
 
 /**
  * @brief Load Regions (Features & Descriptors) for one view.
+ * @note A binary regions file (.regions) is used instead of the text features (.feat)
+ *       and descriptors (.desc) files if it exists. If both formats exist in the same
+ *       folder, the most recently written one is used.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
+ * @param[in] memoryMapped Use read-only regions directly backed by the memory-mapped binary regions file
  * @return loaded Regions
  */
-std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber);
+std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber, bool memoryMapped = false);
 
 /**
  * @brief Load Features for one view.
@@ -65,5 +69,18 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                          const std::vector<std::string>& folders,
                          const std::vector<feature::EImageDescriberType>& imageDescriberTypes);
 
+/**
+ * @brief Compute a UID from the content of the regions files of one view.
+ * @note The binary regions file (.regions) and the text features and descriptors
+ *       files (.feat, .desc) of the same regions have different UIDs.
+ * @param[in] folders The feature Folders
+ * @param[in] viewId The view id
+ * @param[in] imageDescriberTypes The imageDescriber types
+ * @return the regions UID (hexadecimal SHA-256 digest)
+ */
+std::string computeRegionsUID(const std::vector<std::string>& folders,
+                              IndexT viewId,
+                              const std::vector<feature::EImageDescriberType>& imageDescriberTypes);
+
 } // namespace sfm
 } // namespace aliceVision
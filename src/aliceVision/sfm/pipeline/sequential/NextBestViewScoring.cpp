@@ -0,0 +1,237 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "NextBestViewScoring.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace aliceVision {
+namespace sfm {
+
+void NextBestViewScoring::initialize(const track::CompactTracks& tracks,
+                                     const Views& views,
+                                     const feature::FeaturesPerView& featuresProvider,
+                                     std::size_t pyramidBase,
+                                     const std::vector<int>& pyramidWeights)
+{
+  _tracks = &tracks;
+  _pyramidWeights = pyramidWeights;
+
+  const std::size_t pyramidDepth = _pyramidWeights.size();
+  std::vector<std::size_t> widthPerLevel(pyramidDepth);
+  std::vector<std::size_t> startPerLevel(pyramidDepth);
+  _nbCells = 0;
+  for(std::size_t level = 0; level < pyramidDepth; ++level)
+  {
+    startPerLevel[level] = _nbCells;
+    widthPerLevel[level] = std::pow(pyramidBase, level + 1);
+    _nbCells += Square(widthPerLevel[level]);
+  }
+
+  // cell size of each level for each view
+  const std::vector<IndexT>& trackViews = tracks.views();
+  std::vector<double> cellWidths(trackViews.size() * pyramidDepth);
+  std::vector<double> cellHeights(trackViews.size() * pyramidDepth);
+  for(std::size_t v = 0; v < trackViews.size(); ++v)
+  {
+    const View& view = *views.at(trackViews[v]);
+    for(std::size_t level = 0; level < pyramidDepth; ++level)
+    {
+      cellWidths[v * pyramidDepth + level] = (double)view.getWidth() / (double)widthPerLevel[level];
+      cellHeights[v * pyramidDepth + level] = (double)view.getHeight() / (double)widthPerLevel[level];
+    }
+  }
+
+  _obsViewIndexes.resize(tracks.nbObservations());
+  _obsCells.resize(tracks.nbObservations() * pyramidDepth);
+
+  #pragma omp parallel for
+  for(std::ptrdiff_t t = 0; t < static_cast<std::ptrdiff_t>(tracks.nbTracks()); ++t)
+  {
+    const IndexT trackIndex = static_cast<IndexT>(t);
+    const track::CompactTracks::Range<IndexT> viewIds = tracks.trackViews(trackIndex);
+    const track::CompactTracks::Range<IndexT> featIds = tracks.trackFeatures(trackIndex);
+    const std::size_t begin = tracks.trackBegin(trackIndex);
+
+    for(std::size_t i = 0; i < viewIds.size(); ++i)
+    {
+      const std::size_t obs = begin + i;
+      const IndexT v = viewIndex(viewIds[i]);
+      const auto& feature = featuresProvider.getFeatures(viewIds[i], tracks.descType(trackIndex))[featIds[i]];
+      _obsViewIndexes[obs] = v;
+
+      for(std::size_t level = 0; level < pyramidDepth; ++level)
+      {
+        std::size_t xCell = std::floor(std::max(feature.x(), 0.0f) / cellWidths[v * pyramidDepth + level]);
+        std::size_t yCell = std::floor(std::max(feature.y(), 0.0f) / cellHeights[v * pyramidDepth + level]);
+        xCell = std::min(xCell, widthPerLevel[level] - 1);
+        yCell = std::min(yCell, widthPerLevel[level] - 1);
+        _obsCells[obs * pyramidDepth + level] = startPerLevel[level] + xCell + yCell * widthPerLevel[level];
+      }
+    }
+  }
+
+  _isReconstructed.assign(tracks.nbTracks(), 0);
+
+  _nbTracks.assign(trackViews.size(), 0);
+  _scores.assign(trackViews.size(), 0);
+  _cellCounts.assign(trackViews.size(), std::vector<uint32_t>());
+  _rankedScores.assign(trackViews.size(), 0);
+  _isModified.assign(trackViews.size(), 0);
+  _modifiedViews.clear();
+  _rankedViews.clear();
+}
+
+void NextBestViewScoring::addTrack(IndexT trackId)
+{
+  assert(_tracks != nullptr);
+  const IndexT trackIndex = _tracks->trackIndex(trackId);
+  if(trackIndex != UndefinedIndexT && !_isReconstructed[trackIndex])
+    setTrackReconstructed(trackIndex, true);
+}
+
+void NextBestViewScoring::removeTrack(IndexT trackId)
+{
+  assert(_tracks != nullptr);
+  const IndexT trackIndex = _tracks->trackIndex(trackId);
+  if(trackIndex != UndefinedIndexT && _isReconstructed[trackIndex])
+    setTrackReconstructed(trackIndex, false);
+}
+
+void NextBestViewScoring::clearTracks()
+{
+  std::fill(_isReconstructed.begin(), _isReconstructed.end(), 0);
+  std::fill(_nbTracks.begin(), _nbTracks.end(), 0);
+  std::fill(_scores.begin(), _scores.end(), 0);
+  for(std::vector<uint32_t>& cellCounts : _cellCounts)
+    std::fill(cellCounts.begin(), cellCounts.end(), 0);
+
+  // all the ranked views are removed
+  for(IndexT v = 0; v < _rankedScores.size(); ++v)
+  {
+    if(_rankedScores[v] > 0 && !_isModified[v])
+    {
+      _isModified[v] = 1;
+      _modifiedViews.push_back(v);
+    }
+  }
+}
+
+std::size_t NextBestViewScoring::nbReconstructedTracks(IndexT viewId) const
+{
+  const IndexT v = viewIndex(viewId);
+  return (v == UndefinedIndexT) ? 0 : _nbTracks[v];
+}
+
+std::size_t NextBestViewScoring::score(IndexT viewId) const
+{
+  const IndexT v = viewIndex(viewId);
+  return (v == UndefinedIndexT) ? 0 : _scores[v];
+}
+
+std::size_t NextBestViewScoring::computeScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const
+{
+  const std::size_t pyramidDepth = _pyramidWeights.size();
+  std::vector<char> occupiedCells(_nbCells, 0);
+  std::size_t score = 0;
+
+  for(const std::size_t trackId : trackIds)
+  {
+    const IndexT trackIndex = _tracks->trackIndex(trackId);
+    assert(trackIndex != UndefinedIndexT);
+
+    const track::CompactTracks::Range<IndexT> viewIds = _tracks->trackViews(trackIndex);
+    const IndexT* it = std::lower_bound(viewIds.begin(), viewIds.end(), viewId);
+    assert(it != viewIds.end() && *it == viewId);
+    const std::size_t obs = _tracks->trackBegin(trackIndex) + (it - viewIds.begin());
+
+    for(std::size_t level = 0; level < pyramidDepth; ++level)
+    {
+      char& occupied = occupiedCells[_obsCells[obs * pyramidDepth + level]];
+      if(!occupied)
+      {
+        occupied = 1;
+        score += _pyramidWeights[level];
+      }
+    }
+  }
+  return score;
+}
+
+IndexT NextBestViewScoring::viewIndex(IndexT viewId) const
+{
+  const std::vector<IndexT>& views = _tracks->views();
+  const auto it = std::lower_bound(views.begin(), views.end(), viewId);
+  if(it == views.end() || *it != viewId)
+    return UndefinedIndexT;
+  return static_cast<IndexT>(it - views.begin());
+}
+
+void NextBestViewScoring::setTrackReconstructed(IndexT trackIndex, bool reconstructed)
+{
+  const std::size_t pyramidDepth = _pyramidWeights.size();
+  _isReconstructed[trackIndex] = reconstructed;
+
+  for(std::size_t obs = _tracks->trackBegin(trackIndex); obs < _tracks->trackEnd(trackIndex); ++obs)
+  {
+    const IndexT v = _obsViewIndexes[obs];
+    std::vector<uint32_t>& cellCounts = _cellCounts[v];
+    if(cellCounts.empty())
+      cellCounts.resize(_nbCells, 0);
+
+    // the score changes only when a cell becomes occupied or empty
+    for(std::size_t level = 0; level < pyramidDepth; ++level)
+    {
+      uint32_t& count = cellCounts[_obsCells[obs * pyramidDepth + level]];
+      if(reconstructed)
+      {
+        if(count++ == 0)
+          _scores[v] += _pyramidWeights[level];
+      }
+      else
+      {
+        assert(count > 0);
+        if(--count == 0)
+          _scores[v] -= _pyramidWeights[level];
+      }
+    }
+    if(reconstructed)
+      ++_nbTracks[v];
+    else
+      --_nbTracks[v];
+
+    if(!_isModified[v])
+    {
+      _isModified[v] = 1;
+      _modifiedViews.push_back(v);
+    }
+  }
+}
+
+void NextBestViewScoring::update()
+{
+  const std::vector<IndexT>& views = _tracks->views();
+
+  for(const IndexT v : _modifiedViews)
+  {
+    _isModified[v] = 0;
+    if(_rankedScores[v] == _scores[v])
+      continue;
+    if(_rankedScores[v] > 0)
+      _rankedViews.erase(std::make_pair(_rankedScores[v], views[v]));
+    if(_scores[v] > 0)
+      _rankedViews.emplace(_scores[v], views[v]);
+    _rankedScores[v] = _scores[v];
+  }
+  _modifiedViews.clear();
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,136 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/feature/FeaturesPerView.hpp>
+#include <aliceVision/track/CompactTracks.hpp>
+#include <aliceVision/types.hpp>
+
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Incremental scoring of the views for the next best view selection.
+ *
+ * The score of a view is based on a pyramid grid of the image: each cell of each level
+ * containing at least one reconstructed track adds the weight of its level to the score.
+ * This promotes a good repartition of the features in the image (instead of relying
+ * only on the number of features). Inspired by [Schonberger 2016]:
+ * "Structure-from-Motion Revisited", Johannes L. Schonberger, Jan-Michael Frahm
+ *
+ * The number of reconstructed tracks per view and the number of reconstructed tracks
+ * per pyramid cell are stored as counters, updated by the events of the reconstruction
+ * (addTrack / removeTrack), so only the views of the added or removed tracks are updated.
+ * The views are kept sorted by score in a priority queue (rankedViews()).
+ */
+class NextBestViewScoring
+{
+public:
+  /// Sort by decreasing score then by increasing view id
+  struct ScoreCompare
+  {
+    bool operator()(const std::pair<std::size_t, IndexT>& a, const std::pair<std::size_t, IndexT>& b) const
+    {
+      return (a.first > b.first) || (a.first == b.first && a.second < b.second);
+    }
+  };
+
+  /// Views with at least one reconstructed track: <score, viewId>
+  using RankedViews = std::set<std::pair<std::size_t, IndexT>, ScoreCompare>;
+
+  /**
+   * @brief Precompute the pyramid cells of all the observations of the tracks
+   * @param[in] tracks all the putative tracks, must outlive the scoring
+   * @param[in] views all views
+   * @param[in] featuresProvider input features
+   * @param[in] pyramidBase number of cells per dimension is pyramidBase^(level+1)
+   * @param[in] pyramidWeights weight of each level of the pyramid (gives the depth of the pyramid)
+   */
+  void initialize(const track::CompactTracks& tracks,
+                  const Views& views,
+                  const feature::FeaturesPerView& featuresProvider,
+                  std::size_t pyramidBase,
+                  const std::vector<int>& pyramidWeights);
+
+  /**
+   * @brief A track has been reconstructed (landmarkId == trackId).
+   * Nothing is done if the track is unknown or already reconstructed.
+   * @param[in] trackId the track id
+   */
+  void addTrack(IndexT trackId);
+
+  /**
+   * @brief A track has been removed from the reconstruction (landmarkId == trackId).
+   * Nothing is done if the track is unknown or not reconstructed.
+   * @param[in] trackId the track id
+   */
+  void removeTrack(IndexT trackId);
+
+  /// Remove all the tracks from the reconstruction
+  void clearTracks();
+
+  /// Update the position in the ranked views of the views modified since the last call
+  void update();
+
+  /// @return the number of reconstructed tracks visible in a view
+  std::size_t nbReconstructedTracks(IndexT viewId) const;
+
+  /// @return the pyramid score of a view for the reconstructed tracks
+  std::size_t score(IndexT viewId) const;
+
+  /// @return the views with at least one reconstructed track, best score first
+  const RankedViews& rankedViews() const { return _rankedViews; }
+
+  /**
+   * @brief Compute the pyramid score of a view for a subset of tracks (not incremental)
+   * @param[in] viewId the view id
+   * @param[in] trackIds the tracks, all visible in the view
+   * @return the score
+   */
+  std::size_t computeScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const;
+
+private:
+  /// @return the index of a view in the tracks views or UndefinedIndexT
+  IndexT viewIndex(IndexT viewId) const;
+
+  /// Update the counters of all the views of a track
+  void setTrackReconstructed(IndexT trackIndex, bool reconstructed);
+
+  const track::CompactTracks* _tracks = nullptr;
+  std::vector<int> _pyramidWeights;
+  std::size_t _nbCells = 0;
+
+  // per observation of the tracks (aligned with the tracks observations)
+  /// index of the view of the observation
+  std::vector<IndexT> _obsViewIndexes;
+  /// cell of the observation for each level of the pyramid
+  std::vector<uint32_t> _obsCells;
+
+  // per track
+  std::vector<char> _isReconstructed;
+
+  // per view (index in the tracks views)
+  std::vector<std::size_t> _nbTracks;
+  std::vector<std::size_t> _scores;
+  /// number of reconstructed tracks per cell, allocated with the first track
+  std::vector<std::vector<uint32_t>> _cellCounts;
+  /// score of the view in the ranked views (0 if not ranked)
+  std::vector<std::size_t> _rankedScores;
+  std::vector<char> _isModified;
+  std::vector<IndexT> _modifiedViews;
+
+  RankedViews _rankedViews;
+};
+
+} // namespace sfm
+} // namespace aliceVision
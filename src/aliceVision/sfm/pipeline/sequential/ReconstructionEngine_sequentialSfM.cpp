@@ -25,7 +25,9 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cpu.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 
@@ -49,78 +51,6 @@ namespace sfm {
 using namespace aliceVision::geometry;
 using namespace aliceVision::camera;
 
-/**
- * @brief Compute indexes of all features in a fixed size pyramid grid.
- * These precomputed values are useful to the next best view selection for incremental SfM.
- *
- * @param[in] tracksPerView: The list of TrackID per view
- * @param[in] map_tracks: All putative tracks
- * @param[in] views: All views
- * @param[in] featuresProvider: Input features and descriptors
- * @param[in] pyramidDepth: Depth of the pyramid.
- * @param[out] tracksPyramidPerView:
- *             Precomputed list of pyramid cells ID for each track in each view.
- */
-void computeTracksPyramidPerView(
-    const track::TracksPerView& tracksPerView,
-    const track::TracksMap& map_tracks,
-    const Views& views,
-    const feature::FeaturesPerView& featuresProvider,
-    const std::size_t pyramidBase,
-    const std::size_t pyramidDepth,
-    track::TracksPyramidPerView& tracksPyramidPerView)
-{
-  std::vector<std::size_t> widthPerLevel(pyramidDepth);
-  std::vector<std::size_t> startPerLevel(pyramidDepth);
-  std::size_t start = 0;
-  for(std::size_t level = 0; level < pyramidDepth; ++level)
-  {
-    startPerLevel[level] = start;
-    widthPerLevel[level] = std::pow(pyramidBase, level+1);
-    start += Square(widthPerLevel[level]);
-  }
-
-  tracksPyramidPerView.reserve(tracksPerView.size());
-  for(const auto& viewTracks: tracksPerView)
-  {
-    auto& trackPyramid = tracksPyramidPerView[viewTracks.first];
-    // reserve 500 tracks in each view
-    trackPyramid.reserve(500 * pyramidDepth);
-  }
-
-  for(const auto& viewTracks: tracksPerView)
-  {
-    const auto viewId = viewTracks.first;
-    auto& tracksPyramidIndex = tracksPyramidPerView[viewId];
-    const View& view = *views.at(viewId).get();
-    std::vector<double> cellWidthPerLevel(pyramidDepth);
-    std::vector<double> cellHeightPerLevel(pyramidDepth);
-    for(std::size_t level = 0; level < pyramidDepth; ++level)
-    {
-      cellWidthPerLevel[level] = (double)view.getWidth() / (double)widthPerLevel[level];
-      cellHeightPerLevel[level] = (double)view.getHeight() / (double)widthPerLevel[level];
-    }
-    for(std::size_t i = 0; i < viewTracks.second.size(); ++i)
-    {
-      const std::size_t trackId = viewTracks.second[i];
-      const track::Track& track = map_tracks.at(trackId);
-      const std::size_t featIndex = track.featPerView.at(viewId);
-      const auto& feature = featuresProvider.getFeatures(viewId, track.descType)[featIndex]; 
-      
-      for(std::size_t level = 0; level < pyramidDepth; ++level)
-      {
-        std::size_t xCell = std::floor(std::max(feature.x(), 0.0f) / cellWidthPerLevel[level]);
-        std::size_t yCell = std::floor(std::max(feature.y(), 0.0f) / cellHeightPerLevel[level]);
-        xCell = std::min(xCell, widthPerLevel[level] - 1);
-        yCell = std::min(yCell, widthPerLevel[level] - 1);
-        const std::size_t levelIndex = xCell + yCell * widthPerLevel[level];
-        assert(levelIndex < Square(widthPerLevel[level]));
-        tracksPyramidIndex[trackId * pyramidDepth + level] = startPerLevel[level] + levelIndex;
-      }
-    }
-  }
-}
-
 ReconstructionEngine_sequentialSfM::ReconstructionEngine_sequentialSfM(
   const SfMData & sfm_data,
   const std::string & soutDirectory,
@@ -166,6 +96,15 @@ bool ReconstructionEngine_sequentialSfM::process()
     // and update the landmarkIds accordingly.
     // Note: each landmark has a corresponding track with the same id (landmarkId == trackId).
     remapLandmarkIdsToTrackIds();
+
+    // extension of an existing reconstruction:
+    // only the new views are resected, the bundle adjustments are restricted to their neighbourhood
+    _extendReconstruction = true;
+    if(_localBundleAdjustmentOnExtension && !_uselocalBundleAdjustment)
+    {
+      ALICEVISION_LOG_INFO("Extension of an existing reconstruction: use the local bundle adjustment.");
+      setUseLocalBundleAdjustmentStrategy(true);
+    }
   }
 
   // reconstruction
@@ -200,7 +139,7 @@ void ReconstructionEngine_sequentialSfM::initializePyramidScoring()
 std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
 {
   // compute tracks from matches
-  track::TracksBuilder tracksBuilder;
+  track::ParallelTracksBuilder tracksBuilder;
 
   {
     // list of features matches for each couple of images
@@ -216,25 +155,24 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
     }
 
     ALICEVISION_LOG_DEBUG("Track export to internal structure");
-    // build tracks with STL compliant type
-    tracksBuilder.exportToSTL(_map_tracks);
-    ALICEVISION_LOG_DEBUG("Build tracks per view");
-    track::tracksUtilsMap::computeTracksPerView(_map_tracks, _map_tracksPerView);
+    {
+      // build tracks with STL compliant type, only kept until the compact tracks are built
+      track::TracksMap tracks;
+      tracksBuilder.exportToSTL(tracks);
+      // also builds the tracks per view reverse index
+      _compactTracks.build(tracks);
+    }
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
-    computeTracksPyramidPerView(
-            _map_tracksPerView, _map_tracks, _sfmData.views, *_featuresPerView, _pyramidBase, _pyramidDepth, _map_featsPyramidPerView);
+    _nextBestViewScoring.initialize(_compactTracks, _sfmData.views, *_featuresPerView, _pyramidBase, _pyramidWeights);
 
     // display stats
     {
-      std::set<size_t> imagesId;
-      track::tracksUtilsMap::imageIdInTracks(_map_tracksPerView, imagesId);
-
       ALICEVISION_LOG_INFO("Fuse matches into tracks: " << std::endl
         << "\t- # tracks: " << tracksBuilder.nbTracks() << std::endl
-        << "\t- # images in tracks: " << imagesId.size());
+        << "\t- # images in tracks: " << _compactTracks.views().size());
 
       std::map<size_t, size_t> map_Occurence_TrackLength;
-      track::tracksUtilsMap::tracksLength(_map_tracks, map_Occurence_TrackLength);
+      track::tracksUtilsMap::tracksLength(_compactTracks, map_Occurence_TrackLength);
       ALICEVISION_LOG_INFO("TrackLength, Occurrence");
       for(const auto& iter: map_Occurence_TrackLength)
       {
@@ -244,7 +182,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
       }
     }
   }
-  return _map_tracks.size();
+  return _compactTracks.nbTracks();
 }
 
 std::vector<Pair> ReconstructionEngine_sequentialSfM::getInitialImagePairsCandidates()
@@ -281,57 +219,107 @@ void ReconstructionEngine_sequentialSfM::createInitialReconstruction(const std::
 
 void ReconstructionEngine_sequentialSfM::remapLandmarkIdsToTrackIds()
 {
-  using namespace track;
-
   // get unmap landmarks
   Landmarks landmarks;
 
   // clear sfmData structure and store them locally
   std::swap(landmarks, _sfmData.getLandmarks());
 
-  // builds landmarks temporary comparison structure
-  // ObsKey <ViewId, FeatId, decType>
-  // ObsToLandmark <ObsKey, LandmarkId>
-  using ObsKey = std::tuple<IndexT, IndexT, feature::EImageDescriberType>;
-  using ObsToLandmark = std::map<ObsKey, IndexT>;
+  // views observing the landmarks
+  std::vector<IndexT> landmarkViews;
+  {
+    std::set<IndexT> landmarkViewsSet;
+    for(const auto& landmarkPair : landmarks)
+    {
+      for(const auto& observationPair : landmarkPair.second.observations)
+        landmarkViewsSet.insert(observationPair.first);
+    }
+    landmarkViews.assign(landmarkViewsSet.begin(), landmarkViewsSet.end());
+  }
 
-  ObsToLandmark obsToLandmark;
+  ALICEVISION_LOG_DEBUG("Builds the feature to track index of the " << landmarkViews.size() << " views observing the landmarks");
 
-  ALICEVISION_LOG_DEBUG("Builds landmarks temporary comparison structure");
+  // feature to track index of each view: <descType, featureId, trackIndex> sorted by descType and featureId
+  using FeatureTrack = std::tuple<feature::EImageDescriberType, IndexT, IndexT>;
+  std::vector<std::vector<FeatureTrack>> featureTracksPerView(landmarkViews.size());
 
-  for(const auto& landmarkPair : landmarks)
+  #pragma omp parallel for schedule(dynamic)
+  for(std::ptrdiff_t v = 0; v < static_cast<std::ptrdiff_t>(landmarkViews.size()); ++v)
   {
-    const IndexT landmarkId = landmarkPair.first;
-    const IndexT firstViewId = landmarkPair.second.observations.begin()->first;
-    const IndexT firstFeatureId = landmarkPair.second.observations.begin()->second.id_feat;
-    const feature::EImageDescriberType descType = landmarkPair.second.descType;
-
-    obsToLandmark.emplace(ObsKey(firstViewId, firstFeatureId, descType), landmarkId);
+    const IndexT viewId = landmarkViews.at(v);
+    std::vector<FeatureTrack>& featureTracks = featureTracksPerView.at(v);
+    const track::CompactTracks::Range<IndexT> trackIndexes = _compactTracks.tracksInView(viewId);
+
+    featureTracks.reserve(trackIndexes.size());
+    for(const IndexT trackIndex : trackIndexes)
+      featureTracks.emplace_back(_compactTracks.descType(trackIndex), _compactTracks.featureInView(trackIndex, viewId), trackIndex);
+    std::sort(featureTracks.begin(), featureTracks.end());
   }
 
-  ALICEVISION_LOG_DEBUG("Find corresponding landmark id per track id");
+  ALICEVISION_LOG_DEBUG("Find the corresponding track of each landmark");
 
-  // find corresponding landmark id per track id
-  for(const auto& trackPair : _map_tracks)
+  // the track of a landmark is the one containing most of its observations
+  std::vector<const Landmarks::value_type*> landmarkPtrs;
+  landmarkPtrs.reserve(landmarks.size());
+  for(const auto& landmarkPair : landmarks)
+    landmarkPtrs.push_back(&landmarkPair);
+
+  std::vector<IndexT> trackIndexPerLandmark(landmarkPtrs.size(), UndefinedIndexT);
+  std::vector<std::size_t> nbVotesPerLandmark(landmarkPtrs.size(), 0);
+
+  #pragma omp parallel for
+  for(std::ptrdiff_t l = 0; l < static_cast<std::ptrdiff_t>(landmarkPtrs.size()); ++l)
   {
-    const IndexT trackId = trackPair.first;
-    const Track& track = trackPair.second;
+    const Landmark& landmark = landmarkPtrs.at(l)->second;
+    std::map<IndexT, std::size_t> votes;
 
-    for(const auto& featView : track.featPerView)
+    for(const auto& observationPair : landmark.observations)
     {
-      const ObsToLandmark::const_iterator it = obsToLandmark.find(ObsKey(featView.first, featView.second, track.descType));
+      const auto viewIt = std::lower_bound(landmarkViews.begin(), landmarkViews.end(), observationPair.first);
+      const std::vector<FeatureTrack>& featureTracks = featureTracksPerView.at(viewIt - landmarkViews.begin());
+      const FeatureTrack key(landmark.descType, observationPair.second.id_feat, 0);
+      const auto it = std::lower_bound(featureTracks.begin(), featureTracks.end(), key);
+
+      if(it != featureTracks.end() &&
+         std::get<0>(*it) == landmark.descType &&
+         std::get<1>(*it) == observationPair.second.id_feat)
+      {
+        ++votes[std::get<2>(*it)];
+      }
+    }
 
-      if(it != obsToLandmark.end())
+    for(const auto& vote : votes)
+    {
+      if(vote.second > nbVotesPerLandmark.at(l))
       {
-        // re-insert the landmark with the new id
-        _sfmData.getLandmarks().emplace(trackId, landmarks.find(it->second)->second);
-        break; //one landmark per track
+        trackIndexPerLandmark.at(l) = vote.first;
+        nbVotesPerLandmark.at(l) = vote.second;
       }
     }
   }
 
+  // re-insert the landmarks with the new ids, one landmark per track (the one with most observations in the track)
+  std::map<IndexT, std::size_t> landmarkPerTrack;
+  for(std::size_t l = 0; l < landmarkPtrs.size(); ++l)
+  {
+    const IndexT trackIndex = trackIndexPerLandmark.at(l);
+    if(trackIndex == UndefinedIndexT)
+      continue;
+
+    const auto it = landmarkPerTrack.emplace(trackIndex, l);
+    if(!it.second && nbVotesPerLandmark.at(l) > nbVotesPerLandmark.at(it.first->second))
+      it.first->second = l;
+  }
+
+  for(const auto& trackLandmark : landmarkPerTrack)
+  {
+    const IndexT trackId = _compactTracks.trackId(trackLandmark.first);
+    _sfmData.getLandmarks().emplace(trackId, landmarkPtrs.at(trackLandmark.second)->second);
+    _nextBestViewScoring.addTrack(trackId);
+  }
+
   ALICEVISION_LOG_INFO("Landmark ids to track ids reampping: " << std::endl
-                        << "\t- # tracks: " << _map_tracks.size() << std::endl
+                        << "\t- # tracks: " << _compactTracks.nbTracks() << std::endl
                         << "\t- # input landmarks: " << landmarks.size() << std::endl
                         << "\t- # output landmarks: " << _sfmData.getLandmarks().size());
 }
@@ -353,7 +341,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
       viewIds.insert(viewId);
 
     if(viewResectionId != UndefinedIndexT &&
-       viewResectionId > resectionId)
+       viewResectionId >= resectionId)
     {
       resectionId = viewResectionId + 1;
     }
@@ -391,9 +379,14 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
 
     updateReconstruction(resectionId, bestViewIds, viewIds);
 
+    if(_compactInactiveLandmarks && _uselocalBundleAdjustment)
+      storeInactiveLandmarks(viewIds);
+
     ++resectionId;
   }
 
+  restoreInactiveLandmarks();
+
   return timer.elapsed();
 }
 
@@ -405,8 +398,12 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
   // get reconstructed views before resection
   const std::set<IndexT> prevReconstructedViews = _sfmData.getValidViews();
 
+  // resection results, applied to the scene in the order of the views
+  std::vector<ResectionData, Eigen::aligned_allocator<ResectionData>> resectionDataPerView(bestViewIds.size());
+  std::vector<char> hasResectedPerView(bestViewIds.size(), 0);
+
   // add images to the 3D reconstruction
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic)
   for(int i = 0; i < bestViewIds.size(); ++i)
   {
     const IndexT viewId = bestViewIds.at(i);
@@ -422,10 +419,6 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
 
@@ -441,32 +434,30 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
           << "\t- view id: " << viewId << std::endl
           << "\t- rig id: " << view.getRigId() << std::endl
           << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        viewIds.erase(viewId);
-
         continue;
       }
     }
 
-    ResectionData newResectionData;
-    const bool hasResected = computeResection(viewId, newResectionData);
+    // random numbers of the robust resection only depend on the view
+    system::RandomTaskScope randomTask(viewId);
+    hasResectedPerView[i] = computeResection(viewId, resectionDataPerView[i]);
+  }
 
-#pragma omp critical
+  for(std::size_t i = 0; i < bestViewIds.size(); ++i)
+  {
+    const IndexT viewId = bestViewIds[i];
+    if(hasResectedPerView[i])
     {
-      if(hasResected)
-      {
-        imageAdded |= hasResected;
-        updateScene(viewId, newResectionData);
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
-        _sfmData.getViews().at(viewId)->setResectionId(resectionId);
-      }
-      else
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
-      }
-      viewIds.erase(viewId);
+      imageAdded = true;
+      updateScene(viewId, resectionDataPerView[i]);
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+      _sfmData.getViews().at(viewId)->setResectionId(resectionId);
     }
+    else
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+    }
+    viewIds.erase(viewId);
   }
 
   ALICEVISION_LOG_DEBUG("Resection of " << bestViewIds.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
@@ -534,7 +525,11 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
     chrono_start = std::chrono::steady_clock::now();
 
     std::set<IndexT> removedPosesId;
-    bool contentRemoved = eraseUnstablePosesAndObservations(this->_sfmData, _minPointsPerPose, _minTrackLength, &removedPosesId);
+    std::set<IndexT> removedLandmarksId;
+    bool contentRemoved = eraseUnstablePosesAndObservations(this->_sfmData, _minPointsPerPose, _minTrackLength, &removedPosesId, &_inactiveObservationsPerPose, &removedLandmarksId);
+
+    for(const IndexT landmarkId : removedLandmarksId)
+      _nextBestViewScoring.removeTrack(landmarkId);
 
     if (_uselocalBundleAdjustment && contentRemoved)
     {
@@ -650,93 +645,74 @@ void ReconstructionEngine_sequentialSfM::exportStatistics(double reconstructionT
 
 bool ReconstructionEngine_sequentialSfM::findConnectedViews(
   std::vector<ViewConnectionScore>& out_connectedViews,
-  const std::set<IndexT>& remainingViewIds) const
+  const std::set<IndexT>& remainingViewIds)
 {
   out_connectedViews.clear();
 
   if (remainingViewIds.empty() || _sfmData.getLandmarks().empty())
     return false;
 
-  // Collect tracksIds
-  std::set<size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
+  // rank the views modified by the tracks added or removed since the last call
+  _nextBestViewScoring.update();
 
   const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
 
-#pragma omp parallel for
-  for(int i = 0; i < remainingViewIds.size(); ++i)
+  // The views are ranked by an image score based on the number of matches to the 3D scene
+  // and the repartition of these features in the image.
+  for(const auto& rankedView : _nextBestViewScoring.rankedViews())
   {
-    std::set<IndexT>::const_iterator iter = remainingViewIds.cbegin();
-    std::advance(iter, i);
-    const IndexT viewId = *iter;
-    const IndexT intrinsicId = _sfmData.getViews().at(viewId)->getIntrinsicId();
-    const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
-
-    // Compute 2D - 3D possible content
-    aliceVision::track::TracksPerView::const_iterator tracksIdsIt = _map_tracksPerView.find(viewId);
-    if(tracksIdsIt == _map_tracksPerView.end())
+    const IndexT viewId = rankedView.second;
+    if(!remainingViewIds.count(viewId))
       continue;
 
-    const aliceVision::track::TrackIdSet& set_tracksIds = tracksIdsIt->second;
-    if (set_tracksIds.empty())
-      continue;
+    const View& view = *_sfmData.views.at(viewId);
 
     // Check if the view is part of a rig
+    if(view.isPartOfRig())
     {
-      const View& view = *_sfmData.views.at(viewId);
-
-      if(view.isPartOfRig())
+      // Some views can become indirectly localized when the sub-pose becomes defined
+      if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
       {
-        // Some views can become indirectly localized when the sub-pose becomes defined
-        if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
-        {
-          continue;
-        }
+        continue;
+      }
 
-        // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
-        const bool knownPose = _sfmData.existsPose(view);
-        const Rig& rig = _sfmData.getRig(view);
-        const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+      // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
+      const bool knownPose = _sfmData.existsPose(view);
+      const Rig& rig = _sfmData.getRig(view);
+      const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
 
-        if(rig.isInitialized() &&
-           !knownPose &&
-           (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
-        {
-          continue;
-        }
+      if(rig.isInitialized() &&
+         !knownPose &&
+         (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+      {
+        continue;
       }
     }
 
-    // Count the common possible putative point
-    //  with the already 3D reconstructed trackId
-    std::vector<std::size_t> vec_trackIdForResection;
-    vec_trackIdForResection.reserve(set_tracksIds.size());
-    std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                          reconstructed_trackId.begin(),
-                          reconstructed_trackId.end(),
-                          std::back_inserter(vec_trackIdForResection));
-    // Compute an image score based on the number of matches to the 3D scene
-    // and the repartition of these features in the image.
-    std::size_t score = computeImageScore(viewId, vec_trackIdForResection);
-#pragma omp critical
-    {
-      out_connectedViews.emplace_back(viewId, vec_trackIdForResection.size(), score, isIntrinsicsReconstructed);
-    }
+    const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(view.getIntrinsicId());
+    // number of the common possible putative points with the already 3D reconstructed trackIds
+    const std::size_t nbTracks = _nextBestViewScoring.nbReconstructedTracks(viewId);
+#ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
+    const std::size_t score = nbTracks;
+#else
+    const std::size_t score = rankedView.first;
+#endif
+    out_connectedViews.emplace_back(viewId, nbTracks, score, isIntrinsicsReconstructed);
   }
 
-  // Sort by the image score
-  std::sort(out_connectedViews.begin(), out_connectedViews.end(),
-            [](const ViewConnectionScore& t1, const ViewConnectionScore& t2) {
+#ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
+  // Sort by the number of tracks
+  std::stable_sort(out_connectedViews.begin(), out_connectedViews.end(),
+                   [](const ViewConnectionScore& t1, const ViewConnectionScore& t2) {
     return std::get<2>(t1) > std::get<2>(t2);
   });
+#endif
   return !out_connectedViews.empty();
 }
 
 bool ReconstructionEngine_sequentialSfM::findNextBestViews(
   std::vector<IndexT> & out_selectedViewIds,
-  const std::set<IndexT>& remainingViewIds) const
+  const std::set<IndexT>& remainingViewIds)
 {
   out_selectedViewIds.clear();
   auto chrono_start = std::chrono::steady_clock::now();
@@ -880,7 +856,7 @@ bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& current_p
   // use the track to have a more dense match correspondence set
   aliceVision::track::TracksMap map_tracksCommon;
   const std::set<std::size_t> set_imageIndex= {I, J};
-  track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _map_tracksPerView, map_tracksCommon);
+  track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _compactTracks, map_tracksCommon);
 
   //-- Copy point to arrays
   const std::size_t n = map_tracksCommon.size();
@@ -968,6 +944,7 @@ bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& current_p
           _sfmData.getPoses().clear();
           _sfmData.getLandmarks().clear();
           _sfmData.resetRigs();
+          _nextBestViewScoring.clearTracks();
 
           return false;
       }
@@ -1098,7 +1075,7 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
 
     aliceVision::track::TracksMap map_tracksCommon;
     const std::set<size_t> set_imageIndex= {I, J};
-    track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _map_tracksPerView, map_tracksCommon);
+    track::tracksUtilsMap::getCommonTracksInImagesFast(set_imageIndex, _compactTracks, map_tracksCommon);
 
     // Copy points correspondences to arrays for relative pose estimation
     const size_t n = map_tracksCommon.size();
@@ -1282,21 +1259,7 @@ std::size_t ReconstructionEngine_sequentialSfM::computeImageScore(IndexT viewId,
 #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
   return trackIds.size();
 #else
-  std::size_t score = 0;
-  // The number of cells of the pyramid grid represent the score
-  // and ensure a proper repartition of features in images.
-  const auto& featsPyramid = _map_featsPyramidPerView.at(viewId);
-  for(std::size_t level = 0; level < _pyramidDepth; ++level)
-  {
-    std::set<std::size_t> featIndexes; // Set of grid cell indexes in the pyramid
-    for(IndexT trackId: trackIds)
-    {
-      std::size_t pyramidIndex = featsPyramid.at(trackId * _pyramidDepth + level);
-      featIndexes.insert(pyramidIndex);
-    }
-    score += featIndexes.size() * _pyramidWeights[level];
-  }
-  return score;
+  return _nextBestViewScoring.computeScore(viewId, trackIds);
 #endif
 }
 
@@ -1316,20 +1279,19 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
   using namespace track;
 
   // A. Compute 2D/3D matches
-  // A1. list tracks ids used by the view
-  const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewIndex);
-
-  // A2. intersects the track list with the reconstructed
-  std::set<std::size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
-  
-  // Get the ids of the already reconstructed tracks
-  std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                        reconstructed_trackId.begin(),
-                        reconstructed_trackId.end(),
-                        std::inserter(resectionData.tracksId, resectionData.tracksId.begin()));
+  // A1. list tracks used by the view (sorted by track id)
+  const track::CompactTracks::Range<IndexT> viewTrackIndexes = _compactTracks.tracksInView(viewIndex);
+
+  // A2. keep the already reconstructed tracks and get back their featId in the view.
+  // These 2D/3D associations will be used for the resection.
+  for(const IndexT trackIndex : viewTrackIndexes)
+  {
+    const std::size_t trackId = _compactTracks.trackId(trackIndex);
+    if(_sfmData.getLandmarks().count(trackId) == 0)
+      continue;
+    resectionData.tracksId.insert(resectionData.tracksId.end(), trackId);
+    resectionData.featuresId.emplace_back(_compactTracks.descType(trackIndex), _compactTracks.featureInView(trackIndex, viewIndex));
+  }
   
   if (resectionData.tracksId.empty())
   {
@@ -1338,13 +1300,6 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
     return false;
   }
   
-  // Get back featId associated to a tracksID already reconstructed.
-  // These 2D/3D associations will be used for the resection.
-  tracksUtilsMap::getFeatureIdInViewPerTrack(_map_tracks,
-                                             resectionData.tracksId,
-                                             viewIndex,
-                                             &resectionData.featuresId);
-  
   // Localize the image inside the SfM reconstruction
   resectionData.pt2D.resize(2, resectionData.tracksId.size());
   resectionData.pt3D.resize(3, resectionData.tracksId.size());
@@ -1511,44 +1466,76 @@ bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const std
 
 void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<IndexT>& previousReconstructedViews, 
                                                                 const std::set<IndexT>& newReconstructedViews, 
-                                                                std::map<IndexT, std::set<IndexT>> & mapTracksToTriangulate) const
+                                                                TracksToTriangulate& tracksToTriangulate) const
 {
-  std::set<IndexT> allReconstructedViews;
-  allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
-  allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
+  // sorted by the std::set
+  std::vector<IndexT> allReconstructedViews;
+  allReconstructedViews.reserve(previousReconstructedViews.size() + newReconstructedViews.size());
+  std::set_union(previousReconstructedViews.begin(), previousReconstructedViews.end(),
+                 newReconstructedViews.begin(), newReconstructedViews.end(),
+                 std::back_inserter(allReconstructedViews));
   
-  std::set<IndexT> allTracksInNewViews;
-  track::tracksUtilsMap::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, allTracksInNewViews);
-  
-  std::set<IndexT>::iterator it;
-#pragma omp parallel private(it)
+  // indexes of the tracks visible in the new views
+  std::vector<IndexT> trackIndexesInNewViews;
+  for(const IndexT viewId: newReconstructedViews)
+  {
+    const track::CompactTracks::Range<IndexT> viewTrackIndexes = _compactTracks.tracksInView(viewId);
+    trackIndexesInNewViews.insert(trackIndexesInNewViews.end(), viewTrackIndexes.begin(), viewTrackIndexes.end());
+  }
+  std::sort(trackIndexesInNewViews.begin(), trackIndexesInNewViews.end());
+  trackIndexesInNewViews.erase(std::unique(trackIndexesInNewViews.begin(), trackIndexesInNewViews.end()), trackIndexesInNewViews.end());
+
+  // gather the tracks in one buffer per thread
+  std::vector<TracksToTriangulate> tracksPerThread(omp_get_max_threads());
+
+#pragma omp parallel
   {
-    for (it = allTracksInNewViews.begin(); it != allTracksInNewViews.end(); ++it)
+    TracksToTriangulate& threadTracks = tracksPerThread[omp_get_thread_num()];
+
+    // static schedule: each thread gets one contiguous chunk of tracks, in the order of the thread numbers
+#pragma omp for schedule(static)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(trackIndexesInNewViews.size()); ++i)
     {
-#pragma omp single nowait
+      const IndexT trackIndex = trackIndexesInNewViews[i];
+      const track::CompactTracks::Range<IndexT> trackViews = _compactTracks.trackViews(trackIndex);
+      const track::CompactTracks::Range<IndexT> trackFeatures = _compactTracks.trackFeatures(trackIndex);
+      const std::size_t begin = threadTracks.viewIds.size();
+
+      // views of the track are sorted
+      for(std::size_t j = 0; j < trackViews.size(); ++j)
       {
-        const std::size_t trackId = *it;
-        
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        std::set<IndexT> allViewsSharingTheTrack;
-        std::transform(track.featPerView.begin(), track.featPerView.end(),
-                       std::inserter(allViewsSharingTheTrack, allViewsSharingTheTrack.begin()),
-                       stl::RetrieveKey());
-        
-        std::set<IndexT> allReconstructedViewsSharingTheTrack;
-        std::set_intersection(allViewsSharingTheTrack.begin(), allViewsSharingTheTrack.end(),
-                              allReconstructedViews.begin(), allReconstructedViews.end(),
-                              std::inserter(allReconstructedViewsSharingTheTrack, allReconstructedViewsSharingTheTrack.begin()));
-        
-        if (allReconstructedViewsSharingTheTrack.size() >= _minNbObservationsForTriangulation)
+        if(std::binary_search(allReconstructedViews.begin(), allReconstructedViews.end(), trackViews[j]))
         {
-#pragma omp critical        
-          mapTracksToTriangulate[trackId] = allReconstructedViewsSharingTheTrack;
+          threadTracks.viewIds.push_back(trackViews[j]);
+          threadTracks.featIds.push_back(trackFeatures[j]);
         }
       }
+
+      if(threadTracks.viewIds.size() - begin >= _minNbObservationsForTriangulation)
+      {
+        threadTracks.trackIndexes.push_back(trackIndex);
+        threadTracks.offsets.push_back(threadTracks.viewIds.size());
+      }
+      else
+      {
+        threadTracks.viewIds.resize(begin);
+        threadTracks.featIds.resize(begin);
+      }
     }
   }
+
+  // concatenate the buffers in the order of the threads: the tracks remain sorted
+  tracksToTriangulate = TracksToTriangulate();
+  for(const TracksToTriangulate& threadTracks : tracksPerThread)
+  {
+    const std::size_t offset = tracksToTriangulate.viewIds.size();
+    tracksToTriangulate.trackIndexes.insert(tracksToTriangulate.trackIndexes.end(), threadTracks.trackIndexes.begin(), threadTracks.trackIndexes.end());
+    tracksToTriangulate.viewIds.insert(tracksToTriangulate.viewIds.end(), threadTracks.viewIds.begin(), threadTracks.viewIds.end());
+    tracksToTriangulate.featIds.insert(tracksToTriangulate.featIds.end(), threadTracks.featIds.begin(), threadTracks.featIds.end());
+    for(std::size_t i = 1; i < threadTracks.offsets.size(); ++i)
+      tracksToTriangulate.offsets.push_back(offset + threadTracks.offsets[i]);
+  }
+  assert(std::is_sorted(tracksToTriangulate.trackIndexes.begin(), tracksToTriangulate.trackIndexes.end()));
 }
 
 void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1556,50 +1543,56 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
   ALICEVISION_LOG_DEBUG("Triangulating (mode: multi-view LO-RANSAC)... ");
 
   // -- Identify the track to triangulate :
-  // This map contains all the tracks that will be triangulated (for the first time, or not)
+  // This list contains all the tracks that will be triangulated (for the first time, or not)
   // These tracks are seen by at least one new reconstructed view.  
-  std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations> 
-  getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, mapTracksToTriangulate);
-  
-  std::vector<IndexT> setTracksId; // <trackId>
-  std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
-                 std::inserter(setTracksId, setTracksId.begin()),
-                 stl::RetrieveKey());
-                   
-#pragma omp parallel for 
-  for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
-  {
-    const IndexT trackId = setTracksId.at(i);
-    bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
-    
-    // The track needs to be seen by a min. number of views to be triangulated
-    if (observations.size() < _minNbObservationsForTriangulation)
-      continue;
-    
+  TracksToTriangulate tracksToTriangulate;
+  getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, tracksToTriangulate);
+
+  // -- Triangulate each track (already reconstructed or not) in its own result slot
+  std::vector<Landmark> triangulatedLandmarks(tracksToTriangulate.size());
+  std::vector<char> isValidTrack(tracksToTriangulate.size(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < tracksToTriangulate.size(); i++)
+  {
+    const IndexT trackIndex = tracksToTriangulate.trackIndexes[i];
+    const feature::EImageDescriberType descType = _compactTracks.descType(trackIndex);
+    // random numbers of the LO-RANSAC only depend on the track
+    system::RandomTaskScope randomTask(_compactTracks.trackId(trackIndex));
+    // all the posed views possessing the track are at [begin, end)
+    const std::size_t begin = tracksToTriangulate.offsets[i];
+    const std::size_t end = tracksToTriangulate.offsets[i + 1];
+    const std::vector<IndexT>& viewIds = tracksToTriangulate.viewIds;
+    const std::vector<IndexT>& featIds = tracksToTriangulate.featIds;
+
+    const auto getFeature = [&](std::size_t obs) -> Vec2
+    {
+      return _featuresPerView->getFeatures(viewIds[obs], descType)[featIds[obs]].coords().cast<double>();
+    };
+
+    bool isValid = true;
     Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
+    std::set<std::size_t> inliers; // inlier observations in [begin, end)
     
-    if (observations.size() == 2) 
+    if (end - begin == 2) 
     {
       /* --------------------------------------------
        *    2 observations : triangulation using DLT
        * -------------------------------------------- */ 
        
-      inliers = observations;
+      inliers = {begin, begin + 1};
       
       // -- Prepare:
-      IndexT I =  *(observations.begin());
-      IndexT J =  *(observations.rbegin());
+      IndexT I =  viewIds[begin];
+      IndexT J =  viewIds[begin + 1];
       const View* viewI = scene.getViews().at(I).get();
       const View* viewJ = scene.getViews().at(J).get();
       const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
       const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
       const Pose3 poseI = scene.getPose(*viewI).getTransform();
       const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
-      const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-      const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+      const Vec2 xI = getFeature(begin);
+      const Vec2 xJ = getFeature(begin + 1);
   
       // -- Triangulate:
       TriangulateDLT(camI->get_projective_equivalent(poseI), 
@@ -1623,7 +1616,7 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
           poseJ.depth(X_euclidean) < 0 || 
           camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
           camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
-        isValidTrack = false;
+        isValid = false;
     }
     else 
     {
@@ -1632,22 +1625,15 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
        * ------------------------------------------------------- */ 
      
       // -- Prepare:
-      Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
+      Mat2X features(2, end - begin); // undistorted 2D features (one per pose)
       std::vector<Mat34> Ps; // projective matrices (one per pose)
+      Ps.reserve(end - begin);
+      for (std::size_t obs = begin; obs < end; ++obs)
       {
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        int i = 0;
-        for (const IndexT& viewId : observations)
-        {
-          const View* view = scene.getViews().at(viewId).get();
-          const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
-          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
-          features(0,i) = x_ud(0); 
-          features(1,i) = x_ud(1);  
-          Ps.push_back(cam->get_projective_equivalent(scene.getPose(*view).getTransform()));
-          i++;
-        }
+        const View* view = scene.getViews().at(viewIds[obs]).get();
+        const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
+        features.col(obs - begin) = cam->get_ud_pixel(getFeature(obs)); // undistorted 2D point
+        Ps.push_back(cam->get_projective_equivalent(scene.getPose(*view).getTransform()));
       }
       
       // -- Triangulate: 
@@ -1658,45 +1644,49 @@ void ReconstructionEngine_sequentialSfM::triangulateMultiViews_LORANSAC(SfMData&
       
       HomogeneousToEuclidean(X_homogeneous, &X_euclidean);     
       
-      // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
+      std::set<IndexT> inlierViews;
       for (const auto & id : inliersIndex)
-        inliers.insert(*std::next(observations.begin(), id));
+      {
+        inliers.insert(begin + id);
+        inlierViews.insert(viewIds[begin + id]);
+      }
 
       // -- Check:
       //  - nb of cameras validing the track 
       //  - angle (small angle leads imprecise triangulation)
       //  - positive depth (chierality)
-      if (inliers.size() < _minNbObservationsForTriangulation ||
-          !checkAngles(X_euclidean, inliers, scene, _minAngleForTriangulation) ||
-          !checkChieralities(X_euclidean, inliers, scene))
-        isValidTrack = false;
+      if (inlierViews.size() < _minNbObservationsForTriangulation ||
+          !checkAngles(X_euclidean, inlierViews, scene, _minAngleForTriangulation) ||
+          !checkChieralities(X_euclidean, inlierViews, scene))
+        isValid = false;
     }  
 
-    // -- Add the tringulated point to the scene
-    if (isValidTrack)
+    // -- Prepare the tringulated point
+    if (isValid)
     {
-      Landmark landmark;
+      Landmark& landmark = triangulatedLandmarks[i];
       landmark.X = X_euclidean;
-      landmark.descType = track.descType;
-      for (const IndexT & viewId : inliers) // add inliers as observations
-      {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId));
-      }
-#pragma omp critical
-      {
-        scene.structure[trackId] = landmark;
-      }      
+      landmark.descType = descType;
+      for (const std::size_t obs : inliers) // add inliers as observations
+        landmark.observations[viewIds[obs]] = Observation(getFeature(obs), featIds[obs]);
     }
-    else
+    isValidTrack[i] = isValid;
+  } // for all shared tracks 
+
+  // -- Merge the results in the scene, in the order of the tracks
+  for (std::size_t i = 0; i < tracksToTriangulate.size(); ++i)
+  {
+    const std::size_t trackId = _compactTracks.trackId(tracksToTriangulate.trackIndexes[i]);
+    if (isValidTrack[i])
     {
-#pragma omp critical
-      {
-        if (scene.structure.find(trackId) != scene.structure.end()) 
-          scene.structure.erase(trackId);
-      }
+      scene.structure[trackId] = std::move(triangulatedLandmarks[i]);
+      _nextBestViewScoring.addTrack(trackId);
     }
-  } // for all shared tracks 
+    else if (scene.structure.erase(trackId))
+    {
+      _nextBestViewScoring.removeTrack(trackId);
+    }
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1716,144 +1706,153 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
   std::set<IndexT> allReconstructedViews;
   allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
   allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
+
+  // pairs of a new view with any reconstructed view (I < J)
+  std::vector<Pair> pairs;
+  for(const IndexT indexAll : allReconstructedViews)
+  {
+    for(const IndexT indexNew : newReconstructedViews)
+    {
+      if(indexAll != indexNew)
+        pairs.emplace_back(std::min(indexNew, indexAll), std::max(indexNew, indexAll));
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  // An observation is added to a 3D point if it is in front of the camera with a small residual
+  const auto isValidObservation = [&](IndexT viewId, const Vec3& X, const Vec2& x)
+  {
+    const View* view = scene.getViews().at(viewId).get();
+    const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
+    const Pose3 pose = scene.getPose(*view).getTransform();
+    const auto& acThresholdIt = _map_ACThreshold.find(viewId);
+    // TODO assert(acThresholdIt != _map_ACThreshold.end());
+    const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
+    return pose.depth(X) > 0 && cam->residual(pose, X, x).norm() < std::max(4.0, acThreshold);
+  };
+
+  // results of the triangulation of each pair, the scene structure is read-only until the merge
+  struct PairTriangulation
+  {
+    /// observations to add to existing 3D points: <trackId, <viewId, observation>>
+    std::vector<std::pair<std::size_t, std::pair<IndexT, Observation>>> newObservations;
+    /// new 3D points: <trackId, landmark>
+    std::vector<std::pair<std::size_t, Landmark>> newLandmarks;
+  };
+  std::vector<PairTriangulation> pairTriangulations(pairs.size());
   
 #pragma omp parallel for schedule(dynamic)
-  for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(allReconstructedViews.size()); ++i)
+  for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(pairs.size()); ++i)
   {
-    std::set<IndexT>::const_iterator iter = allReconstructedViews.begin();
-    std::advance(iter, i);
-    const IndexT indexAll = *iter;
+    const IndexT I = pairs[i].first;
+    const IndexT J = pairs[i].second;
+    PairTriangulation& pairTriangulation = pairTriangulations[i];
+      
+    // Find track correspondences between I and J
+    const std::set<std::size_t> set_viewIndex = { I, J };
+    track::TracksMap map_tracksCommonIJ;
+    track::tracksUtilsMap::getCommonTracksInImagesFast(set_viewIndex, _compactTracks, map_tracksCommonIJ);
+
+    const View* viewI = scene.getViews().at(I).get();
+    const View* viewJ = scene.getViews().at(J).get();
+    const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
+    const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
+    const Pose3 poseI = scene.getPose(*viewI).getTransform();
+    const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
     
-    for(IndexT indexNew: newReconstructedViews)
+    for (const std::pair<std::size_t, track::Track >& trackIt : map_tracksCommonIJ)
     {
-      if(indexAll == indexNew)
-        continue;
-      
-      const std::size_t I = std::min((IndexT)indexNew, indexAll);
-      const std::size_t J = std::max((IndexT)indexNew, indexAll);
-      
-      // Find track correspondences between I and J
-      const std::set<std::size_t> set_viewIndex = { I, J };
-      track::TracksMap map_tracksCommonIJ;
-      track::tracksUtilsMap::getCommonTracksInImagesFast(set_viewIndex, _map_tracks, _map_tracksPerView, map_tracksCommonIJ);
+      const std::size_t trackId = trackIt.first;
+      const track::Track & track = trackIt.second;
 
-      const View* viewI = scene.getViews().at(I).get();
-      const View* viewJ = scene.getViews().at(J).get();
-      const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
-      const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
-      const Pose3 poseI = scene.getPose(*viewI).getTransform();
-      const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
+      const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
+      const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
       
-      std::size_t new_putative_track = 0, new_added_track = 0, extented_track = 0;
-      for (const std::pair<std::size_t, track::Track >& trackIt : map_tracksCommonIJ)
+      // test if the track already exists in 3D
+      const auto landmarkIt = scene.structure.find(trackId);
+      if (landmarkIt != scene.structure.end())
       {
-        const std::size_t trackId = trackIt.first;
-        const track::Track & track = trackIt.second;
-
-        const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-        const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+        // 3D point triangulated before, only add image observation if needed
+        const Landmark& landmark = landmarkIt->second;
+        if (landmark.observations.count(I) == 0 && isValidObservation(I, landmark.X, xI))
+          pairTriangulation.newObservations.emplace_back(trackId, std::make_pair(I, Observation(xI, track.featPerView.at(I))));
+        if (landmark.observations.count(J) == 0 && isValidObservation(J, landmark.X, xJ))
+          pairTriangulation.newObservations.emplace_back(trackId, std::make_pair(J, Observation(xJ, track.featPerView.at(J))));
+      }
+      else
+      {
+        // A new 3D point must be added
+        Vec3 X_euclidean = Vec3::Zero();
+        const Vec2 xI_ud = camI->get_ud_pixel(xI);
+        const Vec2 xJ_ud = camJ->get_ud_pixel(xJ);
+        const Mat34 pI = camI->get_projective_equivalent(poseI);
+        const Mat34 pJ = camJ->get_projective_equivalent(poseJ);
         
-        // test if the track already exists in 3D
-        bool trackIdExists;
-#pragma omp critical
-        {
-          trackIdExists = scene.structure.find(trackId) != scene.structure.end();
-        }
-        if (trackIdExists)
-        {
-          // 3D point triangulated before, only add image observation if needed
-#pragma omp critical
-          {
-            Landmark& landmark = scene.structure.at(trackId);
-            if (landmark.observations.count(I) == 0)
-            {
-              const Vec2 residual = camI->residual(poseI, landmark.X, xI);
-              const auto& acThresholdIt = _map_ACThreshold.find(I);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseI.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-                ++extented_track;
-              }
-            }
-            if (landmark.observations.count(J) == 0)
-            {
-              const Vec2 residual = camJ->residual(poseJ, landmark.X, xJ);
-              const auto& acThresholdIt = _map_ACThreshold.find(J);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseJ.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-                ++extented_track;
-              }
-            }
-          }
-        }
-        else
+        TriangulateDLT(pI, xI_ud, pJ, xJ_ud, &X_euclidean);
+        
+        // Check triangulation results
+        //  - Check angle (small angle leads imprecise triangulation)
+        //  - Check positive depth
+        //  - Check residual values
+        const double angle = AngleBetweenRays(poseI, camI, poseJ, camJ, xI, xJ);
+        const Vec2 residualI = camI->residual(poseI, X_euclidean, xI);
+        const Vec2 residualJ = camJ->residual(poseJ, X_euclidean, xJ);
+        
+        // TODO assert(acThresholdIt != _map_ACThreshold.end());
+        
+        const auto& acThresholdItI = _map_ACThreshold.find(I);
+        const auto& acThresholdItJ = _map_ACThreshold.find(J);
+        
+        const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
+        const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
+        
+        if (angle > _minAngleForTriangulation &&
+            poseI.depth(X_euclidean) > 0 &&
+            poseJ.depth(X_euclidean) > 0 &&
+            residualI.norm() < acThresholdI &&
+            residualJ.norm() < acThresholdJ)
         {
-          // A new 3D point must be added
-#pragma omp critical
-          {
-            ++new_putative_track;
-          }
-          
-          Vec3 X_euclidean = Vec3::Zero();
-          const Vec2 xI_ud = camI->get_ud_pixel(xI);
-          const Vec2 xJ_ud = camJ->get_ud_pixel(xJ);
-          const Mat34 pI = camI->get_projective_equivalent(poseI);
-          const Mat34 pJ = camJ->get_projective_equivalent(poseJ);
-          
-          TriangulateDLT(pI, xI_ud, pJ, xJ_ud, &X_euclidean);
-          
-          // Check triangulation results
-          //  - Check angle (small angle leads imprecise triangulation)
-          //  - Check positive depth
-          //  - Check residual values
-          const double angle = AngleBetweenRays(poseI, camI, poseJ, camJ, xI, xJ);
-          const Vec2 residualI = camI->residual(poseI, X_euclidean, xI);
-          const Vec2 residualJ = camJ->residual(poseJ, X_euclidean, xJ);
-          
-          // TODO assert(acThresholdIt != _map_ACThreshold.end());
-          
-          const auto& acThresholdItI = _map_ACThreshold.find(I);
-          const auto& acThresholdItJ = _map_ACThreshold.find(J);
-          
-          const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-          const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
-          
-          if (angle > _minAngleForTriangulation &&
-              poseI.depth(X_euclidean) > 0 &&
-              poseJ.depth(X_euclidean) > 0 &&
-              residualI.norm() < acThresholdI &&
-              residualJ.norm() < acThresholdJ)
-          {
-#pragma omp critical
-            {
-              // Add a new track
-              Landmark & landmark = scene.structure[trackId];
-              landmark.X = X_euclidean;
-              landmark.descType = track.descType;
-              
-              landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-              landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-              
-              ++new_added_track;
-            } // critical
-          } // 3D point is valid
-        } // else (New 3D point)
-      }// for all correspondences
+          // Add a new track
+          Landmark landmark;
+          landmark.X = X_euclidean;
+          landmark.descType = track.descType;
+          landmark.observations[I] = Observation(xI, track.featPerView.at(I));
+          landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
+          pairTriangulation.newLandmarks.emplace_back(trackId, std::move(landmark));
+        } // 3D point is valid
+      } // else (New 3D point)
+    }// for all correspondences
+  }
+
+  // Merge the results in the scene, in the order of the pairs
+  for (PairTriangulation& pairTriangulation : pairTriangulations)
+  {
+    for (auto& newObservation : pairTriangulation.newObservations)
+    {
+      Landmark& landmark = scene.structure.at(newObservation.first);
+      if (landmark.observations.count(newObservation.second.first) == 0)
+        landmark.observations.insert(std::move(newObservation.second));
     }
 
-//  #pragma omp critical
-//  if (!map_tracksCommonIJ.empty())
-//  {
-//    ALICEVISION_LOG_DEBUG("--Triangulated 3D points [" << I << "-" << J << "]:\n"
-//                      "\t#Track extented: " << extented_track << "\n"
-//                      "\t#Validated/#Possible: " << new_added_track << "/" << new_putative_track << "\n"
-//                      "\t#3DPoint for the entire scene: " << scene.getLandmarks().size());
-//  }
+    for (auto& newLandmark : pairTriangulation.newLandmarks)
+    {
+      const auto landmarkIt = scene.structure.find(newLandmark.first);
+      if (landmarkIt == scene.structure.end())
+      {
+        scene.structure[newLandmark.first] = std::move(newLandmark.second);
+        _nextBestViewScoring.addTrack(newLandmark.first);
+        continue;
+      }
+      // 3D point triangulated by a previous pair, only add image observations if needed
+      Landmark& landmark = landmarkIt->second;
+      for (const auto& observation : newLandmark.second.observations)
+      {
+        if (landmark.observations.count(observation.first) == 0 &&
+            isValidObservation(observation.first, landmark.X, observation.second.x))
+          landmark.observations.insert(observation);
+      }
+    }
   }
 }
 
@@ -1886,7 +1885,7 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
   LocalBundleAdjustmentCeres::LocalBA_options options;
   options.enableParametersOrdering();
   
-  if (_sfmData.getPoses().size() > 100) // default value: 100 
+  if (isLocalBARestricted())
   {
     options.setSparseBA();
     options.enableLocalBA();
@@ -1894,13 +1893,15 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
   else
   {
     options.setDenseBA();
+    // all the landmarks are refined
+    restoreInactiveLandmarks();
   }
   
   const std::size_t kMinNbOfMatches = 50; // default value: 50 
   bool isBaSucceed;
   
   // Add the new reconstructed views to the graph
-  _localBA_data->updateGraphWithNewViews(_sfmData, _map_tracksPerView, newReconstructedViews, kMinNbOfMatches);
+  _localBA_data->updateGraphWithNewViews(_sfmData, _compactTracks, newReconstructedViews, kMinNbOfMatches);
   
   // -- Prepare Local BA & Adjust
   LocalBundleAdjustmentCeres localBA_ceres;
@@ -1961,10 +1962,160 @@ bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<In
   return isBaSucceed;
 }
 
+bool ReconstructionEngine_sequentialSfM::isLocalBARestricted() const
+{
+  // when extending a reconstruction, only the neighbourhood of the new views is refined
+  return _sfmData.getPoses().size() > 100 || (_extendReconstruction && _localBundleAdjustmentOnExtension); // default value: 100
+}
+
+std::set<IndexT> ReconstructionEngine_sequentialSfM::getActiveViews(const std::set<IndexT>& remainingViewIds) const
+{
+  const std::set<IndexT> reconstructedViews = _sfmData.getValidViews();
+  std::set<IndexT> activeViews;
+
+  // the landmarks of the tracks of the remaining views get new observations,
+  // and the next local BA refine the views connected to them
+  std::vector<char> isVisited(_compactTracks.nbTracks(), 0);
+  for(const IndexT viewId : remainingViewIds)
+  {
+    for(const IndexT trackIndex : _compactTracks.tracksInView(viewId))
+    {
+      if(isVisited[trackIndex])
+        continue;
+      isVisited[trackIndex] = 1;
+      for(const IndexT trackViewId : _compactTracks.trackViews(trackIndex))
+      {
+        if(reconstructedViews.count(trackViewId))
+          activeViews.insert(trackViewId);
+      }
+    }
+  }
+
+  // the non-constant intrinsics are refined by every local BA
+  for(const IndexT viewId : reconstructedViews)
+  {
+    const IndexT intrinsicId = _sfmData.getViews().at(viewId)->getIntrinsicId();
+    if(!_sfmData.getIntrinsicPtr(intrinsicId)->isLocked() && !_localBA_data->isFocalLengthConstant(intrinsicId))
+      activeViews.insert(viewId);
+  }
+
+  // the views of the same poses (rigs), and the neighbours up to the local BA graph distance
+  for(std::size_t distance = 0; ; ++distance)
+  {
+    std::set<IndexT> activePoses;
+    for(const IndexT viewId : activeViews)
+      activePoses.insert(_sfmData.getViews().at(viewId)->getPoseId());
+    for(const IndexT viewId : reconstructedViews)
+    {
+      if(activePoses.count(_sfmData.getViews().at(viewId)->getPoseId()))
+        activeViews.insert(viewId);
+    }
+
+    if(distance + 1 >= _localBAGraphDistanceLimit)
+      break;
+
+    std::set<IndexT> neighbourViews;
+    for(const auto& landmarkPair : _sfmData.getLandmarks())
+    {
+      const Observations& observations = landmarkPair.second.observations;
+      const bool isActive = std::any_of(observations.begin(), observations.end(),
+                                        [&](const Observations::value_type& observation) { return activeViews.count(observation.first) > 0; });
+      if(!isActive)
+        continue;
+      for(const auto& observation : observations)
+        neighbourViews.insert(observation.first);
+    }
+    activeViews.insert(neighbourViews.begin(), neighbourViews.end());
+  }
+  return activeViews;
+}
+
+void ReconstructionEngine_sequentialSfM::storeInactiveLandmarks(const std::set<IndexT>& remainingViewIds)
+{
+  // the landmarks are all refined by the bundle adjustment
+  if(!isLocalBARestricted())
+    return;
+
+  const std::set<IndexT> activeViews = getActiveViews(remainingViewIds);
+
+  Landmarks inactiveLandmarks;
+  Landmarks& landmarks = _sfmData.getLandmarks();
+  for(auto it = landmarks.begin(); it != landmarks.end();)
+  {
+    const Observations& observations = it->second.observations;
+    const bool isActive = std::any_of(observations.begin(), observations.end(),
+                                      [&](const Observations::value_type& observation) { return activeViews.count(observation.first) > 0; });
+    if(isActive)
+    {
+      ++it;
+      continue;
+    }
+
+    // the poses of the inactive landmarks are not removed for a lack of observations
+    for(const auto& observation : observations)
+      ++_inactiveObservationsPerPose[_sfmData.getViews().at(observation.first)->getPoseId()];
+
+    // no removal event for the next best view scoring: the track is still reconstructed
+    inactiveLandmarks.emplace(it->first, std::move(it->second));
+    it = landmarks.erase(it);
+  }
+
+  if(inactiveLandmarks.empty())
+    return;
+
+  _inactiveLandmarks.insert(inactiveLandmarks);
+
+  if(_spillInactiveLandmarks)
+  {
+    const fs::path spillFolder = fs::path(_outputFolder) / "inactiveLandmarks";
+    if(!fs::exists(spillFolder))
+      fs::create_directory(spillFolder);
+
+    if(!_inactiveLandmarks.spill(spillFolder.string(), std::set<IndexT>()))
+      ALICEVISION_LOG_WARNING("Unable to spill the inactive landmarks to disk, they are kept in memory.");
+  }
+
+  ALICEVISION_LOG_INFO("Inactive landmarks: " << std::endl
+                        << "\t- # new inactive landmarks: " << inactiveLandmarks.size() << std::endl
+                        << "\t- # inactive landmarks in memory: " << _inactiveLandmarks.nbLandmarks() << std::endl
+                        << "\t- # inactive landmarks on disk: " << _inactiveLandmarks.nbSpilled() << std::endl
+                        << "\t- # active landmarks: " << landmarks.size());
+}
+
+void ReconstructionEngine_sequentialSfM::restoreInactiveLandmarks()
+{
+  if(_inactiveLandmarks.empty() && _inactiveLandmarks.nbSpilled() == 0)
+    return;
+
+  if(!_inactiveLandmarks.restore())
+    throw std::runtime_error("Unable to read the inactive landmarks spilled to disk.");
+
+  Landmarks inactiveLandmarks;
+  _inactiveLandmarks.exportToSTL(inactiveLandmarks);
+  _inactiveLandmarks.clear();
+  _inactiveObservationsPerPose.clear();
+
+  for(auto& landmarkPair : inactiveLandmarks)
+    _sfmData.getLandmarks().emplace(landmarkPair.first, std::move(landmarkPair.second));
+
+  // the poses removed since the landmarks became inactive
+  std::set<IndexT> removedLandmarksId;
+  eraseObservationsWithMissingPoses(_sfmData, _minTrackLength, &removedLandmarksId);
+
+  for(const IndexT landmarkId : removedLandmarksId)
+    _nextBestViewScoring.removeTrack(landmarkId);
+
+  ALICEVISION_LOG_INFO("Restore " << inactiveLandmarks.size() << " inactive landmarks, " << _sfmData.getLandmarks().size() << " landmarks in the scene.");
+}
+
 std::size_t ReconstructionEngine_sequentialSfM::removeOutliers(double precision)
 {
-  const std::size_t nbOutliersResidualErr = RemoveOutliers_PixelResidualError(_sfmData, precision, 2);
-  const std::size_t nbOutliersAngleErr = RemoveOutliers_AngleError(_sfmData, _minAngleForLandmark);
+  std::set<IndexT> removedLandmarksId;
+  const std::size_t nbOutliersResidualErr = RemoveOutliers_PixelResidualError(_sfmData, precision, 2, &removedLandmarksId);
+  const std::size_t nbOutliersAngleErr = RemoveOutliers_AngleError(_sfmData, _minAngleForLandmark, &removedLandmarksId);
+
+  for(const IndexT landmarkId : removedLandmarksId)
+    _nextBestViewScoring.removeTrack(landmarkId);
 
   ALICEVISION_LOG_INFO("Remove outliers: " << std::endl
                         << "\t- # outliers residual error: " << nbOutliersResidualErr << std::endl
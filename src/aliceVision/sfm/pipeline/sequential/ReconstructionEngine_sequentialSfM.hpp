@@ -8,12 +8,15 @@
 #pragma once
 
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
+#include <aliceVision/sfm/pipeline/sequential/NextBestViewScoring.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentData.hpp>
+#include <aliceVision/sfm/CompactLandmarks.hpp>
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/track/Track.hpp>
+#include <aliceVision/track/CompactTracks.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 #include <dependencies/histogram/histogram.hpp>
@@ -113,10 +116,37 @@ public:
 
   void setLocalBundleAdjustmentGraphDistance(std::size_t distance)
   {
+    _localBAGraphDistanceLimit = distance;
     if(_uselocalBundleAdjustment)
       _localBA_data->setGraphDistanceLimit(distance);
   }
 
+  /**
+   * @brief When extending an existing reconstruction (input poses and landmarks),
+   * restrict the bundle adjustments to the neighbourhood of the new views (local BA),
+   * whatever the number of poses. Enabled by default.
+   */
+  void setLocalBundleAdjustmentOnExtension(bool v)
+  {
+    _localBundleAdjustmentOnExtension = v;
+  }
+
+  /**
+   * @brief Between the resections, move the landmarks that the next resections can't change
+   * to a compact storage (see CompactLandmarks), optionally spilled to disk.
+   * They are restored at the end of the reconstruction.
+   * Only used when the bundle adjustment is restricted to the neighbourhood of the new views (local BA):
+   * the inactive landmarks are only observed by views without track in the remaining views,
+   * out of the local BA graph distance and with constant intrinsics.
+   * @param[in] compact hold the inactive landmarks in a compact storage
+   * @param[in] spill write the inactive landmarks to files in the output folder
+   */
+  void setCompactInactiveLandmarks(bool compact, bool spill = false)
+  {
+    _compactInactiveLandmarks = compact || spill;
+    _spillInactiveLandmarks = spill;
+  }
+
   void setUseLocalBundleAdjustmentStrategy(bool v)
   {
     _uselocalBundleAdjustment = v;
@@ -124,6 +154,7 @@ public:
     {
       _localBA_data = std::make_shared<LocalBundleAdjustmentData>(_sfmData);
       _localBA_data->setOutDirectory((fs::path(_outputFolder) / "localBA").string());
+      _localBA_data->setGraphDistanceLimit(_localBAGraphDistanceLimit);
 
       // delete all the previous data about the Local BA.
       if(fs::exists(_localBA_data->getOutDirectory()))
@@ -164,6 +195,8 @@ public:
   /**
    * @brief If we have already reconstructed landmarks in a previous reconstruction,
    * we need to recognize the corresponding tracks and update the landmarkIds accordingly.
+   * Each landmark is assigned to the track containing most of its observations,
+   * the landmarks without track are removed.
    */
   void remapLandmarkIdsToTrackIds();
 
@@ -197,7 +230,7 @@ public:
    * @return False if there is no view connected.
    */
   bool findConnectedViews(std::vector<ViewConnectionScore>& out_connectedViews,
-                          const std::set<IndexT>& remainingViewIds) const;
+                          const std::set<IndexT>& remainingViewIds);
 
   /**
    * @brief Estimate the best images on which we can compute the resectioning safely.
@@ -209,7 +242,7 @@ public:
    * @return False if there is no possible resection.
    */
   bool findNextBestViews(std::vector<IndexT>& out_selectedViewIds,
-                         const std::set<IndexT>& remainingViewIds) const;
+                         const std::set<IndexT>& remainingViewIds);
 
 private:
 
@@ -227,6 +260,21 @@ private:
     bool isNewIntrinsic;
   };
 
+  /// Tracks to triangulate with their observations in the reconstructed views
+  struct TracksToTriangulate
+  {
+    /// indexes of the tracks in the compact tracks (sorted)
+    std::vector<IndexT> trackIndexes;
+    /// the observations of the i-th track are at [offsets[i], offsets[i+1]) in viewIds and featIds
+    std::vector<std::size_t> offsets = std::vector<std::size_t>(1, 0);
+    /// view ids of the observations (sorted for each track)
+    std::vector<IndexT> viewIds;
+    /// feature ids of the observations
+    std::vector<IndexT> featIds;
+
+    std::size_t size() const { return trackIndexes.size(); }
+  };
+
   /**
    * @brief Compute the initial 3D seed (First camera t=0; R=Id, second estimated by 5 point algorithm)
    * @param[in] initialPair
@@ -347,12 +395,12 @@ private:
    * view and at least \c _minNbObservationsForTriangulation (new and previous) reconstructed view.
    * @param[in] previousReconstructedViews The old reconstructed views.
    * @param[in] newReconstructedViews The newly reconstructed views.
-   * @param[out] mapTracksToTriangulate A map with the tracks to triangulate and the observations to do it.
+   * @param[out] tracksToTriangulate The tracks to triangulate and the observations to do it, sorted by track.
    */
   void getTracksToTriangulate(
       const std::set<IndexT> & previousReconstructedViews, 
       const std::set<IndexT> & newReconstructedViews, 
-      std::map<IndexT, std::set<IndexT> > & mapTracksToTriangulate) const;
+      TracksToTriangulate & tracksToTriangulate) const;
 
   /**
    * @brief Remove observation/tracks that have:
@@ -364,6 +412,35 @@ private:
    */
   std::size_t removeOutliers(double precision);
 
+  /**
+   * @brief The local BA strategy only refines the neighbourhood of the new views
+   * if the scene is large enough or if an existing reconstruction is extended,
+   * otherwise all the parameters are refined.
+   * @return true if the local BA is restricted to the neighbourhood of the new views
+   */
+  bool isLocalBARestricted() const;
+
+  /**
+   * @brief Get the reconstructed views whose pose or landmarks can be changed by the next resections:
+   * views sharing a track with a remaining view or with a non-constant intrinsic,
+   * and their neighbours up to the local BA graph distance.
+   * @param[in] remainingViewIds The views not reconstructed yet
+   * @return the active views
+   */
+  std::set<IndexT> getActiveViews(const std::set<IndexT>& remainingViewIds) const;
+
+  /**
+   * @brief Move the landmarks without observation in the active views from the scene to the
+   * inactive landmarks storage (spilled to disk if enabled).
+   * @param[in] remainingViewIds The views not reconstructed yet
+   */
+  void storeInactiveLandmarks(const std::set<IndexT>& remainingViewIds);
+
+  /**
+   * @brief Move back the inactive landmarks in the scene, without the observations of the removed poses
+   */
+  void restoreInactiveLandmarks();
+
   // Parameters
 
   Pair _userInitialImagePair;
@@ -371,6 +448,8 @@ private:
   int _minTrackLength = 2;
   int _minPointsPerPose = 30;
   bool _uselocalBundleAdjustment = false;
+  std::size_t _localBAGraphDistanceLimit = 1;
+  bool _localBundleAdjustmentOnExtension = true;
   /// minimum number of obersvations to triangulate a 3d point.
   std::size_t _minNbObservationsForTriangulation = 2;
   /// a 3D point must have at least 2 obervations not too much aligned.
@@ -397,15 +476,26 @@ private:
 
   // Temporary data
 
-  /// Putative landmark tracks (visibility per potential 3D point)
-  track::TracksMap _map_tracks;
-  /// Putative tracks per view
-  track::TracksPerView _map_tracksPerView;
-  /// Precomputed pyramid index for each trackId of each viewId.
-  track::TracksPyramidPerView _map_featsPyramidPerView;
+  /// Putative landmark tracks (visibility per potential 3D point) stored in contiguous arrays,
+  /// with the tracks per view reverse index
+  track::CompactTracks _compactTracks;
+  /// Pyramid scores of the views, updated with the landmarks added to or removed from the scene
+  NextBestViewScoring _nextBestViewScoring;
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
 
+  /// true if the input reconstruction (poses and landmarks) is extended with new views
+  bool _extendReconstruction = false;
+
+  // Inactive landmarks
+
+  bool _compactInactiveLandmarks = false;
+  bool _spillInactiveLandmarks = false;
+  /// landmarks that the next resections can't change, removed from the scene structure
+  CompactLandmarks _inactiveLandmarks;
+  /// number of observations of each pose in the inactive landmarks
+  HashMap<IndexT, IndexT> _inactiveObservationsPerPose;
+
   // Local Bundle Adjustment data
 
   /// Contains all the data used by the Local BA approach
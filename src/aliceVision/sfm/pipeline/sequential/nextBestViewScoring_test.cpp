@@ -0,0 +1,137 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/sequential/NextBestViewScoring.hpp>
+
+#include <limits>
+#include <random>
+
+#define BOOST_TEST_MODULE nextBestViewScoring
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+const std::size_t nbViews = 12;
+const std::size_t nbTracks = 2000;
+const std::size_t imageWidth = 1000;
+const std::size_t imageHeight = 800;
+
+// Check the incremental scores against a full computation from the landmarks
+void checkScores(const NextBestViewScoring& scoring, const track::CompactTracks& tracks, const Landmarks& landmarks)
+{
+  std::size_t nbRanked = 0;
+  for(const IndexT viewId : tracks.views())
+  {
+    std::vector<std::size_t> reconstructedTracks;
+    for(const IndexT trackIndex : tracks.tracksInView(viewId))
+    {
+      if(landmarks.count(tracks.trackId(trackIndex)))
+        reconstructedTracks.push_back(tracks.trackId(trackIndex));
+    }
+    BOOST_CHECK_EQUAL(reconstructedTracks.size(), scoring.nbReconstructedTracks(viewId));
+    BOOST_CHECK_EQUAL(scoring.computeScore(viewId, reconstructedTracks), scoring.score(viewId));
+    if(!reconstructedTracks.empty())
+      ++nbRanked;
+  }
+
+  // sorted by decreasing scores
+  BOOST_CHECK_EQUAL(nbRanked, scoring.rankedViews().size());
+  std::size_t previousScore = std::numeric_limits<std::size_t>::max();
+  for(const auto& rankedView : scoring.rankedViews())
+  {
+    BOOST_CHECK_EQUAL(rankedView.first, scoring.score(rankedView.second));
+    BOOST_CHECK(rankedView.first <= previousScore);
+    previousScore = rankedView.first;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(NextBestViewScoring_incremental)
+{
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> xDistribution(0.f, imageWidth);
+  std::uniform_real_distribution<float> yDistribution(0.f, imageHeight);
+  std::uniform_int_distribution<std::size_t> viewDistribution(0, nbViews - 1);
+
+  Views views;
+  feature::FeaturesPerView featuresPerView;
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    views[viewId] = std::make_shared<View>("", viewId, 0, viewId, imageWidth, imageHeight);
+
+  // tracks of 2 to 5 random views
+  std::vector<feature::PointFeatures> features(nbViews);
+  track::TracksMap tracksMap;
+  for(std::size_t trackId = 0; trackId < nbTracks; ++trackId)
+  {
+    track::Track& track = tracksMap[trackId];
+    track.descType = feature::EImageDescriberType::SIFT;
+    const std::size_t length = 2 + trackId % 4;
+    while(track.featPerView.size() < length)
+    {
+      const std::size_t viewId = viewDistribution(gen);
+      if(track.featPerView.count(viewId))
+        continue;
+      track.featPerView[viewId] = features[viewId].size();
+      features[viewId].emplace_back(xDistribution(gen), yDistribution(gen));
+    }
+  }
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    featuresPerView.addFeatures(viewId, feature::EImageDescriberType::SIFT, features[viewId]);
+
+  const track::CompactTracks tracks(tracksMap);
+
+  const std::vector<int> pyramidWeights = {16, 8, 4, 2, 1};
+  NextBestViewScoring scoring;
+  scoring.initialize(tracks, views, featuresPerView, 2, pyramidWeights);
+  BOOST_CHECK(scoring.rankedViews().empty());
+
+  // add and remove random landmarks
+  Landmarks landmarks;
+  std::uniform_int_distribution<std::size_t> trackDistribution(0, nbTracks - 1);
+  for(std::size_t step = 0; step < 20; ++step)
+  {
+    // the events are sent for all the landmarks changes, even redundant ones
+    for(std::size_t i = 0; i < 200; ++i)
+    {
+      const std::size_t trackId = trackDistribution(gen);
+      landmarks[trackId] = Landmark();
+      scoring.addTrack(trackId);
+    }
+    if(step % 3 == 2)
+    {
+      for(std::size_t i = 0; i < 300; ++i)
+      {
+        const std::size_t trackId = trackDistribution(gen);
+        landmarks.erase(trackId);
+        scoring.removeTrack(trackId);
+      }
+    }
+    scoring.update();
+    checkScores(scoring, tracks, landmarks);
+  }
+
+  // landmarks without track are ignored
+  landmarks[nbTracks + 10] = Landmark();
+  scoring.addTrack(nbTracks + 10);
+  scoring.update();
+  checkScores(scoring, tracks, landmarks);
+
+  landmarks.clear();
+  scoring.clearTracks();
+  scoring.update();
+  checkScores(scoring, tracks, landmarks);
+  BOOST_CHECK(scoring.rankedViews().empty());
+
+  // the scores can be rebuilt after a clear
+  for(std::size_t trackId = 0; trackId < nbTracks; trackId += 3)
+  {
+    landmarks[trackId] = Landmark();
+    scoring.addTrack(trackId);
+  }
+  scoring.update();
+  checkScores(scoring, tracks, landmarks);
+}
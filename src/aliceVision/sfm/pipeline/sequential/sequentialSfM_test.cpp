@@ -9,10 +9,14 @@
 #include <aliceVision/sfm/utils/statistics.hpp>
 #include <aliceVision/sfm/utils/syntheticScene.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/track/Track.hpp>
 
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <map>
+#include <set>
+#include <utility>
 
 
 #define BOOST_TEST_MODULE SEQUENTIAL_SFM
@@ -197,3 +201,117 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Rig)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), nbPoints);
 }
 
+
+// Test the extension of an existing reconstruction with new views
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Extension)
+{
+  const int nviews = 8;
+  const int nviewsReconstructed = 5;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // Keep the poses and the observations of the first views only,
+  // with landmark ids which do not correspond to the track ids
+  SfMData sfmData2 = sfmData;
+  sfmData2.structure.clear();
+  for(IndexT viewId = nviewsReconstructed; viewId < nviews; ++viewId)
+    sfmData2.getPoses().erase(viewId);
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    Landmark landmark = landmarkPair.second;
+    for(IndexT viewId = nviewsReconstructed; viewId < nviews; ++viewId)
+      landmark.observations.erase(viewId);
+    sfmData2.structure[landmarkPair.first + 1000] = landmark;
+  }
+  for(const auto& viewPair : sfmData2.getViews())
+  {
+    if(viewPair.first < nviewsReconstructed)
+      viewPair.second->setResectionId(viewPair.first);
+  }
+  // lock the previous reconstruction
+  for(auto& posePair : sfmData2.getPoses())
+    posePair.second.lock();
+
+  ReconstructionEngine_sequentialSfM sfmEngine(
+    sfmData2,
+    "./",
+    "./Reconstruction_Report.html");
+
+  // Add a tiny noise in 2D observations to make data more realistic
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  // Configure the featuresPerView & the matches_provider from the synthetic dataset
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  // Configure data provider (Features and Matches)
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  // Configure reconstruction parameters
+  sfmEngine.setFixedIntrinsics(true);
+
+  BOOST_CHECK (sfmEngine.process());
+
+  const SfMData& finalSfMData = sfmEngine.getSfMData();
+  const double dResidual = RMSE(finalSfMData);
+  ALICEVISION_LOG_DEBUG("RMSE residual: " << dResidual);
+  BOOST_CHECK_LT(dResidual, 0.5);
+  BOOST_CHECK_EQUAL(finalSfMData.getPoses().size(), nviews);
+  BOOST_CHECK_EQUAL(finalSfMData.getLandmarks().size(), npoints);
+
+  // the previous poses are unchanged, the new views are resected after them
+  for(IndexT viewId = 0; viewId < nviewsReconstructed; ++viewId)
+  {
+    BOOST_CHECK(finalSfMData.getPoses().at(viewId).getTransform().rotation().isApprox(sfmData.getPoses().at(viewId).getTransform().rotation()));
+    BOOST_CHECK(finalSfMData.getPoses().at(viewId).getTransform().center().isApprox(sfmData.getPoses().at(viewId).getTransform().center()));
+  }
+  for(IndexT viewId = nviewsReconstructed; viewId < nviews; ++viewId)
+    BOOST_CHECK_GE(finalSfMData.getViews().at(viewId)->getResectionId(), nviewsReconstructed);
+
+  // the tracks built by the engine from the matches
+  track::ParallelTracksBuilder tracksBuilder;
+  tracksBuilder.build(pairwiseMatches);
+  tracksBuilder.filter(2);
+  track::TracksMap tracks;
+  tracksBuilder.exportToSTL(tracks);
+
+  std::map<std::pair<IndexT, IndexT>, std::size_t> trackIdPerFeature;
+  for(const auto& trackPair : tracks)
+  {
+    for(const auto& featurePair : trackPair.second.featPerView)
+      trackIdPerFeature[std::make_pair(static_cast<IndexT>(featurePair.first), static_cast<IndexT>(featurePair.second))] = trackPair.first;
+  }
+
+  // each input landmark is remapped to the track holding its observations, with the same position
+  for(const auto& landmarkPair : sfmData2.getLandmarks())
+  {
+    const Landmark& inputLandmark = landmarkPair.second;
+    std::set<std::size_t> trackIds;
+    for(const auto& observationPair : inputLandmark.observations)
+    {
+      const auto trackIt = trackIdPerFeature.find(std::make_pair(observationPair.first, observationPair.second.id_feat));
+      BOOST_REQUIRE(trackIt != trackIdPerFeature.end());
+      trackIds.insert(trackIt->second);
+    }
+    BOOST_REQUIRE_EQUAL(trackIds.size(), 1);
+
+    const std::size_t trackId = *trackIds.begin();
+    BOOST_REQUIRE(finalSfMData.getLandmarks().count(trackId));
+    const Landmark& landmark = finalSfMData.getLandmarks().at(trackId);
+    for(const auto& observationPair : inputLandmark.observations)
+    {
+      const auto observationIt = landmark.observations.find(observationPair.first);
+      BOOST_REQUIRE(observationIt != landmark.observations.end());
+      BOOST_CHECK_EQUAL(observationIt->second.id_feat, observationPair.second.id_feat);
+    }
+    BOOST_CHECK_SMALL((landmark.X - inputLandmark.X).norm(), 1e-2);
+  }
+}
@@ -18,7 +18,8 @@ IndexT RemoveOutliers_PixelResidualError
 (
   SfMData & sfm_data,
   const double dThresholdPixel,
-  const unsigned int minTrackLength
+  const unsigned int minTrackLength,
+  std::set<IndexT>* outRemovedLandmarkId
 )
 {
   IndexT outlier_count = 0;
@@ -43,14 +44,18 @@ IndexT RemoveOutliers_PixelResidualError
         ++itObs;
     }
     if (observations.empty() || observations.size() < minTrackLength)
+    {
+      if (outRemovedLandmarkId != NULL)
+        outRemovedLandmarkId->insert(iterTracks->first);
       iterTracks = sfm_data.structure.erase(iterTracks);
+    }
     else
       ++iterTracks;
   }
   return outlier_count;
 }
 
-IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAngle)
+IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAngle, std::set<IndexT>* outRemovedLandmarkId)
 {
   IndexT removedTrack_count = 0;
   Landmarks::iterator iterTracks = sfm_data.structure.begin();
@@ -81,6 +86,8 @@ IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAng
     }
     if (max_angle < dMinAcceptedAngle)
     {
+      if (outRemovedLandmarkId != NULL)
+        outRemovedLandmarkId->insert(iterTracks->first);
       iterTracks = sfm_data.structure.erase(iterTracks);
       ++removedTrack_count;
     }
@@ -90,7 +97,8 @@ IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAng
   return removedTrack_count;
 }
 
-bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std::set<IndexT>* outRemovedPosedId)
+bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std::set<IndexT>* outRemovedPosedId,
+                        const HashMap<IndexT, IndexT>* externalObservationsPerPose)
 {
   IndexT removed_elements = 0;
   const Landmarks & landmarks = sfm_data.structure;
@@ -120,6 +128,16 @@ bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std
         map_PoseId_Count[v->getPoseId()] = 0;
     }
   }
+  // Count the observations stored outside of the sfm_data structure
+  if (externalObservationsPerPose != NULL)
+  {
+    for (const auto& poseCount : *externalObservationsPerPose)
+    {
+      auto itCount = map_PoseId_Count.find(poseCount.first);
+      if (itCount != map_PoseId_Count.end())
+        itCount->second += poseCount.second;
+    }
+  }
   // If usage count is smaller than the threshold, remove the Pose
   for (HashMap<IndexT, IndexT>::const_iterator it = map_PoseId_Count.begin();
     it != map_PoseId_Count.end(); ++it)
@@ -137,7 +155,8 @@ bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std
   return removed_elements > 0;
 }
 
-bool eraseObservationsWithMissingPoses(SfMData& sfm_data, const IndexT min_points_per_landmark)
+bool eraseObservationsWithMissingPoses(SfMData& sfm_data, const IndexT min_points_per_landmark,
+                                       std::set<IndexT>* outRemovedLandmarkId)
 {
   IndexT removed_elements = 0;
 
@@ -165,7 +184,11 @@ bool eraseObservationsWithMissingPoses(SfMData& sfm_data, const IndexT min_point
         ++itObs;
     }
     if (observations.empty() || observations.size() < min_points_per_landmark)
+    {
+      if (outRemovedLandmarkId != NULL)
+        outRemovedLandmarkId->insert(itLandmarks->first);
       itLandmarks = sfm_data.structure.erase(itLandmarks);
+    }
     else
       ++itLandmarks;
   }
@@ -177,7 +200,9 @@ bool eraseUnstablePosesAndObservations(
   SfMData& sfm_data,
   const IndexT min_points_per_pose,
   const IndexT min_points_per_landmark,
-  std::set<IndexT>* outRemovedPosedId)
+  std::set<IndexT>* outRemovedPosedId,
+  const HashMap<IndexT, IndexT>* externalObservationsPerPose,
+  std::set<IndexT>* outRemovedLandmarkId)
 {
   IndexT remove_iteration = 0;
   bool bRemovedContent = false;
@@ -186,10 +211,10 @@ bool eraseUnstablePosesAndObservations(
   do
   {
     bRemovedContent = false;
-    if (eraseUnstablePoses(sfm_data, min_points_per_pose, outRemovedPosedId))
+    if (eraseUnstablePoses(sfm_data, min_points_per_pose, outRemovedPosedId, externalObservationsPerPose))
     {
       bRemovedPoses = true;
-      bRemovedContent = eraseObservationsWithMissingPoses(sfm_data, min_points_per_landmark);
+      bRemovedContent = eraseObservationsWithMissingPoses(sfm_data, min_points_per_landmark, outRemovedLandmarkId);
       if (bRemovedContent)
         bRemovedObservations = true;
       // Erase some observations can make some Poses index disappear so perform the process in a loop
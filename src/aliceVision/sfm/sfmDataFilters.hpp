@@ -28,23 +28,32 @@ inline PairSet Pair_filter(const IterablePairs& pairs, const IterableIndex& inde
 
 /// Remove observations with too large reprojection error.
 /// Return the number of removed tracks.
+/// outRemovedLandmarkId: ids of the landmarks removed for a lack of observations (optional)
 IndexT RemoveOutliers_PixelResidualError(SfMData& sfm_data,
                                          const double dThresholdPixel,
-                                         const unsigned int minTrackLength = 2);
+                                         const unsigned int minTrackLength = 2,
+                                         std::set<IndexT>* outRemovedLandmarkId = NULL);
 
 // Remove tracks that have a small angle (tracks with tiny angle leads to instable 3D points)
 // Return the number of removed tracks
-IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAngle);
+IndexT RemoveOutliers_AngleError(SfMData& sfm_data, const double dMinAcceptedAngle,
+                                 std::set<IndexT>* outRemovedLandmarkId = NULL);
 
-bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std::set<IndexT> *outRemovedPosedId = NULL);
+/// Remove the poses with too few observations.
+/// externalObservationsPerPose: number of observations of each pose in landmarks stored outside of sfm_data (optional)
+bool eraseUnstablePoses(SfMData& sfm_data, const IndexT min_points_per_pose, std::set<IndexT> *outRemovedPosedId = NULL,
+                        const HashMap<IndexT, IndexT>* externalObservationsPerPose = NULL);
 
-bool eraseObservationsWithMissingPoses(SfMData& sfm_data, const IndexT min_points_per_landmark);
+bool eraseObservationsWithMissingPoses(SfMData& sfm_data, const IndexT min_points_per_landmark,
+                                       std::set<IndexT>* outRemovedLandmarkId = NULL);
 
 /// Remove unstable content from analysis of the sfm_data structure
 bool eraseUnstablePosesAndObservations(SfMData& sfm_data,
                                        const IndexT min_points_per_pose = 6,
                                        const IndexT min_points_per_landmark = 2, 
-                                       std::set<IndexT> *outRemovedPosedId = NULL);
+                                       std::set<IndexT> *outRemovedPosedId = NULL,
+                                       const HashMap<IndexT, IndexT>* externalObservationsPerPose = NULL,
+                                       std::set<IndexT>* outRemovedLandmarkId = NULL);
 
 } // namespace sfm
 } // namespace aliceVision
@@ -208,5 +208,65 @@ SfMData getInputRigScene(const NViewDataSet& d,
   return sfmData;
 }
 
+SfMData generateSyntheticScene(std::size_t nbViews,
+                               std::size_t nbLandmarks,
+                               std::size_t nbObservationsPerLandmark,
+                               unsigned int seed,
+                               double noise)
+{
+  assert(nbObservationsPerLandmark >= 2 && nbObservationsPerLandmark <= nbViews);
+
+  SfMData sfmData;
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> uniform(-0.5, 0.5);
+  std::normal_distribution<double> gaussian(0.0, noise > 0.0 ? noise : 1.0);
+
+  const unsigned int w = 1920;
+  const unsigned int h = 1080;
+  const double focal = 1000.0;
+  const IndexT intrinsicId = 0; // shared intrinsic
+  sfmData.intrinsics[intrinsicId] = std::make_shared<camera::Pinhole>(w, h, focal, w / 2.0, h / 2.0);
+
+  // 1. Views and poses: camera i at (i, 0, 0) looking along +Z
+  for(std::size_t i = 0; i < nbViews; ++i)
+  {
+    const IndexT viewId = static_cast<IndexT>(i);
+    sfmData.views[viewId] = std::make_shared<View>("", viewId, intrinsicId, viewId, w, h);
+    sfmData.setPose(*sfmData.views.at(viewId), CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(static_cast<double>(i), 0.0, 0.0))));
+  }
+
+  // 2. Landmarks on a wall at a distance proportional to the number of observations,
+  //    so the landmarks stay in the field of view of the cameras which see them.
+  const camera::IntrinsicBase* intrinsic = sfmData.intrinsics.at(intrinsicId).get();
+  const double wallDistance = 2.0 * nbObservationsPerLandmark;
+  const std::size_t nbFirstViews = nbViews - nbObservationsPerLandmark + 1;
+  std::vector<IndexT> nbFeaturesPerView(nbViews, 0);
+
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    const std::size_t firstView = generator() % nbFirstViews;
+
+    Landmark& landmark = sfmData.structure[static_cast<IndexT>(i)];
+    landmark.descType = feature::EImageDescriberType::SIFT;
+    landmark.X = Vec3(firstView + 0.5 * (nbObservationsPerLandmark - 1) + uniform(generator),
+                      0.5 * nbObservationsPerLandmark * uniform(generator),
+                      wallDistance * (1.0 + 0.25 * uniform(generator)));
+
+    for(std::size_t j = firstView; j < firstView + nbObservationsPerLandmark; ++j)
+    {
+      const IndexT viewId = static_cast<IndexT>(j);
+      Vec2 pt = intrinsic->project(sfmData.getPose(*sfmData.views.at(viewId)).getTransform(), landmark.X);
+      if(noise > 0.0)
+      {
+        pt(0) += gaussian(generator);
+        pt(1) += gaussian(generator);
+      }
+      landmark.observations[viewId] = Observation(pt, nbFeaturesPerView[j]++);
+    }
+  }
+
+  return sfmData;
+}
+
 } // namespace sfm
 } // namespace aliceVision
@@ -84,5 +84,25 @@ SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& con
 // As only one intrinsic is defined we used shared intrinsic
 SfMData getInputRigScene(const NViewDataSet& d, const NViewDatasetConfigurator& config, camera::EINTRINSIC eintrinsic);
 
+/**
+ * @brief Generate a large synthetic scene (deterministic for a given seed).
+ *
+ * The cameras move along a line looking at a "wall" of landmarks,
+ * each landmark is observed by nbObservationsPerLandmark consecutive cameras.
+ * So the scene size (views, observations) can be chosen independently and the
+ * co-visibility graph is sparse, as in a real large scale reconstruction.
+ *
+ * @param[in] nbViews number of views (one pose per view, shared intrinsic)
+ * @param[in] nbLandmarks number of landmarks
+ * @param[in] nbObservationsPerLandmark number of observations of each landmark
+ * @param[in] seed random generator seed
+ * @param[in] noise standard deviation of the noise added to the observations (pixels)
+ */
+SfMData generateSyntheticScene(std::size_t nbViews,
+                               std::size_t nbLandmarks,
+                               std::size_t nbObservationsPerLandmark,
+                               unsigned int seed = 0,
+                               double noise = 0.0);
+
 } // namespace sfm
 } // namespace aliceVision
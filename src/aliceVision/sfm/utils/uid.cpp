@@ -8,9 +8,14 @@
 #include "uid.hpp"
 
 #include <aliceVision/sfm/View.hpp>
+#include <aliceVision/system/Sha256.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
@@ -70,6 +75,32 @@ std::size_t computeUID(const View& view)
   return uid;
 }
 
+std::string computeFileUID(const std::string& filepath)
+{
+  std::ifstream stream(filepath, std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Unable to read the file '" + filepath + "' to compute its UID.");
+
+  // digest the file by chunks to bound the memory usage
+  const std::size_t chunkSize = 4 * 1024 * 1024;
+  std::vector<char> chunk(chunkSize);
+  system::Sha256 sha256;
+
+  while(stream)
+  {
+    stream.read(chunk.data(), chunkSize);
+    const std::size_t readSize = stream.gcount();
+    if(readSize == 0)
+      break;
+    sha256.update(chunk.data(), readSize);
+  }
+
+  if(stream.bad())
+    throw std::runtime_error("Unable to read the file '" + filepath + "' to compute its UID.");
+
+  return sha256.hexDigest();
+}
+
 void updateStructureWithNewUID(Landmarks &landmarks, const std::map<std::size_t, std::size_t> &oldIdToNew)
 {
   // update the id in the visibility of each 3D point
@@ -10,6 +10,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 
 #include <map>
+#include <string>
 
 namespace aliceVision {
 namespace sfm {
@@ -21,6 +22,15 @@ namespace sfm {
  */
 std::size_t computeUID(const View& view);
 
+/**
+ * @brief Compute a UID from the content of a file: its SHA-256 digest.
+ * Used as a content-addressed key: the UID changes if the file content changes,
+ * not if the file is renamed or moved.
+ * @param[in] filepath The file to digest
+ * @return the file UID (hexadecimal SHA-256 digest)
+ */
+std::string computeFileUID(const std::string& filepath);
+
 /**
  * @brief Update all viewID referenced in the observation of each landmark according 
  * to the provided mapping.
@@ -0,0 +1,147 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Sha256.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+const uint32_t ROUND_CONSTANTS[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotateRight(uint32_t x, int n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+} // namespace
+
+Sha256::Sha256()
+  : _state{{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}}
+{}
+
+void Sha256::update(const void* data, std::size_t size)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  _size += size;
+
+  // complete the pending block
+  if(_bufferSize > 0)
+  {
+    const std::size_t copySize = std::min(size, _buffer.size() - _bufferSize);
+    std::memcpy(_buffer.data() + _bufferSize, bytes, copySize);
+    _bufferSize += copySize;
+    bytes += copySize;
+    size -= copySize;
+    if(_bufferSize < _buffer.size())
+      return;
+    processBlock(_buffer.data());
+    _bufferSize = 0;
+  }
+
+  // full blocks are processed in place
+  for(; size >= _buffer.size(); bytes += _buffer.size(), size -= _buffer.size())
+    processBlock(bytes);
+
+  if(size > 0)
+  {
+    std::memcpy(_buffer.data(), bytes, size);
+    _bufferSize = size;
+  }
+}
+
+std::array<uint8_t, 32> Sha256::digest() const
+{
+  // padding: 0x80, zeros and the size in bits (big endian) on a copy
+  Sha256 final(*this);
+  const uint64_t bitSize = _size * 8;
+  const uint8_t padding[64] = {0x80};
+  const std::size_t paddingSize = (_bufferSize < 56) ? (56 - _bufferSize) : (120 - _bufferSize);
+  final.update(padding, paddingSize);
+
+  uint8_t sizeBytes[8];
+  for(int i = 0; i < 8; ++i)
+    sizeBytes[i] = static_cast<uint8_t>(bitSize >> (56 - 8 * i));
+  final.update(sizeBytes, 8);
+
+  std::array<uint8_t, 32> result;
+  for(std::size_t i = 0; i < final._state.size(); ++i)
+  {
+    for(int j = 0; j < 4; ++j)
+      result[i * 4 + j] = static_cast<uint8_t>(final._state[i] >> (24 - 8 * j));
+  }
+  return result;
+}
+
+std::string Sha256::hexDigest() const
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  const std::array<uint8_t, 32> bytes = digest();
+  std::string result(bytes.size() * 2, '0');
+  for(std::size_t i = 0; i < bytes.size(); ++i)
+  {
+    result[2 * i] = hexDigits[bytes[i] >> 4];
+    result[2 * i + 1] = hexDigits[bytes[i] & 0xf];
+  }
+  return result;
+}
+
+void Sha256::processBlock(const uint8_t* block)
+{
+  uint32_t w[64];
+  for(int i = 0; i < 16; ++i)
+  {
+    w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+           (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+  }
+  for(int i = 16; i < 64; ++i)
+  {
+    const uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    const uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+
+  for(int i = 0; i < 64; ++i)
+  {
+    const uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+    const uint32_t ch = (e & f) ^ (~e & g);
+    const uint32_t temp1 = h + s1 + ch + ROUND_CONSTANTS[i] + w[i];
+    const uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+    const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    const uint32_t temp2 = s0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  _state[0] += a; _state[1] += b; _state[2] += c; _state[3] += d;
+  _state[4] += e; _state[5] += f; _state[6] += g; _state[7] += h;
+}
+
+} // namespace system
+} // namespace aliceVision
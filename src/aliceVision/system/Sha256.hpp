@@ -0,0 +1,53 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Incremental SHA-256 digest (FIPS 180-4).
+ */
+class Sha256
+{
+public:
+  Sha256();
+
+  /**
+   * @brief Add data to the digest
+   * @param[in] data The data
+   * @param[in] size The data size in bytes
+   */
+  void update(const void* data, std::size_t size);
+
+  void update(const std::string& data)
+  {
+    update(data.data(), data.size());
+  }
+
+  /// @return the digest of the data added so far, the digest can still be updated
+  std::array<uint8_t, 32> digest() const;
+
+  /// @return the digest of the data added so far as a lowercase hexadecimal string
+  std::string hexDigest() const;
+
+private:
+  void processBlock(const uint8_t* block);
+
+  std::array<uint32_t, 8> _state;
+  std::array<uint8_t, 64> _buffer;
+  std::size_t _bufferSize = 0;
+  uint64_t _size = 0;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -164,3 +164,119 @@ int get_total_cpus(void)
 
 #endif /* GET_TOTAL_CPUS_DEFINED */
 
+
+
+/* get_cpu_features() x86 specific code: uses cpuid and xgetbv */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+namespace aliceVision {
+namespace system {
+namespace {
+
+void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for(int i = 0; i < 4; ++i)
+		regs[i] = static_cast<unsigned int>(info[i]);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+unsigned long long xgetbv0()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures detect_cpu_features()
+{
+	CpuFeatures features;
+	unsigned int regs[4] = {0, 0, 0, 0};
+
+	cpuid(0, 0, regs);
+	const unsigned int maxLeaf = regs[0];
+	if(maxLeaf < 1)
+		return features;
+
+	cpuid(1, 0, regs);
+	features.sse2 = (regs[3] >> 26) & 1;
+	features.sse41 = (regs[2] >> 19) & 1;
+	features.sse42 = (regs[2] >> 20) & 1;
+	features.popcnt = (regs[2] >> 23) & 1;
+
+	const bool osxsave = (regs[2] >> 27) & 1;
+	const bool cpuAvx = (regs[2] >> 28) & 1;
+	const bool cpuFma = (regs[2] >> 12) & 1;
+
+	// check that the OS saves the YMM (and ZMM) registers
+	const unsigned long long xcr0 = osxsave ? xgetbv0() : 0;
+	const bool osAvx = (xcr0 & 0x6) == 0x6;
+	const bool osAvx512 = (xcr0 & 0xe6) == 0xe6;
+
+	features.avx = cpuAvx && osAvx;
+	features.fma = cpuFma && features.avx;
+
+	if(maxLeaf < 7)
+		return features;
+
+	cpuid(7, 0, regs);
+	features.avx2 = features.avx && ((regs[1] >> 5) & 1);
+	features.avx512f = osAvx512 && ((regs[1] >> 16) & 1);
+	features.avx512bw = features.avx512f && ((regs[1] >> 30) & 1);
+	features.avx512vnni = features.avx512f && ((regs[2] >> 11) & 1);
+	features.avx512vpopcntdq = features.avx512f && ((regs[2] >> 14) & 1);
+
+	return features;
+}
+
+} // namespace
+
+const CpuFeatures& get_cpu_features()
+{
+	static const CpuFeatures features = detect_cpu_features();
+	return features;
+}
+}}
+#else
+namespace aliceVision {
+namespace system {
+
+const CpuFeatures& get_cpu_features()
+{
+	static const CpuFeatures features;
+	return features;
+}
+}}
+#endif /* x86 */
+
+namespace aliceVision {
+namespace system {
+
+std::ostream& operator<<(std::ostream& os, const CpuFeatures& features)
+{
+	os << "sse2: " << features.sse2
+	   << ", sse4.1: " << features.sse41
+	   << ", sse4.2: " << features.sse42
+	   << ", popcnt: " << features.popcnt
+	   << ", avx: " << features.avx
+	   << ", avx2: " << features.avx2
+	   << ", fma: " << features.fma
+	   << ", avx512f: " << features.avx512f
+	   << ", avx512bw: " << features.avx512bw
+	   << ", avx512vnni: " << features.avx512vnni
+	   << ", avx512vpopcntdq: " << features.avx512vpopcntdq;
+	return os;
+}
+}}
@@ -6,9 +6,39 @@
 
 #pragma once
 
+#include <ostream>
+
 namespace aliceVision {
 namespace system {
 
+/**
+ * @brief x86 instruction set extensions supported by the CPU and enabled by the OS.
+ * All the flags are false on other architectures.
+ */
+struct CpuFeatures
+{
+  bool sse2 = false;
+  bool sse41 = false;
+  bool sse42 = false;
+  bool popcnt = false;
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool avx512f = false;
+  bool avx512bw = false;
+  bool avx512vnni = false;
+  bool avx512vpopcntdq = false;
+};
+
+/**
+ * @brief Returns the instruction set extensions of the CPU.
+ *
+ * Detected once with cpuid (and xgetbv for the AVX / AVX-512 register states).
+ */
+const CpuFeatures& get_cpu_features();
+
+std::ostream& operator<<(std::ostream& os, const CpuFeatures& features);
+
 /**
  * @brief Returns the CPU clock, as reported by the OS.
  *
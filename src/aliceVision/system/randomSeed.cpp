@@ -0,0 +1,76 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "randomSeed.hpp"
+
+#include <atomic>
+#include <random>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+std::atomic<bool> deterministicMode(false);
+std::atomic<uint64_t> globalSeed(0);
+
+// task of the calling thread and number of seeds requested by this task
+thread_local uint64_t currentTaskId = 0;
+thread_local uint64_t currentCounter = 0;
+
+/// SplitMix64 finalizer: decorrelates close inputs (task ids, counters)
+inline uint64_t mix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+void setDeterministicMode(uint64_t seed)
+{
+  globalSeed = seed;
+  deterministicMode = true;
+}
+
+void unsetDeterministicMode()
+{
+  deterministicMode = false;
+}
+
+bool isDeterministicMode()
+{
+  return deterministicMode;
+}
+
+unsigned int getRandomSeed()
+{
+  if(!deterministicMode)
+    return std::random_device()();
+
+  const uint64_t seed = mix(mix(mix(globalSeed) ^ currentTaskId) ^ currentCounter++);
+  return static_cast<unsigned int>(seed ^ (seed >> 32));
+}
+
+RandomTaskScope::RandomTaskScope(uint64_t taskId)
+  : _previousTaskId(currentTaskId)
+  , _previousCounter(currentCounter)
+{
+  // the task id 0 is used outside of any task
+  currentTaskId = mix(taskId) + 1;
+  currentCounter = 0;
+}
+
+RandomTaskScope::~RandomTaskScope()
+{
+  currentTaskId = _previousTaskId;
+  currentCounter = _previousCounter;
+}
+
+} // namespace system
+} // namespace aliceVision
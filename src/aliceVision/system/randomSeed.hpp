@@ -0,0 +1,63 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstdint>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Enable the deterministic mode: the seeds of the random number generators are
+ * derived from the given global seed instead of std::random_device.
+ * @param[in] seed global seed
+ */
+void setDeterministicMode(uint64_t seed);
+
+/**
+ * @brief Disable the deterministic mode (default): the seeds are drawn from std::random_device.
+ */
+void unsetDeterministicMode();
+
+/// @return true if the deterministic mode is enabled
+bool isDeterministicMode();
+
+/**
+ * @brief Seed for a new random number generator.
+ *
+ * In deterministic mode, the seed is derived from the global seed, the current task
+ * (see RandomTaskScope) and the number of seeds already requested by this task.
+ * So the seeds of a task do not depend on the thread running it.
+ * Otherwise, the seed is drawn from std::random_device.
+ *
+ * @return the seed
+ */
+unsigned int getRandomSeed();
+
+/**
+ * @brief Set the current task of the calling thread (e.g. a view id or a pair index)
+ * for the duration of the scope, the previous task is restored at the end of the scope.
+ *
+ * In deterministic mode, each task has its own stream of seeds,
+ * a parallel loop should declare a task per iteration to be reproducible.
+ */
+class RandomTaskScope
+{
+public:
+  explicit RandomTaskScope(uint64_t taskId);
+  ~RandomTaskScope();
+
+  RandomTaskScope(const RandomTaskScope&) = delete;
+  RandomTaskScope& operator=(const RandomTaskScope&) = delete;
+
+private:
+  uint64_t _previousTaskId;
+  uint64_t _previousCounter;
+};
+
+} // namespace system
+} // namespace aliceVision
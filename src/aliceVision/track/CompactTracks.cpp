@@ -0,0 +1,236 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompactTracks.hpp"
+
+#include <iterator>
+
+namespace aliceVision {
+namespace track {
+
+void CompactTracks::build(const TracksMap& tracks)
+{
+  const std::size_t nbTracks = tracks.size();
+
+  _trackIds.clear();
+  _descTypes.clear();
+  _trackIds.reserve(nbTracks);
+  _descTypes.reserve(nbTracks);
+  _trackOffsets.assign(1, 0);
+  _trackOffsets.reserve(nbTracks + 1);
+  _contiguousIds = true;
+
+  std::size_t nbObservations = 0;
+  for(const auto& track: tracks)
+  {
+    _contiguousIds = _contiguousIds && (track.first == _trackIds.size());
+    _trackIds.push_back(track.first);
+    _descTypes.push_back(track.second.descType);
+    nbObservations += track.second.featPerView.size();
+    _trackOffsets.push_back(nbObservations);
+  }
+
+  _viewIds.resize(nbObservations);
+  _featIds.resize(nbObservations);
+
+  // features of each track (TracksMap is sorted by track id and featPerView by view id)
+  std::map<IndexT, std::size_t> nbTracksPerView;
+  std::size_t i = 0;
+  for(const auto& track: tracks)
+  {
+    for(const auto& feat: track.second.featPerView)
+    {
+      _viewIds[i] = static_cast<IndexT>(feat.first);
+      _featIds[i] = static_cast<IndexT>(feat.second);
+      ++nbTracksPerView[_viewIds[i]];
+      ++i;
+    }
+  }
+
+  // reverse index
+  _views.clear();
+  _views.reserve(nbTracksPerView.size());
+  _viewOffsets.assign(1, 0);
+  _viewOffsets.reserve(nbTracksPerView.size() + 1);
+  for(const auto& viewCount: nbTracksPerView)
+  {
+    _views.push_back(viewCount.first);
+    _viewOffsets.push_back(_viewOffsets.back() + viewCount.second);
+  }
+
+  _viewTrackIndexes.resize(nbObservations);
+  std::vector<std::size_t> positions(_viewOffsets.begin(), _viewOffsets.end() - 1);
+  for(IndexT t = 0; t < nbTracks; ++t)
+  {
+    for(const IndexT viewId: trackViews(t))
+    {
+      const std::size_t v = std::lower_bound(_views.begin(), _views.end(), viewId) - _views.begin();
+      _viewTrackIndexes[positions[v]++] = t;
+    }
+  }
+}
+
+void CompactTracks::exportToSTL(TracksMap& tracks) const
+{
+  tracks.clear();
+  tracks.reserve(nbTracks());
+  for(IndexT t = 0; t < nbTracks(); ++t)
+  {
+    Track& track = tracks.emplace_hint(tracks.end(), _trackIds[t], Track())->second;
+    track.descType = _descTypes[t];
+    track.featPerView.reserve(trackLength(t));
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+      track.featPerView.emplace_hint(track.featPerView.end(), _viewIds[i], _featIds[i]);
+  }
+}
+
+IndexT CompactTracks::trackIndex(std::size_t trackId) const
+{
+  if(_contiguousIds)
+    return (trackId < _trackIds.size()) ? static_cast<IndexT>(trackId) : UndefinedIndexT;
+
+  const auto it = std::lower_bound(_trackIds.begin(), _trackIds.end(), trackId);
+  if(it == _trackIds.end() || *it != trackId)
+    return UndefinedIndexT;
+  return static_cast<IndexT>(it - _trackIds.begin());
+}
+
+IndexT CompactTracks::featureInView(IndexT trackIndex, IndexT viewId) const
+{
+  const Range<IndexT> views = trackViews(trackIndex);
+  const IndexT* it = std::lower_bound(views.begin(), views.end(), viewId);
+  if(it == views.end() || *it != viewId)
+    return UndefinedIndexT;
+  return _featIds[_trackOffsets[trackIndex] + (it - views.begin())];
+}
+
+CompactTracks::Range<IndexT> CompactTracks::tracksInView(IndexT viewId) const
+{
+  const auto it = std::lower_bound(_views.begin(), _views.end(), viewId);
+  if(it == _views.end() || *it != viewId)
+    return {nullptr, nullptr};
+  const std::size_t v = it - _views.begin();
+  return {_viewTrackIndexes.data() + _viewOffsets[v], _viewTrackIndexes.data() + _viewOffsets[v + 1]};
+}
+
+namespace tracksUtilsMap {
+
+namespace {
+
+/**
+ * @brief Indexes of the tracks visible in all the given images (sorted)
+ */
+void getCommonTrackIndexes(const std::set<std::size_t>& imageIndexes,
+                           const CompactTracks& tracks,
+                           std::vector<IndexT>& trackIndexes)
+{
+  trackIndexes.clear();
+  if(imageIndexes.empty())
+    return;
+
+  std::vector<IndexT> tmp;
+  bool first = true;
+  for(const std::size_t imageIndex: imageIndexes)
+  {
+    const CompactTracks::Range<IndexT> imageTracks = tracks.tracksInView(static_cast<IndexT>(imageIndex));
+    if(imageTracks.empty())
+    {
+      // one image is not present in the tracks, so there is no track in common
+      trackIndexes.clear();
+      return;
+    }
+    if(first)
+    {
+      trackIndexes.assign(imageTracks.begin(), imageTracks.end());
+      first = false;
+      continue;
+    }
+    tmp.clear();
+    std::set_intersection(trackIndexes.begin(), trackIndexes.end(),
+                          imageTracks.begin(), imageTracks.end(),
+                          std::back_inserter(tmp));
+    trackIndexes.swap(tmp);
+    if(trackIndexes.empty())
+      return;
+  }
+}
+
+} // namespace
+
+void getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
+                             const CompactTracks& tracks,
+                             std::set<std::size_t>& visibleTracks)
+{
+  assert(!imageIndexes.empty());
+  visibleTracks.clear();
+
+  std::vector<IndexT> trackIndexes;
+  getCommonTrackIndexes(imageIndexes, tracks, trackIndexes);
+
+  for(const IndexT t: trackIndexes)
+    visibleTracks.insert(visibleTracks.end(), tracks.trackId(t));
+}
+
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const CompactTracks& tracks,
+                                 TracksMap& tracksOut)
+{
+  assert(!imageIndexes.empty());
+  tracksOut.clear();
+
+  std::vector<IndexT> trackIndexes;
+  getCommonTrackIndexes(imageIndexes, tracks, trackIndexes);
+
+  tracksOut.reserve(trackIndexes.size());
+  for(const IndexT t: trackIndexes)
+  {
+    Track& trackFeatsOut = tracksOut.emplace_hint(tracksOut.end(), tracks.trackId(t), Track())->second;
+    trackFeatsOut.descType = tracks.descType(t);
+    trackFeatsOut.featPerView.reserve(imageIndexes.size());
+    for(const std::size_t imageIndex: imageIndexes)
+      trackFeatsOut.featPerView.emplace_hint(trackFeatsOut.featPerView.end(), imageIndex,
+                                             tracks.featureInView(t, static_cast<IndexT>(imageIndex)));
+  }
+  return !tracksOut.empty();
+}
+
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const CompactTracks& tracks,
+                           std::set<IndexT>& tracksIds)
+{
+  tracksIds.clear();
+  for(const IndexT id: imagesId)
+  {
+    for(const IndexT t: tracks.tracksInView(id))
+      tracksIds.insert(static_cast<IndexT>(tracks.trackId(t)));
+  }
+}
+
+void computeTracksPerView(const CompactTracks& tracks, TracksPerView& tracksPerView)
+{
+  tracksPerView.clear();
+  tracksPerView.reserve(tracks.views().size());
+  for(const IndexT viewId: tracks.views())
+  {
+    TrackIdSet& tracksSet = tracksPerView.emplace_hint(tracksPerView.end(), viewId, TrackIdSet())->second;
+    const CompactTracks::Range<IndexT> viewTracks = tracks.tracksInView(viewId);
+    tracksSet.reserve(viewTracks.size());
+    // track indexes are sorted, so are the track ids
+    for(const IndexT t: viewTracks)
+      tracksSet.push_back(tracks.trackId(t));
+  }
+}
+
+void tracksLength(const CompactTracks& tracks,
+                  std::map<std::size_t, std::size_t>& occurenceTrackLength)
+{
+  for(IndexT t = 0; t < tracks.nbTracks(); ++t)
+    ++occurenceTrackLength[tracks.trackLength(t)];
+}
+
+} // namespace tracksUtilsMap
+} // namespace track
+} // namespace aliceVision
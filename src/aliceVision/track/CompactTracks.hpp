@@ -0,0 +1,166 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/types.hpp>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Read-only tracks storage with contiguous arrays (CSR layout).
+ *
+ * Tracks are sorted by track id and addressed by their index in [0, nbTracks()).
+ * The observations of the track at index t are at [trackBegin(t), trackEnd(t))
+ * in the view ids and feature ids arrays, sorted by view id.
+ *
+ * A reverse index gives, for each view, the indexes of the tracks visible in
+ * this view (in increasing order, so also sorted by track id).
+ */
+class CompactTracks
+{
+public:
+  /// Read-only range on a contiguous array
+  template<typename T>
+  struct Range
+  {
+    const T* first;
+    const T* last;
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const T& operator[](std::size_t i) const { return first[i]; }
+  };
+
+  CompactTracks() = default;
+
+  explicit CompactTracks(const TracksMap& tracks)
+  {
+    build(tracks);
+  }
+
+  /**
+   * @brief Build the storage from a TracksMap
+   * @param[in] tracks
+   */
+  void build(const TracksMap& tracks);
+
+  /**
+   * @brief Export the tracks as a TracksMap
+   * @param[out] tracks
+   */
+  void exportToSTL(TracksMap& tracks) const;
+
+  std::size_t nbTracks() const { return _trackIds.size(); }
+  std::size_t nbObservations() const { return _viewIds.size(); }
+  bool empty() const { return _trackIds.empty(); }
+
+  /// @return the index of the track with the given id or UndefinedIndexT
+  IndexT trackIndex(std::size_t trackId) const;
+
+  std::size_t trackId(IndexT trackIndex) const { return _trackIds[trackIndex]; }
+  feature::EImageDescriberType descType(IndexT trackIndex) const { return _descTypes[trackIndex]; }
+  std::size_t trackLength(IndexT trackIndex) const { return _trackOffsets[trackIndex + 1] - _trackOffsets[trackIndex]; }
+
+  std::size_t trackBegin(IndexT trackIndex) const { return _trackOffsets[trackIndex]; }
+  std::size_t trackEnd(IndexT trackIndex) const { return _trackOffsets[trackIndex + 1]; }
+
+  /// @return the view ids of a track (sorted)
+  Range<IndexT> trackViews(IndexT trackIndex) const
+  {
+    return {_viewIds.data() + _trackOffsets[trackIndex], _viewIds.data() + _trackOffsets[trackIndex + 1]};
+  }
+
+  /// @return the feature ids of a track (in the order of trackViews)
+  Range<IndexT> trackFeatures(IndexT trackIndex) const
+  {
+    return {_featIds.data() + _trackOffsets[trackIndex], _featIds.data() + _trackOffsets[trackIndex + 1]};
+  }
+
+  /// @return the feature id of a track in a view or UndefinedIndexT if the track is not visible in this view
+  IndexT featureInView(IndexT trackIndex, IndexT viewId) const;
+
+  /// @return the views with at least one track (sorted)
+  const std::vector<IndexT>& views() const { return _views; }
+
+  /// @return the indexes of the tracks visible in a view (sorted), empty if the view is unknown
+  Range<IndexT> tracksInView(IndexT viewId) const;
+
+private:
+  // tracks
+  std::vector<std::size_t> _trackIds;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  std::vector<std::size_t> _trackOffsets;
+  std::vector<IndexT> _viewIds;
+  std::vector<IndexT> _featIds;
+  /// true if the track ids are [0, nbTracks)
+  bool _contiguousIds = true;
+
+  // reverse index: view -> tracks
+  std::vector<IndexT> _views;
+  std::vector<std::size_t> _viewOffsets;
+  std::vector<IndexT> _viewTrackIndexes;
+};
+
+namespace tracksUtilsMap {
+
+/**
+ * @brief Find common tracks among a set of images.
+ * @param[in] imageIndexes: set of images we are looking for common tracks.
+ * @param[in] tracks: all tracks of the scene.
+ * @param[out] visibleTracks: output with only the common track ids.
+ */
+void getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
+                             const CompactTracks& tracks,
+                             std::set<std::size_t>& visibleTracks);
+
+/**
+ * @brief Find common tracks among images.
+ * @param[in] imageIndexes: set of images we are looking for common tracks.
+ * @param[in] tracks: all tracks of the scene.
+ * @param[out] tracksOut: output with only the common tracks.
+ */
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const CompactTracks& tracks,
+                                 TracksMap& tracksOut);
+
+/**
+ * @brief Find all the visible tracks from a set of images.
+ * @param[in] imagesId set of images we are looking for tracks.
+ * @param[in] tracks all tracks of the scene.
+ * @param[out] tracksIds the tracks in the images
+ */
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const CompactTracks& tracks,
+                           std::set<IndexT>& tracksIds);
+
+/**
+ * @brief computeTracksPerView
+ * @param[in] tracks
+ * @param[out] tracksPerView
+ */
+void computeTracksPerView(const CompactTracks& tracks, TracksPerView& tracksPerView);
+
+/**
+ * @brief Return the occurrence of tracks length.
+ * @param[in] tracks
+ * @param[out] occurenceTrackLength
+ */
+void tracksLength(const CompactTracks& tracks,
+                  std::map<std::size_t, std::size_t>& occurenceTrackLength);
+
+} // namespace tracksUtilsMap
+} // namespace track
+} // namespace aliceVision
@@ -0,0 +1,140 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Lock-free union-find (disjoint sets) on dense ids [0, size).
+ *
+ * Each element is stored in a single 64 bits atomic word: the rank in the high
+ * 32 bits and the parent id in the low 32 bits, so unite() and find() can be
+ * called concurrently from several threads.
+ * - find() uses path halving (CAS on the parent, failures are ignored),
+ * - unite() links the root with the lowest rank below the other one
+ *   (ties are broken by id) and retries if a root changed in between.
+ */
+class ConcurrentUnionFind
+{
+public:
+  typedef std::uint32_t IdT;
+
+  explicit ConcurrentUnionFind(std::size_t size)
+    : _size(size)
+    , _data(new std::atomic<std::uint64_t>[size])
+  {
+    for(std::size_t i = 0; i < size; ++i)
+      _data[i].store(i, std::memory_order_relaxed);
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  /**
+   * @brief Find the root of the set containing id
+   */
+  IdT find(IdT id) const
+  {
+    while(true)
+    {
+      const std::uint64_t value = _data[id].load(std::memory_order_relaxed);
+      const IdT parentId = parent(value);
+      if(parentId == id)
+        return id;
+
+      const IdT grandParentId = parent(_data[parentId].load(std::memory_order_relaxed));
+      if(parentId != grandParentId)
+      {
+        // path halving: link id to its grand parent
+        std::uint64_t expected = value;
+        _data[id].compare_exchange_weak(expected, makeValue(rank(value), grandParentId), std::memory_order_relaxed);
+      }
+      id = grandParentId;
+    }
+  }
+
+  /**
+   * @brief Merge the sets containing a and b
+   * @return false if a and b were already in the same set
+   */
+  bool unite(IdT a, IdT b)
+  {
+    while(true)
+    {
+      a = find(a);
+      b = find(b);
+      if(a == b)
+        return false;
+
+      std::uint32_t rankA = rank(_data[a].load(std::memory_order_relaxed));
+      std::uint32_t rankB = rank(_data[b].load(std::memory_order_relaxed));
+
+      // link a below b
+      if(rankA > rankB || (rankA == rankB && a < b))
+      {
+        std::swap(a, b);
+        std::swap(rankA, rankB);
+      }
+
+      std::uint64_t expected = makeValue(rankA, a);
+      if(!_data[a].compare_exchange_strong(expected, makeValue(rankA, b), std::memory_order_relaxed))
+        continue; // a is not a root with this rank anymore
+
+      if(rankA == rankB)
+      {
+        // increase the rank of the new root (if it has not been modified meanwhile)
+        expected = makeValue(rankB, b);
+        _data[b].compare_exchange_strong(expected, makeValue(rankB + 1, b), std::memory_order_relaxed);
+      }
+      return true;
+    }
+  }
+
+  bool sameSet(IdT a, IdT b) const
+  {
+    while(true)
+    {
+      a = find(a);
+      b = find(b);
+      if(a == b)
+        return true;
+      // a is still a root: a and b are in different sets
+      if(parent(_data[a].load(std::memory_order_relaxed)) == a)
+        return false;
+    }
+  }
+
+private:
+  static IdT parent(std::uint64_t value)
+  {
+    return static_cast<IdT>(value & 0xffffffffu);
+  }
+
+  static std::uint32_t rank(std::uint64_t value)
+  {
+    return static_cast<std::uint32_t>(value >> 32);
+  }
+
+  static std::uint64_t makeValue(std::uint32_t rank, IdT parent)
+  {
+    return (static_cast<std::uint64_t>(rank) << 32) | parent;
+  }
+
+  std::size_t _size;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> _data;
+};
+
+} // namespace track
+} // namespace aliceVision
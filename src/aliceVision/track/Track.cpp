@@ -6,6 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Track.hpp"
+#include "ConcurrentUnionFind.hpp"
+
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace track {
@@ -161,6 +166,336 @@ void TracksBuilder::exportToSTL(TracksMap& allTracks) const
   }
 }
 
+void ParallelTracksBuilder::build(const PairwiseMatches& pairwiseMatches)
+{
+  typedef ConcurrentUnionFind::IdT IdT;
+  const IdT invalidId = std::numeric_limits<IdT>::max();
+
+  // a block of matches between the features of 2 (viewId, descType) groups
+  struct MatchesBlock
+  {
+    std::size_t keyI;
+    std::size_t keyJ;
+    const IndMatches* matches;
+  };
+
+  // list the (viewId, descType) groups in increasing order
+  typedef std::pair<std::size_t, feature::EImageDescriberType> Key;
+  std::map<Key, std::size_t> keys;
+
+  for(const auto& matchesPerDescIt: pairwiseMatches)
+  {
+    for(const auto& matchesIt: matchesPerDescIt.second)
+    {
+      keys.emplace(Key(matchesPerDescIt.first.first, matchesIt.first), 0);
+      keys.emplace(Key(matchesPerDescIt.first.second, matchesIt.first), 0);
+    }
+  }
+
+  _keyViewIds.clear();
+  _keyDescTypes.clear();
+  for(auto& key: keys)
+  {
+    key.second = _keyViewIds.size();
+    _keyViewIds.push_back(key.first.first);
+    _keyDescTypes.push_back(key.first.second);
+  }
+
+  std::vector<MatchesBlock> blocks;
+  // for each group: the blocks referencing it (block index, true if it is the J side)
+  std::vector<std::vector<std::pair<std::size_t, bool>>> blocksPerKey(keys.size());
+
+  for(const auto& matchesPerDescIt: pairwiseMatches)
+  {
+    for(const auto& matchesIt: matchesPerDescIt.second)
+    {
+      const MatchesBlock block = {keys.at(Key(matchesPerDescIt.first.first, matchesIt.first)),
+                                  keys.at(Key(matchesPerDescIt.first.second, matchesIt.first)),
+                                  &matchesIt.second};
+      blocksPerKey[block.keyI].emplace_back(blocks.size(), false);
+      blocksPerKey[block.keyJ].emplace_back(blocks.size(), true);
+      blocks.push_back(block);
+    }
+  }
+
+  const int nbKeys = static_cast<int>(keys.size());
+
+  // for each group: global id of each referenced feature index (invalidId if not referenced)
+  std::vector<std::vector<IdT>> globalIds(nbKeys);
+  std::vector<std::size_t> keyOffsets(nbKeys + 1, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int k = 0; k < nbKeys; ++k)
+  {
+    std::vector<IdT>& ids = globalIds[k];
+    for(const auto& blockSide: blocksPerKey[k])
+    {
+      for(const IndMatch& m: *blocks[blockSide.first].matches)
+      {
+        const IndexT featIndex = blockSide.second ? m._j : m._i;
+        if(featIndex >= ids.size())
+          ids.resize(featIndex + 1, invalidId);
+        ids[featIndex] = 0;
+      }
+    }
+    keyOffsets[k + 1] = std::count(ids.begin(), ids.end(), IdT(0));
+  }
+
+  for(int k = 0; k < nbKeys; ++k)
+    keyOffsets[k + 1] += keyOffsets[k];
+
+  const std::size_t nbFeatures = keyOffsets.back();
+  if(nbFeatures >= invalidId)
+    throw std::runtime_error("Too many features to build the tracks: " + std::to_string(nbFeatures));
+
+  // assign the dense global ids
+  _featureKeys.resize(nbFeatures);
+  _featureIndexes.resize(nbFeatures);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int k = 0; k < nbKeys; ++k)
+  {
+    std::vector<IdT>& ids = globalIds[k];
+    IdT globalId = static_cast<IdT>(keyOffsets[k]);
+    for(std::size_t featIndex = 0; featIndex < ids.size(); ++featIndex)
+    {
+      if(ids[featIndex] == invalidId)
+        continue;
+      ids[featIndex] = globalId;
+      _featureKeys[globalId] = static_cast<std::uint32_t>(k);
+      _featureIndexes[globalId] = static_cast<std::uint32_t>(featIndex);
+      ++globalId;
+    }
+  }
+
+  // make the union according the pair matches
+  ConcurrentUnionFind unionFind(nbFeatures);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int b = 0; b < static_cast<int>(blocks.size()); ++b)
+  {
+    const std::vector<IdT>& idsI = globalIds[blocks[b].keyI];
+    const std::vector<IdT>& idsJ = globalIds[blocks[b].keyJ];
+    for(const IndMatch& m: *blocks[b].matches)
+      unionFind.unite(idsI[m._i], idsJ[m._j]);
+  }
+
+  std::vector<IdT> roots(nbFeatures);
+
+  #pragma omp parallel for
+  for(int64_t f = 0; f < static_cast<int64_t>(nbFeatures); ++f)
+    roots[f] = unionFind.find(static_cast<IdT>(f));
+
+  // temporary numbering of the tracks in the order of their first feature
+  std::vector<IdT> trackPerRoot(nbFeatures, invalidId);
+  std::vector<IdT>& trackPerFeature = roots;
+  std::vector<IdT> firstFeatures;
+
+  for(std::size_t f = 0; f < nbFeatures; ++f)
+  {
+    IdT& trackId = trackPerRoot[roots[f]];
+    if(trackId == invalidId)
+    {
+      trackId = static_cast<IdT>(firstFeatures.size());
+      firstFeatures.push_back(static_cast<IdT>(f));
+    }
+    trackPerFeature[f] = trackId;
+  }
+
+  const std::size_t nbTracks = firstFeatures.size();
+
+  // TracksBuilder enumerates its union-find classes in the order of their representative feature,
+  // which is given by the sequential union by size (ties to the J feature) of the matches in the
+  // pairwiseMatches order. Replay these unions track by track to number the tracks the same way.
+
+  // bucket the matches by track, keeping their order
+  std::vector<std::size_t> matchOffsets(nbTracks + 1, 0);
+  for(const MatchesBlock& block: blocks)
+  {
+    const std::vector<IdT>& idsI = globalIds[block.keyI];
+    for(const IndMatch& m: *block.matches)
+      ++matchOffsets[trackPerFeature[idsI[m._i]] + 1];
+  }
+  for(std::size_t t = 0; t < nbTracks; ++t)
+    matchOffsets[t + 1] += matchOffsets[t];
+
+  std::vector<std::pair<IdT, IdT>> trackMatches(matchOffsets.back());
+  {
+    std::vector<std::size_t> positions(matchOffsets.begin(), matchOffsets.end() - 1);
+    for(const MatchesBlock& block: blocks)
+    {
+      const std::vector<IdT>& idsI = globalIds[block.keyI];
+      const std::vector<IdT>& idsJ = globalIds[block.keyJ];
+      for(const IndMatch& m: *block.matches)
+        trackMatches[positions[trackPerFeature[idsI[m._i]]]++] = std::make_pair(idsI[m._i], idsJ[m._j]);
+    }
+  }
+
+  globalIds.clear();
+
+  // each track only touches its own features
+  std::vector<IdT> parents(nbFeatures);
+  std::vector<IdT> classSizes(nbFeatures, 1);
+  std::iota(parents.begin(), parents.end(), IdT(0));
+
+  const auto findRoot = [&parents](IdT f)
+  {
+    while(parents[f] != f)
+    {
+      parents[f] = parents[parents[f]];
+      f = parents[f];
+    }
+    return f;
+  };
+
+  // reuse trackPerRoot: track of each representative feature
+  std::vector<IdT>& trackPerRepresentative = trackPerRoot;
+  std::fill(trackPerRepresentative.begin(), trackPerRepresentative.end(), invalidId);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int64_t t = 0; t < static_cast<int64_t>(nbTracks); ++t)
+  {
+    for(std::size_t i = matchOffsets[t]; i < matchOffsets[t + 1]; ++i)
+    {
+      const IdT a = findRoot(trackMatches[i].first);
+      const IdT b = findRoot(trackMatches[i].second);
+      if(a == b)
+        continue;
+      if(classSizes[a] > classSizes[b])
+      {
+        classSizes[a] += classSizes[b];
+        parents[b] = a;
+      }
+      else
+      {
+        classSizes[b] += classSizes[a];
+        parents[a] = b;
+      }
+    }
+    trackPerRepresentative[findRoot(firstFeatures[t])] = static_cast<IdT>(t);
+  }
+
+  // final track ids in the order of the representatives
+  std::vector<IdT> trackIds(nbTracks);
+  std::size_t trackId = 0;
+  for(std::size_t f = 0; f < nbFeatures; ++f)
+  {
+    if(trackPerRepresentative[f] != invalidId)
+      trackIds[trackPerRepresentative[f]] = static_cast<IdT>(trackId++);
+  }
+
+  #pragma omp parallel for
+  for(int64_t f = 0; f < static_cast<int64_t>(nbFeatures); ++f)
+    trackPerFeature[f] = trackIds[trackPerFeature[f]];
+
+  // store the features of each track contiguously (in increasing order)
+  _trackOffsets.assign(nbTracks + 1, 0);
+  for(std::size_t f = 0; f < nbFeatures; ++f)
+    ++_trackOffsets[trackPerFeature[f] + 1];
+  for(std::size_t t = 0; t < nbTracks; ++t)
+    _trackOffsets[t + 1] += _trackOffsets[t];
+
+  _trackFeatures.resize(nbFeatures);
+  std::vector<std::size_t> positions(_trackOffsets.begin(), _trackOffsets.end() - 1);
+  for(std::size_t f = 0; f < nbFeatures; ++f)
+    _trackFeatures[positions[trackPerFeature[f]]++] = static_cast<std::uint32_t>(f);
+
+  _validTracks.assign(nbTracks, 1);
+}
+
+void ParallelTracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
+{
+  // remove bad tracks:
+  // - track that are too short,
+  // - track with id conflicts (many times the same image index)
+
+  const int64_t nbTracks = static_cast<int64_t>(_validTracks.size());
+
+  #pragma omp parallel for if(multithreaded)
+  for(int64_t t = 0; t < nbTracks; ++t)
+  {
+    const std::size_t begin = _trackOffsets[t];
+    const std::size_t end = _trackOffsets[t + 1];
+
+    if(end - begin < minTrackLength)
+    {
+      _validTracks[t] = 0;
+      continue;
+    }
+
+    // features are sorted by viewId: a conflict is between two consecutive features
+    for(std::size_t i = begin + 1; i < end; ++i)
+    {
+      if(_keyViewIds[_featureKeys[_trackFeatures[i - 1]]] == _keyViewIds[_featureKeys[_trackFeatures[i]]])
+      {
+        _validTracks[t] = 0;
+        break;
+      }
+    }
+  }
+}
+
+bool ParallelTracksBuilder::exportToStream(std::ostream& os) const
+{
+  std::size_t cpt = 0;
+  for(std::size_t t = 0; t < _validTracks.size(); ++t)
+  {
+    if(!_validTracks[t])
+      continue;
+
+    os << "Class: " << cpt++ << std::endl;
+    os << "\t" << "track length: " << _trackOffsets[t + 1] - _trackOffsets[t] << std::endl;
+
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+    {
+      const std::uint32_t key = _featureKeys[_trackFeatures[i]];
+      os << _keyViewIds[key] << "  " << KeypointId(_keyDescTypes[key], _featureIndexes[_trackFeatures[i]]) << std::endl;
+    }
+  }
+  return os.good();
+}
+
+void ParallelTracksBuilder::exportToSTL(TracksMap& allTracks) const
+{
+  allTracks.clear();
+
+  std::vector<std::size_t> validTracks;
+  validTracks.reserve(_validTracks.size());
+  for(std::size_t t = 0; t < _validTracks.size(); ++t)
+  {
+    if(_validTracks[t])
+      validTracks.push_back(t);
+  }
+
+  std::vector<std::pair<std::size_t, Track>> tracks(validTracks.size());
+
+  #pragma omp parallel for
+  for(int64_t trackIndex = 0; trackIndex < static_cast<int64_t>(validTracks.size()); ++trackIndex)
+  {
+    const std::size_t t = validTracks[trackIndex];
+    tracks[trackIndex].first = trackIndex;
+    Track& outTrack = tracks[trackIndex].second;
+    outTrack.featPerView.reserve(_trackOffsets[t + 1] - _trackOffsets[t]);
+
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+    {
+      const std::uint32_t key = _featureKeys[_trackFeatures[i]];
+      // all descType inside the track will be the same
+      outTrack.descType = _keyDescTypes[key];
+      outTrack.featPerView[_keyViewIds[key]] = _featureIndexes[_trackFeatures[i]];
+    }
+  }
+
+  allTracks = TracksMap(boost::container::ordered_unique_range,
+                        std::make_move_iterator(tracks.begin()),
+                        std::make_move_iterator(tracks.end()));
+}
+
+std::size_t ParallelTracksBuilder::nbTracks() const
+{
+  return std::count(_validTracks.begin(), _validTracks.end(), 1);
+}
+
 namespace tracksUtilsMap {
 
 bool getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
@@ -17,6 +17,7 @@
 #include <lemon/unionfind.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <functional>
 #include <vector>
@@ -193,6 +194,66 @@ struct TracksBuilder
   }
 };
 
+/**
+ * @brief Allows to create Tracks from a set of Matches accross Views,
+ * with a multithreaded implementation designed for large datasets.
+ *
+ * Same usage and same tracks as TracksBuilder, but:
+ * - each referenced feature gets a dense global id (sorted by viewId, descType, featIndex),
+ *   looked up through one array per (viewId, descType),
+ * - the features are merged in parallel with a lock-free union-find (ConcurrentUnionFind),
+ * - the tracks are stored as contiguous arrays of feature ids and exported in parallel.
+ *
+ * The tracks are numbered like the TracksBuilder union-find classes, so the output
+ * is identical to TracksBuilder (track ids included) and does not depend on the number of threads.
+ */
+struct ParallelTracksBuilder
+{
+  /**
+   * @brief Build tracks for a given series of pairWise matches
+   * @param[in] pairwiseMatches PairWise matches
+   */
+  void build(const PairwiseMatches& pairwiseMatches);
+
+  /**
+   * @brief Remove bad tracks (too short or track with ids collision)
+   * @param[in] minTrackLength
+   * @param[in] multithreaded Is multithreaded
+   */
+  void filter(std::size_t minTrackLength = 2, bool multithreaded = true);
+
+  /**
+   * @brief Export to stream
+   * @param[out] os stream
+   * @return
+   */
+  bool exportToStream(std::ostream& os) const;
+
+  /**
+   * @brief Export tracks as a map (each entry is a sequence of imageId and keypointId):
+   *        {TrackIndex => {(imageIndex, keypointId), ... ,(imageIndex, keypointId)}
+   */
+  void exportToSTL(TracksMap& allTracks) const;
+
+  /**
+   * @brief Return the number of tracks
+   */
+  std::size_t nbTracks() const;
+
+private:
+  /// (viewId, descType) of each group of features
+  std::vector<std::size_t> _keyViewIds;
+  std::vector<feature::EImageDescriberType> _keyDescTypes;
+  /// for each feature global id: index of its (viewId, descType) group and feature index
+  std::vector<std::uint32_t> _featureKeys;
+  std::vector<std::uint32_t> _featureIndexes;
+  /// features of each track: _trackFeatures[_trackOffsets[t], _trackOffsets[t+1])
+  std::vector<std::size_t> _trackOffsets;
+  std::vector<std::uint32_t> _trackFeatures;
+  /// track status (0 if removed by the filter)
+  std::vector<char> _validTracks;
+};
+
 namespace tracksUtilsMap {
 
 /**
@@ -6,10 +6,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/track/Track.hpp"
+#include "aliceVision/track/CompactTracks.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 
 #include <vector>
 #include <utility>
+#include <random>
 
 #define BOOST_TEST_MODULE Track
 #include <boost/test/included/unit_test.hpp>
@@ -178,6 +180,186 @@ BOOST_AUTO_TEST_CASE(Track_Conflict) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Track_ParallelTracksBuilder_Conflict) {
+
+  //
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //{2 -> 3 -> 2
+  //      3 -> 8 } This track must be deleted, index 3 appears two times
+  //
+
+  // Create the input pairwise correspondences
+  PairwiseMatches map_pairwisematches;
+
+  const IndMatch testAB[] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  const IndMatch testBC[] = {IndMatch(0,0), IndMatch(1,6), IndMatch(3,2), IndMatch(3,8)};
+
+  std::vector<IndMatch> ab(testAB, testAB+3);
+  std::vector<IndMatch> bc(testBC, testBC+4);
+  const int A = 0;
+  const int B = 1;
+  const int C = 2;
+  map_pairwisematches[ std::make_pair(A,B) ][EImageDescriberType::UNKNOWN] = ab;
+  map_pairwisematches[ std::make_pair(B,C) ][EImageDescriberType::UNKNOWN] = bc;
+
+  ParallelTracksBuilder trackBuilder;
+  trackBuilder.build( map_pairwisematches );
+
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+  trackBuilder.filter(); // Key feature tested here to kill the conflicted track
+  BOOST_CHECK_EQUAL(2, trackBuilder.nbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  //0, {(0,0) (1,0) (2,0)}
+  //1, {(0,1) (1,1) (2,6)}
+  const std::pair<std::size_t,std::size_t> GT_Tracks[] =
+    {std::make_pair(0,0), std::make_pair(1,0), std::make_pair(2,0),
+     std::make_pair(0,1), std::make_pair(1,1), std::make_pair(2,6)};
+
+  BOOST_CHECK_EQUAL(2,  map_tracks.size());
+  std::size_t cpt = 0, i = 0;
+  for (TracksMap::const_iterator iterT = map_tracks.begin();
+    iterT != map_tracks.end();
+    ++iterT, ++i)
+  {
+    BOOST_CHECK_EQUAL(i, iterT->first);
+    for (auto iter = iterT->second.featPerView.begin();
+      iter != iterT->second.featPerView.end();
+      ++iter)
+    {
+      BOOST_CHECK( GT_Tracks[cpt] == std::make_pair(iter->first, iter->second));
+      ++cpt;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_ParallelTracksBuilder_vs_TracksBuilder) {
+
+  // random matches between 10 views with 2 describer types
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<aliceVision::IndexT> featDist(0, 300);
+
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t I = 0; I < 10; ++I)
+  {
+    for(std::size_t J = I + 1; J < 10; ++J)
+    {
+      for(EImageDescriberType descType : {EImageDescriberType::SIFT, EImageDescriberType::AKAZE})
+      {
+        IndMatches& matches = map_pairwisematches[std::make_pair(I, J)][descType];
+        for(int m = 0; m < 40; ++m)
+          matches.emplace_back(featDist(gen), featDist(gen));
+      }
+    }
+  }
+
+  for(std::size_t minTrackLength : {0, 2, 3})
+  {
+    TracksBuilder trackBuilder;
+    trackBuilder.build(map_pairwisematches);
+    ParallelTracksBuilder parallelTrackBuilder;
+    parallelTrackBuilder.build(map_pairwisematches);
+
+    BOOST_CHECK_EQUAL(trackBuilder.nbTracks(), parallelTrackBuilder.nbTracks());
+
+    // without filtering, the tracks with conflicts keep any of their features in a view
+    if(minTrackLength == 0)
+      continue;
+
+    trackBuilder.filter(minTrackLength);
+    parallelTrackBuilder.filter(minTrackLength);
+    BOOST_CHECK_EQUAL(trackBuilder.nbTracks(), parallelTrackBuilder.nbTracks());
+
+    TracksMap tracks, parallelTracks;
+    trackBuilder.exportToSTL(tracks);
+    parallelTrackBuilder.exportToSTL(parallelTracks);
+
+    // same tracks with the same track ids
+    BOOST_CHECK_EQUAL(tracks.size(), parallelTracks.size());
+    for(const auto& track : tracks)
+    {
+      const auto parallelTrackIt = parallelTracks.find(track.first);
+      BOOST_REQUIRE(parallelTrackIt != parallelTracks.end());
+      BOOST_CHECK(track.second.descType == parallelTrackIt->second.descType);
+      BOOST_CHECK(track.second.featPerView == parallelTrackIt->second.featPerView);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_CompactTracks) {
+
+  // random tracks between 10 views
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<aliceVision::IndexT> featDist(0, 300);
+
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t I = 0; I < 10; ++I)
+  {
+    for(std::size_t J = I + 1; J < 10; ++J)
+    {
+      IndMatches& matches = map_pairwisematches[std::make_pair(I, J)][EImageDescriberType::SIFT];
+      for(int m = 0; m < 40; ++m)
+        matches.emplace_back(featDist(gen), featDist(gen));
+    }
+  }
+
+  ParallelTracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  trackBuilder.filter(2);
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+  // non contiguous track ids
+  map_tracks.erase(map_tracks.begin());
+
+  const CompactTracks compactTracks(map_tracks);
+  BOOST_CHECK_EQUAL(map_tracks.size(), compactTracks.nbTracks());
+
+  // round trip
+  TracksMap exportedTracks;
+  compactTracks.exportToSTL(exportedTracks);
+  BOOST_CHECK_EQUAL(map_tracks.size(), exportedTracks.size());
+  for(const auto& track : map_tracks)
+  {
+    const aliceVision::IndexT t = compactTracks.trackIndex(track.first);
+    BOOST_CHECK(t != aliceVision::UndefinedIndexT);
+    BOOST_CHECK_EQUAL(track.second.featPerView.size(), compactTracks.trackLength(t));
+    BOOST_CHECK(track.second.featPerView == exportedTracks.at(track.first).featPerView);
+  }
+  BOOST_CHECK_EQUAL(aliceVision::UndefinedIndexT, compactTracks.trackIndex(0));
+
+  // tracks per view
+  TracksPerView tracksPerView, compactTracksPerView;
+  tracksUtilsMap::computeTracksPerView(map_tracks, tracksPerView);
+  tracksUtilsMap::computeTracksPerView(compactTracks, compactTracksPerView);
+  BOOST_CHECK(tracksPerView == compactTracksPerView);
+
+  // tracks length
+  std::map<std::size_t, std::size_t> length, compactLength;
+  tracksUtilsMap::tracksLength(map_tracks, length);
+  tracksUtilsMap::tracksLength(compactTracks, compactLength);
+  BOOST_CHECK(length == compactLength);
+
+  // common tracks
+  for(const std::set<std::size_t>& imageIndexes : std::vector<std::set<std::size_t>>{{0, 1}, {2, 5, 7}, {3}, {1, 20}})
+  {
+    TracksMap commonTracks, compactCommonTracks;
+    tracksUtilsMap::getCommonTracksInImagesFast(imageIndexes, map_tracks, tracksPerView, commonTracks);
+    tracksUtilsMap::getCommonTracksInImagesFast(imageIndexes, compactTracks, compactCommonTracks);
+    BOOST_CHECK_EQUAL(commonTracks.size(), compactCommonTracks.size());
+    for(const auto& track : commonTracks)
+      BOOST_CHECK(track.second.featPerView == compactCommonTracks.at(track.first).featPerView);
+
+    std::set<std::size_t> visibleTracks, compactVisibleTracks;
+    tracksUtilsMap::getCommonTracksInImages(imageIndexes, tracksPerView, visibleTracks);
+    tracksUtilsMap::getCommonTracksInImages(imageIndexes, compactTracks, compactVisibleTracks);
+    BOOST_CHECK(visibleTracks == compactVisibleTracks);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
 {
   {
@@ -5,17 +5,113 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/tail.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <boost/progress.hpp>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <stdexcept>
+#include <vector>
 #include <boost/format.hpp>
 
 namespace aliceVision{
 namespace voctree{
 
+namespace {
+
+enum class EDistanceMethod
+{
+  CLASSIC,
+  COMMON_POINTS,
+  STRONG_COMMON_POINTS,
+  WEIGHTED_STRONG_COMMON_POINTS,
+  INVERSED_WEIGHTED_COMMON_POINTS
+};
+
+EDistanceMethod distanceMethodFromString(const std::string& distanceMethod)
+{
+  if(distanceMethod == "classic")                      return EDistanceMethod::CLASSIC;
+  if(distanceMethod == "commonPoints")                 return EDistanceMethod::COMMON_POINTS;
+  if(distanceMethod == "strongCommonPoints")           return EDistanceMethod::STRONG_COMMON_POINTS;
+  if(distanceMethod == "weightedStrongCommonPoints")   return EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS;
+  if(distanceMethod == "inversedWeightedCommonPoints") return EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS;
+  throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
+}
+
+/**
+ * @brief Per-thread accumulation buffers of the document scores, reused by the queries.
+ * @note Only the entries of the visited documents are used and reset by a query,
+ *       so a query costs O(visited documents) instead of O(documents).
+ */
+struct QueryScores
+{
+  std::vector<float> scores;
+  std::vector<bool> isVisited;
+  std::vector<uint32_t> visitedDocs;
+
+  /// Reset the entries of the visited documents
+  void reset()
+  {
+    for(const uint32_t docIndex : visitedDocs)
+    {
+      scores[docIndex] = 0.f;
+      isVisited[docIndex] = false;
+    }
+    visitedDocs.clear();
+  }
+};
+
+/// Reset the query scores on scope exit, so the buffers stay clean if an exception is thrown
+class QueryScoresGuard
+{
+public:
+  QueryScoresGuard(QueryScores& queryScores, std::size_t nbDocs)
+    : _queryScores(queryScores)
+  {
+    if(_queryScores.scores.size() < nbDocs)
+    {
+      _queryScores.scores.resize(nbDocs, 0.f);
+      _queryScores.isVisited.resize(nbDocs, false);
+    }
+  }
+
+  ~QueryScoresGuard()
+  {
+    _queryScores.reset();
+  }
+
+private:
+  QueryScores& _queryScores;
+};
+
+/**
+ * @brief Score contribution of a word shared by the query and a document (see sparseDistance).
+ * @param[in] method distance method
+ * @param[in] queryCount number of query features associated to the word
+ * @param[in] docCount number of document features associated to the word
+ * @param[in] weight word weight
+ */
+inline float commonWordScore(EDistanceMethod method, uint32_t queryCount, uint32_t docCount, float weight)
+{
+  switch(method)
+  {
+    case EDistanceMethod::CLASSIC:
+      // |q - d| = q + d - 2 min(q, d)
+      return 2.f * std::min(queryCount, docCount);
+    case EDistanceMethod::COMMON_POINTS:
+      return std::min(queryCount, docCount);
+    case EDistanceMethod::STRONG_COMMON_POINTS:
+      return (queryCount == 1 && docCount == 1) ? 1.f : 0.f;
+    case EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS:
+      return (queryCount == 1 && docCount == 1) ? weight : 0.f;
+    case EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS:
+      return weight / std::min(queryCount, docCount);
+  }
+  return 0.f;
+}
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)	
 {
 	for( const auto &e : dv )
@@ -31,22 +127,24 @@ Database::Database(uint32_t num_words)
 word_weights_( num_words, 1.0f ) { }
 
 DocId Database::insert(DocId doc_id, const SparseHistogram& document)
+{
+  return insert(doc_id, CompactHistogram(document));
+}
+
+DocId Database::insert(DocId doc_id, const CompactHistogram& document)
 {
   // Ensure that the new document to insert is not already there.
-  assert(database_.find(doc_id) == database_.end());
+  assert(docIndices_.find(doc_id) == docIndices_.end());
 
-  // For each word, retrieve its inverted file and increment the count for doc_id.
-  for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
-  {
-    Word word = it->first;
-    InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
-    else
-      file.back().count += it->second.size();
-  }
+  const uint32_t docIndex = docIds_.size();
+
+  // For each word, retrieve its inverted file and add the count for doc_id.
+  for(std::size_t i = 0; i < document.size(); ++i)
+    word_files_[document.word(i)].push_back(WordFrequency(docIndex, document.count(i)));
 
-  database_[doc_id] = document;
+  docIds_.push_back(doc_id);
+  docIndices_[doc_id] = docIndex;
+  documents_.push_back(document);
 
   return doc_id;
 }
@@ -67,19 +165,55 @@ void Database::sanityCheck(size_t N, std::map<size_t, DocMatches>& matches) cons
   }
 
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
+
+  std::vector<DocMatches> docMatches(documents_.size());
+  boost::progress_display display(documents_.size());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(documents_.size()); ++i)
+  {
+    find(documents_[i], N, docMatches[i]);
+
+    #pragma omp critical
+    {
+      ++display;
+    }
+  }
+
+  for(std::size_t i = 0; i < docMatches.size(); ++i)
+    matches[docIds_[i]] = std::move(docMatches[i]);
+}
+
+void Database::find(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod) const
+{
+  if(N == 0)
+    N = this->size();
+
+  // the inner loop can't iterate over a std::map
+  std::vector<SparseHistogramPerImage::const_iterator> queryIts;
+  queryIts.reserve(queries.size());
+  for(auto it = queries.begin(); it != queries.end(); ++it)
+    queryIts.push_back(it);
+
+  // since we already know the size of the vectors, in order to parallelize the
   // query allocate the whole memory
-  boost::progress_display display(database_.size());
-  
-  //#pragma omp parallel for default(none) shared(database_)
-  for(const auto &doc : database_)
+  std::vector<DocMatches> queryMatches(queryIts.size());
+  boost::progress_display display(queryIts.size());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(queryIts.size()); ++i)
   {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
+    find(queryIts.at(i)->second, N, queryMatches.at(i), distanceMethod);
+
+    #pragma omp critical
+    {
+      ++display;
+    }
   }
+
+  // merge in query order
+  for(std::size_t i = 0; i < queryIts.size(); ++i)
+    matches[queryIts.at(i)->first] = std::move(queryMatches.at(i));
 }
 
 /**
@@ -92,12 +226,9 @@ void Database::sanityCheck(size_t N, std::map<size_t, DocMatches>& matches) cons
  */
 void Database::find(const std::vector<Word>& document, size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  SparseHistogram query;
   // from the list of visual words associated with each feature in the document/image
-  // generate the (sparse) histogram of the visual words 
-  computeSparseHistogram(document, query);
-
-  find( query, N, matches, distanceMethod);
+  // generate the (sparse) histogram of the visual words
+  find(CompactHistogram(document), N, matches, distanceMethod);
 }
 
 /**
@@ -110,23 +241,80 @@ void Database::find(const std::vector<Word>& document, size_t N, std::vector<Doc
  */
 void Database::find( const SparseHistogram& query, size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  // Accumulate the best N matches
-  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
-  boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
+  find(CompactHistogram(query), N, matches, distanceMethod);
+}
 
-  /// @todo Try only computing distances against documents sharing at least one word
-  for(const auto& document: database_)
+void Database::find(const CompactHistogram& query, size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
+{
+  const EDistanceMethod method = distanceMethodFromString(distanceMethod);
+  const std::size_t nbDocs = docIds_.size();
+
+  N = std::min(N, nbDocs);
+
+  // accumulate the scores of the documents sharing words with the query
+  // through the inverted files
+  static thread_local QueryScores queryScores;
+  QueryScoresGuard queryScoresGuard(queryScores, nbDocs);
+  std::vector<float>& scores = queryScores.scores;
+  std::vector<bool>& isVisited = queryScores.isVisited;
+  std::vector<uint32_t>& visitedDocs = queryScores.visitedDocs;
+  const uint32_t querySize = query.nbFeatures();
+
+  for(std::size_t i = 0; i < query.size(); ++i)
   {
-    // for each document/image in the database compute the distance between the 
-    // histograms of the query image and the others
-    float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-    acc(DocMatch(document.first, distance));
+    const Word word = query.word(i);
+    const uint32_t queryCount = query.count(i);
+
+    if(word < 0 || word >= static_cast<Word>(word_files_.size()))
+      continue;
+
+    const float weight = word_weights_[word];
+
+    for(const WordFrequency& wordFrequency : word_files_[word])
+    {
+      if(!isVisited[wordFrequency.docIndex])
+      {
+        isVisited[wordFrequency.docIndex] = true;
+        visitedDocs.push_back(wordFrequency.docIndex);
+      }
+      scores[wordFrequency.docIndex] += commonWordScore(method, queryCount, wordFrequency.count, weight);
+    }
   }
 
-  // extract the best N
-  boost::accumulators::extractor<bestN_tag> bestN;
-  matches.resize(std::min(N, database_.size()));
-  std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
+  std::vector<DocMatch> candidates;
+
+  if(method == EDistanceMethod::CLASSIC)
+  {
+    // every document has a distance depending on its size (O(documents))
+    candidates.reserve(nbDocs);
+    for(std::size_t i = 0; i < nbDocs; ++i)
+      candidates.emplace_back(docIds_[i], static_cast<float>(querySize) + documents_[i].nbFeatures() - scores[i]);
+  }
+  else
+  {
+    // documents without common words have a null distance,
+    // only use them to complete the N matches
+    candidates.reserve(std::max(visitedDocs.size(), N));
+    for(const uint32_t docIndex : visitedDocs)
+      candidates.emplace_back(docIds_[docIndex], -scores[docIndex]);
+
+    for(std::size_t i = 0; i < nbDocs && candidates.size() < N; ++i)
+    {
+      if(!isVisited[i])
+        candidates.emplace_back(docIds_[i], 0.f);
+    }
+  }
+
+  // partial selection of the best N (ties are sorted by document id)
+  const auto compare = [](const DocMatch& a, const DocMatch& b)
+  {
+    return (a.score < b.score) || (a.score == b.score && a.id < b.id);
+  };
+
+  N = std::min(N, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + N, candidates.end(), compare);
+  candidates.resize(N);
+  matches.swap(candidates);
 }
 
 /**
@@ -137,7 +325,7 @@ void Database::find( const SparseHistogram& query, size_t N, std::vector<DocMatc
  */
 void Database::computeTfIdfWeights(float default_weight)
 {
-  float N = (float) database_.size();
+  float N = (float) documents_.size();
   size_t num_words = word_files_.size();
   for(size_t i = 0; i < num_words; ++i)
   {
@@ -198,7 +386,7 @@ void Database::loadWeights(const std::string& file)
  */
 size_t Database::size() const
 {
-  return database_.size();
+  return documents_.size();
 }
 
 } //namespace voctree
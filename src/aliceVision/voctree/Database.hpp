@@ -75,6 +75,15 @@ public:
    */
   DocId insert(DocId doc_id, const SparseHistogram& document);
 
+  /**
+   * @brief Insert a new document.
+   *
+   * @param doc_id Unique ID of the new document to insert
+   * @param document The set of quantized words in a document/image.
+   * \return An ID representing the inserted document.
+   */
+  DocId insert(DocId doc_id, const CompactHistogram& document);
+
   /**
    * @brief Perform a sanity check of the database by querying each document
    * of the database and finding its top N matches
@@ -84,6 +93,17 @@ public:
    */
    void sanityCheck(std::size_t N, std::map<std::size_t, DocMatches>& matches) const;
 
+  /**
+   * @brief Find the top N matches in the database for each query document.
+   * Queries are processed in parallel.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words per document id.
+   * @param[in] N The number of matches to return per query (0 for all the database documents).
+   * @param[out] matches IDs and scores for the top N matching database documents per query document id.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Find the top N matches in the database for the query document.
    *
@@ -94,9 +114,12 @@ public:
    */
   void find(const std::vector<Word>& document, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
   
-    /**
+  /**
    * @brief Find the top N matches in the database for the query document.
    *
+   * Scores are accumulated through the inverted files, so only the documents sharing
+   * words with the query are visited (and all the documents in O(1) for the "classic" distance).
+   *
    * @param[in] query The query document, a normalized set of quantized words.
    * @param[int] N        The number of matches to return.
    * @param[in] distanceMethod distance method (norm L1, etc.)
@@ -104,6 +127,12 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for the query document.
+   * @see find(const SparseHistogram&, std::size_t, std::vector<DocMatch>&, const std::string&)
+   */
+  void find(const CompactHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -127,36 +156,58 @@ public:
   //void save(const std::string& file) const;
   //void load(const std::string& file);
 
-  const SparseHistogramPerImage& getSparseHistogramPerImage() const
+  /// Inserted documents, in insertion order
+  const std::vector<CompactHistogram>& getDocuments() const
+  {
+    return documents_;
+  }
+
+  /// Document id of each inserted document, in insertion order
+  const std::vector<DocId>& getDocIds() const
   {
-    return database_;
+    return docIds_;
+  }
+
+  /**
+   * @brief Get an inserted document
+   * @param[in] doc_id document id
+   * @throw std::out_of_range if the document is not in the database
+   */
+  const CompactHistogram& getDocument(DocId doc_id) const
+  {
+    return documents_[docIndices_.at(doc_id)];
+  }
+
+  const std::vector<float>& getWordWeights() const
+  {
+    return word_weights_;
   }
   
 private:
 
   struct WordFrequency
   {
-    DocId id;
+    /// document index in docIds_
+    uint32_t docIndex;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
+    WordFrequency(uint32_t _docIndex, uint32_t _count)
+      : docIndex(_docIndex)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  // Stored in increasing order by document index
   typedef std::vector<WordFrequency> InvertedFile;
 
-  /// @todo Use sorted vector?
-  // typedef std::vector< std::pair<Word, float> > DocumentVector;
-  
   friend std::ostream& operator<<(std::ostream& os, const SparseHistogram& dv);
 
   std::vector<InvertedFile> word_files_;
   std::vector<float> word_weights_;
-  SparseHistogramPerImage database_; // Precomputed for inserted documents
+  std::vector<CompactHistogram> documents_; // Inserted documents per document index (insertion order)
+  std::vector<DocId> docIds_; // Document id per document index
+  std::map<DocId, uint32_t> docIndices_; // Document index per document id
 
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
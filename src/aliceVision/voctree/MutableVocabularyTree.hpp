@@ -40,6 +40,7 @@ public:
     return this->word_start_ + this->num_words_;
   }
 
+  /// Mutable centers, call pack() after editing them to use the fast quantization
   std::vector<Feature, FeatureAllocator>& centers()
   {
     return this->centers_;
@@ -10,12 +10,16 @@
 #include "DefaultAllocator.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <numeric>
+#include <random>
 #include <vector>
 #include <limits>
 #include <stdio.h>
@@ -32,14 +36,14 @@ struct InitRandom
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     ALICEVISION_LOG_DEBUG("#\t\tRandom initialization");
     // Construct a random permutation of the features using a Fisher-Yates shuffle
     std::vector<Feature*> features_perm = features;
     for(size_t i = features.size(); i > 1; --i)
     {
-      size_t k = rand() % i;
+      size_t k = std::uniform_int_distribution<size_t>(0, i - 1)(generator);
       std::swap(features_perm[i - 1], features_perm[k]);
     }
     // Take the first k permuted features as the initial centers
@@ -60,7 +64,7 @@ struct InitKmeanspp
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     typedef typename Distance::result_type squared_distance_type;
 
@@ -84,9 +88,10 @@ struct InitKmeanspp
     std::vector<squared_distance_type> distsTempBest(features.size(), std::numeric_limits<squared_distance_type>::max());
     typename std::vector<squared_distance_type>::iterator dstiter;
     typename std::vector<Feature*>::const_iterator featiter;
+    std::uniform_real_distribution<float> percDistribution(0.0f, 1.0f);
 
     // 1. Choose a random center
-    size_t randCenter = rand() % features.size();
+    size_t randCenter = std::uniform_int_distribution<size_t>(0, features.size() - 1)(generator);
 
     // add it to the centers
     centers[0] = *features[ randCenter ];
@@ -118,7 +123,7 @@ struct InitKmeanspp
         // 0 and this sum, then start compute the sum from the first element again
         // until the partial sum is greater than the number drawn: the
         // the previous element is what we are looking for
-        const float perc = (float)rand() / RAND_MAX;
+        const float perc = percDistribution(generator);
         squared_distance_type partial = (squared_distance_type)(currSum * perc);
         // look for the element that cap the partial sum that has been
         // drawn
@@ -186,7 +191,7 @@ struct InitGiven
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     // Do nothing!
   }
@@ -256,7 +261,8 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
 /**
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
- * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * The standard Lloyd's algorithm is used (with Hamerly's triangle inequality pruning), or mini-batch
+ * k-means for large sets of features. By default, cluster centers are initialized with K-means++.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -265,7 +271,7 @@ class SimpleKmeans
 {
 public:
   typedef typename Distance::result_type squared_distance_type;
-  typedef boost::function<void(const std::vector<Feature*>&, size_t, std::vector<Feature, FeatureAllocator>&, Distance, const int verbose) > Initializer;
+  typedef boost::function<void(const std::vector<Feature*>&, size_t, std::vector<Feature, FeatureAllocator>&, Distance, std::mt19937&, const int verbose) > Initializer;
 
   /**
    * @brief Constructor
@@ -304,6 +310,33 @@ public:
     restarts_ = restarts;
   }
 
+  size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Set the number of features of the mini-batches.
+   * If the number of features to cluster is larger, the centers are estimated with
+   * mini-batch k-means (faster, approximate), otherwise with the standard Lloyd's algorithm.
+   * @param[in] miniBatchSize The mini-batch size, 0 to disable mini-batch k-means
+   */
+  void setMiniBatchSize(size_t miniBatchSize)
+  {
+    mini_batch_size_ = miniBatchSize;
+  }
+
+  bool getUseTriangleInequality() const
+  {
+    return use_triangle_inequality_;
+  }
+
+  /// Use the triangle inequality to skip the distance computations that cannot change the assignment (same results).
+  void setUseTriangleInequality(bool useTriangleInequality)
+  {
+    use_triangle_inequality_ = useTriangleInequality;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -341,17 +374,53 @@ public:
                                         std::vector<Feature, FeatureAllocator>& centers,
                                         std::vector<unsigned int>& membership) const;
 
+  /**
+   * @brief Partition a set of features into k clusters, drawing the random numbers from the given generator.
+   *
+   * The global rand() is not used, so several sets of features can be clustered concurrently
+   * (one generator per set).
+   *
+   * @param      features   The features to be clustered.
+   * @param      k          The number of clusters.
+   * @param[out] centers    A set of k cluster centers.
+   * @param[out] membership Cluster assignment for each feature
+   * @param[in,out] generator The random number generator
+   */
+  squared_distance_type clusterPointers(const std::vector<Feature*>& features, size_t k,
+                                        std::vector<Feature, FeatureAllocator>& centers,
+                                        std::vector<unsigned int>& membership,
+                                        std::mt19937& generator) const;
+
 private:
 
   squared_distance_type clusterOnce(const std::vector<Feature*>& features, size_t k,
                                     std::vector<Feature, FeatureAllocator>& centers,
-                                    std::vector<unsigned int>& membership) const;
+                                    std::vector<unsigned int>& membership,
+                                    std::mt19937& generator) const;
+
+  squared_distance_type clusterOnceMiniBatch(const std::vector<Feature*>& features, size_t k,
+                                             std::vector<Feature, FeatureAllocator>& centers,
+                                             std::vector<unsigned int>& membership,
+                                             std::mt19937& generator) const;
+
+  squared_distance_type computeSSE(const std::vector<Feature*>& features,
+                                   const std::vector<Feature, FeatureAllocator>& centers,
+                                   const std::vector<unsigned int>& membership) const;
+
+  /// Find the nearest center of a feature, its distance and the distance to the second nearest center
+  void findNearestCenters(const Feature& feature,
+                          const std::vector<Feature, FeatureAllocator>& centers,
+                          unsigned int& nearest,
+                          double& nearestDist,
+                          double& secondNearestDist) const;
 
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   size_t max_iterations_;
   size_t restarts_;
+  size_t mini_batch_size_;
+  bool use_triangle_inequality_;
   int verbose_;
 };
 
@@ -362,8 +431,10 @@ distance_(d),
 //    choose_centers_( InitRandom( ) ),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
-verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+use_triangle_inequality_(true),
+verbose_(verbose)
 {
 }
 
@@ -385,6 +456,17 @@ typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_typ
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
                                                                    std::vector<Feature, FeatureAllocator>& centers,
                                                                    std::vector<unsigned int>& membership) const
+{
+  std::mt19937 generator(system::getRandomSeed());
+  return clusterPointers(features, k, centers, membership, generator);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
+                                                                   std::vector<Feature, FeatureAllocator>& centers,
+                                                                   std::vector<unsigned int>& membership,
+                                                                   std::mt19937& generator) const
 {
   std::vector<Feature, FeatureAllocator> new_centers(centers);
   new_centers.resize(k);
@@ -395,8 +477,8 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::ve
   for(size_t starts = 0; starts < restarts_; ++starts)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Trial " << starts + 1 << "/" << restarts_);
-    choose_centers_(features, k, new_centers, distance_, verbose_);
-    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership);
+    choose_centers_(features, k, new_centers, distance_, generator, verbose_);
+    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership, generator);
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("End of Trial " << starts + 1 << "/" << restarts_);
     if(sse < least_sse)
     {
@@ -411,79 +493,159 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::ve
   return least_sse;
 }
 
+template < class Feature, class Distance, class FeatureAllocator >
+void SimpleKmeans<Feature, Distance, FeatureAllocator>::findNearestCenters(const Feature& feature,
+                                                                       const std::vector<Feature, FeatureAllocator>& centers,
+                                                                       unsigned int& nearest,
+                                                                       double& nearestDist,
+                                                                       double& secondNearestDist) const
+{
+  squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
+  squared_distance_type d_second = std::numeric_limits<squared_distance_type>::max();
+  nearest = 0;
+
+  // Find the nearest cluster center to the feature
+  for(unsigned int j = 0; j < centers.size(); ++j)
+  {
+    const squared_distance_type distance = distance_(feature, centers[j]);
+    if(distance < d_min)
+    {
+      d_second = d_min;
+      d_min = distance;
+      nearest = j;
+    }
+    else if(distance < d_second)
+    {
+      d_second = distance;
+    }
+  }
+  nearestDist = std::sqrt(static_cast<double>(d_min));
+  secondNearestDist = (centers.size() > 1) ? std::sqrt(static_cast<double>(d_second)) : std::numeric_limits<double>::max();
+}
+
 template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector<Feature*>& features, size_t k,
                                                                std::vector<Feature, FeatureAllocator>& centers,
-                                                               std::vector<unsigned int>& membership) const
+                                                               std::vector<unsigned int>& membership,
+                                                               std::mt19937& generator) const
 {
-  typedef typename std::vector<Feature, FeatureAllocator>::value_type centerType;
-  typedef typename Distance::value_type feature_value_type;
+  if(mini_batch_size_ > 0 && features.size() > mini_batch_size_)
+    return clusterOnceMiniBatch(features, k, centers, membership, generator);
 
+  // Per thread accumulation of the new centers (merged in thread order),
+  // sized in the parallel region by its number of threads (one when nested)
+  std::vector<std::vector<size_t> > thread_center_counts;
+  std::vector<std::vector<Feature, FeatureAllocator> > thread_centers;
   std::vector<size_t> new_center_counts(k);
   std::vector<Feature, FeatureAllocator> new_centers(k);
   squared_distance_type max_center_shift = std::numeric_limits<squared_distance_type>::max();
 
+  // Hamerly's bounds on the distance of each feature to its center (upper)
+  // and to the other centers (lower), only valid after the first iteration.
+  // The distances are not computed when the bounds prove that the center is unchanged.
+  //
+  //  Greg Hamerly, Making k-means even faster. SDM 2010.
+  std::vector<double> upper_bounds(features.size());
+  std::vector<double> lower_bounds(features.size());
+  std::vector<double> center_half_dists(k, 0.0); // half distance to the closest other center
+  std::vector<double> center_shifts(k, 0.0);
+
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Iterations");
   for(size_t iter = 0; iter < max_iterations_; ++iter)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
-    // Zero out new centers and counts
-    std::fill(new_center_counts.begin(), new_center_counts.end(), 0);
-    //		for(size_t i = 0; i < k; checkElements(new_centers[i++], "bef"));
-    std::fill(new_centers.begin(), new_centers.end(), zero_);
-    //		for(size_t i = 0; i < k; checkElements(new_centers[i++], "aft"));
-    assert(checkVectorElements(new_centers, "newcenters init"));
-    bool is_stable = true;
+    const bool full_search = (iter == 0) || !use_triangle_inequality_;
 
+    if(!full_search)
+    {
+      for(size_t i = 0; i < k; ++i)
+      {
+        double d_min = std::numeric_limits<double>::max();
+        for(size_t j = 0; j < k; ++j)
+        {
+          if(i != j)
+            d_min = std::min(d_min, std::sqrt(static_cast<double>(distance_(centers[i], centers[j]))));
+        }
+        center_half_dists[i] = 0.5 * d_min;
+      }
+    }
+
+    bool is_stable = true;
 
     // Assign data objects to current centers
-    #pragma omp parallel for shared( new_centers, new_center_counts, features, centers, membership)
-    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+    #pragma omp parallel
     {
-      squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
-      unsigned int nearest = 0;
-      bool found = false;
+      #pragma omp single
+      {
+        const std::size_t nbThreads = omp_get_num_threads();
+        if(thread_centers.size() != nbThreads)
+        {
+          thread_center_counts.assign(nbThreads, std::vector<size_t>(k));
+          thread_centers.assign(nbThreads, std::vector<Feature, FeatureAllocator>(k));
+        }
+      }
 
-      // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
-      // cluster center
+      std::vector<size_t>& counts = thread_center_counts[omp_get_thread_num()];
+      std::vector<Feature, FeatureAllocator>& sums = thread_centers[omp_get_thread_num()];
+      std::fill(counts.begin(), counts.end(), 0);
+      std::fill(sums.begin(), sums.end(), zero_);
+      bool thread_is_stable = true;
 
-      // Find the nearest cluster center to feature i
-      for(unsigned int j = 0; j < k; ++j)
+      #pragma omp for schedule(static)
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
       {
-        squared_distance_type distance = distance_(*features[i], centers[j]);
-        //		printf("\t\tdistance %f\n", (float)distance);
-        //		PrintFeat(*features[i] );
-        if(distance < d_min)
+        unsigned int nearest = membership[i];
+        if(full_search)
+        {
+          findNearestCenters(*features[i], centers, nearest, upper_bounds[i], lower_bounds[i]);
+        }
+        else
+        {
+          const double bound = std::max(center_half_dists[nearest], lower_bounds[i]);
+          if(upper_bounds[i] > bound)
+          {
+            // tighten the upper bound, then search all the centers if still needed
+            upper_bounds[i] = std::sqrt(static_cast<double>(distance_(*features[i], centers[nearest])));
+            if(upper_bounds[i] > bound)
+              findNearestCenters(*features[i], centers, nearest, upper_bounds[i], lower_bounds[i]);
+          }
+        }
+
+        // Assign feature i to the cluster it is nearest to
+        if(membership[i] != nearest)
         {
-          d_min = distance;
-          nearest = j;
-          found = true;
+          thread_is_stable = false;
+          membership[i] = nearest;
         }
-        //		 printf("\t distance %f %f\n", (double)distance, (double)d_min);
+        // Accumulate the cluster center and its membership count
+        sums[nearest] += *features[i];
+        ++counts[nearest];
       }
-      assert(found);
-      // Assign feature i to the cluster it is nearest to
-      if(membership[i] != nearest)
+
+      if(!thread_is_stable)
       {
+        #pragma omp critical
         is_stable = false;
-        membership[i] = nearest;
-      }
-      // Accumulate the cluster center and its membership count
-      //	  printf("\t nearest %d\n", nearest);
-      //			checkElements(*features[i], "feat");
-      #pragma omp critical
-      {
-        new_centers[nearest] += *features[i];
-        //			checkElements(new_centers[nearest], "sum");
-        //	  printf("\t new_centers[nearest] += *features[i];\n");
-        ++new_center_counts[nearest];
-        //	  printf("\taccumulate\n");
       }
-    }//for
+    }
 
     if(is_stable) break;
 
+    std::fill(new_center_counts.begin(), new_center_counts.end(), 0);
+    std::fill(new_centers.begin(), new_centers.end(), zero_);
+    for(std::size_t t = 0; t < thread_centers.size(); ++t)
+    {
+      for(size_t i = 0; i < k; ++i)
+      {
+        if(thread_center_counts[t][i] == 0)
+          continue;
+        new_centers[i] += thread_centers[t][i];
+        new_center_counts[i] += thread_center_counts[t][i];
+      }
+    }
+    assert(checkVectorElements(new_centers, "newcenters"));
+
     if(iter > 0)
       max_center_shift = 0;
     // Assign new centers
@@ -491,34 +653,133 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
     {
       if(new_center_counts[i] > 0)
       {
-        //		  printf("%d - %d\n", i, new_center_counts[i] );
-        //		  PrintFeat(new_centers[i] );
-        //		checkElements(new_centers[i], "bef");
         new_centers[i] = new_centers[i] / new_center_counts[i];
 
         squared_distance_type shift = distance_(new_centers[i], centers[i]);
 
         max_center_shift = std::max(max_center_shift, shift);
+        center_shifts[i] = std::sqrt(static_cast<double>(shift));
 
         centers[i] = new_centers[i];
-        //					centers[i] = new_centers[i] / new_center_counts[i];
-        //		checkElements(new_centers[i], "aft");
-        //		PrintFeat(centers[i] );
       }
       else
       {
         // Choose a new center randomly from the input features
         // @todo use a better strategy like taking splitting the largest cluster
-        unsigned int index = rand() % features.size();
+        const unsigned int index = std::uniform_int_distribution<unsigned int>(0, features.size() - 1)(generator);
+        center_shifts[i] = std::sqrt(static_cast<double>(distance_(*features[index], centers[i])));
         centers[i] = *features[index];
         ALICEVISION_LOG_DEBUG("Choosing a new center: " << index);
       }
     }
-    //			ALICEVISION_LOG_DEBUG("max_center_shift: " << max_center_shift);  
+    //			ALICEVISION_LOG_DEBUG("max_center_shift: " << max_center_shift);
     if(max_center_shift <= 10e-10) break;
+
+    if(use_triangle_inequality_)
+    {
+      // Update the bounds with the center shifts
+      std::size_t largest = 0;
+      for(size_t i = 1; i < k; ++i)
+      {
+        if(center_shifts[i] > center_shifts[largest])
+          largest = i;
+      }
+      double secondLargestShift = 0.0;
+      for(size_t i = 0; i < k; ++i)
+      {
+        if(i != largest)
+          secondLargestShift = std::max(secondLargestShift, center_shifts[i]);
+      }
+
+      #pragma omp parallel for
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+      {
+        upper_bounds[i] += center_shifts[membership[i]];
+        lower_bounds[i] -= (membership[i] == largest) ? secondLargestShift : center_shifts[largest];
+      }
+    }
   }
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
 
+  return computeSSE(features, centers, membership);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnceMiniBatch(const std::vector<Feature*>& features, size_t k,
+                                                                        std::vector<Feature, FeatureAllocator>& centers,
+                                                                        std::vector<unsigned int>& membership,
+                                                                        std::mt19937& generator) const
+{
+  typedef typename Distance::value_type feature_value_type;
+
+  // Mini-batch k-means: the centers are updated from random subsets of the features,
+  // each center being the mean of all the features assigned to it so far.
+  //
+  //  D. Sculley, Web-scale k-means clustering. WWW 2010.
+  std::uniform_int_distribution<std::size_t> featureDistribution(0, features.size() - 1);
+
+  std::vector<size_t> batch(mini_batch_size_);
+  std::vector<unsigned int> batch_membership(mini_batch_size_);
+  std::vector<size_t> center_counts(k, 0); // number of features assigned to each center so far
+  std::vector<size_t> batch_center_counts(k);
+  std::vector<Feature, FeatureAllocator> batch_centers(k);
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations");
+  for(size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    for(std::size_t& index : batch)
+      index = featureDistribution(generator);
+
+    #pragma omp parallel for
+    for(ptrdiff_t b = 0; b < static_cast<ptrdiff_t>(batch.size()); ++b)
+    {
+      double nearestDist, secondNearestDist;
+      findNearestCenters(*features[batch[b]], centers, batch_membership[b], nearestDist, secondNearestDist);
+    }
+
+    std::fill(batch_center_counts.begin(), batch_center_counts.end(), 0);
+    std::fill(batch_centers.begin(), batch_centers.end(), zero_);
+    for(size_t b = 0; b < batch.size(); ++b)
+    {
+      batch_centers[batch_membership[b]] += *features[batch[b]];
+      ++batch_center_counts[batch_membership[b]];
+    }
+
+    squared_distance_type max_center_shift = 0;
+    for(size_t i = 0; i < k; ++i)
+    {
+      if(batch_center_counts[i] == 0)
+        continue;
+      Feature new_center = centers[i];
+      new_center *= static_cast<feature_value_type>(center_counts[i]);
+      new_center += batch_centers[i];
+      center_counts[i] += batch_center_counts[i];
+      new_center = new_center / center_counts[i];
+
+      max_center_shift = std::max(max_center_shift, distance_(new_center, centers[i]));
+      centers[i] = new_center;
+    }
+    if(max_center_shift <= 10e-10) break;
+  }
+
+  // Assign all the features to the final centers
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    double nearestDist, secondNearestDist;
+    findNearestCenters(*features[i], centers, membership[i], nearestDist, secondNearestDist);
+  }
+
+  return computeSSE(features, centers, membership);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::computeSSE(const std::vector<Feature*>& features,
+                                                              const std::vector<Feature, FeatureAllocator>& centers,
+                                                              const std::vector<unsigned int>& membership) const
+{
   // Return the sum squared error
   /// @todo Kahan summation?
   squared_distance_type sse = squared_distance_type(0);
@@ -8,7 +8,12 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/randomSeed.hpp>
+
 #include <deque>
+#include <random>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -79,19 +84,35 @@ public:
     return verbose_;
   }
 
+  /**
+   * @brief Set the seed of the k-means random number generators.
+   * Each subset is clustered with its own generator, seeded from this seed, its level and its index.
+   */
+  void setSeed(unsigned int seed)
+  {
+    seed_ = seed;
+  }
+
+  unsigned int getSeed() const
+  {
+    return seed_;
+  }
+
 protected:
   Tree tree_;
   Kmeans kmeans_;
   Feature zero_;
 private:
   unsigned char verbose_;
+  unsigned int seed_;
 };
 
 template<class Feature, template<typename, typename> class DistanceT, class FeatureAllocator>
 TreeBuilder<Feature, DistanceT, FeatureAllocator>::TreeBuilder(const Feature& zero, Distance d, unsigned char verbose)
 : kmeans_(zero, d, verbose),
 zero_(zero),
-verbose_(verbose)
+verbose_(verbose),
+seed_(system::getRandomSeed())
 {
 }
 
@@ -118,16 +139,35 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
       feature_ptrs.push_back(const_cast<Feature*> (&f));
     }
   }
-  FeatureVector centers; // always size k
   for(uint32_t level = 0; level < levels; ++level)
   {
     if(verbose_) printf("# Level %u\n", level);
-    std::vector<unsigned int> membership;
+    const std::size_t nbSubsets = subset_queue.size();
+
+    // The subsets are independent: cluster them concurrently when there are enough of them,
+    // otherwise cluster them one by one and let the k-means use all the threads.
+    std::vector<FeatureVector> subsetCenters(nbSubsets); // always size k
+    std::vector< std::vector<unsigned int> > subsetMemberships(nbSubsets);
+    const bool parallelSubsets = (nbSubsets >= static_cast<std::size_t>(omp_get_max_threads()));
+
+    #pragma omp parallel for schedule(dynamic) if(parallelSubsets)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbSubsets); ++i)
+    {
+      const std::vector<Feature*> &subset = subset_queue[i];
+      // Cluster the current subset into k centers.
+      if(subset.size() > k)
+      {
+        // the result does not depend on the thread clustering the subset
+        std::seed_seq seedSequence{seed_, level, static_cast<uint32_t>(i)};
+        std::mt19937 generator(seedSequence);
+        kmeans_.clusterPointers(subset, k, subsetCenters[i], subsetMemberships[i], generator);
+      }
+    }
 
-    for(size_t i = 0, ie = subset_queue.size(); i < ie; ++i)
+    for(size_t i = 0; i < nbSubsets; ++i)
     {
       std::vector<Feature*> &subset = subset_queue.front();
-      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, ie, subset.size());
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, nbSubsets, subset.size());
 
       // If the subset already has k or fewer elements, just use those as the centers.
       if(subset.size() <= k)
@@ -148,9 +188,9 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
       }
       else
       {
-        // Cluster the current subset into k centers.
-        if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", subset.size(), k);
-        kmeans_.clusterPointers(subset, k, centers, membership);
+        if(verbose_ > 2) printf("#\tclustered the current subset of %lu elements into %d centers\n", subset.size(), k);
+        const FeatureVector& centers = subsetCenters[i];
+        const std::vector<unsigned int>& membership = subsetMemberships[i];
         // Add the centers and mark them as valid.
         tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
         tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
@@ -167,9 +207,13 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
         subset_queue.pop_front();
         subset_queue.insert(subset_queue.end(), new_subsets.begin(), new_subsets.end());
       }
+      // Release the memory of this subset
+      FeatureVector().swap(subsetCenters[i]);
+      std::vector<unsigned int>().swap(subsetMemberships[i]);
     }
     if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
   }
+  tree_.pack();
 }
 
 }
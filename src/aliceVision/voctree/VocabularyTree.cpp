@@ -6,238 +6,259 @@
 
 #include "VocabularyTree.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 namespace aliceVision {
 namespace voctree {
 
-float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+CompactHistogram::CompactHistogram(const Document& document)
 {
+  // sort the (word, feature id) pairs by word, keeping the feature ids in increasing order
+  std::vector<std::pair<Word, IndexT> > wordFeatures(document.size());
+  for(std::size_t i = 0; i < document.size(); ++i)
+    wordFeatures[i] = std::make_pair(document[i], static_cast<IndexT>(i));
+  std::sort(wordFeatures.begin(), wordFeatures.end());
 
-  float distance = 0.0f;
-  float epsilon = 0.001;
-  
-  SparseHistogram::const_iterator i1 = v1.begin(), i1e = v1.end();
-  SparseHistogram::const_iterator i2 = v2.begin(), i2e = v2.end();
-  
-  if(distanceMethod.compare("classic") == 0) 
-  {      
-    while(i1 != i1e && i2 != i2e)
-    {
-      if(i2->first < i1->first)
-      {
-        distance += i2->second.size();
-        ++i2;
-      }
-      else if(i1->first < i2->first)
-      {
-        distance += i1->second.size();
-        ++i1;
-      }
-      else
-      {
-        distance += fabs(i1->second.size() - i2->second.size());
-        ++i1;
-        ++i2;
-      }
-    }
-
-    while(i1 != i1e)
+  featureIds_.reserve(document.size());
+  offsets_.push_back(0);
+  for(std::size_t i = 0; i < wordFeatures.size(); ++i)
+  {
+    if(words_.empty() || words_.back() != wordFeatures[i].first)
     {
-      distance += i1->second.size();
-      ++i1;
+      if(!words_.empty())
+        offsets_.push_back(i);
+      words_.push_back(wordFeatures[i].first);
     }
+    featureIds_.push_back(wordFeatures[i].second);
+  }
+  if(!words_.empty())
+    offsets_.push_back(featureIds_.size());
+}
 
-    while(i2 != i2e)
-    {
-      distance += i2->second.size();
-      ++i2;
-    }
+CompactHistogram::CompactHistogram(const SparseHistogram& histogram)
+{
+  words_.reserve(histogram.size());
+  offsets_.reserve(histogram.size() + 1);
+  offsets_.push_back(0);
+  for(const auto& wordIt : histogram)
+  {
+    words_.push_back(wordIt.first);
+    featureIds_.insert(featureIds_.end(), wordIt.second.begin(), wordIt.second.end());
+    offsets_.push_back(featureIds_.size());
   }
-  
-  else if(distanceMethod.compare("commonPoints") == 0) 
+}
+
+SparseHistogram CompactHistogram::toSparseHistogram() const
+{
+  SparseHistogram histogram;
+  for(std::size_t i = 0; i < words_.size(); ++i)
+    histogram[words_[i]].assign(featureIds_.begin() + offsets_[i], featureIds_.begin() + offsets_[i + 1]);
+  return histogram;
+}
+
+void CompactHistogram::write(std::ostream& stream) const
+{
+  const uint32_t nbWords = words_.size();
+  const uint32_t nbFeatures = featureIds_.size();
+  stream.write((const char*) &nbWords, sizeof(uint32_t));
+  stream.write((const char*) &nbFeatures, sizeof(uint32_t));
+  stream.write((const char*) words_.data(), nbWords * sizeof(Word));
+  stream.write((const char*) offsets_.data(), (nbWords + 1) * sizeof(uint32_t));
+  stream.write((const char*) featureIds_.data(), nbFeatures * sizeof(IndexT));
+}
+
+void CompactHistogram::read(std::istream& stream)
+{
+  uint32_t nbWords = 0;
+  uint32_t nbFeatures = 0;
+  stream.read((char*) &nbWords, sizeof(uint32_t));
+  stream.read((char*) &nbFeatures, sizeof(uint32_t));
+  if(!stream.good())
+    throw std::runtime_error("Invalid histogram data: can't read the sizes.");
+
+  // check the sizes against the remaining data (when known) before allocating
+  const std::istream::pos_type position = stream.tellg();
+  if(position != std::istream::pos_type(-1))
   {
-    double score = 0.0;
-    double N1 = 0.0;
-    double N2 = 0.0;
-    
-    while(i1 != i1e && i2 != i2e)
-    {
-      if(i2->first < i1->first)
-      {
-        N2 += i2->second.size();
-        ++i2;
-      }
-      else if(i1->first < i2->first)
-      {
-        N1 += i1->second.size();
-         ++i1;
-      }
-      else
-      {
-        score += std::min(i1->second.size(), i2->second.size());
-        N1 += i1->second.size();
-        N2 += i2->second.size();
-        ++i1;
-        ++i2;
-      }
-    }
+    stream.seekg(0, std::ios_base::end);
+    const std::istream::pos_type end = stream.tellg();
+    stream.seekg(position);
+    const uint64_t dataSize = uint64_t(nbWords) * sizeof(Word) + (uint64_t(nbWords) + 1) * sizeof(uint32_t) + uint64_t(nbFeatures) * sizeof(IndexT);
+    if(end == std::istream::pos_type(-1) || uint64_t(end - position) < dataSize)
+      throw std::runtime_error("Invalid histogram data: truncated data.");
+  }
 
-    while(i1 != i1e)
-    {
-      N1 += i1->second.size();
-      ++i1;
-    }
+  std::vector<Word> words(nbWords);
+  std::vector<uint32_t> offsets(nbWords + 1);
+  std::vector<IndexT> featureIds(nbFeatures);
+  stream.read((char*) words.data(), nbWords * sizeof(Word));
+  stream.read((char*) offsets.data(), (nbWords + 1) * sizeof(uint32_t));
+  stream.read((char*) featureIds.data(), nbFeatures * sizeof(IndexT));
+  if(!stream.good())
+    throw std::runtime_error("Invalid histogram data: truncated data.");
 
-    while(i2 != i2e)
-    {
-      N2 += i2->second.size();
-      ++i2;
-    }
-    
-    distance = - score;
+  // the words are sorted and unique, the offsets delimit the features of each word
+  if(offsets.front() != 0 || offsets.back() != nbFeatures)
+    throw std::runtime_error("Invalid histogram data: corrupted offsets.");
+  for(std::size_t i = 0; i < nbWords; ++i)
+  {
+    if(offsets[i] > offsets[i + 1] || (i > 0 && words[i - 1] >= words[i]))
+      throw std::runtime_error("Invalid histogram data: corrupted words or offsets.");
   }
-  
-  else if(distanceMethod.compare("strongCommonPoints") == 0) 
+
+  words_.swap(words);
+  offsets_.swap(offsets);
+  featureIds_.swap(featureIds);
+}
+
+namespace {
+
+/// Iterate over the (word, count) entries of a SparseHistogram
+class SparseHistogramCursor
+{
+public:
+  explicit SparseHistogramCursor(const SparseHistogram& histogram)
+    : _it(histogram.begin())
+    , _end(histogram.end())
+  {}
+
+  bool valid() const { return _it != _end; }
+  Word word() const { return _it->first; }
+  std::size_t count() const { return _it->second.size(); }
+  void next() { ++_it; }
+
+private:
+  SparseHistogram::const_iterator _it;
+  SparseHistogram::const_iterator _end;
+};
+
+/// Iterate over the (word, count) entries of a CompactHistogram
+class CompactHistogramCursor
+{
+public:
+  explicit CompactHistogramCursor(const CompactHistogram& histogram)
+    : _histogram(histogram)
+  {}
+
+  bool valid() const { return _i < _histogram.size(); }
+  Word word() const { return _histogram.word(_i); }
+  std::size_t count() const { return _histogram.count(_i); }
+  void next() { ++_i; }
+
+private:
+  const CompactHistogram& _histogram;
+  std::size_t _i = 0;
+};
+
+/**
+ * @brief Linear merge of two histograms sorted by word,
+ * only the words shared by the two histograms change the score.
+ */
+template<class Cursor1, class Cursor2>
+float mergeDistance(Cursor1 i1, Cursor2 i2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+{
+  float distance = 0.0f;
+
+  if(distanceMethod.compare("classic") == 0)
   {
-    double score = 0.0;
-    double N1 = 0.0;
-    double N2 = 0.0;
-    
-    while(i1 != i1e && i2 != i2e)
+    while(i1.valid() && i2.valid())
     {
-      if(i2->first < i1->first)
+      if(i2.word() < i1.word())
       {
-        N2 += i2->second.size();
-        ++i2;
+        distance += i2.count();
+        i2.next();
       }
-      else if(i1->first < i2->first)
+      else if(i1.word() < i2.word())
       {
-        N1 += i1->second.size();
-        ++i1;
+        distance += i1.count();
+        i1.next();
       }
       else
       {
-        if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
-        {
-          score += 1;
-          N1 += 1;
-          N2 += 1;
-        }
-        ++i1;
-        ++i2;
+        distance += std::abs(static_cast<double>(i1.count()) - static_cast<double>(i2.count()));
+        i1.next();
+        i2.next();
       }
     }
 
-    while(i1 != i1e)
-    {
-      N1 += i1->second.size();
-      ++i1;
-    }
+    for(; i1.valid(); i1.next())
+      distance += i1.count();
 
-    while(i2 != i2e)
-    {
-      N2 += i2->second.size();
-      ++i2;
-    }
-    
-    distance = - score;
+    for(; i2.valid(); i2.next())
+      distance += i2.count();
+
+    return distance;
   }
-  
-  else if(distanceMethod.compare("weightedStrongCommonPoints") == 0) 
-  {
-    double score = 0.0;
-    double N1 = 0.0;
-    double N2 = 0.0;
-    
-    while(i1 != i1e && i2 != i2e)
-    {
-      if(i2->first < i1->first)
-      {
-        N2 += i2->second.size()*word_weights[i2->first];
-        ++i2;
-      }
-      else if(i1->first < i2->first)
-      {
-        N1 += i1->second.size()*word_weights[i1->first];
-         ++i1;
-      }
-        if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
-        {
-          score += word_weights[i1->first];
-          N1 += word_weights[i1->first];
-          N2 += word_weights[i2->first];
-        }
-        ++i1;
-        ++i2;
-    }
 
-    while(i1 != i1e)
-    {
-      N1 += i1->second.size()*word_weights[i1->first];
-      ++i1;
-    }
+  enum { COMMON_POINTS, STRONG_COMMON_POINTS, WEIGHTED_STRONG_COMMON_POINTS, INVERSED_WEIGHTED_COMMON_POINTS } method;
 
-    while(i2 != i2e)
-    {
-      N2 += i2->second.size()*word_weights[i2->first];
-      ++i2;
-    }
-    
-    distance = - score;
-  }
-  
+  if(distanceMethod.compare("commonPoints") == 0)
+    method = COMMON_POINTS;
+  else if(distanceMethod.compare("strongCommonPoints") == 0)
+    method = STRONG_COMMON_POINTS;
+  else if(distanceMethod.compare("weightedStrongCommonPoints") == 0)
+    method = WEIGHTED_STRONG_COMMON_POINTS;
   else if(distanceMethod.compare("inversedWeightedCommonPoints") == 0)
+    method = INVERSED_WEIGHTED_COMMON_POINTS;
+  else
+    throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
+
+  double score = 0.0;
+
+  while(i1.valid() && i2.valid())
   {
-    double score = 0.0;
-    double N1 = 0.0;
-    double N2 = 0.0;
-    std::map<int,int> compteur;
-    
-    while(i1 != i1e && i2 != i2e)
+    if(i2.word() < i1.word())
     {
-      if(i2->first < i1->first)
-      {
-        N2 += i2->second.size() / word_weights[i2->first];
-        ++i2;
-      }
-      else if(i1->first < i2->first)
-      {
-        N1 += i1->second.size() / word_weights[i1->first];
-         ++i1;
-      }
-      else
-      {
-        compteur[i1->first] += std::min(i1->second.size(), i2->second.size());
-        N1 += i1->second.size() / word_weights[i1->first];
-        N2 += i2->second.size() / word_weights[i2->first];
-        ++i1;
-        ++i2;
-      }
+      i2.next();
     }
-
-    while(i1 != i1e)
+    else if(i1.word() < i2.word())
     {
-      N1 += i1->second.size() / word_weights[i1->first];
-      ++i1;
+      i1.next();
     }
-
-    while(i2 != i2e)
+    else
     {
-      N2 += i2->second.size() / word_weights[i2->first];;
-      ++i2;
+      const std::size_t count1 = i1.count();
+      const std::size_t count2 = i2.count();
+
+      switch(method)
+      {
+        case COMMON_POINTS:
+          score += std::min(count1, count2);
+          break;
+        case STRONG_COMMON_POINTS:
+          if(count1 == 1 && count2 == 1)
+            score += 1;
+          break;
+        case WEIGHTED_STRONG_COMMON_POINTS:
+          if(count1 == 1 && count2 == 1)
+            score += word_weights[i1.word()];
+          break;
+        case INVERSED_WEIGHTED_COMMON_POINTS:
+          score += (1.0 / std::min(count1, count2)) * word_weights[i1.word()];
+          break;
+      }
+      i1.next();
+      i2.next();
     }
-    
-    for(auto iCompteur = compteur.begin(); iCompteur != compteur.end(); iCompteur++)
-      score += (1.0/iCompteur->second) * word_weights[iCompteur->first];
-    
-    distance = - score;
   }
-  else
-  {
-    throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
-  }
-  
+
+  distance = - score;
   return distance;
 }
 
+} // namespace
+
+float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+{
+  return mergeDistance(SparseHistogramCursor(v1), SparseHistogramCursor(v2), distanceMethod, word_weights);
+}
+
+float sparseDistance(const CompactHistogram& v1, const CompactHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
+{
+  return mergeDistance(CompactHistogramCursor(v1), CompactHistogramCursor(v2), distanceMethod, word_weights);
+}
+
 } //namespace voctree
 } //namespace aliceVision
\ No newline at end of file
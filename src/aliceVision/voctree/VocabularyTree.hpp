@@ -16,7 +16,13 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/system/Logger.hpp>
 
+#include <Eigen/Core>
+
 #include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
 #include <vector>
 #include <map>
 #include <cassert>
@@ -57,6 +63,66 @@ inline void computeSparseHistogram(const std::vector<Word>& document, SparseHist
   }
 }
 
+/**
+ * @brief Sparse histogram of visual words stored in flat sorted arrays.
+ *
+ * The unique words are sorted in increasing order and the ids of the features
+ * associated to the i-th word are featureIds()[offsets()[i]] to featureIds()[offsets()[i+1]]
+ * (CSR layout). It holds the same data as a SparseHistogram without one tree node
+ * and one vector allocation per word.
+ */
+class CompactHistogram
+{
+public:
+  CompactHistogram()
+    : offsets_(1, 0)
+  {}
+
+  /**
+   * @brief Build the histogram of a document
+   * @param[in] document a list of (possibly repeated) visual words, one per feature
+   */
+  explicit CompactHistogram(const Document& document);
+
+  explicit CompactHistogram(const SparseHistogram& histogram);
+
+  SparseHistogram toSparseHistogram() const;
+
+  /// Number of unique words
+  std::size_t size() const { return words_.size(); }
+  bool empty() const { return words_.empty(); }
+  /// Number of features
+  std::size_t nbFeatures() const { return featureIds_.size(); }
+
+  Word word(std::size_t i) const { return words_[i]; }
+  /// Number of features associated to the i-th word
+  uint32_t count(std::size_t i) const { return offsets_[i + 1] - offsets_[i]; }
+
+  const std::vector<Word>& words() const { return words_; }
+  const std::vector<uint32_t>& offsets() const { return offsets_; }
+  const std::vector<IndexT>& featureIds() const { return featureIds_; }
+
+  /// Write the histogram in binary format
+  void write(std::ostream& stream) const;
+  /**
+   * @brief Read a histogram written by write()
+   * @throw std::runtime_error if the data is truncated or inconsistent (the histogram is left unchanged)
+   */
+  void read(std::istream& stream);
+
+  bool operator==(const CompactHistogram& other) const
+  {
+    return words_ == other.words_ &&
+           offsets_ == other.offsets_ &&
+           featureIds_ == other.featureIds_;
+  }
+
+private:
+  std::vector<Word> words_;
+  std::vector<uint32_t> offsets_;
+  std::vector<IndexT> featureIds_;
+};
+
 class IVocabularyTree
 {
 public:
@@ -74,6 +140,14 @@ public:
    */
   virtual SparseHistogram quantizeToSparse(const void* blindDescriptors) const = 0;
 
+  /**
+   * @brief Create a SparseHistogram from a contiguous array of descriptors.
+   * @param descriptorsData pointer to the first descriptor (see Regions::DescriptorRawData)
+   * @param nbDescriptors number of descriptors
+   * @return
+   */
+  virtual SparseHistogram quantizeToSparse(const void* descriptorsData, std::size_t nbDescriptors) const = 0;
+
   /// Get the depth (number of levels) of the tree.
   virtual uint32_t levels() const = 0;
   /// Get the branching factor (max splits at each node) of the tree.
@@ -119,18 +193,39 @@ public:
 
   /// Quantizes a set of features into visual words.
   template<class DescriptorT>
-  std::vector<Word> quantize(const std::vector<DescriptorT>& features) const;
+  std::vector<Word> quantize(const std::vector<DescriptorT>& features) const
+  {
+    return quantize(features.data(), features.size());
+  }
+
+  /// Quantizes a contiguous array of features into visual words.
+  template<class DescriptorT>
+  std::vector<Word> quantize(const DescriptorT* features, std::size_t nbFeatures) const;
 
   /// Quantizes a set of features into sparse histogram of visual words.
   template<class DescriptorT>
   SparseHistogram quantizeToSparse(const std::vector<DescriptorT>& features) const;
 
+  template<class DescriptorT>
+  CompactHistogram quantizeToCompact(const std::vector<DescriptorT>& features) const
+  {
+    return CompactHistogram(quantize(features));
+  }
+
   SparseHistogram quantizeToSparse(const void* blindDescriptors) const override
   {
     const std::vector<Feature>* descriptors = static_cast<const std::vector<Feature>*>(blindDescriptors);
     return quantizeToSparse(*descriptors);
   }
 
+  SparseHistogram quantizeToSparse(const void* descriptorsData, std::size_t nbDescriptors) const override
+  {
+    SparseHistogram histo;
+    std::vector<Word> doc = quantize(static_cast<const Feature*>(descriptorsData), nbDescriptors);
+    computeSparseHistogram(doc, histo);
+    return histo;
+  }
+
   /// Get the depth (number of levels) of the tree.
   uint32_t levels() const override;
   /// Get the branching factor (max splits at each node) of the tree.
@@ -141,6 +236,13 @@ public:
   /// Clears vocabulary, leaving an empty tree.
   void clear() override;
 
+  /**
+   * @brief Pack the centers in the fast quantization layout:
+   * float centers, the children of each node stored contiguously and aligned.
+   * Called by load(), only supported with the L2 distance.
+   */
+  void pack();
+
   /// Save vocabulary to a file.
   void save(const std::string& file) const override;
   /// Load vocabulary from a file.
@@ -165,12 +267,30 @@ protected:
   uint32_t num_words_; // number of leaf nodes
   uint32_t word_start_; // number of non-leaf nodes, or offset to the first leaf node
 
+  /// Packed centers (one aligned row of packed_dim_ floats per center), empty if not packed
+  std::vector<float, Eigen::aligned_allocator<float> > packed_centers_;
+  Eigen::VectorXf packed_norms_; // squared norm of each packed center
+  uint32_t packed_dim_ = 0; // descriptor dimension, padded to a multiple of 8 floats
+
   bool initialized() const
   {
     return num_words_ != 0;
   }
 
   void setNodeCounts();
+
+  /**
+   * @brief Quantize a block of features with the packed centers.
+   * At each level, the distances to all the children of the current node are computed
+   * at once as |c|^2 - 2 c.q (a matrix-vector product on the contiguous children).
+   * This float expansion has a rounding error, so the children within its error bound
+   * of the nearest one are re-ranked with the exact distance: the words are the same
+   * as the ones of the generic quantize().
+   * Like the generic quantize(), the valid children of a node are assumed
+   * to be a prefix of its children (the tree builder invalidates the last ones).
+   */
+  template<class DescriptorT>
+  void quantizePacked(const DescriptorT* features, std::size_t nbFeatures, Word* words) const;
 };
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -222,14 +342,29 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
-std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features) const
+std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT* features, std::size_t nbFeatures) const
 {
-  // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
-  std::vector<Word> imgVisualWords(features.size(), 0);
+  // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << nbFeatures);
+  std::vector<Word> imgVisualWords(nbFeatures, 0);
+
+  if(!packed_centers_.empty())
+  {
+    // quantize the features by blocks
+    const std::size_t blockSize = 256;
+    const ptrdiff_t nbBlocks = (nbFeatures + blockSize - 1) / blockSize;
+    #pragma omp parallel for schedule(dynamic)
+    for(ptrdiff_t b = 0; b < nbBlocks; ++b)
+    {
+      const std::size_t begin = b * blockSize;
+      const std::size_t end = std::min(begin + blockSize, nbFeatures);
+      quantizePacked(&features[begin], end - begin, &imgVisualWords[begin]);
+    }
+    return imgVisualWords;
+  }
 
   // quantize the features
   #pragma omp parallel for
-  for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
+  for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(nbFeatures); ++j)
   {
     // store the visual word associated to the feature in the temporary list
     imgVisualWords[j] = quantize<DescriptorT>(features[j]);
@@ -249,6 +384,77 @@ SparseHistogram VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeToS
   return histo;
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::quantizePacked(const DescriptorT* features, std::size_t nbFeatures, Word* words) const
+{
+  typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixRowMajor;
+
+  assert(initialized());
+
+  // features as float rows (padded with zeros like the centers)
+  MatrixRowMajor queries = MatrixRowMajor::Zero(nbFeatures, packed_dim_);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    for(std::size_t d = 0; d < features[i].size(); ++d)
+      queries(i, d) = static_cast<float>(features[i][d]);
+  }
+
+  typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
+  typedef Eigen::Map<const MatrixRowMajor, Eigen::Aligned> CentersMap;
+
+  // bound of the relative rounding error of the float expansion, with a safety factor
+  const float tolerance = 4.f * packed_dim_ * std::numeric_limits<float>::epsilon();
+
+  Eigen::VectorXf distances(splits());
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    const float queryNorm = queries.row(i).norm();
+    int32_t index = -1; // virtual "root" index, which has no associated center.
+    for(unsigned level = 0; level < levels_; ++level)
+    {
+      // Calculate the offset to the first child of the current index.
+      const int32_t first_child = (index + 1) * splits();
+      // Number of valid children (fewer than splits() children)
+      int32_t nbChildren = 0;
+      while(nbChildren < (int32_t) splits() && valid_centers_[first_child + nbChildren])
+        ++nbChildren;
+      assert(std::none_of(valid_centers_.begin() + first_child + nbChildren, valid_centers_.begin() + first_child + splits(),
+                          [](uint8_t valid) { return valid != 0; }));
+      int32_t best_child = first_child;
+      if(nbChildren > 0)
+      {
+        // distances to all the children centers at once
+        const CentersMap children(&packed_centers_[std::size_t(first_child) * packed_dim_], nbChildren, packed_dim_);
+        // |c - q|^2 = |c|^2 - 2 c.q + |q|^2 (the last term does not change the nearest child)
+        distances.head(nbChildren) = packed_norms_.segment(first_child, nbChildren);
+        distances.head(nbChildren).noalias() -= 2.f * (children * queries.row(i).transpose());
+        Eigen::Index best;
+        const float bestDistance = distances.head(nbChildren).minCoeff(&best);
+
+        // re-rank the children that can be the nearest one with the exact distance
+        const float maxNorm = std::sqrt(packed_norms_.segment(first_child, nbChildren).maxCoeff());
+        const float margin = tolerance * (maxNorm + queryNorm) * (maxNorm + queryNorm);
+        distance_type best_distance = std::numeric_limits<distance_type>::max();
+        for(int32_t c = 0; c < nbChildren; ++c)
+        {
+          if(distances(c) > bestDistance + margin)
+            continue;
+          const distance_type child_distance = Distance<DescriptorT, Feature>()(features[i], centers_[first_child + c]);
+          if(child_distance < best_distance)
+          {
+            best = c;
+            best_distance = child_distance;
+          }
+        }
+        best_child += best;
+      }
+      index = best_child;
+    }
+    words[i] = index - word_start_;
+  }
+}
+
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 uint32_t VocabularyTree<Feature, Distance, FeatureAllocator>::levels() const
 {
@@ -272,9 +478,35 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
+  packed_centers_.clear();
+  packed_norms_.resize(0);
+  packed_dim_ = 0;
   k_ = levels_ = num_words_ = word_start_ = 0;
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::pack()
+{
+  packed_centers_.clear();
+  packed_norms_.resize(0);
+  packed_dim_ = 0;
+
+  // the packed quantization computes L2 distances
+  if(!std::is_same<Distance<Feature, Feature>, L2<Feature, Feature> >::value || centers_.empty())
+    return;
+
+  const std::size_t dim = centers_.front().size();
+  packed_dim_ = ((dim + 7) / 8) * 8;
+  packed_centers_.assign(centers_.size() * packed_dim_, 0.f);
+  for(std::size_t i = 0; i < centers_.size(); ++i)
+  {
+    for(std::size_t d = 0; d < dim; ++d)
+      packed_centers_[i * packed_dim_ + d] = static_cast<float>(centers_[i][d]);
+  }
+  typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixRowMajor;
+  packed_norms_ = Eigen::Map<const MatrixRowMajor>(packed_centers_.data(), centers_.size(), packed_dim_).rowwise().squaredNorm();
+}
+
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string& file) const
 {
@@ -318,6 +550,7 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string
 
   setNodeCounts();
   assert(size == num_words_ + word_start_);
+  pack();
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -343,6 +576,12 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::setNodeCounts()
  */
 float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod = "classic", const std::vector<float>& word_weights = std::vector<float>());
 
+/**
+ * @brief compute the sparse distance between two compact histograms according to the chosen distance method.
+ * Same result as the SparseHistogram version.
+ */
+float sparseDistance(const CompactHistogram& v1, const CompactHistogram& v2, const std::string &distanceMethod = "classic", const std::vector<float>& word_weights = std::vector<float>());
+
 inline std::unique_ptr<IVocabularyTree> createVoctreeForDescriberType(feature::EImageDescriberType imageDescriberType)
 {
   using namespace aliceVision::feature;
@@ -0,0 +1,65 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "databaseIO.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace voctree {
+
+void saveDocuments(const std::string& filename, const Database& db)
+{
+  std::ofstream out(filename, std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error("Unable to write the documents file '" + filename + "'");
+
+  const uint32_t nbDocuments = db.size();
+  out.write((const char*) &nbDocuments, sizeof(uint32_t));
+  for(std::size_t i = 0; i < nbDocuments; ++i)
+  {
+    const DocId docId = db.getDocIds()[i];
+    out.write((const char*) &docId, sizeof(DocId));
+    db.getDocuments()[i].write(out);
+  }
+
+  if(!out.good())
+    throw std::runtime_error("Failed to write the documents file '" + filename + "'");
+}
+
+void loadDocuments(const std::string& filename, Database& db)
+{
+  std::ifstream in(filename, std::ios_base::binary);
+  if(!in.is_open())
+    throw std::runtime_error("Unable to read the documents file '" + filename + "'");
+
+  uint32_t nbDocuments = 0;
+  in.read((char*) &nbDocuments, sizeof(uint32_t));
+  for(std::size_t i = 0; i < nbDocuments && in.good(); ++i)
+  {
+    DocId docId;
+    CompactHistogram document;
+    in.read((char*) &docId, sizeof(DocId));
+    if(!in.good())
+      break;
+    try
+    {
+      document.read(in);
+    }
+    catch(const std::exception& e)
+    {
+      throw std::runtime_error("Failed to read the documents file '" + filename + "': " + e.what());
+    }
+    db.insert(docId, document);
+  }
+
+  if(!in.good())
+    throw std::runtime_error("Failed to read the documents file '" + filename + "'");
+}
+
+} //namespace voctree
+} //namespace aliceVision
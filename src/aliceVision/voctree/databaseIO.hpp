@@ -108,6 +108,24 @@ void voctreeStatistics(const sfm::SfMData& sfmData,
                        const std::string& distanceMethod,
                        std::map<int, int>& globalHistogram);
 
+/**
+ * @brief Save the documents of a database in a binary file,
+ * so that the database can be rebuilt without quantizing the descriptors again.
+ *
+ * @param[in] filename The output file
+ * @param[in] db The database
+ */
+void saveDocuments(const std::string& filename, const Database& db);
+
+/**
+ * @brief Insert the documents saved by saveDocuments() in a database.
+ *
+ * @param[in] filename The documents file
+ * @param[in,out] db The database, with the word weights already loaded
+ * @throw std::runtime_error if the file can't be read or is corrupted
+ */
+void loadDocuments(const std::string& filename, Database& db);
+
 } //namespace voctree
 } //namespace aliceVision
 
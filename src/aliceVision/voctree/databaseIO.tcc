@@ -17,6 +17,7 @@
 #include <exception>
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace voctree {
@@ -46,7 +47,7 @@ std::size_t populateDatabase(const sfm::SfMData& sfmData,
     loadDescsFromBinFile(currentFile.second, descriptors, false, Nmax);
     size_t result = descriptors.size();
     
-    SparseHistogram newDoc =  tree.quantizeToSparse(descriptors);
+    CompactHistogram newDoc = tree.quantizeToCompact(descriptors);
 
     // Insert document in database
     db.insert(currentFile.first, newDoc);
@@ -88,7 +89,7 @@ std::size_t populateDatabase(const sfm::SfMData& sfmData,
     
     allDescriptors[currentFile.first] = descriptors;
     
-    SparseHistogram newDoc = tree.quantizeToSparse(descriptors);
+    CompactHistogram newDoc = tree.quantizeToCompact(descriptors);
     
     // Insert document in database
     db.insert(currentFile.first, newDoc);
@@ -43,6 +43,8 @@ void getListOfDescriptorFiles(const sfm::SfMData& sfmData,
  * @param[in] featuresFolders The folder(s) containing the descriptor files (optional)
  * @param[in,out] descriptors the vector to which append all the read descriptors
  * @param[in,out] numFeatures a vector collecting for each file read the number of features read
+ * @param[in] maxDescriptors the maximum number of descriptors to read, if there are more descriptors
+ *            they are evenly subsampled (one file at a time, to limit the memory used), 0 to read all of them
  * @return the total number of features read
  *
  */
@@ -50,7 +52,8 @@ template<class DescriptorT, class FileDescriptorT>
 size_t readDescFromFiles(const sfm::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<size_t>& numFeatures);
+                         std::vector<size_t>& numFeatures,
+                         size_t maxDescriptors = 0);
 
 } // namespace voctree
 } // namespace aliceVision
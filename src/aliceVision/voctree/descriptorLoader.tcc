@@ -11,6 +11,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/progress.hpp>
 
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 
@@ -21,7 +22,8 @@ template<class DescriptorT, class FileDescriptorT>
 size_t readDescFromFiles(const sfm::SfMData& sfmData,
                          const std::vector<std::string>& featuresFolders,
                          std::vector<DescriptorT>& descriptors,
-                         std::vector<size_t> &numFeatures)
+                         std::vector<size_t> &numFeatures,
+                         size_t maxDescriptors)
 {
   namespace bfs = boost::filesystem;
   std::map<IndexT, std::string> descriptorsFiles;
@@ -59,6 +61,15 @@ size_t readDescFromFiles(const sfm::SfMData& sfmData,
     return 0;
   }
 
+  // Keep an evenly distributed subset of the descriptors if there are too many
+  const bool subsample = (maxDescriptors > 0 && numDescriptors > maxDescriptors);
+  const std::size_t numDescriptorsInFiles = numDescriptors;
+  if(subsample)
+  {
+    ALICEVISION_LOG_DEBUG("Only " << maxDescriptors << " descriptors will be read");
+    numDescriptors = maxDescriptors;
+  }
+
   // Allocate the memory
   descriptors.reserve(numDescriptors);
   size_t numDescriptorsCheck = numDescriptors; // for later check
@@ -68,11 +79,32 @@ size_t readDescFromFiles(const sfm::SfMData& sfmData,
   ALICEVISION_LOG_DEBUG("Reading the descriptors...");
   display.restart(descriptorsFiles.size());
 
+  std::vector<DescriptorT> fileDescriptors;
+  std::size_t numDescriptorsRead = 0; // index of the descriptor in all the files
+
   // Run through the path vector and read the descriptors
   for(const auto &currentFile : descriptorsFiles)
   {
-    // Read the descriptors and append them in the vector
-    feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, descriptors, true);
+    if(subsample)
+    {
+      // Read the descriptors of the file and append the ones of the subset
+      fileDescriptors.clear();
+      feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, fileDescriptors, true);
+      for(const DescriptorT& descriptor : fileDescriptors)
+      {
+        // keep the descriptor if the subset index changes
+        const std::uint64_t subsetIndex = std::uint64_t(numDescriptorsRead) * maxDescriptors / numDescriptorsInFiles;
+        const std::uint64_t nextSubsetIndex = std::uint64_t(numDescriptorsRead + 1) * maxDescriptors / numDescriptorsInFiles;
+        if(nextSubsetIndex > subsetIndex)
+          descriptors.push_back(descriptor);
+        ++numDescriptorsRead;
+      }
+    }
+    else
+    {
+      // Read the descriptors and append them in the vector
+      feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, descriptors, true);
+    }
     size_t result = descriptors.size();
 
     // Add the number of descriptors from this file
@@ -28,13 +28,24 @@ struct L2
 
   result_type operator()(const DescriptorA& a, const DescriptorB& b) const
   {
-    result_type result = result_type(0);
-    for(std::size_t i = 0; i < a.size(); ++i)
+    // independent partial sums, so the compiler can vectorize the loop
+    result_type partial[4] = {0, 0, 0, 0};
+    const std::size_t size = a.size();
+    std::size_t i = 0;
+    for(; i + 4 <= size; i += 4)
     {
-      result_type diff = (result_type)a[i] - (result_type)b[i];
-      result += diff*diff;
+      for(std::size_t p = 0; p < 4; ++p)
+      {
+        const result_type diff = (result_type)a[i + p] - (result_type)b[i + p];
+        partial[p] += diff*diff;
+      }
     }
-    return result;
+    for(; i < size; ++i)
+    {
+      const result_type diff = (result_type)a[i] - (result_type)b[i];
+      partial[0] += diff*diff;
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
   }
 };
 
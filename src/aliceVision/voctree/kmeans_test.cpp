@@ -44,8 +44,9 @@ BOOST_AUTO_TEST_CASE(kmeanInitializer)
   }
 
   voctree::InitKmeanspp initializer;
+  std::mt19937 initGenerator;
 
-  initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>());
+  initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>(), initGenerator);
 
   // it's difficult to check the result as it is random, just check there are no weird things
   BOOST_CHECK(voctree::checkVectorElements(centers, "initializer1"));
@@ -65,7 +66,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializer)
     }
   }
 
-  initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>());
+  initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>(), initGenerator);
 
   // it's difficult to check the result as it is random, just check there are no weird things
   BOOST_CHECK(voctree::checkVectorElements(centers, "initializer2"));
@@ -104,6 +105,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializerVarying)
     FeatureFloatVector centers;
 
     voctree::InitKmeanspp initializer;
+    std::mt19937 initGenerator;
 
     features.reserve(FEATURENUMBER * K);
     featPtr.reserve(features.size());
@@ -119,7 +121,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializerVarying)
       }
     }
 
-    initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>());
+    initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>(), initGenerator);
 
     // it's difficult to check the result as it is random, just check there are no weird things
     BOOST_CHECK(voctree::checkVectorElements(centers, "initializer"));
@@ -290,3 +292,83 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanTriangleInequality)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing kmeans with and without the triangle inequality pruning...");
+
+  const std::size_t DIMENSION = 16;
+  const std::size_t FEATURENUMBER = 5000;
+  const std::size_t K = 20;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // uniformly distributed features: many iterations are needed to converge
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER);
+  for(std::size_t i = 0; i < FEATURENUMBER; ++i)
+    features.push_back(FeatureFloat::Random());
+
+  FeatureFloatVector initialCenters(features.begin(), features.begin() + K);
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero());
+  kmeans.setInitMethod(voctree::InitGiven());
+
+  FeatureFloatVector centers = initialCenters;
+  std::vector<unsigned int> membership;
+  kmeans.setUseTriangleInequality(false);
+  const double sse = kmeans.cluster(features, K, centers, membership);
+
+  FeatureFloatVector centersPruning = initialCenters;
+  std::vector<unsigned int> membershipPruning;
+  kmeans.setUseTriangleInequality(true);
+  const double ssePruning = kmeans.cluster(features, K, centersPruning, membershipPruning);
+
+  // same clustering
+  BOOST_CHECK(membership == membershipPruning);
+  BOOST_CHECK_CLOSE(sse, ssePruning, 1e-6);
+  for(std::size_t i = 0; i < K; ++i)
+    BOOST_CHECK_SMALL(static_cast<double>((centers[i] - centersPruning[i]).norm()), 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing mini-batch kmeans...");
+
+  const std::size_t DIMENSION = 8;
+  const std::size_t FEATURENUMBER = 2000;
+  const std::size_t K = 10;
+  const std::size_t STEP = 5 * K;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // k clusters well far away
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      features.push_back(FeatureFloat::Random() + FeatureFloat::Constant(STEP * i));
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero());
+  kmeans.setRestarts(3);
+  kmeans.setMiniBatchSize(500);
+
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  kmeans.cluster(features, K, centers, membership);
+
+  BOOST_CHECK_EQUAL(membership.size(), features.size());
+
+  // each cluster is found
+  std::vector<std::size_t> h(K, 0);
+  for(std::size_t i = 0; i < membership.size(); ++i)
+    ++h[membership[i]];
+  for(std::size_t i = 0; i < K; ++i)
+    BOOST_CHECK_EQUAL(h[i], FEATURENUMBER);
+}
@@ -5,14 +5,18 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/TreeBuilder.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <Eigen/Core>
 
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
+#include <boost/filesystem.hpp>
+
 #define BOOST_TEST_MODULE voctreeBuilder
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -21,7 +25,7 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
 {
   using namespace aliceVision;
 
-  const std::string treeName = "test.tree";
+  const std::string treeName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("test-%%%%%%.tree")).string();
 
   const std::size_t DIMENSION = 3;
   const std::size_t FEATURENUMBER = 100;
@@ -69,6 +73,7 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
 
   voctree::MutableVocabularyTree<FeatureFloat> loadedtree;
   loadedtree.load(treeName);
+  boost::filesystem::remove(treeName);
 
   // check the centers are the same
   FeatureFloatVector centerOrig = builder.tree().centers();
@@ -81,5 +86,93 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   {
     BOOST_CHECK_SMALL(distance(centerOrig[i],centerLoad[i]), kepsf);
   }
+
+  // the packed quantization gives the same words as the generic one
+  voctree::MutableVocabularyTree<FeatureFloat> unpackedTree;
+  unpackedTree.setSize(LEVELS, K);
+  unpackedTree.centers() = centerOrig;
+  unpackedTree.validCenters() = valid;
+
+  for(std::size_t i = 0; i < features.size(); ++i)
+    BOOST_CHECK_EQUAL(loadedtree.quantize(features[i]), unpackedTree.quantize(features[i]));
+
+  // the same seed gives the same tree, whatever the thread clustering each subset
+  voctree::TreeBuilder<FeatureFloat> seededBuilder(FeatureFloat::Zero());
+  seededBuilder.kmeans().setRestarts(10);
+  seededBuilder.setSeed(builder.getSeed());
+  seededBuilder.build(features, K, LEVELS);
+
+  BOOST_CHECK_EQUAL(seededBuilder.tree().centers().size(), centerOrig.size());
+  for(std::size_t i = 0; i < centerOrig.size(); ++i)
+    BOOST_CHECK_SMALL(distance(centerOrig[i], seededBuilder.tree().centers()[i]), kepsf);
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreePackedQuantize_sift)
+{
+  using namespace aliceVision;
+
+  typedef feature::Descriptor<float, 128> DescriptorFloat;
+  typedef feature::Descriptor<unsigned char, 128> DescriptorUChar;
+
+  const std::size_t K = 10;
+  const std::size_t LEVELS = 3;
+  const std::size_t NBCENTERS = K + K * K + K * K * K;
+
+  // SIFT-like descriptors: sparse bins in the uchar range
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> binDistribution(0, 255);
+  std::bernoulli_distribution nonZeroDistribution(0.4);
+  const auto randomDescriptor = [&]()
+  {
+    DescriptorUChar descriptor;
+    for(std::size_t d = 0; d < descriptor.size(); ++d)
+      descriptor[d] = nonZeroDistribution(generator) ? binDistribution(generator) : 0;
+    return descriptor;
+  };
+
+  // the centers are means of such descriptors, close to each other like in a trained tree
+  std::uniform_real_distribution<float> offsetDistribution(-2.f, 2.f);
+  voctree::MutableVocabularyTree<DescriptorFloat> tree;
+  tree.setSize(LEVELS, K);
+  tree.centers().resize(NBCENTERS);
+  tree.validCenters().assign(NBCENTERS, 1);
+  for(std::size_t i = 0; i < NBCENTERS; ++i)
+  {
+    const DescriptorUChar base = (i < K) ? randomDescriptor() : DescriptorUChar();
+    const DescriptorFloat& parent = (i < K) ? DescriptorFloat(0.f) : tree.centers()[i / K - 1];
+    for(std::size_t d = 0; d < base.size(); ++d)
+      tree.centers()[i][d] = (i < K) ? float(base[d]) : std::max(0.f, parent[d] + offsetDistribution(generator) * (LEVELS - i / (K * K)));
+  }
+  // the last children of a node are invalid
+  for(std::size_t i = 2 * K + 7; i < 3 * K; ++i)
+    tree.validCenters()[i] = 0;
+  tree.pack();
+
+  std::vector<DescriptorUChar> features;
+  for(std::size_t i = 0; i < 2000; ++i)
+    features.push_back(randomDescriptor());
+  // the rounded centers and the rounded middles of sibling centers,
+  // whose distances to the nearest centers are near ties
+  for(std::size_t i = K; i < NBCENTERS; ++i)
+  {
+    const std::size_t sibling = (i % K == K - 1) ? i + 1 - K : i + 1;
+    DescriptorUChar center;
+    DescriptorUChar middle;
+    for(std::size_t d = 0; d < middle.size(); ++d)
+    {
+      center[d] = static_cast<unsigned char>(std::min(255.f, std::round(tree.centers()[i][d])));
+      middle[d] = static_cast<unsigned char>(std::min(255.f, std::round(0.5f * (tree.centers()[i][d] + tree.centers()[sibling][d]))));
+    }
+    features.push_back(center);
+    features.push_back(middle);
+  }
+
+  // the packed quantization of the blocks gives the same words as the generic one
+  const std::vector<voctree::Word> words = tree.quantize(features);
+  BOOST_CHECK_EQUAL(words.size(), features.size());
+  std::size_t nbDifferentWords = 0;
+  for(std::size_t i = 0; i < features.size(); ++i)
+    nbDifferentWords += (words[i] != tree.quantize(features[i]));
+  BOOST_CHECK_EQUAL(nbDifferentWords, 0);
+}
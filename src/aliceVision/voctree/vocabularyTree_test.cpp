@@ -5,9 +5,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/databaseIO.hpp>
+
+#include <boost/filesystem.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -57,3 +62,157 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedFile)
+{
+  const int cardDocuments = 50;
+  const int cardFeatures = 40;
+  const int cardWords = 100;
+
+  // Create random documents
+  std::srand(42);
+  Database db(cardWords);
+  SparseHistogramPerImage documents;
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(cardFeatures);
+    for(int j = 0; j < cardFeatures; ++j)
+      document[j] = std::rand() % cardWords;
+    computeSparseHistogram(document, documents[i * 3]);
+    db.insert(i * 3, documents[i * 3]);
+  }
+  db.computeTfIdfWeights();
+
+  const std::vector<std::string> distanceMethods = {"classic", "commonPoints", "strongCommonPoints", "weightedStrongCommonPoints", "inversedWeightedCommonPoints"};
+
+  for(const std::string& distanceMethod : distanceMethods)
+  {
+    std::map<DocId, DocMatches> allMatches;
+    db.find(documents, 0, allMatches, distanceMethod);
+    BOOST_CHECK_EQUAL(cardDocuments, allMatches.size());
+
+    for(const auto& query : documents)
+    {
+      // Compare the inverted file scores with the full histogram distances
+      vector<DocMatch> matches;
+      db.find(query.second, cardDocuments, matches, distanceMethod);
+      BOOST_CHECK_EQUAL(cardDocuments, matches.size());
+
+      for(std::size_t i = 0; i < matches.size(); ++i)
+      {
+        if(i > 0)
+          BOOST_CHECK(matches[i-1].score <= matches[i].score);
+
+        const float distance = sparseDistance(query.second, documents.at(matches[i].id), distanceMethod, db.getWordWeights());
+        BOOST_CHECK_CLOSE(distance + 1000.f, matches[i].score + 1000.f, 0.001);
+        BOOST_CHECK_EQUAL(matches[i].id, allMatches.at(query.first)[i].id);
+      }
+
+      // Partial top N
+      vector<DocMatch> topMatches;
+      db.find(query.second, 5, topMatches, distanceMethod);
+      BOOST_CHECK_EQUAL(5, topMatches.size());
+      for(std::size_t i = 0; i < topMatches.size(); ++i)
+        BOOST_CHECK_EQUAL(matches[i].score, topMatches[i].score);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(database_compactHistogram)
+{
+  const int cardDocuments = 20;
+  const int cardFeatures = 60;
+  const int cardWords = 50;
+
+  std::srand(7);
+  Database db(cardWords);
+  vector<CompactHistogram> documents;
+  SparseHistogramPerImage sparseDocuments;
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(cardFeatures);
+    for(int j = 0; j < cardFeatures; ++j)
+      document[j] = std::rand() % cardWords;
+
+    // same content as the map histogram
+    documents.emplace_back(document);
+    computeSparseHistogram(document, sparseDocuments[i]);
+    BOOST_CHECK(documents.back().toSparseHistogram() == sparseDocuments[i]);
+    BOOST_CHECK(CompactHistogram(sparseDocuments[i]) == documents.back());
+    BOOST_CHECK_EQUAL(cardFeatures, documents.back().nbFeatures());
+
+    db.insert(i, documents.back());
+  }
+  db.computeTfIdfWeights();
+
+  // binary serialization
+  std::stringstream stream;
+  for(const CompactHistogram& document : documents)
+    document.write(stream);
+  for(const CompactHistogram& document : documents)
+  {
+    CompactHistogram readDocument;
+    readDocument.read(stream);
+    BOOST_CHECK(readDocument == document);
+  }
+
+  // corrupted data is rejected
+  {
+    std::stringstream documentStream;
+    documents.front().write(documentStream);
+    const std::string data = documentStream.str();
+
+    // truncated
+    std::stringstream truncatedStream(data.substr(0, data.size() - 1));
+    CompactHistogram readDocument;
+    BOOST_CHECK_THROW(readDocument.read(truncatedStream), std::runtime_error);
+
+    // huge number of words
+    std::string corruptedData = data;
+    const uint32_t nbWords = std::numeric_limits<uint32_t>::max();
+    corruptedData.replace(0, sizeof(uint32_t), (const char*) &nbWords, sizeof(uint32_t));
+    std::stringstream hugeStream(corruptedData);
+    BOOST_CHECK_THROW(readDocument.read(hugeStream), std::runtime_error);
+
+    // last offset out of the features
+    corruptedData = data;
+    const uint32_t offset = cardFeatures + 1;
+    const std::size_t lastOffsetPosition = 2 * sizeof(uint32_t) + documents.front().size() * (sizeof(Word) + sizeof(uint32_t));
+    corruptedData.replace(lastOffsetPosition, sizeof(uint32_t), (const char*) &offset, sizeof(uint32_t));
+    std::stringstream offsetStream(corruptedData);
+    BOOST_CHECK_THROW(readDocument.read(offsetStream), std::runtime_error);
+    BOOST_CHECK(readDocument.empty());
+  }
+
+  // documents file
+  const std::string documentsFile = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("test-%%%%%%.documents")).string();
+  saveDocuments(documentsFile, db);
+  Database loadedDb(cardWords);
+  loadDocuments(documentsFile, loadedDb);
+  boost::filesystem::remove(documentsFile);
+  BOOST_CHECK_EQUAL(db.size(), loadedDb.size());
+  for(int i = 0; i < cardDocuments; ++i)
+    BOOST_CHECK(loadedDb.getDocument(i) == documents[i]);
+
+  const std::vector<std::string> distanceMethods = {"classic", "commonPoints", "strongCommonPoints", "weightedStrongCommonPoints", "inversedWeightedCommonPoints"};
+
+  for(const std::string& distanceMethod : distanceMethods)
+  {
+    for(int i = 0; i < cardDocuments; ++i)
+    {
+      BOOST_CHECK(db.getDocument(i) == documents[i]);
+
+      for(int j = 0; j < cardDocuments; ++j)
+      {
+        // the linear merge gives the same distance with both representations
+        BOOST_CHECK_EQUAL(sparseDistance(sparseDocuments[i], sparseDocuments[j], distanceMethod, db.getWordWeights()),
+                          sparseDistance(documents[i], documents[j], distanceMethod, db.getWordWeights()));
+      }
+
+      vector<DocMatch> compactMatches, sparseMatches;
+      db.find(documents[i], 5, compactMatches, distanceMethod);
+      db.find(sparseDocuments[i], 5, sparseMatches, distanceMethod);
+      BOOST_CHECK(compactMatches == sparseMatches);
+    }
+  }
+}
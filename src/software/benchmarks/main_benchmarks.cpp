@@ -0,0 +1,475 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
+#include <aliceVision/multiview/triangulation/Triangulation.hpp>
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/matching/io.hpp>
+#include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/version.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/// Timings of one benchmark
+struct BenchmarkResult
+{
+  std::string name;
+  /// number of processed items (observations, views, points...) per repetition
+  std::size_t nbItems = 0;
+  /// elapsed time of each repetition (seconds)
+  std::vector<double> timings;
+};
+
+/**
+ * @brief Run a benchmark
+ * @param[in] name benchmark name
+ * @param[in] nbItems number of processed items per repetition
+ * @param[in] repetitions number of repetitions
+ * @param[in] run run one repetition and return its elapsed time (so the setup is not timed)
+ */
+BenchmarkResult runBenchmark(const std::string& name, std::size_t nbItems, int repetitions, const std::function<double()>& run)
+{
+  BenchmarkResult result;
+  result.name = name;
+  result.nbItems = nbItems;
+
+  ALICEVISION_LOG_INFO("Benchmark '" << name << "' (" << nbItems << " items)");
+  for(int r = 0; r < repetitions; ++r)
+  {
+    result.timings.push_back(run());
+    ALICEVISION_LOG_INFO("\t- repetition " << r << ": " << result.timings.back() << " s");
+  }
+  return result;
+}
+
+/**
+ * @brief Write the benchmark results as JSON
+ */
+void writeJSON(std::ostream& os, const sfm::SfMData& scene, unsigned int seed, const std::vector<BenchmarkResult>& results)
+{
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkIt : scene.getLandmarks())
+    nbObservations += landmarkIt.second.observations.size();
+
+  os << std::setprecision(9);
+  os << "{\n"
+     << "  \"version\": \"" << ALICEVISION_VERSION_STRING << "\",\n"
+     << "  \"nbThreads\": " << omp_get_max_threads() << ",\n"
+     << "  \"scene\": {\n"
+     << "    \"seed\": " << seed << ",\n"
+     << "    \"nbViews\": " << scene.getViews().size() << ",\n"
+     << "    \"nbLandmarks\": " << scene.getLandmarks().size() << ",\n"
+     << "    \"nbObservations\": " << nbObservations << "\n"
+     << "  },\n"
+     << "  \"benchmarks\": [";
+
+  for(std::size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchmarkResult& result = results[i];
+    std::vector<double> sorted = result.timings;
+    std::sort(sorted.begin(), sorted.end());
+    const double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+
+    os << (i ? ",\n" : "\n")
+       << "    {\n"
+       << "      \"name\": \"" << result.name << "\",\n"
+       << "      \"nbItems\": " << result.nbItems << ",\n"
+       << "      \"repetitions\": " << sorted.size() << ",\n"
+       << "      \"min\": " << sorted.front() << ",\n"
+       << "      \"median\": " << sorted[sorted.size() / 2] << ",\n"
+       << "      \"mean\": " << mean << ",\n"
+       << "      \"max\": " << sorted.back() << ",\n"
+       << "      \"timings\": [";
+    for(std::size_t r = 0; r < result.timings.size(); ++r)
+      os << (r ? ", " : "") << result.timings[r];
+    os << "]\n"
+       << "    }";
+  }
+  os << "\n  ]\n}\n";
+}
+
+/// Pick nb elements evenly distributed in [0, size)
+std::vector<std::size_t> evenlySpacedIndexes(std::size_t size, std::size_t nb)
+{
+  std::vector<std::size_t> indexes;
+  nb = std::min(nb, size);
+  indexes.reserve(nb);
+  for(std::size_t i = 0; i < nb; ++i)
+    indexes.push_back(i * size / nb);
+  return indexes;
+}
+
+void benchmarkTracks(const sfm::SfMData& scene, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  matching::PairwiseMatches matches;
+  sfm::generateSyntheticMatches(matches, scene, feature::EImageDescriberType::SIFT);
+
+  std::size_t nbMatches = 0;
+  for(const auto& matchesIt : matches)
+    for(const auto& descMatches : matchesIt.second)
+      nbMatches += descMatches.second.size();
+
+  results.push_back(runBenchmark("TracksBuilder::build", nbMatches, repetitions, [&]()
+  {
+    track::TracksBuilder tracksBuilder;
+    system::Timer timer;
+    tracksBuilder.build(matches);
+    return timer.elapsed();
+  }));
+
+  results.push_back(runBenchmark("ParallelTracksBuilder::build", nbMatches, repetitions, [&]()
+  {
+    track::ParallelTracksBuilder tracksBuilder;
+    system::Timer timer;
+    tracksBuilder.build(matches);
+    return timer.elapsed();
+  }));
+}
+
+void benchmarkResection(const sfm::SfMData& scene, std::size_t nbResections, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  // 2D-3D correspondences of the selected views (computeResection inputs)
+  std::map<IndexT, std::size_t> selectedViews;
+  for(const std::size_t i : evenlySpacedIndexes(scene.getViews().size(), nbResections))
+    selectedViews.emplace(std::next(scene.getViews().begin(), i)->first, selectedViews.size());
+
+  std::vector<std::vector<std::pair<Vec2, Vec3>>> correspondences(selectedViews.size());
+  for(const auto& landmarkIt : scene.getLandmarks())
+  {
+    for(const auto& observationIt : landmarkIt.second.observations)
+    {
+      const auto viewIt = selectedViews.find(observationIt.first);
+      if(viewIt != selectedViews.end())
+        correspondences[viewIt->second].emplace_back(observationIt.second.x, landmarkIt.second.X);
+    }
+  }
+
+  std::vector<sfm::ImageLocalizerMatchData> resectionData(selectedViews.size());
+  std::size_t nbCorrespondences = 0;
+  for(std::size_t i = 0; i < resectionData.size(); ++i)
+  {
+    resectionData[i].pt2D.resize(2, correspondences[i].size());
+    resectionData[i].pt3D.resize(3, correspondences[i].size());
+    resectionData[i].vec_descType.assign(correspondences[i].size(), feature::EImageDescriberType::SIFT);
+    for(std::size_t c = 0; c < correspondences[i].size(); ++c)
+    {
+      resectionData[i].pt2D.col(c) = correspondences[i][c].first;
+      resectionData[i].pt3D.col(c) = correspondences[i][c].second;
+    }
+    nbCorrespondences += correspondences[i].size();
+  }
+
+  results.push_back(runBenchmark("SfMLocalizer::Localize (computeResection)", nbCorrespondences, repetitions, [&]()
+  {
+    std::vector<sfm::ImageLocalizerMatchData> data = resectionData;
+    system::Timer timer;
+    for(const auto& viewIt : selectedViews)
+    {
+      const sfm::View& view = *scene.getViews().at(viewIt.first);
+      geometry::Pose3 pose;
+      sfm::SfMLocalizer::Localize(Pair(view.getWidth(), view.getHeight()),
+                                  scene.getIntrinsics().at(view.getIntrinsicId()).get(),
+                                  data[viewIt.second], pose);
+    }
+    return timer.elapsed();
+  }));
+}
+
+void benchmarkTriangulation(const sfm::SfMData& scene, std::size_t nbTriangulations, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  // undistorted features and projection matrices of the selected landmarks
+  // (triangulateMultiViews_LORANSAC inputs)
+  std::vector<Mat2X> features;
+  std::vector<std::vector<Mat34>> projections;
+  std::size_t nbObservations = 0;
+
+  for(const std::size_t i : evenlySpacedIndexes(scene.getLandmarks().size(), nbTriangulations))
+  {
+    const sfm::Landmark& landmark = std::next(scene.getLandmarks().begin(), i)->second;
+    Mat2X x(2, landmark.observations.size());
+    std::vector<Mat34> Ps;
+    for(const auto& observationIt : landmark.observations)
+    {
+      const sfm::View& view = *scene.getViews().at(observationIt.first);
+      const camera::IntrinsicBase* intrinsic = scene.getIntrinsics().at(view.getIntrinsicId()).get();
+      x.col(Ps.size()) = intrinsic->get_ud_pixel(observationIt.second.x);
+      Ps.push_back(intrinsic->get_projective_equivalent(scene.getPose(view).getTransform()));
+    }
+    nbObservations += Ps.size();
+    features.push_back(x);
+    projections.push_back(Ps);
+  }
+
+  results.push_back(runBenchmark("TriangulateNViewLORANSAC (triangulateMultiViews_LORANSAC)", nbObservations, repetitions, [&]()
+  {
+    system::Timer timer;
+    for(std::size_t i = 0; i < features.size(); ++i)
+    {
+      Vec4 X;
+      std::vector<std::size_t> inliers;
+      TriangulateNViewLORANSAC(features[i], projections[i], &X, &inliers, 8.0);
+    }
+    return timer.elapsed();
+  }));
+}
+
+void benchmarkBundleAdjustment(const sfm::SfMData& scene, unsigned int seed, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkIt : scene.getLandmarks())
+    nbObservations += landmarkIt.second.observations.size();
+
+  results.push_back(runBenchmark("BundleAdjustmentCeres::Adjust", nbObservations, repetitions, [&]()
+  {
+    // perturb the structure so the solver has some work to do
+    sfm::SfMData sfmData = scene;
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> noise(0.0, 0.01);
+    for(auto& landmarkIt : sfmData.structure)
+      landmarkIt.second.X += Vec3(noise(generator), noise(generator), noise(generator));
+
+    sfm::BundleAdjustmentCeres::BA_options options(false);
+    options.setSparseBA();
+    sfm::BundleAdjustmentCeres bundleAdjustment(options);
+
+    system::Timer timer;
+    bundleAdjustment.Adjust(sfmData, sfm::BA_REFINE_ROTATION | sfm::BA_REFINE_TRANSLATION | sfm::BA_REFINE_STRUCTURE);
+    return timer.elapsed();
+  }));
+}
+
+void benchmarkVoctree(const sfm::SfMData& scene, std::size_t nbWords, std::size_t nbQueries, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  // the landmarks are quantized into words, so co-visible views share words
+  voctree::SparseHistogramPerImage histograms;
+  for(const auto& landmarkIt : scene.getLandmarks())
+  {
+    const voctree::Word word = static_cast<voctree::Word>(landmarkIt.first % nbWords);
+    for(const auto& observationIt : landmarkIt.second.observations)
+      histograms[observationIt.first][word].push_back(observationIt.second.id_feat);
+  }
+
+  voctree::Database database(static_cast<uint32_t>(nbWords));
+  for(const auto& histogramIt : histograms)
+    database.insert(histogramIt.first, histogramIt.second);
+  database.computeTfIdfWeights();
+
+  voctree::SparseHistogramPerImage queries;
+  for(const std::size_t i : evenlySpacedIndexes(histograms.size(), nbQueries))
+  {
+    const auto& histogramIt = *std::next(histograms.begin(), i);
+    queries.emplace(histogramIt.first, histogramIt.second);
+  }
+
+  results.push_back(runBenchmark("voctree::Database::find", queries.size(), repetitions, [&]()
+  {
+    std::map<voctree::DocId, voctree::DocMatches> matches;
+    system::Timer timer;
+    database.find(queries, 50, matches);
+    return timer.elapsed();
+  }));
+}
+
+void benchmarkMatchesIO(const sfm::SfMData& scene, const std::string& tmpFolder, int repetitions, std::vector<BenchmarkResult>& results)
+{
+  matching::PairwiseMatches matches;
+  sfm::generateSyntheticMatches(matches, scene, feature::EImageDescriberType::SIFT);
+
+  std::size_t nbMatches = 0;
+  for(const auto& matchesIt : matches)
+    for(const auto& descMatches : matchesIt.second)
+      nbMatches += descMatches.second.size();
+
+  const fs::path folder = fs::path(tmpFolder) / fs::unique_path("aliceVision_benchmarks_%%%%-%%%%");
+  fs::create_directories(folder);
+
+  for(const std::string extension : {"txt", "bin"})
+  {
+    matching::Save(matches, folder.string(), extension, false);
+    const std::string filepath = (folder / ("matches." + extension)).string();
+
+    results.push_back(runBenchmark("LoadMatchFile (" + extension + ")", nbMatches, repetitions, [&]()
+    {
+      matching::PairwiseMatches loadedMatches;
+      system::Timer timer;
+      if(!matching::LoadMatchFile(loadedMatches, filepath))
+        ALICEVISION_LOG_ERROR("Unable to load the matches file: " << filepath);
+      return timer.elapsed();
+    }));
+  }
+
+  fs::remove_all(folder);
+}
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string outputFilename;
+  std::string benchmarksList = "all";
+  std::string tmpFolder = fs::temp_directory_path().string();
+  std::size_t nbViews = 1000;
+  std::size_t nbLandmarks = 200000;
+  std::size_t nbObservationsPerLandmark = 5;
+  unsigned int seed = 0;
+  double noise = 0.5;
+  int repetitions = 3;
+  std::size_t nbResections = 100;
+  std::size_t nbTriangulations = 10000;
+  std::size_t nbWords = 100000;
+  std::size_t nbQueries = 100;
+
+  po::options_description allParams("AliceVision benchmarks\n"
+                                    "Time the SfM pipeline hot paths on a deterministic synthetic scene.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("output,o", po::value<std::string>(&outputFilename),
+      "Output JSON file for the results (standard output if empty).")
+    ("benchmarks,b", po::value<std::string>(&benchmarksList)->default_value(benchmarksList),
+      "Comma-separated list of benchmarks: tracks, resection, triangulation, bundleAdjustment, voctree, matchesIO (or all).")
+    ("nbViews", po::value<std::size_t>(&nbViews)->default_value(nbViews),
+      "Number of views of the synthetic scene.")
+    ("nbLandmarks", po::value<std::size_t>(&nbLandmarks)->default_value(nbLandmarks),
+      "Number of landmarks of the synthetic scene.")
+    ("nbObservationsPerLandmark", po::value<std::size_t>(&nbObservationsPerLandmark)->default_value(nbObservationsPerLandmark),
+      "Number of observations of each landmark.")
+    ("seed", po::value<unsigned int>(&seed)->default_value(seed),
+      "Seed of the synthetic scene generator.")
+    ("noise", po::value<double>(&noise)->default_value(noise),
+      "Standard deviation of the noise on the observations (pixels).")
+    ("repetitions,r", po::value<int>(&repetitions)->default_value(repetitions),
+      "Number of repetitions of each benchmark.")
+    ("nbResections", po::value<std::size_t>(&nbResections)->default_value(nbResections),
+      "Number of views localized by the resection benchmark.")
+    ("nbTriangulations", po::value<std::size_t>(&nbTriangulations)->default_value(nbTriangulations),
+      "Number of landmarks triangulated by the triangulation benchmark.")
+    ("nbWords", po::value<std::size_t>(&nbWords)->default_value(nbWords),
+      "Number of words of the voctree database.")
+    ("nbQueries", po::value<std::size_t>(&nbQueries)->default_value(nbQueries),
+      "Number of voctree database queries.")
+    ("tmpFolder", po::value<std::string>(&tmpFolder)->default_value(tmpFolder),
+      "Folder for the temporary matches files.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(nbObservationsPerLandmark < 3 || nbObservationsPerLandmark > nbViews || repetitions < 1 || nbWords == 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid parameters: nbObservationsPerLandmark must be in [3, nbViews], repetitions and nbWords must be positive.");
+    return EXIT_FAILURE;
+  }
+
+  std::set<std::string> benchmarks;
+  boost::split(benchmarks, benchmarksList, boost::is_any_of(","));
+  const bool all = benchmarks.count("all") > 0;
+
+  ALICEVISION_LOG_INFO("Generate the synthetic scene: " << nbViews << " views, " << nbLandmarks << " landmarks, "
+                       << nbLandmarks * nbObservationsPerLandmark << " observations.");
+  system::Timer sceneTimer;
+  const sfm::SfMData scene = sfm::generateSyntheticScene(nbViews, nbLandmarks, nbObservationsPerLandmark, seed, noise);
+  ALICEVISION_LOG_INFO("Scene generated in " << sceneTimer.elapsed() << " s.");
+
+  std::vector<BenchmarkResult> results;
+
+  if(all || benchmarks.count("tracks"))
+    benchmarkTracks(scene, repetitions, results);
+  if(all || benchmarks.count("resection"))
+    benchmarkResection(scene, nbResections, repetitions, results);
+  if(all || benchmarks.count("triangulation"))
+    benchmarkTriangulation(scene, nbTriangulations, repetitions, results);
+  if(all || benchmarks.count("bundleAdjustment"))
+    benchmarkBundleAdjustment(scene, seed, repetitions, results);
+  if(all || benchmarks.count("voctree"))
+    benchmarkVoctree(scene, nbWords, nbQueries, repetitions, results);
+  if(all || benchmarks.count("matchesIO"))
+    benchmarkMatchesIO(scene, tmpFolder, repetitions, results);
+
+  if(results.empty())
+  {
+    ALICEVISION_LOG_ERROR("No benchmark selected: " << benchmarksList);
+    return EXIT_FAILURE;
+  }
+
+  if(outputFilename.empty())
+  {
+    writeJSON(std::cout, scene, seed, results);
+  }
+  else
+  {
+    std::ofstream file(outputFilename);
+    if(!file.is_open())
+    {
+      ALICEVISION_LOG_ERROR("Unable to write the output file: " << outputFilename);
+      return EXIT_FAILURE;
+    }
+    writeJSON(file, scene, seed, results);
+    ALICEVISION_LOG_INFO("Results saved in " << outputFilename);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -141,12 +141,10 @@ int main(int argc, char* argv[])
     // print GPU Information
     ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
 
-    // check if the gpu suppport CUDA compute capability 2.0
-    if(!system::gpuSupportCUDA(2,0))
-    {
-      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0).");
-      return EXIT_FAILURE;
-    }
+    // check if the gpu suppport CUDA compute capability 2.0, otherwise use the CPU implementation
+    const bool useGPU = system::gpuSupportCUDA(2,0);
+    if(!useGPU)
+      ALICEVISION_LOG_WARNING("No CUDA-Enabled GPU (with at least compute capablility 2.0), use the CPU implementation.");
 
     // check if the scale is correct
     if(downscale < 1)
@@ -205,8 +203,16 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Create depth maps.");
 
     {
-        depthMap::computeDepthMapsPSSGM(&mp, &pc, cams);
-        depthMap::refineDepthMaps(&mp, &pc, cams);
+        if(useGPU)
+        {
+            depthMap::computeDepthMapsPSSGM(&mp, &pc, cams);
+            depthMap::refineDepthMaps(&mp, &pc, cams);
+        }
+        else
+        {
+            depthMap::computeDepthMapsPSSGM(-1, &mp, &pc, cams);
+            depthMap::refineDepthMaps(-1, &mp, &pc, cams);
+        }
     }
 
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
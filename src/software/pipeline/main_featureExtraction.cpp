@@ -9,6 +9,8 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/pipeline/ContentCache.hpp>
+#include <aliceVision/sfm/utils/uid.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_POPSIFT) \
@@ -45,13 +47,18 @@ class FeatureExtractor
     const sfm::View& view;
     std::size_t memoryConsuption = 0;
     std::string outputBasename;
+    bool binaryRegions;
     std::vector<std::size_t> cpuImageDescriberIndexes;
     std::vector<std::size_t> gpuImageDescriberIndexes;
+    /// content UID of the image file, only used with a cache (computed on demand)
+    std::string imageUID;
 
     ViewJob(const sfm::View& view,
-            const std::string& outputFolder)
+            const std::string& outputFolder,
+            bool binaryRegions)
       : view(view)
       , outputBasename(fs::path(fs::path(outputFolder) / fs::path(std::to_string(view.getViewId()))).string())
+      , binaryRegions(binaryRegions)
     {}
 
     bool useGPU() const
@@ -74,17 +81,31 @@ class FeatureExtractor
       return outputBasename + "." + feature::EImageDescriberType_enumToString(imageDescriberType) + ".desc";
     }
 
-    void setImageDescribers(const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers)
+    std::string getRegionsPath(feature::EImageDescriberType imageDescriberType) const
+    {
+      return outputBasename + "." + feature::EImageDescriberType_enumToString(imageDescriberType) + ".regions";
+    }
+
+    void setImageDescribers(const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                            const sfm::ContentCache& cache,
+                            const std::string& describerParams)
     {
       for(std::size_t i = 0; i < imageDescribers.size(); ++i)
       {
         const std::shared_ptr<feature::ImageDescriber>& imageDescriber = imageDescribers.at(i);
         feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
 
-        if(fs::exists(getFeaturesPath(imageDescriberType)) &&
+        if(binaryRegions && fs::exists(getRegionsPath(imageDescriberType)))
+          continue;
+
+        if(!binaryRegions &&
+           fs::exists(getFeaturesPath(imageDescriberType)) &&
            fs::exists(getDescriptorPath(imageDescriberType)))
           continue;
 
+        if(cache.isEnabled() && restoreFromCache(*imageDescriber, cache, describerParams))
+          continue;
+
         memoryConsuption += imageDescriber->getMemoryConsumption(view.getWidth(), view.getHeight());
 
         if(imageDescriber->useCuda())
@@ -93,6 +114,57 @@ class FeatureExtractor
           cpuImageDescriberIndexes.push_back(i);
       }
     }
+
+    /// Cache key of the regions: image content and describer configuration
+    std::string getCacheKey(const feature::ImageDescriber& imageDescriber, const std::string& describerParams) const
+    {
+      sfm::ContentKey key;
+      key.add(imageUID);
+      key.add(feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType()));
+      key.add(describerParams);
+      key.add(imageDescriber.useCuda());
+      return key.digest();
+    }
+
+    /// Copy the regions files of the view from the cache, if they have already been extracted
+    bool restoreFromCache(const feature::ImageDescriber& imageDescriber,
+                          const sfm::ContentCache& cache,
+                          const std::string& describerParams)
+    {
+      if(imageUID.empty())
+      {
+        try
+        {
+          imageUID = sfm::computeFileUID(view.getImagePath());
+        }
+        catch(const std::exception& e)
+        {
+          // the features are extracted without the cache
+          ALICEVISION_LOG_WARNING("Unable to compute the cache key of the view '" << view.getImagePath() << "': " << e.what());
+          return false;
+        }
+      }
+
+      const feature::EImageDescriberType imageDescriberType = imageDescriber.getDescriberType();
+      const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+      const std::string key = getCacheKey(imageDescriber, describerParams);
+
+      bool restored = false;
+      if(binaryRegions)
+      {
+        restored = cache.restoreFile("features", key, "." + imageDescriberTypeName + ".regions", getRegionsPath(imageDescriberType));
+      }
+      else if(cache.exists("features", key, "." + imageDescriberTypeName + ".feat") &&
+              cache.exists("features", key, "." + imageDescriberTypeName + ".desc"))
+      {
+        restored = cache.restoreFile("features", key, "." + imageDescriberTypeName + ".feat", getFeaturesPath(imageDescriberType)) &&
+                   cache.restoreFile("features", key, "." + imageDescriberTypeName + ".desc", getDescriptorPath(imageDescriberType));
+      }
+
+      if(restored)
+        ALICEVISION_LOG_INFO(imageDescriberTypeName << " features of view '" << view.getImagePath() << "' restored from the cache.");
+      return restored;
+    }
   };
 
 public:
@@ -117,6 +189,22 @@ public:
     _outputFolder = folder;
   }
 
+  void setBinaryRegions(bool binaryRegions)
+  {
+    _binaryRegions = binaryRegions;
+  }
+
+  /**
+   * @brief Reuse the regions already extracted from the same images with the same describers
+   * @param[in] cacheFolder The content-addressed cache folder
+   * @param[in] describerParams The describer configuration (part of the cache keys)
+   */
+  void setCache(const std::string& cacheFolder, const std::string& describerParams)
+  {
+    _cache = sfm::ContentCache(cacheFolder);
+    _describerParams = describerParams;
+  }
+
   void addImageDescriber(std::shared_ptr<feature::ImageDescriber>& imageDescriber)
   {
     _imageDescribers.push_back(imageDescriber);
@@ -141,9 +229,9 @@ public:
     for(auto it = itViewBegin; it != itViewEnd; ++it)
     {
       const sfm::View& view = *(it->second.get());
-      ViewJob viewJob(view, _outputFolder);
+      ViewJob viewJob(view, _outputFolder, _binaryRegions);
 
-      viewJob.setImageDescribers(_imageDescribers);
+      viewJob.setImageDescribers(_imageDescribers, _cache, _describerParams);
       jobMaxMemoryConsuption = std::max(jobMaxMemoryConsuption, viewJob.memoryConsuption);
 
       if(viewJob.useCPU())
@@ -230,7 +318,25 @@ private:
           imageGrayUChar = (imageGrayFloat.GetMat() * 255.f).cast<unsigned char>();
         imageDescriber->describe(imageGrayUChar, regions);
       }
-      imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+      if(job.binaryRegions)
+        imageDescriber->SaveBinary(regions.get(), job.getRegionsPath(imageDescriberType));
+      else
+        imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+
+      // the cache key needs the image UID, computed when restoring from the cache
+      if(_cache.isEnabled() && !job.imageUID.empty())
+      {
+        const std::string key = job.getCacheKey(*imageDescriber, _describerParams);
+        if(job.binaryRegions)
+        {
+          _cache.storeFile("features", key, "." + imageDescriberTypeName + ".regions", job.getRegionsPath(imageDescriberType));
+        }
+        else
+        {
+          _cache.storeFile("features", key, "." + imageDescriberTypeName + ".feat", job.getFeaturesPath(imageDescriberType));
+          _cache.storeFile("features", key, "." + imageDescriberTypeName + ".desc", job.getDescriptorPath(imageDescriberType));
+        }
+      }
       ALICEVISION_LOG_INFO(std::left << std::setw(6) << " " << regions->RegionCount() << " " << imageDescriberTypeName  << " features extracted from view '" << job.view.getImagePath() << "'");
     }
   }
@@ -238,6 +344,9 @@ private:
   const sfm::SfMData& _sfmData;
   std::vector<std::shared_ptr<feature::ImageDescriber>> _imageDescribers;
   std::string _outputFolder;
+  sfm::ContentCache _cache;
+  std::string _describerParams;
+  bool _binaryRegions = false;
   int _rangeStart = -1;
   int _rangeSize = -1;
   int _maxThreads = -1;
@@ -264,6 +373,8 @@ int main(int argc, char **argv)
   int rangeSize = 1;
   int maxThreads = 0;
   bool forceCpuExtraction = false;
+  bool binaryRegions = false;
+  std::string cacheFolder;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -283,6 +394,12 @@ int main(int argc, char **argv)
       "Configuration 'ultra' can take long time !")
     ("forceCpuExtraction", po::value<bool>(&forceCpuExtraction)->default_value(forceCpuExtraction),
       "Use only CPU feature extraction methods.")
+    ("binaryRegions", po::value<bool>(&binaryRegions)->default_value(binaryRegions),
+      "Export features and descriptors in a single binary file per view (*.regions) "
+      "instead of the text features (*.feat) and descriptors (*.desc) files.")
+    ("cacheFolder", po::value<std::string>(&cacheFolder)->default_value(cacheFolder),
+      "Content-addressed cache of the extracted regions, shared between runs: the regions are only extracted "
+      "from the images which have not already been described with the same configuration. Disabled if empty.")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
@@ -360,6 +477,10 @@ int main(int argc, char **argv)
   // create feature extractor
   FeatureExtractor extractor(sfmData);
   extractor.setOutputFolder(outputFolder);
+  extractor.setBinaryRegions(binaryRegions);
+
+  if(!cacheFolder.empty())
+    extractor.setCache(cacheFolder, describerPreset);
 
   // set maxThreads
   extractor.setMaxThreads(maxThreads);
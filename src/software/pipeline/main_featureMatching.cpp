@@ -9,6 +9,7 @@
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
+#include <aliceVision/sfm/pipeline/ContentCache.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
@@ -22,9 +23,11 @@
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix_HGrowing.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterType.hpp>
+#include <aliceVision/matchingImageCollection/RegionsCache.hpp>
 #include <aliceVision/matching/pairwiseAdjacencyDisplay.hpp>
 #include <aliceVision/matching/io.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/feature/selection.hpp>
 #include <aliceVision/graph/graph.hpp>
@@ -33,7 +36,10 @@
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <iterator>
 #include <fstream>
 #include <cctype>
 
@@ -74,6 +80,48 @@ void getStatsMap(const PairwiseMatches& map)
 #endif
 }
 
+/**
+ * @brief Cache key of the matches of an image pair:
+ * content of the regions of both views, their intrinsics and the matching parameters.
+ * @param[in] sfmData The SfMData container
+ * @param[in] pair The image pair
+ * @param[in,out] regionsUIDs The regions UID of the views, computed on demand
+ * @param[in] featuresFolders The feature folders
+ * @param[in] describerTypes The imageDescriber types
+ * @param[in] paramsUID The UID of the matching parameters
+ * @return the pair cache key
+ */
+std::string computePairCacheKey(const SfMData& sfmData,
+                                const Pair& pair,
+                                std::map<IndexT, std::string>& regionsUIDs,
+                                const std::vector<std::string>& featuresFolders,
+                                const std::vector<feature::EImageDescriberType>& describerTypes,
+                                const std::string& paramsUID)
+{
+  ContentKey key;
+  key.add(paramsUID);
+  for(const IndexT viewId : {pair.first, pair.second})
+  {
+    auto regionsUIDIt = regionsUIDs.find(viewId);
+    if(regionsUIDIt == regionsUIDs.end())
+      regionsUIDIt = regionsUIDs.emplace(viewId, computeRegionsUID(featuresFolders, viewId, describerTypes)).first;
+    key.add(regionsUIDIt->second);
+
+    const View& view = *sfmData.getViews().at(viewId);
+    key.add(view.getWidth());
+    key.add(view.getHeight());
+    const IntrinsicBase* intrinsic = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+    key.add(intrinsic != nullptr);
+    if(intrinsic != nullptr)
+    {
+      key.add(static_cast<int>(intrinsic->getType()));
+      for(const double param : intrinsic->getParams())
+        key.add(param);
+    }
+  }
+  return key.digest();
+}
+
 /// Compute corresponding features between a series of views:
 /// - Load view images description (regions: features & descriptors)
 /// - Compute putative local feature matches (descriptors matching)
@@ -101,12 +149,21 @@ int main(int argc, char **argv)
   double geometricErrorMax = 0.0; //< the maximum reprojection error allowed for image matching with geometric validation
   bool savePutativeMatches = false;
   bool guidedMatching = false;
+  bool guidedMatchingGrid = true;
   int maxIteration = 2048;
+  bool geometricEarlyRejection = false;
+  robustEstimation::EACRansacNFA nfaMode = robustEstimation::EACRansacNFA::EXACT;
   bool matchFilePerImage = true;
+  bool saveCascadeHashingIndex = false;
+  std::size_t maxRegionsMemory = 0;
+  std::size_t maxViewsPerBatch = 200;
+  std::size_t pairsBatchSize = 0;
   size_t numMatchesToKeep = 0;
   bool useGridSort = true;
   bool exportDebugFiles = false;
-  const std::string fileExtension = "txt";
+  int randomSeed = -1;
+  std::string cacheFolder;
+  std::string fileExtension = "txt";
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -136,12 +193,17 @@ int main(int argc, char **argv)
     ("photometricMatchingMethod,p", po::value<std::string>(&nearestMatchingMethod)->default_value(nearestMatchingMethod),
       "For Scalar based regions descriptor:\n"
       "* BRUTE_FORCE_L2: L2 BruteForce matching\n"
+      "* BRUTE_FORCE_L2_TILED: L2 BruteForce matching with cache-tiled distance matrices\n"
+      "(faster than BRUTE_FORCE_L2, distances computed as |a|^2+|b|^2-2a.b)\n"
       "* ANN_L2: L2 Approximate Nearest Neighbor matching\n"
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
       "For Binary based descriptor:\n"
       "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
+    ("saveCascadeHashingIndex", po::value<bool>(&saveCascadeHashingIndex)->default_value(saveCascadeHashingIndex),
+      "Save the cascade hashing index of each view in the features folder and reuse it in the next runs "
+      "(only for FAST_CASCADE_HASHING_L2).")
     ("geometricEstimator", po::value<std::string>(&geometricEstimatorName)->default_value(geometricEstimatorName),
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
@@ -153,16 +215,43 @@ int main(int argc, char **argv)
       "Save putative matches.")
     ("guidedMatching", po::value<bool>(&guidedMatching)->default_value(guidedMatching),
       "Use the found model to improve the pairwise correspondences.")
+    ("guidedMatchingGrid", po::value<bool>(&guidedMatchingGrid)->default_value(guidedMatchingGrid),
+      "Guided matching only compares the features close to the epipolar line (or the homography transfer) "
+      "using a grid of the features, instead of all the features of the image pair.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("maxRegionsMemory", po::value<std::size_t>(&maxRegionsMemory)->default_value(maxRegionsMemory),
+      "Memory budget (in MB) of the loaded regions. If set, the image pairs are matched by batches, "
+      "the regions are loaded on demand and the matches are saved after each group of batches. 0 to load all the regions.")
+    ("maxViewsPerBatch", po::value<std::size_t>(&maxViewsPerBatch)->default_value(maxViewsPerBatch),
+      "Maximum number of views whose regions are loaded for a batch of image pairs (at least 2), "
+      "if '--maxRegionsMemory' is set.")
+    ("pairsBatchSize", po::value<std::size_t>(&pairsBatchSize)->default_value(pairsBatchSize),
+      "Deprecated, use '--maxViewsPerBatch'. Approximate number of image pairs per batch, "
+      "converted to a number of views per batch.")
+    ("matchesFileExtension", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* txt: text file\n"
+      "* bin: compact binary file with per pair random access")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
       "Maximum number of iterations allowed in ransac step.")
+    ("geometricEarlyRejection", po::value<bool>(&geometricEarlyRejection)->default_value(geometricEarlyRejection),
+      "Reject the bad models of the geometric estimation before computing all their residuals (SPRT).")
+    ("nfaMode", po::value<robustEstimation::EACRansacNFA>(&nfaMode)->default_value(nfaMode),
+      "NFA evaluation of the A Contrario geometric estimation:\n"
+      "* exact: sort all the residuals of each model\n"
+      "* histogram: bin the residuals in a histogram and only sort the bins which may contain the best NFA")
     ("useGridSort", po::value<bool>(&useGridSort)->default_value(useGridSort),
       "Use matching grid sort.")
     ("exportDebugFiles", po::value<bool>(&exportDebugFiles)->default_value(exportDebugFiles),
       "Export debug files (svg, dot).")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "Seed of the random number generators, for reproducible matches. -1 to use a random seed.")
+    ("cacheFolder", po::value<std::string>(&cacheFolder)->default_value(cacheFolder),
+      "Content-addressed cache of the matches of each image pair, shared between runs: only the pairs "
+      "whose regions or matching parameters have changed are matched. Disabled if empty.")
     ("maxMatches", po::value<std::size_t>(&numMatchesToKeep)->default_value(numMatchesToKeep),
       "Maximum number pf matches to keep.")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
@@ -212,6 +301,9 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  if(randomSeed >= 0)
+    system::setDeterministicMode(randomSeed);
+
   // check and set input options
   if(matchesFolder.empty() || !fs::is_directory(matchesFolder))
   {
@@ -227,6 +319,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid matches file extension: " + fileExtension);
+    return EXIT_FAILURE;
+  }
+
   // Feature matching
   // a. Load SfMData Views & intrinsics data
   // b. Compute putative descriptor matches
@@ -248,7 +346,6 @@ int main(int argc, char **argv)
 
   // from matching mode compute the pair list that have to be matched
   PairSet pairs;
-  std::set<IndexT> filter;
 
   if(predefinedPairList.empty())
   {
@@ -270,262 +367,473 @@ int main(int argc, char **argv)
 
   ALICEVISION_LOG_INFO("Number of pairs: " << pairs.size());
 
-  // filter creation
-  for(const auto& pair: pairs)
-  {
-    filter.insert(pair.first);
-    filter.insert(pair.second);
-  }
-
   ALICEVISION_LOG_INFO("Putative matches");
 
-  PairwiseMatches mapPutativesMatches;
-
   // allocate the right Matcher according the Matching requested method
   EMatcherType collectionMatcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
-  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio);
+  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio,
+                                                                                                  saveCascadeHashingIndex ? featuresFolders : std::vector<std::string>());
 
   const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
 
   ALICEVISION_LOG_INFO("There are " + std::to_string(sfmData.getViews().size()) + " views and " + std::to_string(pairs.size()) + " image pairs.");
 
-  // load the corresponding view regions
-  RegionsPerView regionPerView;
-  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+  // with a memory budget, the pairs are matched by batches and the regions are loaded on demand
+  const bool streaming = (maxRegionsMemory > 0);
+  if(streaming && !matchFilePerImage)
   {
-    ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+    ALICEVISION_LOG_ERROR("Streaming matching (--maxRegionsMemory) needs one match file per image (--matchFilePerImage).");
     return EXIT_FAILURE;
   }
-
-  // perform the matching
-  system::Timer timer;
-
-  for(const feature::EImageDescriberType descType : describerTypes)
+  if(pairsBatchSize > 0)
   {
-    assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-    ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(descType) + " Regions Matching");
-
-    // photometric matching of putative pairs
-    imageCollectionMatcher->Match(regionPerView, pairs, descType, mapPutativesMatches);
-
-    // TODO: DELI
-    // if(!guided_matching) regionPerView.clearDescriptors()
+    // a batch of n views holds about (n/2)^2 pairs between its first and other views
+    maxViewsPerBatch = std::max<std::size_t>(2, static_cast<std::size_t>(2.0 * std::sqrt(static_cast<double>(pairsBatchSize))));
+    ALICEVISION_LOG_WARNING("'--pairsBatchSize' is deprecated, use '--maxViewsPerBatch' (" << maxViewsPerBatch << " views per batch).");
   }
-
-  if(mapPutativesMatches.empty())
+  if(streaming && maxViewsPerBatch < 2)
   {
-    ALICEVISION_LOG_INFO("No putative matches.");
-    // If we only compute a selection of matches, we may have no match.
-    return rangeSize ? EXIT_SUCCESS : EXIT_FAILURE;
+    ALICEVISION_LOG_ERROR("Streaming matching needs at least 2 views per batch (--maxViewsPerBatch).");
+    return EXIT_FAILURE;
   }
 
-  if(geometricFilterType == EGeometricFilterType::HOMOGRAPHY_GROWING)
+  // the matches of a group of batches are saved after its last batch,
+  // a group holds all the pairs of its first views
+  std::vector<PairSet> batches;
+  std::vector<bool> groupEnds;
+  for(std::vector<PairSet>& group : splitPairsInBatches(pairs, streaming ? maxViewsPerBatch : 0))
   {
-    // sort putative matches according to their Lowe ratio
-    // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
-    // to the putative matches order. This modification should improve recall.
-    for(auto& imgPair: mapPutativesMatches)
+    for(PairSet& batch : group)
     {
-      for(auto& descType: imgPair.second)
-      {
-        IndMatches & matches = descType.second;
-        sortMatches_byDistanceRatio(matches);
-      }
+      batches.push_back(std::move(batch));
+      groupEnds.push_back(false);
     }
+    groupEnds.back() = true;
   }
+  RegionsCache regionsCache(sfmData, featuresFolders, describerTypes,
+                            streaming ? maxRegionsMemory * 1024 * 1024 : std::numeric_limits<std::size_t>::max());
+
+  std::size_t nbPutativePairs = 0;
+  std::size_t nbCachedPairs = 0;
+  PairwiseMatches allFinalMatches;
+  PairwiseMatches groupPutativeMatches;
+  PairwiseMatches groupFinalMatches;
+
+  // the pairs already matched with the same regions and parameters are loaded from the cache
+  const ContentCache cache(cacheFolder);
+  std::map<IndexT, std::string> regionsUIDs;
+  const std::string matchingParamsUID = ContentKey()
+    .add(describerTypesName)
+    .add(nearestMatchingMethod)
+    .add(distRatio)
+    .add(geometricFilterTypeName)
+    .add(geometricEstimatorName)
+    .add(geometricErrorMax)
+    .add(maxIteration)
+    .add(geometricEarlyRejection)
+    .add(robustEstimation::EACRansacNFA_enumToString(nfaMode))
+    .add(guidedMatching)
+    .add(guidedMatchingGrid)
+    .add(useGridSort)
+    .add(numMatchesToKeep)
+    .add(randomSeed)
+    .digest();
+
+  for(std::size_t b = 0; b < batches.size(); ++b)
+  {
+    PairSet batchPairs;
+    PairwiseMatches cachedMatches;
+    std::map<Pair, std::string> pairCacheKeys;
 
-  ALICEVISION_LOG_INFO(std::to_string(mapPutativesMatches.size()) << " putative image pair matches");
-
-  for(const auto& imageMatch: mapPutativesMatches)
-    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(imageMatch.first.first) << ", " + std::to_string(imageMatch.first.second) + ") contains " + std::to_string(imageMatch.second.getNbAllMatches()) + " putative matches.");
+    for(const auto& pair: batches.at(b))
+    {
+      if(!cache.isEnabled())
+      {
+        batchPairs.insert(batchPairs.end(), pair);
+        continue;
+      }
 
-  // export putative matches
-  if(savePutativeMatches)
-    Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage);
+      std::string key;
+      try
+      {
+        key = computePairCacheKey(sfmData, pair, regionsUIDs, featuresFolders, describerTypes, matchingParamsUID);
+      }
+      catch(const std::exception& e)
+      {
+        // the pair is matched without the cache
+        ALICEVISION_LOG_WARNING("Unable to compute the cache key of the image pair (" << pair.first << ", " << pair.second << "): " << e.what());
+        batchPairs.insert(batchPairs.end(), pair);
+        continue;
+      }
+      std::string buffer;
+      MatchesPerDescType matchesPerDesc;
+      MatchesPerDescType putativeMatchesPerDesc;
+      // the putative matches are also needed if they are exported
+      if(cache.load("matches", key, buffer) && decodeMatchesPerDescType(buffer, matchesPerDesc) &&
+         (!savePutativeMatches || (cache.load("putativeMatches", key, buffer) && decodeMatchesPerDescType(buffer, putativeMatchesPerDesc))))
+      {
+        // pairs without geometric matches are also cached
+        if(!matchesPerDesc.empty())
+          cachedMatches.emplace(pair, std::move(matchesPerDesc));
+        if(!putativeMatchesPerDesc.empty())
+          groupPutativeMatches.emplace(pair, std::move(putativeMatchesPerDesc));
+        continue;
+      }
+      pairCacheKeys.emplace(pair, key);
+      batchPairs.insert(batchPairs.end(), pair);
+    }
+    nbCachedPairs += cachedMatches.size();
 
-  ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(timer.elapsed()));
+    if(cache.isEnabled())
+      ALICEVISION_LOG_INFO((batches.at(b).size() - batchPairs.size()) << " image pairs loaded from the cache, " << batchPairs.size() << " image pairs to match.");
 
-  /*
-  // TODO: DELI
-  if(exportDebugFiles)
-  {
-    //-- export putative matches Adjacency matrix
-    PairwiseMatchingToAdjacencyMatrixSVG(sfmData.getViews().size(),
-      mapPutativesMatches,
-      (fs::path(matchesFolder) / "PutativeAdjacencyMatrix.svg").string());
-    //-- export view pair graph once putative graph matches have been computed
+    // store the matches of the matched pairs in the cache, add them to the group matches
+    // with the cached matches and save the group matches after its last batch
+    const auto saveBatchMatches = [&](PairwiseMatches& finalMatches)
     {
-      std::set<IndexT> set_ViewIds;
-
-      std::transform(sfmData.getViews().begin(), sfmData.getViews().end(),
-        std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-
-      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(mapPutativesMatches));
+      for(const auto& pairCacheKey: pairCacheKeys)
+      {
+        std::string buffer;
+        const auto matchesIt = finalMatches.find(pairCacheKey.first);
+        encodeMatchesPerDescType((matchesIt != finalMatches.end()) ? matchesIt->second : MatchesPerDescType(), buffer);
+        if(savePutativeMatches)
+        {
+          // a separate entry, only read when the putative matches are exported
+          std::string putativeBuffer;
+          const auto putativeMatchesIt = groupPutativeMatches.find(pairCacheKey.first);
+          encodeMatchesPerDescType((putativeMatchesIt != groupPutativeMatches.end()) ? putativeMatchesIt->second : MatchesPerDescType(), putativeBuffer);
+          cache.store("putativeMatches", pairCacheKey.second, putativeBuffer);
+        }
+        cache.store("matches", pairCacheKey.second, buffer);
+      }
+      groupFinalMatches.insert(std::make_move_iterator(finalMatches.begin()), std::make_move_iterator(finalMatches.end()));
+      groupFinalMatches.insert(cachedMatches.begin(), cachedMatches.end());
+      finalMatches.clear();
+
+      if(!groupEnds.at(b))
+        return;
+
+      // export putative matches
+      if(savePutativeMatches && !groupPutativeMatches.empty())
+        Save(groupPutativeMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage);
+      if(!groupFinalMatches.empty())
+        Save(groupFinalMatches, matchesFolder, fileExtension, matchFilePerImage);
+
+      // release the matches of the group, only keep them for the debug export
+      if(exportDebugFiles && !streaming)
+        allFinalMatches = std::move(groupFinalMatches);
+      groupPutativeMatches.clear();
+      groupFinalMatches.clear();
+    };
+
+    // the views of the batch, in the order of its pairs
+    std::vector<IndexT> batchViews;
+    {
+      std::set<IndexT> views;
+      for(const auto& pair: batchPairs)
+      {
+        if(views.insert(pair.first).second)
+          batchViews.push_back(pair.first);
+        if(views.insert(pair.second).second)
+          batchViews.push_back(pair.second);
+      }
+    }
 
-      graph::exportToGraphvizData(
-        (fs::path(matchesFolder) / "putative_matches.dot").string(),
-        putativeGraph.g);
+    // load the regions of the views of the batch, until the memory budget is reached
+    std::set<IndexT> loadedViews;
+    if(!regionsCache.load(batchViews, loadedViews))
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+      return EXIT_FAILURE;
     }
-  }
-  */
 
-#ifdef ALICEVISION_DEBUG_MATCHING
+    if(loadedViews.size() < batchViews.size())
     {
-      ALICEVISION_LOG_DEBUG("PUTATIVE");
-      getStatsMap(mapPutativesMatches);
+      // the pairs of the views that are not loaded are matched in a next batch of the same group
+      PairSet remainingPairs;
+      for(auto it = batchPairs.begin(); it != batchPairs.end();)
+      {
+        if(loadedViews.count(it->first) && loadedViews.count(it->second))
+        {
+          ++it;
+          continue;
+        }
+        remainingPairs.insert(remainingPairs.end(), *it);
+        pairCacheKeys.erase(*it);
+        it = batchPairs.erase(it);
+      }
+      batches.insert(batches.begin() + b + 1, std::move(remainingPairs));
+      groupEnds.insert(groupEnds.begin() + b + 1, groupEnds.at(b));
+      groupEnds.at(b) = false;
     }
-#endif
 
-  // c. Geometric filtering of putative matches
-  //    - AContrario Estimation of the desired geometric model
-  //    - Use an upper bound for the a contrario estimated threshold
+    if(streaming)
+      ALICEVISION_LOG_INFO("Batch " << b + 1 << "/" << batches.size() << ": " << batchPairs.size() << " image pairs, " << loadedViews.size() << " views.");
 
-  timer.reset();
+    const RegionsPerView& regionPerView = regionsCache.getRegionsPerView();
 
-  matching::PairwiseMatches geometricMatches;
+    // perform the matching
+    system::Timer timer;
+    PairwiseMatches mapPutativesMatches;
 
-  ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
+    for(const feature::EImageDescriberType descType : describerTypes)
+    {
+      assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+      ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(descType) + " Regions Matching");
 
-  switch(geometricFilterType)
-  {
+      // photometric matching of putative pairs
+      imageCollectionMatcher->Match(regionPerView, batchPairs, descType, mapPutativesMatches);
 
-    case EGeometricFilterType::NO_FILTERING:
-      geometricMatches = mapPutativesMatches;
-    break;
+      // TODO: DELI
+      // if(!guided_matching) regionPerView.clearDescriptors()
+    }
 
-    case EGeometricFilterType::FUNDAMENTAL_MATRIX:
+    if(mapPutativesMatches.empty())
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
-        mapPutativesMatches,
-        guidedMatching);
+      ALICEVISION_LOG_INFO("No putative matches.");
+      PairwiseMatches finalMatches;
+      saveBatchMatches(finalMatches);
+      continue;
     }
-    break;
+    nbPutativePairs += mapPutativesMatches.size();
 
-    case EGeometricFilterType::ESSENTIAL_MATRIX:
+    if(geometricFilterType == EGeometricFilterType::HOMOGRAPHY_GROWING)
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches,
-        guidedMatching);
-
-      // perform an additional check to remove pairs with poor overlap
-      std::vector<PairwiseMatches::key_type> toRemoveVec;
-      for(PairwiseMatches::const_iterator iterMap = geometricMatches.begin();
-        iterMap != geometricMatches.end(); ++iterMap)
+      // sort putative matches according to their Lowe ratio
+      // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
+      // to the putative matches order. This modification should improve recall.
+      for(auto& imgPair: mapPutativesMatches)
       {
-        const size_t putativePhotometricCount = mapPutativesMatches.find(iterMap->first)->second.getNbAllMatches();
-        const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
-        const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
-        if (putativeGeometricCount < 50 || ratio < .3f)
-          toRemoveVec.push_back(iterMap->first); // the image pair will be removed
+        for(auto& descType: imgPair.second)
+        {
+          IndMatches & matches = descType.second;
+          sortMatches_byDistanceRatio(matches);
+        }
       }
-
-      // remove discarded pairs
-      for(std::vector<PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
-          iter != toRemoveVec.end(); ++iter)
-        geometricMatches.erase(*iter);
     }
-    break;
 
-    case EGeometricFilterType::HOMOGRAPHY_MATRIX:
-    {
-      const bool onlyGuidedMatching = true;
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches, guidedMatching,
-        onlyGuidedMatching ? -1.0 : 0.6);
-    }
-    break;
+    ALICEVISION_LOG_INFO(std::to_string(mapPutativesMatches.size()) << " putative image pair matches");
+
+    for(const auto& imageMatch: mapPutativesMatches)
+      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(imageMatch.first.first) << ", " + std::to_string(imageMatch.first.second) + ") contains " + std::to_string(imageMatch.second.getNbAllMatches()) + " putative matches.");
+
+    // putative matches exported with the group matches
+    if(savePutativeMatches)
+      groupPutativeMatches.insert(mapPutativesMatches.begin(), mapPutativesMatches.end());
+
+    ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(timer.elapsed()));
 
-    case EGeometricFilterType::HOMOGRAPHY_GROWING:
+    /*
+    // TODO: DELI
+    if(exportDebugFiles)
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), maxIteration),
+      //-- export putative matches Adjacency matrix
+      PairwiseMatchingToAdjacencyMatrixSVG(sfmData.getViews().size(),
         mapPutativesMatches,
-        guidedMatching);
+        (fs::path(matchesFolder) / "PutativeAdjacencyMatrix.svg").string());
+      //-- export view pair graph once putative graph matches have been computed
+      {
+        std::set<IndexT> set_ViewIds;
+
+        std::transform(sfmData.getViews().begin(), sfmData.getViews().end(),
+          std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
+
+        graph::indexedGraph putativeGraph(set_ViewIds, getPairs(mapPutativesMatches));
+
+        graph::exportToGraphvizData(
+          (fs::path(matchesFolder) / "putative_matches.dot").string(),
+          putativeGraph.g);
+      }
     }
-    break;
-  }
+    */
 
-  ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
-  for(const auto& matchGeo: geometricMatches)
-    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+#ifdef ALICEVISION_DEBUG_MATCHING
+      {
+        ALICEVISION_LOG_DEBUG("PUTATIVE");
+        getStatsMap(mapPutativesMatches);
+      }
+#endif
 
-  // grid filtering
-  ALICEVISION_LOG_INFO("Grid filtering");
+    // c. Geometric filtering of putative matches
+    //    - AContrario Estimation of the desired geometric model
+    //    - Use an upper bound for the a contrario estimated threshold
 
-  PairwiseMatches finalMatches;
-  
-  {
-    for(const auto& geometricMatch: geometricMatches)
+    timer.reset();
+
+    matching::PairwiseMatches geometricMatches;
+
+    ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
+
+    switch(geometricFilterType)
     {
-      //Get the image pair and their matches.
-      const Pair& indexImagePair = geometricMatch.first;
-      const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatch.second;
 
-      for(const auto& match: matchesPerDesc)
+      case EGeometricFilterType::NO_FILTERING:
+        geometricMatches = mapPutativesMatches;
+      break;
+
+      case EGeometricFilterType::FUNDAMENTAL_MATRIX:
+      {
+        GeometricFilterMatrix_F_AC filter(geometricErrorMax, maxIteration, geometricEstimator);
+        filter.m_nfaMode = nfaMode;
+        filter.m_useSPRT = geometricEarlyRejection;
+        filter.m_useGridGuidedMatching = guidedMatchingGrid;
+        matchingImageCollection::robustModelEstimation(geometricMatches,
+          &sfmData,
+          regionPerView,
+          filter,
+          mapPutativesMatches,
+          guidedMatching);
+      }
+      break;
+
+      case EGeometricFilterType::ESSENTIAL_MATRIX:
+      {
+        GeometricFilterMatrix_E_AC filter(std::numeric_limits<double>::infinity(), maxIteration);
+        filter.m_nfaMode = nfaMode;
+        filter.m_useSPRT = geometricEarlyRejection;
+        filter.m_useGridGuidedMatching = guidedMatchingGrid;
+        matchingImageCollection::robustModelEstimation(geometricMatches,
+          &sfmData,
+          regionPerView,
+          filter,
+          mapPutativesMatches,
+          guidedMatching);
+
+        // perform an additional check to remove pairs with poor overlap
+        std::vector<PairwiseMatches::key_type> toRemoveVec;
+        for(PairwiseMatches::const_iterator iterMap = geometricMatches.begin();
+          iterMap != geometricMatches.end(); ++iterMap)
+        {
+          const size_t putativePhotometricCount = mapPutativesMatches.find(iterMap->first)->second.getNbAllMatches();
+          const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
+          const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
+          if (putativeGeometricCount < 50 || ratio < .3f)
+            toRemoveVec.push_back(iterMap->first); // the image pair will be removed
+        }
+
+        // remove discarded pairs
+        for(std::vector<PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
+            iter != toRemoveVec.end(); ++iter)
+          geometricMatches.erase(*iter);
+      }
+      break;
+
+      case EGeometricFilterType::HOMOGRAPHY_MATRIX:
+      {
+        const bool onlyGuidedMatching = true;
+        GeometricFilterMatrix_H_AC filter(std::numeric_limits<double>::infinity(), maxIteration);
+        filter.m_nfaMode = nfaMode;
+        filter.m_useSPRT = geometricEarlyRejection;
+        filter.m_useGridGuidedMatching = guidedMatchingGrid;
+        matchingImageCollection::robustModelEstimation(geometricMatches,
+          &sfmData,
+          regionPerView,
+          filter,
+          mapPutativesMatches, guidedMatching,
+          onlyGuidedMatching ? -1.0 : 0.6);
+      }
+      break;
+
+      case EGeometricFilterType::HOMOGRAPHY_GROWING:
       {
-        const feature::EImageDescriberType descType = match.first;
-        assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-        const aliceVision::matching::IndMatches& inputMatches = match.second;
+        matchingImageCollection::robustModelEstimation(geometricMatches,
+          &sfmData,
+          regionPerView,
+          GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), maxIteration),
+          mapPutativesMatches,
+          guidedMatching);
+      }
+      break;
+    }
+
+    ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
+    for(const auto& matchGeo: geometricMatches)
+      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+
+    // grid filtering
+    ALICEVISION_LOG_INFO("Grid filtering");
 
-        const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.second, descType));
-        const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.first, descType));
+    PairwiseMatches finalMatches;
 
-        // get the regions for the current view pair:
-        if(rRegions && lRegions)
+    {
+      for(const auto& geometricMatch: geometricMatches)
+      {
+        //Get the image pair and their matches.
+        const Pair& indexImagePair = geometricMatch.first;
+        const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatch.second;
+
+        for(const auto& match: matchesPerDesc)
         {
-          // sorting function:
-          aliceVision::matching::IndMatches outMatches;
-          sortMatches_byFeaturesScale(inputMatches, *lRegions, *rRegions, outMatches);
+          const feature::EImageDescriberType descType = match.first;
+          assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+          const aliceVision::matching::IndMatches& inputMatches = match.second;
+
+          const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.second, descType));
+          const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.first, descType));
 
-          if(useGridSort)
+          // get the regions for the current view pair:
+          if(rRegions && lRegions)
           {
-            // TODO: rename as matchesGridOrdering
-            matchesGridFiltering(*lRegions, *rRegions, indexImagePair, sfmData, outMatches);
+            // sorting function:
+            aliceVision::matching::IndMatches outMatches;
+            sortMatches_byFeaturesScale(inputMatches, *lRegions, *rRegions, outMatches);
+
+            if(useGridSort)
+            {
+              // TODO: rename as matchesGridOrdering
+              matchesGridFiltering(*lRegions, *rRegions, indexImagePair, sfmData, outMatches);
+            }
+            if(numMatchesToKeep > 0)
+            {
+              size_t finalSize = std::min(numMatchesToKeep, outMatches.size());
+              outMatches.resize(finalSize);
+            }
+
+            // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
+            finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
           }
-          if(numMatchesToKeep > 0)
+          else
           {
-            size_t finalSize = std::min(numMatchesToKeep, outMatches.size());
-            outMatches.resize(finalSize);
+            ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
           }
-
-          // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
-          finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
-        }
-        else
-        {
-          ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
         }
       }
+
+      ALICEVISION_LOG_INFO("After grid filtering:");
+      for(const auto& matchGridFiltering: finalMatches)
+        ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
     }
 
-    ALICEVISION_LOG_INFO("After grid filtering:");
-    for(const auto& matchGridFiltering: finalMatches)
-      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
+    // export geometric filtered matches
+    ALICEVISION_LOG_INFO("Save geometric matches.");
+    saveBatchMatches(finalMatches);
+    ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
+
+#ifdef ALICEVISION_DEBUG_MATCHING
+    {
+      ALICEVISION_LOG_DEBUG("GEOMETRIC");
+      getStatsMap(geometricMatches);
+    }
+#endif
   }
 
-  // export geometric filtered matches
-  ALICEVISION_LOG_INFO("Save geometric matches.");
-  Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage);
-  ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
+  if(nbPutativePairs == 0 && nbCachedPairs == 0)
+  {
+    // if we only compute a selection of matches, we may have no match.
+    return rangeSize ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
 
   // d. Export some statistics
-  if(exportDebugFiles)
+  if(exportDebugFiles && streaming)
+  {
+    ALICEVISION_LOG_WARNING("The adjacency matrix is not exported in streaming matching, the matches are not kept in memory.");
+  }
+  else if(exportDebugFiles)
   {
     // export Adjacency matrix
     ALICEVISION_LOG_INFO("Export Adjacency Matrix of the pairwise's geometric matches");
     PairwiseMatchingToAdjacencyMatrixSVG(sfmData.getViews().size(),
-      finalMatches,(fs::path(matchesFolder) / "GeometricAdjacencyMatrix.svg").string());
+      allFinalMatches,(fs::path(matchesFolder) / "GeometricAdjacencyMatrix.svg").string());
 
     /*
     // export view pair graph once geometric filter have been done
@@ -533,7 +841,7 @@ int main(int argc, char **argv)
       std::set<IndexT> set_ViewIds;
       std::transform(sfmData.getViews().begin(), sfmData.getViews().end(),
         std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(finalMatches));
+      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(allFinalMatches));
       graph::exportToGraphvizData(
         (fs::path(matchesFolder) / "geometric_matches.dot").string(),
         putativeGraph.g);
@@ -541,12 +849,5 @@ int main(int argc, char **argv)
     */
   }
 
-#ifdef ALICEVISION_DEBUG_MATCHING
-  {
-    ALICEVISION_LOG_DEBUG("GEOMETRIC");
-    getStatsMap(geometricMatches);
-  }
-#endif
-
   return EXIT_SUCCESS;
 }
@@ -9,6 +9,8 @@
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 #include <aliceVision/voctree/databaseIO.hpp>
+#include <aliceVision/sfm/pipeline/ContentCache.hpp>
+#include <aliceVision/sfm/utils/uid.hpp>
 #include <aliceVision/config.hpp>
 
 #include <Eigen/Core>
@@ -21,7 +23,11 @@
 #include <ostream>
 #include <string>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <chrono>
+#include <map>
+#include <vector>
 
 static const int DIMENSION = 128;
 
@@ -272,6 +278,118 @@ void generateAllMatchesBetweenTwoMap(const std::map<IndexT, std::string>& descri
   }
 }
 
+/**
+ * @brief Quantize the descriptors of an image in the vocabulary tree,
+ * or load its histogram from the cache if the image has already been quantized in the same tree.
+ *
+ * @param[in] descriptorsPath The descriptors file of the image
+ * @param[in] tree The vocabulary tree
+ * @param[in] treeUID The content UID of the vocabulary tree file
+ * @param[in] nbMaxDescriptors The maximum number of descriptors to load
+ * @param[in] cache The content-addressed cache (may be disabled)
+ * @return the sparse histogram of the image
+ */
+aliceVision::voctree::CompactHistogram computeHistogram(const std::string& descriptorsPath,
+                                                        const aliceVision::voctree::VocabularyTree<DescriptorFloat>& tree,
+                                                        const std::string& treeUID,
+                                                        std::size_t nbMaxDescriptors,
+                                                        const sfm::ContentCache& cache)
+{
+  aliceVision::voctree::CompactHistogram histogram;
+  std::string key;
+
+  if(cache.isEnabled())
+  {
+    try
+    {
+      key = sfm::ContentKey().add(treeUID).add(sfm::computeFileUID(descriptorsPath)).add(nbMaxDescriptors).digest();
+    }
+    catch(const std::exception& e)
+    {
+      // the histogram is computed without the cache
+      ALICEVISION_LOG_WARNING("Unable to compute the cache key of '" << descriptorsPath << "': " << e.what());
+    }
+
+    std::string buffer;
+    if(!key.empty() && cache.load("voctreeHistograms", key, buffer))
+    {
+      try
+      {
+        std::istringstream stream(buffer);
+        histogram.read(stream);
+        return histogram;
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING("Invalid cached histogram of '" << descriptorsPath << "' (" << e.what() << "), the descriptors are quantized again.");
+      }
+    }
+  }
+
+  std::vector<DescriptorUChar> descriptors;
+  loadDescsFromBinFile(descriptorsPath, descriptors, false, nbMaxDescriptors);
+  histogram = tree.quantizeToCompact(descriptors);
+
+  if(!key.empty())
+  {
+    std::ostringstream stream;
+    histogram.write(stream);
+    cache.store("voctreeHistograms", key, stream.str());
+  }
+  return histogram;
+}
+
+/**
+ * @brief Insert the histogram of each image in the database, the histograms are
+ * loaded from the cache when available (see populateDatabase() without cache).
+ * @return the number of features of the inserted histograms
+ */
+std::size_t populateDatabase(const std::map<IndexT, std::string>& descriptorsFiles,
+                             const aliceVision::voctree::VocabularyTree<DescriptorFloat>& tree,
+                             const std::string& treeUID,
+                             std::size_t nbMaxDescriptors,
+                             const sfm::ContentCache& cache,
+                             aliceVision::voctree::Database& db)
+{
+  std::vector<aliceVision::voctree::CompactHistogram> histograms(descriptorsFiles.size());
+  std::vector<std::map<IndexT, std::string>::const_iterator> descriptorsFileIts;
+  descriptorsFileIts.reserve(descriptorsFiles.size());
+  for(auto it = descriptorsFiles.cbegin(); it != descriptorsFiles.cend(); ++it)
+    descriptorsFileIts.push_back(it);
+
+  // exceptions can't escape the parallel region, the first error is thrown after it
+  std::string error;
+
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFileIts.size()); ++i)
+  {
+    try
+    {
+      histograms.at(i) = computeHistogram(descriptorsFileIts.at(i)->second, tree, treeUID, nbMaxDescriptors, cache);
+    }
+    catch(const std::exception& e)
+    {
+      #pragma omp critical
+      if(error.empty())
+        error = e.what();
+    }
+  }
+
+  if(!error.empty())
+    throw std::runtime_error(error);
+
+  // insert the documents in the order of the view ids
+  std::size_t nbFeatures = 0;
+  std::size_t i = 0;
+  for(const auto& descriptorsFile : descriptorsFiles)
+  {
+    nbFeatures += histograms.at(i).nbFeatures();
+    db.insert(descriptorsFile.first, histograms.at(i));
+    ++i;
+  }
+  return nbFeatures;
+}
+
 int main(int argc, char** argv)
 {
   // command-line parameters
@@ -309,6 +427,9 @@ int main(int argc, char** argv)
   /// the combine SfM output
   std::string outputCombinedSfM;
 
+  /// the content-addressed cache folder of the image histograms
+  std::string cacheFolder;
+
   po::options_description allParams(
     "The objective of this software is to find images that are looking to the same areas of the scene. "
     "For that, we use the image retrieval techniques to find images that share content without "
@@ -340,7 +461,10 @@ int main(int argc, char** argv)
       "The number of matches to retrieve for each image (If 0 it will "
       "retrieve all the matches).")
     ("weights,w", po::value<std::string>(&weightsName),
-      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
+      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.")
+    ("cacheFolder", po::value<std::string>(&cacheFolder)->default_value(cacheFolder),
+      "Content-addressed cache of the image histograms in the vocabulary tree, shared between runs: "
+      "only the new images are quantized. Disabled if empty.");
 
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
@@ -488,7 +612,30 @@ int main(int argc, char** argv)
     std::size_t nbFeaturesLoadedInputA = 0;
     std::size_t nbFeaturesLoadedInputB = 0;
 
+    sfm::ContentCache cache(cacheFolder);
+    std::string treeUID;
+    if(cache.isEnabled())
+    {
+      try
+      {
+        treeUID = sfm::computeFileUID(treeName);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING("Unable to compute the UID of the vocabulary tree, the cache is disabled: " << e.what());
+        cache = sfm::ContentCache();
+      }
+    }
+
     auto detect_start = std::chrono::steady_clock::now();
+    if(cache.isEnabled())
+    {
+      if(modeMultiSfM == EImageMatchingMultiSfM::A_AB)
+        nbFeaturesLoadedInputA = populateDatabase(descriptorsFilesA, tree, treeUID, nbMaxDescriptors, cache, db);
+      if(useMultiSfM)
+        nbFeaturesLoadedInputB = populateDatabase(descriptorsFilesB, tree, treeUID, nbMaxDescriptors, cache, db);
+    }
+    else
     {
       if(modeMultiSfM == EImageMatchingMultiSfM::A_AB)
         nbFeaturesLoadedInputA = aliceVision::voctree::populateDatabase<DescriptorUChar>(sfmDataA, featuresFolders, tree, db, nbMaxDescriptors);
@@ -509,7 +656,7 @@ int main(int argc, char** argv)
       return EXIT_FAILURE;
     }
 
-    ALICEVISION_LOG_INFO("Read " << db.getSparseHistogramPerImage().size() << " sets of descriptors for a total of " << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
+    ALICEVISION_LOG_INFO("Read " << db.size() << " sets of descriptors for a total of " << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
     ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec.");
 
     if(!withWeights)
@@ -540,19 +687,16 @@ int main(int argc, char** argv)
       const IndexT viewIdA = itA->first;
       const std::string featuresPathA = itA->second;
 
-      aliceVision::voctree::SparseHistogram imageSH;
+      aliceVision::voctree::CompactHistogram imageSH;
       if(modeMultiSfM == EImageMatchingMultiSfM::A_AB)
       {
         // sparse histogram of A is already computed in the DB
-        imageSH = db.getSparseHistogramPerImage().at(viewIdA);
+        imageSH = db.getDocument(viewIdA);
       }
       else
       {
         // compute the sparse histogram of each image A
-        std::vector<DescriptorUChar> descriptors;
-        // read the descriptors
-        loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-        imageSH = tree.quantizeToSparse(descriptors);
+        imageSH = computeHistogram(featuresPathA, tree, treeUID, nbMaxDescriptors, cache);
       }
 
       std::vector<aliceVision::voctree::DocMatch> matches;
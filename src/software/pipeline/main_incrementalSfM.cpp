@@ -10,6 +10,7 @@
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/randomSeed.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
 #include <boost/program_options.hpp>
@@ -91,6 +92,10 @@ int main(int argc, char **argv)
   bool useOnlyMatchesFromInputFolder = false;
   bool useTrackFiltering = true;
   bool lockScenePreviouslyReconstructed = true;
+  bool localBAOnExtension = true;
+  bool compactInactiveLandmarks = false;
+  bool spillInactiveLandmarks = false;
+  int randomSeed = -1;
   std::size_t localBundelAdjustementGraphDistanceLimit = 1;
   std::string localizerEstimatorName = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC);
 
@@ -150,6 +155,11 @@ int main(int argc, char **argv)
       "It reduces the reconstruction time, especially for big datasets (500+ images).")
     ("localBAGraphDistance", po::value<std::size_t>(&localBundelAdjustementGraphDistanceLimit)->default_value(localBundelAdjustementGraphDistanceLimit),
       "Graph-distance limit setting the Active region in the Local Bundle Adjustment strategy.")
+    ("compactInactiveLandmarks", po::value<bool>(&compactInactiveLandmarks)->default_value(compactInactiveLandmarks),
+      "With the Local Bundle Adjustment, hold the landmarks that the next resections can't change in a compact storage.\n"
+      "Their positions are stored in single precision.")
+    ("spillInactiveLandmarks", po::value<bool>(&spillInactiveLandmarks)->default_value(spillInactiveLandmarks),
+      "With the Local Bundle Adjustment, write the landmarks that the next resections can't change to disk (in the output folder).")
     ("localizerEstimator", po::value<std::string>(&localizerEstimatorName)->default_value(localizerEstimatorName),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
@@ -158,7 +168,12 @@ int main(int argc, char **argv)
     ("useTrackFiltering", po::value<bool>(&useTrackFiltering)->default_value(useTrackFiltering),
       "Enable/Disable the track filtering.\n")
     ("lockScenePreviouslyReconstructed", po::value<bool>(&lockScenePreviouslyReconstructed)->default_value(lockScenePreviouslyReconstructed),
-      "Lock/Unlock scene previously reconstructed.\n");
+      "Lock/Unlock scene previously reconstructed.\n")
+    ("localBAOnExtension", po::value<bool>(&localBAOnExtension)->default_value(localBAOnExtension),
+      "When the input SfMData already contains a reconstruction, only the new views are resected and "
+      "the bundle adjustments are restricted to their neighbourhood (local BA).\n")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "Seed of the random number generators, for reproducible reconstructions. -1 to use a random seed.\n");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -198,6 +213,9 @@ int main(int argc, char **argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  if(randomSeed >= 0)
+    system::setDeterministicMode(randomSeed);
+
   // load input SfMData scene
   SfMData sfmData;
   if(!Load(sfmData, sfmDataFilename, ESfMData::ALL))
@@ -271,6 +289,8 @@ int main(int argc, char **argv)
   sfmEngine.setIntermediateFileExtension(outInterFileExtension);
   sfmEngine.setUseLocalBundleAdjustmentStrategy(useLocalBundleAdjustment);
   sfmEngine.setLocalBundleAdjustmentGraphDistance(localBundelAdjustementGraphDistanceLimit);
+  sfmEngine.setLocalBundleAdjustmentOnExtension(localBAOnExtension);
+  sfmEngine.setCompactInactiveLandmarks(compactInactiveLandmarks, spillInactiveLandmarks);
   sfmEngine.setLocalizerEstimator(robustEstimation::ERobustEstimator_stringToEnum(localizerEstimatorName));
   sfmEngine.useTrackFiltering(useTrackFiltering);
 
@@ -16,6 +16,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
@@ -77,6 +78,8 @@ int main(int argc, char** argv)
   robustEstimation::ERobustEstimator resectionEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
   /// the estimator to use for matching
   robustEstimation::ERobustEstimator matchingEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  /// the NFA evaluation of the A Contrario estimations
+  robustEstimation::EACRansacNFA nfaMode = robustEstimation::EACRansacNFA::EXACT;
   /// the possible choices for the estimators as strings
   const std::string str_estimatorChoices = ""+robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC)
                                           +","+robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::LORANSAC);
@@ -146,6 +149,10 @@ int main(int argc, char** argv)
       ("matchingEstimator", po::value<robustEstimation::ERobustEstimator>(&matchingEstimator)->default_value(matchingEstimator),
           std::string("The type of *sac framework to use for matching "
           "("+str_estimatorChoices+")").c_str())
+      ("nfaMode", po::value<robustEstimation::EACRansacNFA>(&nfaMode)->default_value(nfaMode),
+          "NFA evaluation of the A Contrario estimations (acransac only):\n"
+          "* exact: sort all the residuals of each model\n"
+          "* histogram: bin the residuals in a histogram and only sort the bins which may contain the best NFA")
       ("refineIntrinsics", po::value<bool>(&refineIntrinsics),
           "Enable/Disable camera intrinsics refinement for each localized image")
       ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax), 
@@ -300,6 +307,7 @@ int main(int argc, char** argv)
   param->_errorMax = resectionErrorMax;
   param->_resectionEstimator = resectionEstimator;
   param->_matchingEstimator = matchingEstimator;
+  param->_nfaMode = nfaMode;
 
   if(!localizer->isInit())
   {
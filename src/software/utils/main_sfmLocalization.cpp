@@ -44,6 +44,7 @@ int main(int argc, char **argv)
 
   std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
   double maxResidualError = std::numeric_limits<double>::infinity();
+  robustEstimation::EACRansacNFA nfaMode = robustEstimation::EACRansacNFA::EXACT;
 
   po::options_description allParams(
     "Image localization in an existing SfM reconstruction\n"
@@ -65,7 +66,11 @@ int main(int argc, char **argv)
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
       feature::EImageDescriberType_informations().c_str())
     ("maxResidualError", po::value<double>(&maxResidualError)->default_value(maxResidualError),
-      "Upper bound of the residual error tolerance.");
+      "Upper bound of the residual error tolerance.")
+    ("nfaMode", po::value<robustEstimation::EACRansacNFA>(&nfaMode)->default_value(nfaMode),
+      "NFA evaluation of the A Contrario resection:\n"
+      "* exact: sort all the residuals of each model\n"
+      "* histogram: bin the residuals in a histogram and only sort the bins which may contain the best NFA");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -183,6 +188,7 @@ int main(int argc, char **argv)
   geometry::Pose3 pose;
   sfm::ImageLocalizerMatchData matching_data;
   matching_data.error_max = maxResidualError;
+  matching_data.nfaMode = nfaMode;
 
   // Try to localize the image in the database thanks to its regions
   if (!localizer.Localize(
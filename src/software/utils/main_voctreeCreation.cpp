@@ -49,6 +49,8 @@ int main(int argc, char** argv)
   std::uint32_t restart = 5;
   std::uint32_t LEVELS = 6;
   bool sanityCheck = true;
+  std::size_t maxDescriptors = 0;
+  std::size_t miniBatchSize = 0;
 
   po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
                                     "It takes as input either a list.txt file containing the a simple list of images (bundler format and older AliceVision version format)\n"
@@ -68,6 +70,10 @@ int main(int argc, char** argv)
     (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
     ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
     (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
+    ("maxDescriptors", po::value<std::size_t>(&maxDescriptors)->default_value(maxDescriptors), "Maximum number of training descriptors, "
+      "if there are more descriptors an evenly distributed subset is loaded (0 to load all the descriptors)")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchSize)->default_value(miniBatchSize), "Use mini-batch k-means of this batch size "
+      "to cluster the larger sets of descriptors (faster, approximate), 0 to always use the standard k-means")
     ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
 
   po::options_description logParams("Log parameters");
@@ -122,7 +128,7 @@ int main(int argc, char** argv)
   std::vector<size_t> descRead;
   ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead, maxDescriptors);
   auto detect_end = std::chrono::steady_clock::now();
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   if(descriptors.size() == 0)
@@ -138,6 +144,7 @@ int main(int argc, char** argv)
   aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
   builder.setVerbose(tbVerbosity);
   builder.kmeans().setRestarts(restart);
+  builder.kmeans().setMiniBatchSize(miniBatchSize);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
   builder.build(descriptors, K, LEVELS);
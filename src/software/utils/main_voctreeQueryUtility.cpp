@@ -77,17 +77,22 @@ std::string myToString(std::size_t i, std::size_t zeroPadding)
   return ss.str();
 }
 
-bool saveSparseHistogramPerImage(const std::string &filename, const aliceVision::voctree::SparseHistogramPerImage &docs)
+bool saveDocumentMap(const std::string &filename, const aliceVision::voctree::Database &db)
 {
   std::ofstream fileout(filename);
   if(!fileout.is_open())
     return false;
 
-  for(const auto& d: docs)
+  // documents sorted by id
+  std::map<aliceVision::voctree::DocId, std::size_t> docIndices;
+  for(std::size_t i = 0; i < db.getDocIds().size(); ++i)
+    docIndices[db.getDocIds()[i]] = i;
+
+  for(const auto& d: docIndices)
   {
     fileout << "d{" << d.first << "} = [";
-    for(const auto& i: d.second)
-      fileout << i.first << ", ";
+    for(const auto word: db.getDocuments()[d.second].words())
+      fileout << word << ", ";
     fileout << "]\n";
   }
 
@@ -318,12 +323,12 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  ALICEVISION_LOG_INFO("Done! " << db.getSparseHistogramPerImage().size() << " sets of descriptors read for a total of " << numTotFeatures << " features");
+  ALICEVISION_LOG_INFO("Done! " << db.size() << " sets of descriptors read for a total of " << numTotFeatures << " features");
   ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec");
 
   if(vm.count("saveDocumentMap"))
   {
-    saveSparseHistogramPerImage(documentMapFile, db.getSparseHistogramPerImage());
+    saveDocumentMap(documentMapFile, db);
   }
 
   if(!withWeights)
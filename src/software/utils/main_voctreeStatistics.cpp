@@ -192,7 +192,7 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  ALICEVISION_LOG_INFO("Done! " << db.getSparseHistogramPerImage().size() << " sets of descriptors read for a total of " << numTotFeatures << " features");
+  ALICEVISION_LOG_INFO("Done! " << db.size() << " sets of descriptors read for a total of " << numTotFeatures << " features");
   ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec");
 
   if(!withWeights)